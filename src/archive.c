@@ -0,0 +1,343 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: archive.c
+ *
+ *===================================================================================================================*/
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "archive.h"
+#include "object.h"
+#include "symbollib.h"
+#include "outbuf.h"
+#include "diag.h"
+#include "asmerr.h"
+
+#define HEADER_SIZE 20  /* bytes of the archive header. */
+#define MEMBER_SIZE 12  /* bytes of a member entry. */
+#define INDEX_SIZE 8    /* bytes of an index entry. */
+#define MAX_MEMBERS 0xffff /* the index maps symbols to members in a SymLib, whose values are 16-bit. */
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * SEE HEADER
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+struct Archive {
+  char* _name;                 /* path of the archive file, used in error messages. */
+  const uint8_t* _p_data;      /* the mapped file. */
+  size_t _size;                /* size of the mapped file in bytes. */
+  uint32_t _num_members;
+  const uint8_t* _p_members;   /* base of the member table within the mapped file. */
+  const char* _p_strtab;
+  struct SymLib* _p_index;     /* maps each exported label to the index of its member. */
+};
+
+/*=====================================================================================================================
+ * PRIVATE HELPERS
+ *===================================================================================================================*/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int put_u32le(struct OutBuf* p_buf, uint32_t v){
+  char b[4] = {(char)v, (char)(v >> 8), (char)(v >> 16), (char)(v >> 24)};
+  return outbuf_write(p_buf, b, 4);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static uint32_t get_u32le(const uint8_t* b){
+  return (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static const char* base_name(const char* path){
+  const char* slash = strrchr(path, '/');
+  return (slash != NULL) ? slash + 1 : path;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: the size of the tables of an archive, i.e. the offset of the first member image.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static size_t tables_size(uint32_t num_members, uint32_t num_index, uint32_t strtab_size){
+  size_t n = HEADER_SIZE + (size_t)MEMBER_SIZE * num_members + (size_t)INDEX_SIZE * num_index + strtab_size;
+  return (n + 3) & ~(size_t)3;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: composes the index and string table of an archive; the member names come first in the string table.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int write_index(Object_t* const* pp_objs, int num_objs, struct OutBuf* p_index, struct OutBuf* p_strtab){
+  struct SymLib* p_lib;
+  if(new_symlib(&p_lib) != SUCCESS){
+    fprintf(diag_stream(), "fatal error: out of memory\n");
+    return FAIL;
+  }
+  int result = SUCCESS;
+  for(int m = 0; m < num_objs; ++m){
+    const char* name = base_name(pp_objs[m]->_name);
+    if(outbuf_write(p_strtab, name, strlen(name) + 1) != SUCCESS){
+      result = FAIL;
+    }
+  }
+  ObjSym_t sym;
+  for(int m = 0; m < num_objs && result == SUCCESS; ++m){
+    for(uint32_t i = 0; i < pp_objs[m]->_num_syms; ++i){
+      object_symbol(pp_objs[m], i, &sym);
+      if(sym._kind != OBJSYM_EXPORT){
+        continue;
+      }
+      uint16_t first;
+      if(symlib_search_symbol(p_lib, sym._name, &first) == SUCCESS){
+        fprintf(diag_stream(), "%s: multiple declerations of label %s, also in %s - labels must be unique\n",
+                pp_objs[m]->_name, sym._name, pp_objs[first]->_name);
+        result = FAIL;
+        continue;
+      }
+      if(symlib_add_symbol(p_lib, sym._name, (uint16_t)m, SYMTAG_NONE) != SUCCESS ||
+         put_u32le(p_index, (uint32_t)p_strtab->_size) != SUCCESS || put_u32le(p_index, (uint32_t)m) != SUCCESS ||
+         outbuf_write(p_strtab, sym._name, strlen(sym._name) + 1) != SUCCESS){
+        fprintf(diag_stream(), "fatal error: out of memory\n");
+        result = FAIL;
+      }
+    }
+  }
+  free_symlib(&p_lib);
+  return result;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static Archive_t* reject_archive(Archive_t* p_ar, const char* why){
+  fprintf(diag_stream(), "%s: invalid archive, %s\n", p_ar->_name, why);
+  free_archive(&p_ar);
+  return NULL;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: locates the tables of a mapped archive, checks every offset within them and loads the index into a SymLib.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static Archive_t* load_archive(Archive_t* p_ar){
+  const uint8_t* d = p_ar->_p_data;
+  if(p_ar->_size < HEADER_SIZE || get_u32le(d) != ARCHIVE_MAGIC){
+    return reject_archive(p_ar, "bad magic");
+  }
+  if((uint16_t)(d[4] | (d[5] << 8)) != ARCHIVE_VERSION){
+    return reject_archive(p_ar, "unsupported version");
+  }
+  p_ar->_num_members = get_u32le(d + 8);
+  uint32_t num_index = get_u32le(d + 12);
+  uint32_t strtab_size = get_u32le(d + 16);
+  if(p_ar->_num_members > MAX_MEMBERS || (uint64_t)MEMBER_SIZE * p_ar->_num_members + 
+     (uint64_t)INDEX_SIZE * num_index + strtab_size + HEADER_SIZE > p_ar->_size){
+    return reject_archive(p_ar, "tables exceed the file size");
+  }
+  p_ar->_p_members = d + HEADER_SIZE;
+  const uint8_t* p_index = p_ar->_p_members + MEMBER_SIZE * (size_t)p_ar->_num_members;
+  p_ar->_p_strtab = (const char*)(p_index + INDEX_SIZE * (size_t)num_index);
+  if(strtab_size == 0 || p_ar->_p_strtab[strtab_size - 1] != '\0'){
+    return reject_archive(p_ar, "unterminated string table");
+  }
+  for(uint32_t m = 0; m < p_ar->_num_members; ++m){
+    const uint8_t* e = p_ar->_p_members + MEMBER_SIZE * (size_t)m;
+    uint64_t end = (uint64_t)get_u32le(e + 4) + get_u32le(e + 8);
+    if(get_u32le(e) >= strtab_size || end > p_ar->_size){
+      return reject_archive(p_ar, "bad member");
+    }
+  }
+  if(new_symlib(&p_ar->_p_index) != SUCCESS){
+    fprintf(diag_stream(), "fatal error: out of memory\n");
+    free_archive(&p_ar);
+    return NULL;
+  }
+  for(uint32_t i = 0; i < num_index; ++i){
+    const uint8_t* e = p_index + INDEX_SIZE * (size_t)i;
+    uint32_t name = get_u32le(e), member = get_u32le(e + 4);
+    if(name >= strtab_size || member >= p_ar->_num_members || 
+       symlib_add_symbol(p_ar->_p_index, p_ar->_p_strtab + name, (uint16_t)member, SYMTAG_NONE) != SUCCESS){
+      return reject_archive(p_ar, "bad index");
+    }
+  }
+  return p_ar;
+}
+
+/*=====================================================================================================================
+ * PUBLIC INTERFACE
+ *===================================================================================================================*/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int archive_write(Object_t* const* pp_objs, int num_objs, struct OutBuf* p_out){
+  if(num_objs > MAX_MEMBERS){
+    fprintf(diag_stream(), "archive has more than %d members\n", MAX_MEMBERS);
+    return FAIL;
+  }
+  size_t start = p_out->_size; // images are aligned relative to the start of the archive.
+  struct OutBuf index, strtab;
+  if(init_outbuf(&index, 1 << 12) != SUCCESS){
+    return FAIL;
+  }
+  if(init_outbuf(&strtab, 1 << 12) != SUCCESS){
+    free_outbuf(&index);
+    return FAIL;
+  }
+  int result = write_index(pp_objs, num_objs, &index, &strtab);
+  uint32_t num_index = (uint32_t)(index._size / INDEX_SIZE);
+  size_t offset = tables_size((uint32_t)num_objs, num_index, (uint32_t)strtab._size);
+  char b[4] = {0, 0, 0, 0};
+  if(result == SUCCESS){
+    char version[4] = {(char)ARCHIVE_VERSION, (char)(ARCHIVE_VERSION >> 8), 0, 0};
+    if(put_u32le(p_out, ARCHIVE_MAGIC) != SUCCESS || outbuf_write(p_out, version, 4) != SUCCESS ||
+       put_u32le(p_out, (uint32_t)num_objs) != SUCCESS || put_u32le(p_out, num_index) != SUCCESS ||
+       put_u32le(p_out, (uint32_t)strtab._size) != SUCCESS){
+      result = FAIL;
+    }
+  }
+  uint32_t name = 0;
+  for(int m = 0; m < num_objs && result == SUCCESS; ++m){
+    if(put_u32le(p_out, name) != SUCCESS || put_u32le(p_out, (uint32_t)offset) != SUCCESS ||
+       put_u32le(p_out, (uint32_t)pp_objs[m]->_size) != SUCCESS){
+      result = FAIL;
+    }
+    name += (uint32_t)strlen(base_name(pp_objs[m]->_name)) + 1;
+    offset = (offset + pp_objs[m]->_size + 3) & ~(size_t)3;
+  }
+  if(result == SUCCESS && (outbuf_write(p_out, index._p_data, index._size) != SUCCESS ||
+     outbuf_write(p_out, strtab._p_data, strtab._size) != SUCCESS ||
+     outbuf_write(p_out, b, -(p_out->_size - start) & 3) != SUCCESS)){
+    result = FAIL;
+  }
+  for(int m = 0; m < num_objs && result == SUCCESS; ++m){
+    if(outbuf_write(p_out, pp_objs[m]->_p_data, pp_objs[m]->_size) != SUCCESS ||
+       outbuf_write(p_out, b, -(p_out->_size - start) & 3) != SUCCESS){
+      result = FAIL;
+    }
+  }
+  free_outbuf(&index);
+  free_outbuf(&strtab);
+  return result;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+Archive_t* new_archive(const char* path){
+  Archive_t* p_ar = (Archive_t*)calloc(1, sizeof(Archive_t));
+  if(p_ar == NULL || (p_ar->_name = strdup(path)) == NULL){
+    fprintf(diag_stream(), "fatal error: out of memory\n");
+    free(p_ar);
+    return NULL;
+  }
+  int fd = open(path, O_RDONLY);
+  struct stat st;
+  if(fd < 0 || fstat(fd, &st) != 0){
+    diag_perror(path);
+    if(fd >= 0){
+      close(fd);
+    }
+    free_archive(&p_ar);
+    return NULL;
+  }
+  if(st.st_size > 0){
+    void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(data == MAP_FAILED){
+      diag_perror(path);
+      close(fd);
+      free_archive(&p_ar);
+      return NULL;
+    }
+    p_ar->_p_data = (const uint8_t*)data;
+    p_ar->_size = (size_t)st.st_size;
+  }
+  close(fd);
+  return load_archive(p_ar);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void free_archive(Archive_t** pp_ar){
+  Archive_t* p_ar = *pp_ar;
+  if(p_ar->_p_index != NULL){
+    free_symlib(&p_ar->_p_index);
+  }
+  if(p_ar->_p_data != NULL){
+    munmap((void*)p_ar->_p_data, p_ar->_size);
+  }
+  free(p_ar->_name);
+  free(p_ar);
+  (*pp_ar) = NULL;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int archive_find(Archive_t* p_ar, const char* sym, uint32_t* p_member){
+  uint16_t member;
+  if(symlib_search_symbol(p_ar->_p_index, sym, &member) != SUCCESS){
+    return ERROR_1;
+  }
+  *p_member = member;
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+Object_t* archive_member(Archive_t* p_ar, uint32_t member){
+  const uint8_t* e = p_ar->_p_members + MEMBER_SIZE * (size_t)member;
+  const char* name = p_ar->_p_strtab + get_u32le(e);
+  size_t n = strlen(p_ar->_name) + strlen(name) + 3;
+  char* full = (char*)malloc(n);
+  if(full == NULL){
+    fprintf(diag_stream(), "fatal error: out of memory\n");
+    return NULL;
+  }
+  snprintf(full, n, "%s(%s)", p_ar->_name, name);
+  Object_t* p_obj = new_object_buffer(full, p_ar->_p_data + get_u32le(e + 4), get_u32le(e + 8));
+  free(full);
+  return p_obj;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+const char* archive_name(const Archive_t* p_ar){
+  return p_ar->_name;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+uint32_t archive_num_members(const Archive_t* p_ar){
+  return p_ar->_num_members;
+}
@@ -0,0 +1,115 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: archive.h
+ *
+ *===================================================================================================================*/
+
+
+#ifndef _ARCHIVE_H_
+#define _ARCHIVE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "object.h"
+
+/*
+ * The archive format; a library of relocatable objects with an index of the labels they export. All integers are
+ * little-endian.
+ *
+ *   header:   u32 magic, u16 version, u16 reserved (0), u32 num_members, u32 num_index, u32 strtab_size
+ *   members:  num_members entries of u32 name (offset into strtab), u32 offset (of the object image in the file),
+ *             u32 size (of the object image).
+ *   index:    num_index entries of u32 symbol (offset into strtab), u32 member (index into members).
+ *   strtab:   strtab_size bytes of null terminated member and symbol names.
+ *   images:   the object image of each member, each starting on a 4 byte boundary.
+ *
+ * The index is read into a SymLib on load, thus a symbol is found in a single lookup, and members are only
+ * validated when a link pulls them.
+ */
+#define ARCHIVE_MAGIC     0x43524148 // "HARC".
+#define ARCHIVE_VERSION   1
+#define ARCHIVE_EXTENSION ".harc"
+
+/*
+ * brief: closed type of an archive file mapped into memory; instantiate with 'new_archive'.
+ */
+typedef struct Archive Archive_t;
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: composes an archive of objects; the member names are the object names without their directories.
+ * @param <out> p_out: buffer to append the archive to.
+ * return: SUCCESS, or FAIL on malloc error or if two objects export the same label; errors are reported to the 
+ *  diagnostic stream (see diag.h).
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int archive_write(Object_t* const* pp_objs, int num_objs, struct OutBuf* p_out);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: maps an archive file, validates its header and tables and loads its index.
+ * return: the archive, or NULL if the file cannot be read or is not a valid archive; errors are reported to the
+ *  diagnostic stream (see diag.h).
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+Archive_t* new_archive(const char* path);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: unmaps an archive; the member objects of the archive must be freed first.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+void free_archive(Archive_t** pp_ar);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: looks up the member of an archive that exports a label.
+ * return: SUCCESS, or ERROR_1 if no member exports the label.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int archive_find(Archive_t* p_ar, const char* sym, uint32_t* p_member);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: opens a member of an archive as an object, named "archive(member)"; the object borrows the mapping of the
+ *  archive.
+ * return: the object, or NULL if the member is not a valid object.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+Object_t* archive_member(Archive_t* p_ar, uint32_t member);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+const char* archive_name(const Archive_t* p_ar);
+uint32_t archive_num_members(const Archive_t* p_ar);
+
+#endif
@@ -0,0 +1,905 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: assembler.c
+ *
+ *===================================================================================================================*/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <inttypes.h>
+#include "symbollib.h"
+#include "parser.h"
+#include "asmerr.h"
+#include "decoder.h"
+#include "outbuf.h"
+#include "assembler.h"
+#include "diag.h"
+#include "hash.h"
+#include "srcmap.h"
+#include "optimize.h"
+
+#define VERBOSE(X)if(p->_is_verbose){fprintf(stdout, X);}
+#define VERBOSE2(X, Y)if(p->_is_verbose){fprintf(stdout, X, Y);}
+
+/*
+ * brief: an '@' symbol in the stripped output whose address is unknown when it is reached; patched once the whole
+ *  translation unit has been read.
+ *
+ * @member _out_offset: offset in the stripped output at which the address must be inserted.
+ * @member _sym_offset: offset of the symbol in the symbol name buffer.
+ */
+typedef struct Fixup {
+  size_t _out_offset;
+  size_t _sym_offset;
+} Fixup_t;
+
+/*
+ * states of a line in the line table.
+ */
+#define LINE_BLANK   0x00 // whitespace and/or comment only.
+#define LINE_COMMAND 0x01
+#define LINE_ERROR   0x02 // the line failed to lex.
+
+/*
+ * brief: a line of the translation unit as kept between incremental updates.
+ *
+ * @member _hash: hash of the raw line; lines of equal hash are taken to be unchanged.
+ * @member _address: instruction address at the start of the line, as counted by the symbol phase.
+ * @member _word: the encoded instruction of the line, if _is_encoded.
+ * @member _state: one of the LINE_* states.
+ * @member _cmd: the lexed command; symbols are NOT substituted.
+ */
+typedef struct Line {
+  uint64_t _hash;
+  uint32_t _address;
+  uint16_t _word;
+  uint8_t _state;
+  bool _is_encoded;
+  Command_t _cmd;
+} Line_t;
+
+/*
+ * brief: the line table of the translation unit; the resident state of 'assembler_update'.
+ *
+ * @member _first, _old_end, _new_end: the lines the last update changed; lines [_first, _old_end) of the version
+ *  before it were replaced by lines [_first, _new_end). Counted from 0.
+ */
+struct LineTable {
+  Line_t* _p_lines;
+  uint32_t _num_lines;
+  uint32_t _first;
+  uint32_t _old_end;
+  uint32_t _new_end;
+};
+
+/*
+ * brief: a raw line of the new version of the translation unit, during an update.
+ */
+typedef struct Slice {
+  const char* _p;
+  size_t _n;
+  uint64_t _hash;
+} Slice_t;
+
+/*=====================================================================================================================
+ * PRIVATE HELPERS
+ *===================================================================================================================*/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void next_ram(Assembler_t* p){
+  ++p->_ram_address;
+  if(p->_ram_address == MAX_ADDRESS + 1){ // report once, when the first variable overflows.
+    fprintf(diag_stream(), "exceeded RAM size, variable with address '%" PRIx32 "' cannot fit in 32K memory\n", p->_ram_address);
+    p->_fail = FAIL;
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static inline void next_line(Assembler_t* p){
+  ++p->_line_count;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void next_instruction(Assembler_t* p){
+  ++p->_ins_count;
+  if(p->_ins_count == MAX_ADDRESS + 1){ // report once, when the first instruction overflows.
+    fprintf(diag_stream(), "exceeded ROM size, instruction '%" PRIu32 "' cannot fit in 32K memory\n", p->_ins_count);
+    p->_fail = FAIL;
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: attemps to add the symbol to the appropriate library.
+ * returns: SUCCESS if symbol added, FAIL if symbol already exists in the library.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int add_symbol(Assembler_t* p, Symbol_t* p_sym){
+  assert(p_sym->_type == SYMBOL_A || p_sym->_type == SYMBOL_L);
+  int result;
+  switch(p_sym->_type){
+    case SYMBOL_A:
+      result = symlib_add_symbol(p->_p_sym_lib, p_sym->_sym, (uint16_t)p->_ram_address, SYMTAG_VARIABLE);
+      assert(result == SUCCESS || result == ERROR_1);
+      return (result == SUCCESS) ? next_ram(p), SUCCESS : FAIL;
+    case SYMBOL_L:
+      result = symlib_add_symbol(p->_p_sym_lib, p_sym->_sym, (uint16_t)p->_ins_count, SYMTAG_LABEL);
+      assert(result == SUCCESS || result == ERROR_1);
+      return (result == SUCCESS) ? SUCCESS : FAIL;
+  }
+  return FAIL;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: adds the symbols predefined by the Hack platform to the library.
+ * return: SUCCESS, or FAIL on malloc error.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int add_predefined_symbols(Assembler_t* p){
+  static const char* ptrs[] = {"SP", "LCL", "ARG", "THIS", "THAT"};
+  int result = SUCCESS;
+  for(int i = 0; i < 5 && result == SUCCESS; ++i){
+    result = symlib_add_symbol(p->_p_sym_lib, ptrs[i], (uint16_t)i, SYMTAG_PREDEFINED);
+  }
+  char rx[4];
+  for(int r = 0; r <= 15 && result == SUCCESS; ++r){
+    snprintf(rx, 4, "R%d", r);
+    result = symlib_add_symbol(p->_p_sym_lib, rx, (uint16_t)r, SYMTAG_PREDEFINED);
+  }
+  result = (result == SUCCESS) ? symlib_add_symbol(p->_p_sym_lib, "SCREEN", 16384, SYMTAG_PREDEFINED) : result;
+  result = (result == SUCCESS) ? symlib_add_symbol(p->_p_sym_lib, "KBD", 24576, SYMTAG_PREDEFINED) : result;
+  if(result != SUCCESS){
+    fprintf(diag_stream(), "fatal error: out of memory\n");
+    return p->_fail = FAIL;
+  }
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: adds the predefined symbols and all labels of the translation unit to the library.
+ *
+ * note: this function also counts the number of lines in the file, and for this reason MUST be the first operation
+ *  performed by the assembler; this is convenient for initialising labels.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int parse_labels(Assembler_t* p){
+  Symbol_t sym;
+  int result;
+
+  // first add all predefined symbols...
+  if(add_predefined_symbols(p) != SUCCESS){
+    return FAIL;
+  }
+
+  // parse all labels...
+  while((result = parser_next_symbol(p->_p_parser, &sym)) != CMD_EOF){
+    if(result != FAIL && sym._type == SYMBOL_L){
+      VERBOSE2("found label symbol '%s', adding to symbol library...\n", sym._sym);
+      if(add_symbol(p, &sym) != SUCCESS){
+        fprintf(diag_stream(), "multiple declerations of label %s - labels must be unique\n", sym._sym);
+        p->_fail = FAIL; 
+      }
+    }
+    else{
+      next_instruction(p); // dont count L commands; they dont generate instructions.
+    }
+    next_line(p);
+  }
+  parser_rewind(p->_p_parser); 
+  return p->_fail;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: searches the translation unit for symbols and adds all unique symbols to the library.
+ *
+ * note: this operation must be done in 2 phases because an '@' assembly instruction is ambiguous; it is not 
+ *  possible to know if the symbol after the '@' refers to a variable or a label without first knowing what labels
+ *  exist.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int parse_symbols(Assembler_t* p){
+  Symbol_t sym;
+  int result;
+
+  parse_labels(p);
+
+  // then parse all variables...
+  while((result = parser_next_symbol(p->_p_parser, &sym)) != CMD_EOF){
+    if(result == FAIL){
+      continue;
+    }
+    if(sym._type != SYMBOL_A){
+      continue;
+    }
+    if(add_symbol(p, &sym) == SUCCESS){
+      VERBOSE2("found variable symbol '%s', adding to symbol library...\n", sym._sym);
+    }
+  }
+  parser_rewind(p->_p_parser); 
+  return p->_fail;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: grows the command and instruction arrays, if required, to hold 'n' commands.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int reserve_arrays(Assembler_t* p, uint32_t n){
+  if(n <= p->_capacity){
+    return SUCCESS;
+  }
+  Command_t* p_cmds = (Command_t*)realloc(p->_p_cmds, (size_t)n * sizeof(Command_t));
+  if(p_cmds == NULL){
+    return FAIL;
+  }
+  p->_p_cmds = p_cmds;
+  uint16_t* p_hackins = (uint16_t*)realloc(p->_p_hackins, (size_t)n * sizeof(uint16_t));
+  if(p_hackins == NULL){
+    return FAIL;
+  }
+  p->_p_hackins = p_hackins;
+  p->_capacity = n;
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: parse assembly instructions into command structs.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int parse_commands(Assembler_t* p){
+  if(reserve_arrays(p, p->_line_count) != SUCCESS){
+    fprintf(diag_stream(), "fatal error: out of memory\n");
+    return p->_fail = FAIL;
+  }
+  uint32_t cmdno = 0;
+  int result; 
+  while(cmdno < p->_line_count && (result = parser_next_command(p->_p_parser, &p->_p_cmds[cmdno])) != CMD_EOF){
+    if(result == FAIL){
+      p->_fail = FAIL;
+    }
+    if(p->_is_verbose && result == SUCCESS){
+      parser_print_cmdrep(stderr, &p->_p_cmds[cmdno]);
+    }
+    ++cmdno;
+  }
+  return p->_fail;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: operates on the command array; if command has a symbol, substitutes it for mapped  literal.
+ * @param mode: if mode=0, subs A and L command symbols, if mode!=0 subs only A command symbols.
+ * note: expects the symbol library to contain ALL symbols encountered; should be guaranteed by the symbol populating
+ *  phase.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int substitute_symbols(Assembler_t* p, int mode){
+  for(uint32_t cn = 0; cn < p->_line_count; ++cn){
+    Command_t* c = &p->_p_cmds[cn];
+    if(c->_type == CFORMAT_A0 || (c->_type == CFORMAT_L0 && mode == 0)){
+      uint16_t add;
+      if(symlib_search_symbol(p->_p_sym_lib, c->_sym, &add) != SUCCESS){
+        fprintf(diag_stream(), "fatal error: line %" PRIu32 ": symbol %s was never added to the library\n", 
+                c->_lineno, c->_sym);
+        return p->_fail = FAIL;
+      }
+      ++c->_type; // change to CFORMAT_A/L1
+      c->_value = add;
+    }
+  }
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: maps the generated instructions to their source lines and labels.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int map_sources(Assembler_t* p){
+  if(srcmap_build(p->_p_srcmap, p) != SUCCESS){
+    fprintf(diag_stream(), "fatal error: out of memory\n");
+    return p->_fail = FAIL;
+  }
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: operates on the command array; translates commands into hack machine instructions, and builds their source
+ *  map from the lines of the commands and the labels of the symbol phase.
+ * note: command array MUST first have all symbols substituted for their literal values.
+ * note: the instruction array was sized with the command array; there are at most as many instructions as commands.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int generate_hackins(Assembler_t* p){
+  VERBOSE("generating Hack instructions...\n");
+  uint32_t in = 0;
+  for(uint32_t cn = 0; cn < p->_line_count; ++cn){
+    int type = p->_p_cmds[cn]._type;
+    if(type == CFORMAT_A1 || type == CFORMAT_C0 || type == CFORMAT_C1 || type == CFORMAT_C2){
+      decode(&p->_p_cmds[cn], &p->_p_hackins[in]);
+      ++in;
+    }
+  }
+  p->_ins_count = in; // the symbol phase counts '(<literal>)' L commands as instructions, but they generate none.
+  return map_sources(p);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: opens a parser of the translation unit; of the file 'name' if 'src' is NULL, else of the buffer 'src'.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int open_parser(Assembler_t* p, const char* name, const char* src, size_t n){
+  assert(p->_p_parser == NULL);
+  p->_p_parser = (src == NULL) ? new_parser(name) : new_parser_buffer(name, src, n);
+  if(p->_p_parser == NULL){
+    if(src != NULL){
+      fprintf(diag_stream(), "fatal error: out of memory\n");
+    }
+    return p->_fail = FAIL;
+  }
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: assembles the translation unit of the open parser.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int assemble(Assembler_t* p, const char* name){
+  VERBOSE2("parsing symbols from input file '%s'...\n", name);
+  if(parse_symbols(p) != SUCCESS){
+    VERBOSE("terminating assembly: symbol errors occured\n");
+    return FAIL;
+  }
+  VERBOSE2("parsing assembly commands from input file '%s'...\n", name);
+  if(parse_commands(p) != SUCCESS){
+    VERBOSE("terminating assembly: assembly command errors occured\n");
+    return FAIL;
+  }
+  if(p->_opt_level > 0){
+    VERBOSE("optimising assembly commands...\n");
+    if(p->_p_opt == NULL && (p->_p_opt = (OptReport_t*)calloc(1, sizeof(OptReport_t))) == NULL){
+      fprintf(diag_stream(), "fatal error: out of memory\n");
+      return p->_fail = FAIL;
+    }
+    if(optimize(p, p->_p_opt) != SUCCESS){
+      return FAIL;
+    }
+  }
+  if(substitute_symbols(p, 1) != SUCCESS){
+    return FAIL;
+  }
+  return generate_hackins(p);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: compiles the translation unit of the open parser; as 'assemble', but stops before variables are allocated
+ *  and symbols substituted, since an '@' symbol the unit does not declare may be a label of another unit.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int compile(Assembler_t* p, const char* name){
+  VERBOSE2("parsing labels from input file '%s'...\n", name);
+  if(parse_labels(p) != SUCCESS){
+    VERBOSE("terminating compilation: symbol errors occured\n");
+    return FAIL;
+  }
+  VERBOSE2("parsing assembly commands from input file '%s'...\n", name);
+  if(parse_commands(p) != SUCCESS){
+    VERBOSE("terminating compilation: assembly command errors occured\n");
+    return FAIL;
+  }
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: strips the translation unit of the open parser.
+ *
+ * note: symbols are substituted as soon as they are known (predefined symbols and labels already seen). Any other
+ *  '@' symbol may be a forward reference to a label, so a fixup is recorded and patched after the pass; unknown
+ *  symbols are then allocated as variables in order of first appearance, which gives the same addresses as the
+ *  two-phase symbol parse of 'assembler_assemble'.
+ *
+ * note: output is composed as slices in a large buffer, there is no printf formatting.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int strip(Assembler_t* p, const char* name, struct OutBuf* p_out){
+  struct OutBuf out, syms;
+  Fixup_t* p_fixups = NULL;
+  size_t num_fixups = 0, fixup_cap = 0;
+  Command_t cmd;
+  uint16_t add;
+  int result;
+
+  if(init_outbuf(&out, 1 << 16) != SUCCESS || init_outbuf(&syms, 1 << 12) != SUCCESS){
+    fprintf(diag_stream(), "fatal error: out of memory\n");
+    free_outbuf(&out);
+    return p->_fail = FAIL;
+  }
+  if(add_predefined_symbols(p) != SUCCESS){
+    free_outbuf(&syms);
+    free_outbuf(&out);
+    return FAIL;
+  }
+
+  VERBOSE2("stripping assembly commands from input file '%s'...\n", name);
+  while((result = parser_next_command(p->_p_parser, &cmd)) != CMD_EOF){
+    next_line(p);
+    if(result == FAIL){
+      p->_fail = FAIL;
+      continue;
+    }
+    switch(cmd._type){
+      case CFORMAT_L0:
+        VERBOSE2("found label symbol '%s', adding to symbol library...\n", cmd._sym);
+        if(symlib_add_symbol(p->_p_sym_lib, cmd._sym, (uint16_t)p->_ins_count, SYMTAG_LABEL) != SUCCESS){
+          fprintf(diag_stream(), "multiple declerations of label %s - labels must be unique\n", cmd._sym);
+          p->_fail = FAIL; 
+        }
+        continue;
+      case CFORMAT_L1:
+        continue;
+      case CFORMAT_A0:
+        if(symlib_search_symbol(p->_p_sym_lib, cmd._sym, &add) == SUCCESS){
+          cmd._type = CFORMAT_A1;
+          cmd._value = add;
+          break;
+        }
+        if(num_fixups == fixup_cap){
+          size_t cap = (fixup_cap == 0) ? 256 : fixup_cap * 2;
+          Fixup_t* p_grown = (Fixup_t*)realloc(p_fixups, cap * sizeof(Fixup_t));
+          if(p_grown == NULL){
+            fprintf(diag_stream(), "fatal error: out of memory\n");
+            p->_fail = FAIL;
+            next_instruction(p);
+            continue;
+          }
+          p_fixups = p_grown;
+          fixup_cap = cap;
+        }
+        p_fixups[num_fixups]._out_offset = out._size + 1; // after the '@'.
+        p_fixups[num_fixups]._sym_offset = syms._size;
+        ++num_fixups;
+        outbuf_write(&syms, cmd._sym, strlen(cmd._sym) + 1);
+        outbuf_write(&out, "@\n", 2);
+        next_instruction(p);
+        continue;
+    }
+    parser_write_cmdasm(&out, &cmd);
+    next_instruction(p);
+  }
+
+  // resolve the fixups, allocating variables, and splice the addresses into the output...
+  if(p->_fail == SUCCESS && outbuf_reserve(p_out, out._size + (num_fixups * 5)) != SUCCESS){
+    fprintf(diag_stream(), "fatal error: out of memory\n");
+    p->_fail = FAIL;
+  }
+  else if(p->_fail == SUCCESS){
+    size_t from = 0;
+    for(size_t fn = 0; fn < num_fixups; ++fn){
+      const char* sym = syms._p_data + p_fixups[fn]._sym_offset;
+      if(symlib_search_symbol(p->_p_sym_lib, sym, &add) != SUCCESS){
+        VERBOSE2("found variable symbol '%s', adding to symbol library...\n", sym);
+        add = (uint16_t)p->_ram_address;
+        if(symlib_add_symbol(p->_p_sym_lib, sym, add, SYMTAG_VARIABLE) != SUCCESS){
+          fprintf(diag_stream(), "fatal error: out of memory\n");
+          p->_fail = FAIL;
+          break;
+        }
+        next_ram(p);
+      }
+      outbuf_write(p_out, out._p_data + from, p_fixups[fn]._out_offset - from);
+      outbuf_put_u32(p_out, add);
+      from = p_fixups[fn]._out_offset;
+    }
+    outbuf_write(p_out, out._p_data + from, out._size - from);
+  }
+  else{
+    VERBOSE("terminating strip: assembly command errors occured\n");
+  }
+
+  free_outbuf(&syms);
+  free_outbuf(&out);
+  free(p_fixups);
+  return p->_fail;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: number of addresses a line advances the instruction address by in the symbol phase; lines that fail to lex
+ *  and '(<literal>)' L commands count as instructions there, as in 'parse_symbols'.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static inline uint32_t address_step(const Line_t* p_line){
+  return (p_line->_state == LINE_BLANK || (p_line->_state == LINE_COMMAND && p_line->_cmd._type == CFORMAT_L0)) ? 0 : 1;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: splits the translation unit of the open parser into hashed lines.
+ * return: array of the lines, or NULL on malloc error.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static Slice_t* slice_lines(Assembler_t* p, uint32_t* p_num_lines){
+  size_t capacity = 1024, n = 0;
+  Slice_t* p_slices = (Slice_t*)malloc(capacity * sizeof(Slice_t));
+  const char* line;
+  size_t len;
+  while(p_slices != NULL && parser_next_line(p->_p_parser, &line, &len) == SUCCESS){
+    if(n == capacity){
+      capacity *= 2;
+      Slice_t* p_grown = (Slice_t*)realloc(p_slices, capacity * sizeof(Slice_t));
+      if(p_grown == NULL){
+        free(p_slices);
+        return NULL;
+      }
+      p_slices = p_grown;
+    }
+    p_slices[n]._p = line;
+    p_slices[n]._n = len;
+    p_slices[n]._hash = hash_xxh64(line, len, 0);
+    ++n;
+  }
+  *p_num_lines = (uint32_t)n;
+  return p_slices;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: builds the line table of the new version of the translation unit; lines in the common prefix and suffix of
+ *  the old and new versions are copied from the old table, the lines between are lexed.
+ * @param <out> p_first: index of the first line that differs; addresses must be recounted from here.
+ * return: SUCCESS, or FAIL on malloc error.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int diff_lines(Assembler_t* p, const Slice_t* p_slices, uint32_t num_new, uint32_t* p_first, uint32_t* p_num_lexed){
+  struct LineTable* t = p->_p_lines;
+  uint32_t num_old = t->_num_lines;
+  uint32_t min = (num_old < num_new) ? num_old : num_new;
+  uint32_t pre = 0, suf = 0;
+  while(pre < min && t->_p_lines[pre]._hash == p_slices[pre]._hash){
+    ++pre;
+  }
+  while(suf < min - pre && t->_p_lines[num_old - 1 - suf]._hash == p_slices[num_new - 1 - suf]._hash){
+    ++suf;
+  }
+
+  // the prefix stays in place, the suffix moves by the difference in length of the versions...
+  Line_t* p_lines = t->_p_lines;
+  if(num_new > num_old || p_lines == NULL){
+    if((p_lines = (Line_t*)realloc(p_lines, ((num_new > 0) ? num_new : 1) * sizeof(Line_t))) == NULL){
+      return FAIL;
+    }
+    t->_p_lines = p_lines;
+  }
+  memmove(p_lines + num_new - suf, p_lines + num_old - suf, suf * sizeof(Line_t));
+  for(uint32_t i = pre; i < num_new - suf; ++i){
+    Line_t* p_line = &p_lines[i];
+    p_line->_hash = p_slices[i]._hash;
+    p_line->_is_encoded = false;
+    int result = parser_lex_line(p->_p_parser, p_slices[i]._p, p_slices[i]._n, i + 1, &p_line->_cmd, true);
+    p_line->_state = (result == SUCCESS) ? LINE_COMMAND : (result == CMD_BLANK) ? LINE_BLANK : LINE_ERROR;
+  }
+  t->_num_lines = num_new;
+  t->_first = pre;
+  t->_old_end = num_old - suf;
+  t->_new_end = num_new - suf;
+  *p_first = pre;
+  *p_num_lexed = num_new - suf - pre;
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: the symbol phase of an update; recounts the addresses of the lines from 'first' and rebuilds the symbol 
+ *  library from the line table, in the same order, and with the same errors, as 'parse_symbols'.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int update_symbols(Assembler_t* p, uint32_t first){
+  struct LineTable* t = p->_p_lines;
+  uint32_t address = (first > 0) ? t->_p_lines[first - 1]._address + address_step(&t->_p_lines[first - 1]) : 0;
+  for(uint32_t i = first; i < t->_num_lines; ++i){
+    t->_p_lines[i]._address = address;
+    address += address_step(&t->_p_lines[i]);
+  }
+
+  if(add_predefined_symbols(p) != SUCCESS){
+    return FAIL;
+  }
+
+  // add all labels...
+  for(uint32_t i = 0; i < t->_num_lines; ++i){
+    const Line_t* p_line = &t->_p_lines[i];
+    if(p_line->_state == LINE_BLANK){
+      continue;
+    }
+    next_line(p);
+    if(p_line->_state == LINE_COMMAND && p_line->_cmd._type == CFORMAT_L0){
+      VERBOSE2("found label symbol '%s', adding to symbol library...\n", p_line->_cmd._sym);
+      if(symlib_add_symbol(p->_p_sym_lib, p_line->_cmd._sym, (uint16_t)p_line->_address, SYMTAG_LABEL) != SUCCESS){
+        fprintf(diag_stream(), "multiple declerations of label %s - labels must be unique\n", p_line->_cmd._sym);
+        p->_fail = FAIL; 
+      }
+    }
+    else{
+      next_instruction(p);
+    }
+  }
+
+  // ...then all variables.
+  for(uint32_t i = 0; i < t->_num_lines; ++i){
+    const Line_t* p_line = &t->_p_lines[i];
+    if(p_line->_state != LINE_COMMAND || p_line->_cmd._type != CFORMAT_A0){
+      continue;
+    }
+    uint16_t add;
+    if(symlib_search_symbol(p->_p_sym_lib, p_line->_cmd._sym, &add) != SUCCESS){
+      VERBOSE2("found variable symbol '%s', adding to symbol library...\n", p_line->_cmd._sym);
+      if(symlib_add_symbol(p->_p_sym_lib, p_line->_cmd._sym, (uint16_t)p->_ram_address, SYMTAG_VARIABLE) != SUCCESS){
+        fprintf(diag_stream(), "fatal error: out of memory\n");
+        return p->_fail = FAIL;
+      }
+      next_ram(p);
+    }
+  }
+  return p->_fail;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: the encoding phase of an update; fills the command and instruction arrays from the line table, encoding
+ *  only lines not yet encoded and A commands whose symbol address moved.
+ * return: SUCCESS, or FAIL on malloc error.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int update_hackins(Assembler_t* p, uint32_t* p_num_encoded){
+  struct LineTable* t = p->_p_lines;
+  if(reserve_arrays(p, p->_line_count) != SUCCESS){
+    fprintf(diag_stream(), "fatal error: out of memory\n");
+    return p->_fail = FAIL;
+  }
+  uint32_t cn = 0, in = 0, num_encoded = 0;
+  for(uint32_t i = 0; i < t->_num_lines; ++i){
+    Line_t* p_line = &t->_p_lines[i];
+    if(p_line->_state != LINE_COMMAND){
+      continue;
+    }
+    Command_t* c = &p->_p_cmds[cn++];
+    *c = p_line->_cmd;
+    c->_lineno = i + 1; // the line may have moved since it was lexed.
+    if(c->_type == CFORMAT_A0){
+      uint16_t add;
+      if(symlib_search_symbol(p->_p_sym_lib, c->_sym, &add) != SUCCESS){
+        fprintf(diag_stream(), "fatal error: line %" PRIu32 ": symbol %s was never added to the library\n", 
+                c->_lineno, c->_sym);
+        return p->_fail = FAIL;
+      }
+      c->_type = CFORMAT_A1;
+      c->_value = add;
+      p_line->_is_encoded &= (p_line->_word == (add & 0x7FFF)); // the target moved.
+    }
+    int type = c->_type;
+    if(type == CFORMAT_A1 || type == CFORMAT_C0 || type == CFORMAT_C1 || type == CFORMAT_C2){
+      if(!p_line->_is_encoded){
+        decode(c, &p_line->_word);
+        p_line->_is_encoded = true;
+        ++num_encoded;
+      }
+      p->_p_hackins[in++] = p_line->_word;
+    }
+  }
+  p->_ins_count = in;
+  *p_num_encoded = num_encoded;
+  return map_sources(p);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: reports the errors of all lines that failed to lex; lines of the old version are lexed again to report.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int report_line_errors(Assembler_t* p, const Slice_t* p_slices){
+  struct LineTable* t = p->_p_lines;
+  for(uint32_t i = 0; i < t->_num_lines; ++i){
+    if(t->_p_lines[i]._state == LINE_ERROR){
+      Command_t cmd;
+      parser_lex_line(p->_p_parser, p_slices[i]._p, p_slices[i]._n, i + 1, &cmd, false);
+      p->_fail = FAIL;
+    }
+  }
+  return p->_fail;
+}
+
+/*=====================================================================================================================
+ * PUBLIC INTERFACE
+ *===================================================================================================================*/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+Assembler_t* new_assembler(bool is_verbose){
+  Assembler_t* p = (Assembler_t*)calloc(1, sizeof(Assembler_t));
+  if(p == NULL){
+    return NULL;
+  }
+  if(new_symlib(&p->_p_sym_lib) != SUCCESS){
+    free(p);
+    return NULL;
+  }
+  if((p->_p_srcmap = new_srcmap()) == NULL){
+    free_symlib(&p->_p_sym_lib);
+    free(p);
+    return NULL;
+  }
+  p->_ram_address = RAM_START_ADDRESS;
+  p->_fail = SUCCESS;
+  p->_is_verbose = is_verbose;
+  init_decoder();
+  init_optimizer();
+  return p;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void free_assembler(Assembler_t** pp_asm){
+  Assembler_t* p = *pp_asm;
+  if(p->_p_sym_lib){
+    free_symlib(&p->_p_sym_lib); 
+  }
+  if(p->_p_parser){
+    free_parser(&p->_p_parser);
+  }
+  if(p->_p_lines){
+    free(p->_p_lines->_p_lines);
+    free(p->_p_lines);
+  }
+  if(p->_p_srcmap){
+    free_srcmap(&p->_p_srcmap);
+  }
+  free(p->_p_opt);
+  free(p->_p_cmds);
+  free(p->_p_hackins);
+  free(p);
+  (*pp_asm) = NULL;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int assembler_reset(Assembler_t* p){
+  if(p->_p_parser){
+    free_parser(&p->_p_parser);
+  }
+  p->_line_count = p->_ins_count = 0;
+  p->_ram_address = RAM_START_ADDRESS;
+  p->_fail = SUCCESS;
+  return (symlib_clear(p->_p_sym_lib) == SUCCESS) ? SUCCESS : FAIL;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int assembler_assemble(Assembler_t* p, const char* ifpath){
+  if(open_parser(p, ifpath, NULL, 0) != SUCCESS){
+    return FAIL;
+  }
+  return assemble(p, ifpath);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int assembler_assemble_buffer(Assembler_t* p, const char* name, const char* src, size_t n){
+  if(open_parser(p, name, src, n) != SUCCESS){
+    return FAIL;
+  }
+  return assemble(p, name);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int assembler_compile(Assembler_t* p, const char* ifpath){
+  if(open_parser(p, ifpath, NULL, 0) != SUCCESS){
+    return FAIL;
+  }
+  return compile(p, ifpath);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int assembler_reserve(Assembler_t* p, uint32_t n){
+  return reserve_arrays(p, n);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * note: the phases, and the errors they report, are those of 'assembler_assemble'; only the work is incremental.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int assembler_update(Assembler_t* p, const char* ifpath, uint32_t* p_num_lexed, uint32_t* p_num_encoded){
+  *p_num_lexed = *p_num_encoded = 0;
+  if(p->_p_lines == NULL && (p->_p_lines = (struct LineTable*)calloc(1, sizeof(struct LineTable))) == NULL){
+    fprintf(diag_stream(), "fatal error: out of memory\n");
+    return FAIL;
+  }
+  struct LineTable* t = p->_p_lines;
+  t->_first = t->_old_end = t->_new_end = t->_num_lines; // no lines changed, unless the file is read.
+  if(assembler_reset(p) != SUCCESS || open_parser(p, ifpath, NULL, 0) != SUCCESS){
+    return FAIL;
+  }
+
+  uint32_t num_lines, first;
+  Slice_t* p_slices = slice_lines(p, &num_lines);
+  if(p_slices == NULL || diff_lines(p, p_slices, num_lines, &first, p_num_lexed) != SUCCESS){
+    fprintf(diag_stream(), "fatal error: out of memory\n");
+    free(p_slices);
+    return p->_fail = FAIL;
+  }
+  VERBOSE2("updating symbols from line %" PRIu32 "...\n", first + 1);
+  if(update_symbols(p, first) != SUCCESS){
+    VERBOSE("terminating assembly: symbol errors occured\n");
+  }
+  else if(report_line_errors(p, p_slices) != SUCCESS){
+    VERBOSE("terminating assembly: assembly command errors occured\n");
+  }
+  else{
+    update_hackins(p, p_num_encoded);
+  }
+  free(p_slices);
+  free_parser(&p->_p_parser); // the line table holds all that is needed; do not keep the file mapped.
+  return p->_fail;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+uint32_t assembler_map_line(const Assembler_t* p, uint32_t line){
+  const struct LineTable* t = p->_p_lines;
+  if(t == NULL || line == 0 || line - 1 < t->_first){
+    return line;
+  }
+  return (line - 1 >= t->_old_end) ? line - t->_old_end + t->_new_end : 0;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int assembler_strip(Assembler_t* p, const char* ifpath, struct OutBuf* p_out){
+  if(open_parser(p, ifpath, NULL, 0) != SUCCESS){
+    return FAIL;
+  }
+  return strip(p, ifpath, p_out);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int assembler_strip_buffer(Assembler_t* p, const char* name, const char* src, size_t n, struct OutBuf* p_out){
+  if(open_parser(p, name, src, n) != SUCCESS){
+    return FAIL;
+  }
+  return strip(p, name, p_out);
+}
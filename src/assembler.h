@@ -0,0 +1,200 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: assembler.h
+ *
+ *===================================================================================================================*/
+
+
+#ifndef _ASSEMBLER_H_
+#define _ASSEMBLER_H_
+
+#include <stddef.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include "parser.h"
+
+#define MAX_ADDRESS 32768        // RAM and ROM on the Hack platform are both 15-bit addressed 32K memory.
+#define RAM_START_ADDRESS 1024
+#define ASSEMBLER_VERSION 0x0200 // major.minor in the high.low bytes; bump when the output changes, it keys caches.
+
+struct SymLib;
+struct OutBuf;
+struct LineTable;
+struct SrcMap;
+struct OptReport;
+
+/*
+ * brief: the assembler front end; the state of assembling one translation unit.
+ *
+ * @member _p_sym_lib: library of predefined and user defined symbols.
+ * @member _p_parser: parser of the translation unit being assembled.
+ * @member _line_count: number of non-whitespace/comment lines in the translation unit.
+ * @member _ins_count: number of instructions to generate (= num_line - num_L_commands).
+ * @member _ram_address: the next ram address to store a new variable.
+ * @member _p_cmds: array of _line_count commands parsed from the lines; A command symbols are substituted.
+ * @member _p_hackins: array of _ins_count hack machine instructions.
+ * @member _capacity: number of commands (and instructions) the arrays can hold; the arrays are kept on reset.
+ * @member _p_lines: resident table of the lines of the translation unit kept by 'assembler_update', else NULL.
+ * @member _p_srcmap: source map of the instructions; their lines, and the labels they follow (see srcmap.h).
+ * @member _opt_level: 0, or 1 to optimise the commands of 'assembler_assemble' before they are encoded.
+ * @member _p_opt: what the optimiser saved in the last assembly if _opt_level > 0, else NULL (see optimize.h).
+ * @member _p_line_cycles: cycles a profile spent at each line, by line, to guide the optimiser; else NULL (borrowed).
+ * @member _num_line_cycles: number of lines of _p_line_cycles, including the unused line 0.
+ * @member _fail: FAIL if assembly failed, else SUCCESS.
+ * @member _is_verbose: flag to control verbose output.
+ *
+ * note: after a successful 'assembler_assemble' the back ends may read, but must not modify, the members; the
+ *  command and instruction arrays are final.
+ */
+typedef struct Assembler {
+  struct SymLib* _p_sym_lib;
+  Parser_t* _p_parser;
+  uint32_t _line_count;
+  uint32_t _ins_count;
+  uint32_t _ram_address;
+  Command_t* _p_cmds;
+  uint16_t* _p_hackins;
+  uint32_t _capacity;
+  struct LineTable* _p_lines;
+  struct SrcMap* _p_srcmap;
+  uint8_t _opt_level;
+  struct OptReport* _p_opt;
+  const uint64_t* _p_line_cycles;
+  uint32_t _num_line_cycles;
+  int _fail;
+  bool _is_verbose;
+} Assembler_t;
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: instantiates a new assembler.
+ * return: pointer to the new assembler or NULL on error.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+Assembler_t* new_assembler(bool is_verbose);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void free_assembler(Assembler_t** pp_asm);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: readies an assembler for the next translation unit; keeps the memory of the symbol library and arrays.
+ * return: SUCCESS, or FAIL on malloc error.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int assembler_reset(Assembler_t* p);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: assembles a .asm file into the command and instruction arrays of the assembler.
+ * return: SUCCESS, or FAIL if the file could not be read or contains errors; errors are reported to the diagnostic
+ *  stream (see diag.h).
+ * note: an assembler assembles a single translation unit; call 'assembler_reset' before assembling another.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int assembler_assemble(Assembler_t* p, const char* ifpath);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: as 'assembler_assemble', but of a translation unit already in memory.
+ * @param name: name of the translation unit, used in error messages.
+ * @param src: the translation unit; must outlive the assembly.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int assembler_assemble_buffer(Assembler_t* p, const char* name, const char* src, size_t n);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: compiles a .asm file for separate assembly (see object.h); parses the labels and commands of the file but
+ *  leaves '@' symbols the file does not declare unresolved, and allocates no variables.
+ * return: SUCCESS, or FAIL if the file could not be read or contains errors; errors are reported to the diagnostic
+ *  stream (see diag.h).
+ * note: the symbol library holds only the predefined symbols and labels, and '@<symbol>' commands are not
+ *  substituted; write the object with 'object_write'.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int assembler_compile(Assembler_t* p, const char* ifpath);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: grows the command and instruction arrays, if required, to hold 'n' commands; used by the linker to lay
+ *  out the instructions of the objects it links.
+ * return: SUCCESS, or FAIL on malloc error.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int assembler_reserve(Assembler_t* p, uint32_t n);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: assembles a .asm file incrementally; as 'assembler_assemble', but repeatable on the same assembler as the
+ *  file changes. The lines of the previous update are kept, and only the lines that differ from them are lexed again;
+ *  instruction addresses are recounted from the first differing line, and only changed commands and A commands 
+ *  whose symbol address moved are encoded again.
+ * @param <out> p_num_lexed: number of lines lexed by this update.
+ * @param <out> p_num_encoded: number of instructions encoded by this update.
+ * return: SUCCESS, or FAIL if the file could not be read or contains errors; errors are reported to the diagnostic
+ *  stream (see diag.h).
+ * note: do not mix with 'assembler_assemble' on the same assembler.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int assembler_update(Assembler_t* p, const char* ifpath, uint32_t* p_num_lexed, uint32_t* p_num_encoded);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: maps a line of the translation unit before the last 'assembler_update' to the same line after it.
+ * return: the line, counted from 1; or 0 if the update changed or removed it.
+ *
+ * note: the lines before the first changed line, and after the last, are unchanged; those after may have moved.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+uint32_t assembler_map_line(const Assembler_t* p, uint32_t line);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: strips a .asm file of whitespace, comments, L commands and symbols in a single streaming pass; does not
+ *  build the command or instruction arrays.
+ * @param <out> p_out: buffer to append the stripped assembly to.
+ * return: SUCCESS, or FAIL if the file could not be read or contains errors; errors are reported to the diagnostic
+ *  stream (see diag.h).
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int assembler_strip(Assembler_t* p, const char* ifpath, struct OutBuf* p_out);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: as 'assembler_strip', but of a translation unit already in memory.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int assembler_strip_buffer(Assembler_t* p, const char* name, const char* src, size_t n, struct OutBuf* p_out);
+
+#endif
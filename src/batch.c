@@ -0,0 +1,389 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: batch.c
+ *
+ *===================================================================================================================*/
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "batch.h"
+#include "sim.h"
+#include "assembler.h"
+#include "asmerr.h"
+
+#define ADDRESS_MASK 0x7fff
+#define MAX_CHUNK 0xffff // most steps between updates of the cycle counts; the count of a chunk is 16-bit.
+
+/*
+ * the run of a group is compiled for AVX2, with a fallback for other hosts chosen at load time; the vectors are GCC
+ * vector extensions, so the fallback is the same code on narrower vectors.
+ */
+#if defined(__x86_64__) && defined(__linux__)
+#define TARGET_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define TARGET_CLONES
+#endif
+#define INLINE static inline __attribute__((always_inline)) // so the vector ABI, which differs by target, is unused.
+
+/*
+ * brief: the Hack words of the lanes of a group; a mask is all ones in the lanes it selects.
+ */
+typedef uint16_t Lanes_t __attribute__((vector_size(BATCH_LANES * sizeof(uint16_t))));
+typedef int16_t SignedLanes_t __attribute__((vector_size(BATCH_LANES * sizeof(uint16_t))));
+
+/*
+ * brief: a group of instances run in lockstep.
+ *
+ * @member _p_ram: the RAM of the lanes, interleaved; word w of lane l is at w * BATCH_LANES + l, so a word of all lanes
+ *  at the same address is one vector.
+ * @member _num_lanes: lanes of the group in use; the last group of a batch may be part full.
+ */
+typedef struct Group {
+  uint16_t* _p_ram;
+  uint16_t _a[BATCH_LANES];
+  uint16_t _d[BATCH_LANES];
+  uint16_t _pc[BATCH_LANES];
+  uint8_t _status[BATCH_LANES];
+  uint64_t _cycles[BATCH_LANES];
+  uint32_t _num_lanes;
+} Group_t;
+
+struct Batch {
+  const SimOp_t* _p_ops;
+  Group_t* _p_groups;
+  uint32_t _num_groups;
+  uint32_t _num_lanes;
+};
+
+/*=====================================================================================================================
+ * PRIVATE INTERFACE
+ *===================================================================================================================*/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+INLINE bool is_none(Lanes_t v){
+  uint64_t q[sizeof(Lanes_t) / sizeof(uint64_t)];
+  memcpy(q, &v, sizeof(q));
+  uint64_t any = 0;
+  for(size_t i = 0; i < sizeof(q) / sizeof(uint64_t); ++i){
+    any |= q[i];
+  }
+  return any == 0;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+INLINE Lanes_t blend(Lanes_t mask, Lanes_t x, Lanes_t y){
+  return (x & mask) | (y & ~mask);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: the lowest word of the lanes of a mask, 0xffff if none.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+INLINE uint16_t min_lane(Lanes_t v, Lanes_t mask){
+  static const Lanes_t rotations[4] = {
+    {8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7},
+    {4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3},
+    {2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 0, 1},
+    {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 0}
+  };
+  v |= ~mask;
+  for(int r = 0; r < 4; ++r){
+    Lanes_t rotated = __builtin_shuffle(v, rotations[r]);
+    v = blend((Lanes_t)(rotated < v), rotated, v);
+  }
+  return v[0];
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: reads M of the lanes of a mask; one load if they share an address, e.g. '@R0', else a word per lane.
+ * @param lead: a lane of the mask.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+INLINE Lanes_t load_m(const uint16_t* p_ram, Lanes_t address, Lanes_t mask, int lead){
+  Lanes_t m = {0};
+  if(is_none((address ^ address[lead]) & mask)){
+    memcpy(&m, p_ram + (size_t)address[lead] * BATCH_LANES, sizeof(Lanes_t));
+    return m;
+  }
+  for(int l = 0; l < BATCH_LANES; ++l){
+    m[l] = mask[l] ? p_ram[(size_t)address[l] * BATCH_LANES + l] : 0;
+  }
+  return m;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+INLINE void store_m(uint16_t* p_ram, Lanes_t address, Lanes_t mask, int lead, Lanes_t v){
+  if(is_none((address ^ address[lead]) & mask)){
+    Lanes_t m;
+    uint16_t* p_word = p_ram + (size_t)address[lead] * BATCH_LANES;
+    memcpy(&m, p_word, sizeof(Lanes_t));
+    m = blend(mask, v, m);
+    memcpy(p_word, &m, sizeof(Lanes_t));
+    return;
+  }
+  for(int l = 0; l < BATCH_LANES; ++l){
+    if(mask[l]){
+      p_ram[(size_t)address[l] * BATCH_LANES + l] = v[l];
+    }
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: the lanes whose value 'v' meets the condition of a jump, by its j bits.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+INLINE Lanes_t jump_condition(uint8_t jump, Lanes_t v){
+  SignedLanes_t s = (SignedLanes_t)v, zero = {0};
+  switch(jump){
+    case 1: return (Lanes_t)(s > zero);
+    case 2: return (Lanes_t)(s == zero);
+    case 3: return (Lanes_t)(s >= zero);
+    case 4: return (Lanes_t)(s < zero);
+    case 5: return (Lanes_t)(s != zero);
+    case 6: return (Lanes_t)(s <= zero);
+    default: return ~(Lanes_t){0};
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: stops the lanes of a mask with a status.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+INLINE void stop_lanes(Group_t* p_group, Lanes_t mask, uint8_t status){
+  for(int l = 0; l < BATCH_LANES; ++l){
+    if(mask[l]){
+      p_group->_status[l] = status;
+    }
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: runs a group until all its lanes stop; see 'batch_run'.
+ *
+ * note: the run is split in chunks of steps no longer than the cycles any lane has left, so no lane can pass its
+ *  limit within a chunk, and the cycle counts and limits are only updated between chunks.
+ * note: while all lanes run the same instruction, the next is known to be the one after it until a jump; else the
+ *  lowest instruction of the lanes is found with a reduction of the pc vector.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+TARGET_CLONES
+static void run_group(Group_t* p_group, const SimOp_t* p_ops, uint64_t max_cycles){
+  uint64_t budget = (max_cycles == 0) ? UINT64_MAX : max_cycles;
+  uint64_t used[BATCH_LANES] = {0};
+  Lanes_t a, d, pc, running = {0};
+  memcpy(&a, p_group->_a, sizeof(Lanes_t));
+  memcpy(&d, p_group->_d, sizeof(Lanes_t));
+  memcpy(&pc, p_group->_pc, sizeof(Lanes_t));
+  for(uint32_t l = 0; l < p_group->_num_lanes; ++l){
+    running[l] = (p_group->_status[l] == 0 || p_group->_status[l] == SIM_LIMIT) ? 0xffff : 0;
+  }
+
+  while(!is_none(running)){
+    uint64_t chunk = MAX_CHUNK;
+    int lead = -1;
+    for(int l = 0; l < BATCH_LANES; ++l){
+      if(running[l]){
+        uint64_t left = budget - used[l];
+        chunk = (left < chunk) ? left : chunk;
+        lead = (lead < 0) ? l : lead;
+      }
+    }
+
+    Lanes_t ran = {0};
+    bool is_next_known = false;
+    uint16_t cur = 0;
+    for(uint64_t step = 0; step < chunk; ++step){
+      cur = is_next_known ? cur + 1 : min_lane(pc, running);
+      const SimOp_t* op = &p_ops[cur];
+      if(op->_op == SIMOP_END){ // the lowest lane is past the end, so all are.
+        stop_lanes(p_group, running, SIM_ENDED);
+        running = (Lanes_t){0};
+        break;
+      }
+      Lanes_t mask = running & (Lanes_t)(pc == cur);
+      bool is_converged = is_none(mask ^ running);
+      int lane = lead;
+      if(!is_converged){
+        for(lane = 0; !mask[lane]; ++lane){}
+      }
+      ran -= mask;
+      pc -= mask;
+      is_next_known = is_converged;
+
+      if(op->_op == SIMOP_LOAD){
+        Lanes_t value = {0};
+        value += op->_value;
+        a = blend(mask, value, a);
+        continue;
+      }
+      // the ALU, by the zx, nx, zy, ny, f and no bits...
+      uint8_t bits = (uint8_t)op->_value;
+      Lanes_t address = a & ADDRESS_MASK, zero = {0};
+      Lanes_t x = (bits & 0x20) ? zero : d;
+      Lanes_t y = (bits & 0x40) ? load_m(p_group->_p_ram, address, mask, lane) : a;
+      x = (bits & 0x10) ? ~x : x;
+      y = (bits & 0x08) ? zero : y;
+      y = (bits & 0x04) ? ~y : y;
+      Lanes_t v = (bits & 0x02) ? x + y : x & y;
+      v = (bits & 0x01) ? ~v : v;
+
+      if(op->_dest & 0x1){
+        store_m(p_group->_p_ram, address, mask, lane, v);
+      }
+      if(op->_dest & 0x2){
+        d = blend(mask, v, d);
+      }
+      if(op->_dest & 0x4){
+        a = blend(mask, v, a);
+      }
+      if(op->_jump == 0){
+        continue;
+      }
+      Lanes_t taken = mask & jump_condition(op->_jump, v);
+      if(is_none(taken)){
+        continue;
+      }
+      pc = blend(taken, address, pc);
+      is_next_known = false;
+      if(op->_flags != 0){
+        Lanes_t halted = (Lanes_t)(address == cur);
+        if(op->_flags & SIMFLAG_AFTER_LOAD){
+          halted |= (Lanes_t)(address == (uint16_t)(cur - 1));
+        }
+        halted &= taken;
+        if(!is_none(halted)){
+          stop_lanes(p_group, halted, SIM_HALTED);
+          running &= ~halted;
+          for(lead = 0; lead < BATCH_LANES && !running[lead]; ++lead){}
+          if(is_none(running)){
+            break;
+          }
+        }
+      }
+    }
+
+    for(int l = 0; l < BATCH_LANES; ++l){
+      p_group->_cycles[l] += ran[l];
+      used[l] += ran[l];
+      if(running[l] && used[l] == budget){
+        p_group->_status[l] = SIM_LIMIT;
+        running[l] = 0;
+      }
+    }
+  }
+  memcpy(p_group->_a, &a, sizeof(Lanes_t));
+  memcpy(p_group->_d, &d, sizeof(Lanes_t));
+  memcpy(p_group->_pc, &pc, sizeof(Lanes_t));
+}
+
+/*=====================================================================================================================
+ * PUBLIC INTERFACE
+ *===================================================================================================================*/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+Batch_t* new_batch(const Sim_t* p_sim, uint32_t num_lanes){
+  Batch_t* p_batch = (Batch_t*)calloc(1, sizeof(Batch_t));
+  if(p_batch == NULL){
+    return NULL;
+  }
+  p_batch->_p_ops = p_sim->_p_ops;
+  p_batch->_num_lanes = num_lanes;
+  p_batch->_num_groups = (num_lanes + BATCH_LANES - 1) / BATCH_LANES;
+  p_batch->_p_groups = (Group_t*)calloc(p_batch->_num_groups, sizeof(Group_t));
+  if(p_batch->_p_groups == NULL){
+    free_batch(&p_batch);
+    return NULL;
+  }
+  for(uint32_t g = 0; g < p_batch->_num_groups; ++g){
+    Group_t* p_group = &p_batch->_p_groups[g];
+    p_group->_num_lanes = (num_lanes - g * BATCH_LANES < BATCH_LANES) ? num_lanes - g * BATCH_LANES : BATCH_LANES;
+    p_group->_p_ram = (uint16_t*)calloc((size_t)MAX_ADDRESS * BATCH_LANES, sizeof(uint16_t));
+    if(p_group->_p_ram == NULL){
+      free_batch(&p_batch);
+      return NULL;
+    }
+  }
+  return p_batch;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void free_batch(Batch_t** pp_batch){
+  for(uint32_t g = 0; (*pp_batch)->_p_groups != NULL && g < (*pp_batch)->_num_groups; ++g){
+    free((*pp_batch)->_p_groups[g]._p_ram);
+  }
+  free((*pp_batch)->_p_groups);
+  free(*pp_batch);
+  (*pp_batch) = NULL;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void batch_poke(Batch_t* p_batch, uint32_t lane, uint16_t address, uint16_t value){
+  Group_t* p_group = &p_batch->_p_groups[lane / BATCH_LANES];
+  p_group->_p_ram[(size_t)(address & ADDRESS_MASK) * BATCH_LANES + lane % BATCH_LANES] = value;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+uint16_t batch_peek(const Batch_t* p_batch, uint32_t lane, uint16_t address){
+  const Group_t* p_group = &p_batch->_p_groups[lane / BATCH_LANES];
+  return p_group->_p_ram[(size_t)(address & ADDRESS_MASK) * BATCH_LANES + lane % BATCH_LANES];
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void batch_dump(const Batch_t* p_batch, uint32_t lane, uint16_t* p_ram){
+  const uint16_t* p_lane = p_batch->_p_groups[lane / BATCH_LANES]._p_ram + lane % BATCH_LANES;
+  for(uint32_t w = 0; w < MAX_ADDRESS; ++w){
+    p_ram[w] = p_lane[(size_t)w * BATCH_LANES];
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void batch_run(Batch_t* p_batch, uint64_t max_cycles){
+  for(uint32_t g = 0; g < p_batch->_num_groups; ++g){
+    run_group(&p_batch->_p_groups[g], p_batch->_p_ops, max_cycles);
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+BatchLane_t batch_lane(const Batch_t* p_batch, uint32_t lane){
+  const Group_t* p_group = &p_batch->_p_groups[lane / BATCH_LANES];
+  uint32_t l = lane % BATCH_LANES;
+  return (BatchLane_t){p_group->_a[l], p_group->_d[l], p_group->_pc[l], p_group->_status[l], p_group->_cycles[l]};
+}
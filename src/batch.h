@@ -0,0 +1,108 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: batch.h
+ *
+ *===================================================================================================================*/
+
+
+#ifndef _BATCH_H_
+#define _BATCH_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sim.h"
+
+#define BATCH_LANES 16 // instances run in lockstep by a group; the Hack words of a 256-bit vector.
+
+/*
+ * brief: closed type of a batch of instances of one program; instantiate with 'new_batch'.
+ */
+typedef struct Batch Batch_t;
+
+/*
+ * brief: the state an instance stopped in.
+ *
+ * @member _status: SIM_HALTED, SIM_ENDED or SIM_LIMIT, as returned by 'sim_run'; 0 before a run.
+ */
+typedef struct BatchLane {
+  uint16_t _a;
+  uint16_t _d;
+  uint16_t _pc;
+  uint8_t _status;
+  uint64_t _cycles;
+} BatchLane_t;
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: instantiates a batch of instances of the program loaded in a simulator, each from reset.
+ * @param p_sim: the simulator holding the predecoded program; borrowed, it must outlive the batch.
+ * @param num_lanes: the number of instances.
+ * return: pointer to the new batch or NULL on error.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+Batch_t* new_batch(const Sim_t* p_sim, uint32_t num_lanes);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void free_batch(Batch_t** pp_batch);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: reads and writes the RAM of an instance, e.g. to set the inputs of a test vector before a run.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+void batch_poke(Batch_t* p_batch, uint32_t lane, uint16_t address, uint16_t value);
+uint16_t batch_peek(const Batch_t* p_batch, uint32_t lane, uint16_t address);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: copies the MAX_ADDRESS words of RAM of an instance to 'p_ram'.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+void batch_dump(const Batch_t* p_batch, uint32_t lane, uint16_t* p_ram);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: runs every instance until it halts, ends or has run 'max_cycles' instructions; 0 for no limit. Instances
+ *  that reached the limit of an earlier run continue.
+ *
+ * note: each group of BATCH_LANES instances runs in lockstep, one instruction for all lanes at that instruction per
+ *  step; lanes at other instructions wait, masked out, and the lowest instruction runs next so diverged lanes meet
+ *  again. Each instance stops in the state, and with the status and cycles, that 'sim_run' would stop it in.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+void batch_run(Batch_t* p_batch, uint64_t max_cycles);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+BatchLane_t batch_lane(const Batch_t* p_batch, uint32_t lane);
+
+#endif
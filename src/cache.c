@@ -0,0 +1,277 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: cache.c
+ *
+ *===================================================================================================================*/
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "cache.h"
+#include "outbuf.h"
+#include "outfile.h"
+#include "hash.h"
+#include "assembler.h"
+#include "asmerr.h"
+
+#define KEY_DIGITS 16                  /* an entry file name is its key as 16 hex digits. */
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * SEE HEADER
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+struct Cache {
+  char* _dir;                   /* path of the cache directory. */
+  uint64_t _max_bytes;          /* size limit of the cache. */
+  CacheStats_t _stats;
+  pthread_mutex_t _lock;        /* guards _stats. */
+};
+
+/*
+ * brief: an entry found by 'cache_evict'.
+ */
+typedef struct Entry {
+  char _name[KEY_DIGITS + 1];
+  uint64_t _size;
+  struct timespec _mtime;
+} Entry_t;
+
+/*=====================================================================================================================
+ * PRIVATE HELPERS  
+ *===================================================================================================================*/
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void entry_path(const Cache_t* p_cache, uint64_t key, char* path, size_t n){
+  snprintf(path, n, "%s/%016" PRIx64, p_cache->_dir, key);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static bool is_entry_name(const char* name){
+  for(int i = 0; i < KEY_DIGITS; ++i){
+    char c = name[i];
+    if(!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))){
+      return false;
+    }
+  }
+  return name[KEY_DIGITS] == '\0';
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int compare_mtime(const void* p_a, const void* p_b){
+  const struct timespec* a = &((const Entry_t*)p_a)->_mtime;
+  const struct timespec* b = &((const Entry_t*)p_b)->_mtime;
+  if(a->tv_sec != b->tv_sec){
+    return (a->tv_sec < b->tv_sec) ? -1 : 1;
+  }
+  return (a->tv_nsec < b->tv_nsec) ? -1 : (a->tv_nsec > b->tv_nsec);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void count(Cache_t* p_cache, uint32_t* p_counter){
+  pthread_mutex_lock(&p_cache->_lock);
+  ++(*p_counter);
+  pthread_mutex_unlock(&p_cache->_lock);
+}
+
+/*=====================================================================================================================
+ * PUBLIC INTERFACE 
+ *===================================================================================================================*/
+/*-------------------------------------------------------------------------------------------------------------------*/
+Cache_t* new_cache(const char* dir, uint64_t max_bytes){
+  if(mkdir(dir, 0777) != 0 && errno != EEXIST){
+    perror(dir);
+    return NULL;
+  }
+  Cache_t* p_cache = (Cache_t*)calloc(1, sizeof(Cache_t));
+  if(p_cache == NULL || (p_cache->_dir = strdup(dir)) == NULL){
+    fprintf(stderr, "fatal error: out of memory\n");
+    free(p_cache);
+    return NULL;
+  }
+  p_cache->_max_bytes = max_bytes;
+  pthread_mutex_init(&p_cache->_lock, NULL);
+  return p_cache;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void free_cache(Cache_t** pp_cache){
+  pthread_mutex_destroy(&(*pp_cache)->_lock);
+  free((*pp_cache)->_dir);
+  free(*pp_cache);
+  *pp_cache = NULL;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int cache_key_file(const char* ifpath, uint32_t format, uint64_t* p_key){
+  int fd = open(ifpath, O_RDONLY);
+  struct stat st;
+  if(fd < 0 || fstat(fd, &st) != 0){
+    perror(ifpath);
+    if(fd >= 0){
+      close(fd);
+    }
+    return FAIL;
+  }
+
+  // the version and format seed the hash of the source, so changing either changes every key...
+  uint32_t seed_data[2] = {ASSEMBLER_VERSION, format};
+  uint64_t seed = hash_xxh64(seed_data, sizeof(seed_data), 0);
+  size_t n = (size_t)st.st_size;
+  if(n == 0){
+    *p_key = hash_xxh64(NULL, 0, seed);
+    close(fd);
+    return SUCCESS;
+  }
+  void* p_src = mmap(NULL, n, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if(p_src == MAP_FAILED){
+    perror(ifpath);
+    return FAIL;
+  }
+  *p_key = hash_xxh64(p_src, n, seed);
+  munmap(p_src, n);
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int cache_fetch(Cache_t* p_cache, uint64_t key, struct OutBuf* p_out){
+  char path[PATH_MAX];
+  entry_path(p_cache, key, path, sizeof(path));
+  int fd = open(path, O_RDONLY);
+  struct stat st;
+  if(fd < 0 || fstat(fd, &st) != 0 || outbuf_reserve(p_out, (size_t)st.st_size) != SUCCESS){
+    if(fd >= 0){
+      close(fd);
+    }
+    count(p_cache, &p_cache->_stats._misses);
+    return ERROR_1;
+  }
+
+  // read the whole entry; a short read means the entry was evicted under us, which is a miss...
+  size_t n = (size_t)st.st_size, got = 0;
+  ssize_t r = 0;
+  while(got < n && (r = read(fd, p_out->_p_data + p_out->_size + got, n - got)) > 0){
+    got += (size_t)r;
+  }
+  futimens(fd, NULL); // mark the entry recently used.
+  close(fd);
+  if(got != n){
+    count(p_cache, &p_cache->_stats._misses);
+    return ERROR_1;
+  }
+  p_out->_size += n;
+  count(p_cache, &p_cache->_stats._hits);
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void cache_store(Cache_t* p_cache, uint64_t key, struct OutBuf* p_buf){
+  char path[PATH_MAX];
+  entry_path(p_cache, key, path, sizeof(path));
+  if(outfile_commit(p_buf, path, false, NULL) != SUCCESS){
+    fprintf(stderr, "warning: failed to add '%s' to the cache\n", path);
+    return;
+  }
+  count(p_cache, &p_cache->_stats._stores);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void cache_evict(Cache_t* p_cache){
+  DIR* p_dir = opendir(p_cache->_dir);
+  if(p_dir == NULL){
+    perror(p_cache->_dir);
+    return;
+  }
+
+  // collect the entries and their total size...
+  Entry_t* p_entries = NULL;
+  size_t num_entries = 0, capacity = 0;
+  uint64_t total = 0;
+  struct dirent* p_dirent;
+  while((p_dirent = readdir(p_dir)) != NULL){
+    if(!is_entry_name(p_dirent->d_name)){
+      continue;
+    }
+    struct stat st;
+    if(fstatat(dirfd(p_dir), p_dirent->d_name, &st, 0) != 0 || !S_ISREG(st.st_mode)){
+      continue;
+    }
+    if(num_entries == capacity){
+      capacity = (capacity == 0) ? 64 : capacity * 2;
+      Entry_t* p_grown = (Entry_t*)realloc(p_entries, capacity * sizeof(Entry_t));
+      if(p_grown == NULL){
+        break; // evict what we have seen so far.
+      }
+      p_entries = p_grown;
+    }
+    Entry_t* p_entry = &p_entries[num_entries++];
+    memcpy(p_entry->_name, p_dirent->d_name, KEY_DIGITS + 1);
+    p_entry->_size = (uint64_t)st.st_size;
+    p_entry->_mtime = st.st_mtim;
+    total += p_entry->_size;
+  }
+
+  // ...and remove the least recently used until within the limit.
+  if(total > p_cache->_max_bytes){
+    qsort(p_entries, num_entries, sizeof(Entry_t), compare_mtime);
+    for(size_t i = 0; i < num_entries && total > p_cache->_max_bytes; ++i){
+      if(unlinkat(dirfd(p_dir), p_entries[i]._name, 0) == 0){
+        total -= p_entries[i]._size;
+        ++p_cache->_stats._evictions;
+      }
+    }
+  }
+  free(p_entries);
+  closedir(p_dir);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+CacheStats_t cache_stats(Cache_t* p_cache){
+  pthread_mutex_lock(&p_cache->_lock);
+  CacheStats_t stats = p_cache->_stats;
+  pthread_mutex_unlock(&p_cache->_lock);
+  return stats;
+}
+/*-------------------------------------------------------------------------------------------------------------------*/
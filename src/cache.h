@@ -0,0 +1,115 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: cache.h
+ *
+ *===================================================================================================================*/
+
+
+#ifndef _CACHE_H_
+#define _CACHE_H_
+
+#include <stdint.h>
+
+struct OutBuf;
+
+/*
+ * brief: closed type of a content-addressed cache of assembler outputs in a directory; instantiate with 'new_cache'.
+ *
+ * note: an entry is a file named by the 16 hex digit key of its content; entries are written atomically, so several
+ *  hackass processes may share a cache directory. The mtime of an entry is bumped on each hit and eviction removes
+ *  the least recently used entries first.
+ */
+typedef struct Cache Cache_t;
+
+/*
+ * brief: counts of cache operations, for the stats output.
+ */
+typedef struct CacheStats {
+  uint32_t _hits;
+  uint32_t _misses;
+  uint32_t _stores;
+  uint32_t _evictions;
+} CacheStats_t;
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: opens a cache directory, creating it if it does not exist.
+ * @param dir: the cache directory.
+ * @param max_bytes: size limit of the cache; 'cache_evict' removes entries beyond it.
+ * return: the cache, or NULL on error; errors are reported to stderr.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+Cache_t* new_cache(const char* dir, uint64_t max_bytes);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void free_cache(Cache_t** pp_cache);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: computes the key of an output from the raw bytes of the source file it is assembled from, the assembler
+ *  version and 'format', an id of the kind of output and of the options that change it.
+ * return: SUCCESS, or FAIL if the source file could not be read.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int cache_key_file(const char* ifpath, uint32_t format, uint64_t* p_key);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: looks up an entry of the cache.
+ * @param <out> p_out: buffer to append the cached output to on a hit.
+ * return: SUCCESS on a hit, ERROR_1 on a miss.
+ * note: thread safe.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int cache_fetch(Cache_t* p_cache, uint64_t key, struct OutBuf* p_out);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: adds an entry to the cache; a failure to store is reported but is not an error of the assembly.
+ * note: thread safe.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+void cache_store(Cache_t* p_cache, uint64_t key, struct OutBuf* p_buf);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: removes least recently used entries until the cache is within its size limit.
+ * note: NOT thread safe; call once all fetches and stores are done.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+void cache_evict(Cache_t* p_cache);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+CacheStats_t cache_stats(Cache_t* p_cache);
+
+#endif
@@ -0,0 +1,333 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: coverage.c
+ *
+ *===================================================================================================================*/
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include "coverage.h"
+#include "srcmap.h"
+#include "outbuf.h"
+#include "hash.h"
+#include "asmerr.h"
+
+#define REPORT_LINE_CHARS 512
+#define REPORT_COLUMNS    100 // lists of the report wrap at this column.
+#define HEADER_BYTES      20
+
+/*
+ * brief: a list of the report being appended to a buffer; of ranges of lines or addresses, or of names.
+ *
+ * @member _first, _last: the range not yet appended, if _is_open.
+ * @member _column: the column the next item starts at.
+ * @member _result: FAIL if the buffer could not grow for an item, else SUCCESS.
+ */
+typedef struct List {
+  struct OutBuf* _p_out;
+  uint32_t _first;
+  uint32_t _last;
+  bool _is_open;
+  uint32_t _column;
+  uint32_t _num_items;
+  int _result;
+} List_t;
+
+/*=====================================================================================================================
+ * PRIVATE INTERFACE
+ *===================================================================================================================*/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static inline bool is_set(const uint64_t* p_bits, uint32_t address){
+  return (p_bits[address >> 6] >> (address & 63)) & 1;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static bool has_lines(const SrcMap_t* p_map){
+  return p_map->_num_ins > 0 && p_map->_p_lines[0] != 0;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: true if the instruction is a jump on a condition; 'D;JGT' but not '0;JMP'.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static bool is_branch(uint16_t w){
+  return (w & 0x8000) != 0 && (w & 0x7) != 0 && (w & 0x7) != 0x7;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: appends an item to a list, separated from the item before it by ', ', wrapping it to a new line that would
+ *  pass REPORT_COLUMNS.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void put_item(List_t* p_list, const char* item){
+  size_t n = strlen(item);
+  if(outbuf_reserve(p_list->_p_out, n + 4) != SUCCESS){
+    p_list->_result = FAIL;
+    return;
+  }
+  if(p_list->_num_items > 0){
+    outbuf_putc(p_list->_p_out, ',');
+    p_list->_column += 1;
+  }
+  if(p_list->_num_items == 0 || p_list->_column + 1 + n > REPORT_COLUMNS){
+    outbuf_puts(p_list->_p_out, (p_list->_num_items == 0) ? "  " : "\n  ");
+    p_list->_column = 2;
+  }
+  else{
+    outbuf_putc(p_list->_p_out, ' ');
+    p_list->_column += 1;
+  }
+  outbuf_write(p_list->_p_out, item, n);
+  p_list->_column += (uint32_t)n;
+  ++p_list->_num_items;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: appends the open range of a list, if any, as 'first' or 'first-last'.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void close_range(List_t* p_list){
+  if(!p_list->_is_open){
+    return;
+  }
+  char item[32];
+  if(p_list->_first == p_list->_last){
+    snprintf(item, sizeof(item), "%" PRIu32, p_list->_first);
+  }
+  else{
+    snprintf(item, sizeof(item), "%" PRIu32 "-%" PRIu32, p_list->_first, p_list->_last);
+  }
+  put_item(p_list, item);
+  p_list->_is_open = false;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: adds a line or address to the open range of a list, opening one if none is.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void extend_range(List_t* p_list, uint32_t value){
+  if(!p_list->_is_open){
+    p_list->_first = value;
+    p_list->_is_open = true;
+  }
+  p_list->_last = value;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: ends a list; with 'none' in it if it is empty.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void end_list(List_t* p_list){
+  close_range(p_list);
+  if(p_list->_num_items == 0){
+    put_item(p_list, "none");
+  }
+  p_list->_result = (outbuf_putc(p_list->_p_out, '\n') == SUCCESS) ? p_list->_result : FAIL;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: appends the title of a list and starts it.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void start_list(List_t* p_list, struct OutBuf* p_out, const char* title){
+  *p_list = (List_t){._p_out = p_out};
+  p_list->_result = outbuf_puts(p_out, title);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void put_u64le(struct OutBuf* p_buf, uint64_t v){
+  char b[8];
+  for(int i = 0; i < 8; ++i){
+    b[i] = (char)(v >> (8 * i));
+  }
+  outbuf_write(p_buf, b, 8);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static uint64_t get_u64le(const uint8_t* b){
+  uint64_t v = 0;
+  for(int i = 7; i >= 0; --i){
+    v = (v << 8) | b[i];
+  }
+  return v;
+}
+
+/*=====================================================================================================================
+ * PUBLIC INTERFACE
+ *===================================================================================================================*/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void coverage_merge(SimCoverage_t* p_into, const SimCoverage_t* p_from){
+  for(uint32_t w = 0; w < SIM_COVER_WORDS; ++w){
+    p_into->_executed[w] |= p_from->_executed[w];
+    p_into->_taken[w] |= p_from->_taken[w];
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int coverage_report(const SrcMap_t* p_map, const uint16_t* p_rom, const SimCoverage_t* p_cov, struct OutBuf* p_out){
+  uint32_t n = p_map->_num_ins;
+  bool is_by_line = has_lines(p_map);
+  uint32_t num_executed = 0, num_lines = 0, num_lines_executed = 0, num_branches = 0, num_branches_taken = 0;
+  for(uint32_t i = 0; i < n; ){
+    // the instructions of a line follow each other...
+    uint32_t j = i;
+    bool is_line_executed = false;
+    do{
+      bool is_executed = is_set(p_cov->_executed, j);
+      num_executed += is_executed;
+      is_line_executed = is_line_executed || is_executed;
+      num_branches += is_branch(p_rom[j]);
+      num_branches_taken += is_branch(p_rom[j]) && is_set(p_cov->_taken, j);
+      ++j;
+    }while(is_by_line && j < n && p_map->_p_lines[j] == p_map->_p_lines[i]);
+    ++num_lines;
+    num_lines_executed += is_line_executed;
+    i = j;
+  }
+  uint32_t num_labels = 0, num_labels_executed = 0;
+  for(uint32_t l = 0; l < p_map->_num_labels; ++l){
+    uint32_t address = p_map->_p_label_table[l]._address;
+    num_labels += address < n;
+    num_labels_executed += address < n && is_set(p_cov->_executed, address);
+  }
+
+  char line[REPORT_LINE_CHARS];
+  int k = snprintf(line, sizeof(line), "coverage: %" PRIu32 " of %" PRIu32 " instructions (%.2f%%)", num_executed, n,
+                   (n > 0) ? 100.0 * num_executed / n : 100.0);
+  if(is_by_line){
+    k += snprintf(line + k, sizeof(line) - k, ", %" PRIu32 " of %" PRIu32 " lines", num_lines_executed, num_lines);
+  }
+  snprintf(line + k, sizeof(line) - k, ", %" PRIu32 " of %" PRIu32 " labels, %" PRIu32 " of %" PRIu32 
+           " conditional jumps taken\n", num_labels_executed, num_labels, num_branches_taken, num_branches);
+  int result = outbuf_puts(p_out, line);
+
+  // the lines not executed; ranges of them join over lines without instructions...
+  List_t list;
+  start_list(&list, p_out, is_by_line ? "uncovered lines:\n" : "uncovered instructions:\n");
+  for(uint32_t i = 0; i < n; ){
+    uint32_t j = i;
+    bool is_line_executed = false;
+    do{
+      is_line_executed = is_line_executed || is_set(p_cov->_executed, j);
+      ++j;
+    }while(is_by_line && j < n && p_map->_p_lines[j] == p_map->_p_lines[i]);
+    if(is_line_executed){
+      close_range(&list);
+    }
+    else{
+      extend_range(&list, is_by_line ? p_map->_p_lines[i] : i);
+    }
+    i = j;
+  }
+  end_list(&list);
+  result = (list._result == SUCCESS) ? result : FAIL;
+
+  start_list(&list, p_out, "uncovered labels:\n");
+  for(uint32_t l = 0; l < p_map->_num_labels; ++l){
+    uint32_t address = p_map->_p_label_table[l]._address;
+    if(address < n && !is_set(p_cov->_executed, address)){
+      put_item(&list, p_map->_names._p_data + p_map->_p_label_table[l]._name);
+    }
+  }
+  end_list(&list);
+  result = (list._result == SUCCESS) ? result : FAIL;
+
+  start_list(&list, p_out, "jumps never taken:\n");
+  for(uint32_t i = 0; i < n; ++i){
+    if(is_branch(p_rom[i]) && is_set(p_cov->_executed, i) && !is_set(p_cov->_taken, i)){
+      const char* label = srcmap_label(p_map, i);
+      snprintf(line, sizeof(line), "%s %" PRIu32 "%s%s%s", is_by_line ? "line" : "address", 
+               is_by_line ? p_map->_p_lines[i] : i, (label != NULL) ? " (" : "", (label != NULL) ? label : "", 
+               (label != NULL) ? ")" : "");
+      put_item(&list, line);
+    }
+  }
+  end_list(&list);
+  return (list._result == SUCCESS) ? result : FAIL;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int coverage_write(const SimCoverage_t* p_cov, const uint16_t* p_rom, uint32_t n, struct OutBuf* p_out){
+  uint32_t num_words = (n + 63) / 64;
+  if(outbuf_reserve(p_out, HEADER_BYTES + 2 * 8 * (size_t)num_words) != SUCCESS){
+    return FAIL;
+  }
+  const char header[8] = {COVERAGE_MAGIC[0], COVERAGE_MAGIC[1], COVERAGE_MAGIC[2], COVERAGE_MAGIC[3], 
+                          (char)COVERAGE_VERSION, (char)(COVERAGE_VERSION >> 8), 0, 0};
+  outbuf_write(p_out, header, 8);
+  char count[4] = {(char)n, (char)(n >> 8), (char)(n >> 16), (char)(n >> 24)};
+  outbuf_write(p_out, count, 4);
+  put_u64le(p_out, hash_xxh64(p_rom, n * sizeof(uint16_t), 0));
+  const uint64_t* bitmaps[2] = {p_cov->_executed, p_cov->_taken};
+  for(int b = 0; b < 2; ++b){
+    for(uint32_t w = 0; w < num_words; ++w){
+      // bits past the program are of the address a run ended at, not of instructions...
+      uint32_t num_bits = (w + 1 < num_words || n % 64 == 0) ? 64 : n % 64;
+      put_u64le(p_out, bitmaps[b][w] & ((num_bits == 64) ? UINT64_MAX : ((uint64_t)1 << num_bits) - 1));
+    }
+  }
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int coverage_read(SimCoverage_t* p_cov, const uint16_t* p_rom, uint32_t n, const char* p_data, size_t size){
+  const uint8_t* b = (const uint8_t*)p_data;
+  if(size < HEADER_BYTES || memcmp(b, COVERAGE_MAGIC, 4) != 0 || (b[4] | (b[5] << 8)) != COVERAGE_VERSION){
+    return FAIL;
+  }
+  uint32_t num_ins = (uint32_t)b[8] | ((uint32_t)b[9] << 8) | ((uint32_t)b[10] << 16) | ((uint32_t)b[11] << 24);
+  uint32_t num_words = (num_ins + 63) / 64;
+  if(num_words > SIM_COVER_WORDS || size != HEADER_BYTES + 2 * 8 * (size_t)num_words){
+    return FAIL;
+  }
+  if(num_ins != n || get_u64le(b + 12) != hash_xxh64(p_rom, n * sizeof(uint16_t), 0)){
+    return ERROR_1;
+  }
+  for(uint32_t w = 0; w < num_words; ++w){
+    p_cov->_executed[w] |= get_u64le(b + HEADER_BYTES + 8 * w);
+    p_cov->_taken[w] |= get_u64le(b + HEADER_BYTES + 8 * (num_words + w));
+  }
+  return SUCCESS;
+}
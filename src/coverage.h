@@ -0,0 +1,95 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: coverage.h
+ *
+ *===================================================================================================================*/
+
+
+#ifndef _COVERAGE_H_
+#define _COVERAGE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sim.h"
+
+#define COVERAGE_MAGIC "HCOV"
+#define COVERAGE_VERSION 1
+
+struct SrcMap;
+struct OutBuf;
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: merges a coverage into another by OR; both of the same program, e.g. of tests run on different threads.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+void coverage_merge(SimCoverage_t* p_into, const SimCoverage_t* p_from);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: appends the coverage report of a program to a buffer; the share of its instructions, lines and labels
+ *  executed, then the lines and labels not executed, and the conditional jumps executed but never taken.
+ * @param p_map: the source map of the program.
+ * @param p_rom: the Hack machine instructions of the program.
+ * return: SUCCESS, or FAIL if the buffer could not grow.
+ *
+ * note: a line is covered if any of its instructions was executed, a label if the instruction at its address was.
+ * note: instructions are listed by address where their lines are not known, i.e. of linked programs.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int coverage_report(const struct SrcMap* p_map, const uint16_t* p_rom, const SimCoverage_t* p_cov, 
+                    struct OutBuf* p_out);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: appends the binary form of a coverage to a buffer; little-endian,
+ *
+ *    magic "HCOV", u16 version, u16 0, u32 number of instructions, u64 XXH64 of the instructions,
+ *    the words of the bitmap of instructions executed, then of jumps taken; (n + 63) / 64 u64 each.
+ *
+ * @param p_rom: the 'n' Hack machine instructions of the program.
+ * return: SUCCESS, or FAIL if the buffer could not grow.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int coverage_write(const SimCoverage_t* p_cov, const uint16_t* p_rom, uint32_t n, struct OutBuf* p_out);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: merges a coverage in binary form (see 'coverage_write') into another by OR, if of the same program.
+ * @param p_data: the binary form; 'size' bytes.
+ * return: SUCCESS, ERROR_1 if the coverage is of another program, or FAIL if it is not a coverage.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int coverage_read(SimCoverage_t* p_cov, const uint16_t* p_rom, uint32_t n, const char* p_data, size_t size);
+
+#endif
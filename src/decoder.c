@@ -38,6 +38,7 @@
 #include <assert.h>
 #include <string.h>
 #include <inttypes.h>
+#include <stdbool.h>
 #include "parser.h"
 #include "asmerr.h"
 
@@ -60,12 +61,17 @@ typedef struct Mnemonic {
 static Mnemonic_t jump_bits[8];
 static Mnemonic_t dest_bits[8];
 static Mnemonic_t comp_bits[28];
+static int8_t comp_index[128];  /* inverse of comp_bits; the mnemonic index of the a and c bits, else -1. */
 
 /*=====================================================================================================================
  * PRIVATE INTERFACE
  *===================================================================================================================*/
 
 void init_decoder(){
+  static bool is_initialised = false;
+  if(is_initialised){
+    return;
+  }
   strncpy(jump_bits[0]._str, "", MAX_MNEMONIC_CHAR_LENGTH);    jump_bits[0]._bits = 0b0000000000000000;
   strncpy(jump_bits[1]._str, "JGT", MAX_MNEMONIC_CHAR_LENGTH); jump_bits[1]._bits = 0b0000000000000001;
   strncpy(jump_bits[2]._str, "JEQ", MAX_MNEMONIC_CHAR_LENGTH); jump_bits[2]._bits = 0b0000000000000010;
@@ -112,6 +118,13 @@ void init_decoder(){
   strncpy(comp_bits[25]._str, "M-D", MAX_MNEMONIC_CHAR_LENGTH); comp_bits[25]._bits = 0b0001000111000000;
   strncpy(comp_bits[26]._str, "D&M", MAX_MNEMONIC_CHAR_LENGTH); comp_bits[26]._bits = 0b0001000000000000;
   strncpy(comp_bits[27]._str, "D|M", MAX_MNEMONIC_CHAR_LENGTH); comp_bits[27]._bits = 0b0001010101000000;
+
+  memset(comp_index, -1, sizeof(comp_index));
+  for(int c = 0; c < 28; ++c){
+    comp_index[comp_bits[c]._bits >> 6] = (int8_t)c;
+  }
+
+  is_initialised = true;
 }
 
 /*=====================================================================================================================
@@ -124,26 +137,49 @@ void init_decoder(){
  * @param p_code: output decoded 'Hack' machine instruction.
  * return: SUCCESS or FAIL; FAIL if recieves unaccepted command format.
  * note: does NOT accept CFORMAT_A0, CFORMAT_L0 or CFORMAT_L1.
+ * note: the mnemonic indices of the command index the bit tables directly; the tables are in the same order as the
+ *  mnemonic tables of the lexer.
  */
 int decode(Command_t* p_cmd, uint16_t* p_code){
   assert(p_cmd->_type != CFORMAT_A0 && p_cmd->_type != CFORMAT_L0 && p_cmd->_type != CFORMAT_L1);
   switch(p_cmd->_type){
     case CFORMAT_A1:{
-      uint16_t add = (uint16_t)strtol(p_cmd->_sym, NULL, 10); 
-      (*p_code) = 0b0000000000000000 | add; 
+      (*p_code) = 0b0000000000000000 | (p_cmd->_value & 0b0111111111111111); 
       return SUCCESS;
     }
     case CFORMAT_C0:
     case CFORMAT_C1:
     case CFORMAT_C2:{
-      int j = 0, d = 0, c = 0;
-      while(j < 8 && strncmp(jump_bits[j]._str, p_cmd->_jump, MAX_MNEMONIC_CHAR_LENGTH) != 0){++j;}
-      while(d < 8 && strncmp(dest_bits[d]._str, p_cmd->_dest, MAX_MNEMONIC_CHAR_LENGTH) != 0){++d;}
-      while(c < 28 && strncmp(comp_bits[c]._str, p_cmd->_comp, MAX_MNEMONIC_CHAR_LENGTH) != 0){++c;}
-      assert(j != 8 && d != 8 && c != 28);
+      uint8_t j = p_cmd->_jump, d = p_cmd->_dest, c = p_cmd->_comp;
+      assert(j < 8 && d < 8 && c < 28);
       (*p_code) = (0b1110000000000000 | comp_bits[c]._bits | dest_bits[d]._bits | jump_bits[j]._bits);
       return SUCCESS;
    }
   }
   return FAIL;
 }
+
+/*
+ * brief: finds the mnemonic index of the computation of a C instruction; the inverse of 'decode' for the a and c
+ *  bits.
+ * @param code: a C instruction.
+ * return: the index, or -1 if the a and c bits are not those of a computation mnemonic.
+ */
+int decoder_comp_index(uint16_t code){
+  return comp_index[(code >> 6) & 0x7f];
+}
+
+/*
+ * brief: the mnemonic strings of the comp, dest and jump tables, by index.
+ */
+const char* decoder_comp_mnemonic(int index){
+  return comp_bits[index]._str;
+}
+
+const char* decoder_dest_mnemonic(int index){
+  return dest_bits[index]._str;
+}
+
+const char* decoder_jump_mnemonic(int index){
+  return jump_bits[index]._str;
+}
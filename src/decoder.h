@@ -48,4 +48,19 @@ void init_decoder();
  */
 int decode(Command_t* p_cmd, uint16_t* p_code);
 
+/*
+ * brief: finds the mnemonic index of the computation of a C instruction, as used by Command_t::_comp.
+ * return: the index, or -1 if the a and c bits are not those of a computation mnemonic.
+ * note: requires 'init_decoder'.
+ */
+int decoder_comp_index(uint16_t code);
+
+/*
+ * brief: the mnemonics of the fields of a C instruction, by mnemonic index; "" for the null dest and jump.
+ * note: requires 'init_decoder'.
+ */
+const char* decoder_comp_mnemonic(int index);
+const char* decoder_dest_mnemonic(int index);
+const char* decoder_jump_mnemonic(int index);
+
 #endif
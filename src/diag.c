@@ -0,0 +1,60 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: diag.c
+ *
+ *===================================================================================================================*/
+
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include "diag.h"
+
+static __thread FILE* g_diag_stream;   /* NULL means stderr; stderr is not a constant so cannot initialise this. */
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+FILE* diag_stream(){
+  return (g_diag_stream != NULL) ? g_diag_stream : stderr;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void diag_redirect(FILE* stream){
+  g_diag_stream = stream;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void diag_perror(const char* what){
+  int err = errno;
+  fprintf(diag_stream(), "%s: %s\n", what, strerror(err));
+}
+/*-------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,61 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: diag.h
+ *
+ *===================================================================================================================*/
+
+
+#ifndef _DIAG_H_
+#define _DIAG_H_
+
+#include <stdio.h>
+
+/*
+ * brief: the stream the calling thread reports assembly diagnostics (errors in the source, unreadable files) to;
+ *  stderr unless redirected with 'diag_redirect'.
+ *
+ * note: each thread has its own stream, so concurrent assemblies, e.g. of the server, keep their diagnostics apart.
+ */
+FILE* diag_stream();
+
+/*
+ * brief: redirects the diagnostics of the calling thread to 'stream'; NULL restores stderr.
+ */
+void diag_redirect(FILE* stream);
+
+/*
+ * brief: reports the current errno, prefixed with 'what', to the diagnostic stream; the 'perror' of diagnostics.
+ */
+void diag_perror(const char* what);
+
+#endif
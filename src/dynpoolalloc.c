@@ -59,10 +59,12 @@ struct PoolListNode {
  * note: the 'features' of this pool are somewhat restricted to those of the sub-pools, thus the dynamic pool allocator
  *  also does NOT support deallocations; same as PoolAlloc.
  *
+ * note: sub-pools before the active pool are full; sub-pools after it are empty, kept from before a reset.
  */
 /*-------------------------------------------------------------------------------------------------------------------*/
 struct DynamicPoolAlloc {
   struct PoolListNode* _p_head; 
+  struct PoolListNode* _p_active;   /* the sub-pool allocations are made from. */
   size_t _alloc_size_bytes;
   size_t _sub_pool_size_allocs;
 };
@@ -97,6 +99,7 @@ int new_dynamic_pool_alloc(struct DynamicPoolAlloc** pp_dynpool, size_t alloc_si
     return ERROR_3;
   }
 
+  (*pp_dynpool)->_p_active = (*pp_dynpool)->_p_head;
   (*pp_dynpool)->_alloc_size_bytes = alloc_size_bytes;
   (*pp_dynpool)->_sub_pool_size_allocs = sub_pool_size_allocs;
 
@@ -135,18 +138,8 @@ void free_dynamic_pool_alloc(struct DynamicPoolAlloc** pp_dynpool){
  */
 /*-------------------------------------------------------------------------------------------------------------------*/
 int dynamic_pool_malloc(struct DynamicPoolAlloc* p_dynpool, void** mem){
-  // find last pool in the list; the 'active' pool...
-  struct PoolListNode* active = p_dynpool->_p_head;
-  while(true){
-    if(active->_p_next != NULL){
-      active = active->_p_next;
-    }
-    else {
-      break;
-    }
-  }
-
-  // allocate a chunk of memory...
+  // allocate a chunk of memory from the active pool...
+  struct PoolListNode* active = p_dynpool->_p_active;
   (*mem) = pool_malloc(&active->_pool);
 
   // if successfully allocated the memory, return early...
@@ -154,16 +147,21 @@ int dynamic_pool_malloc(struct DynamicPoolAlloc* p_dynpool, void** mem){
     return SUCCESS;
   }
 
-  // if failed to allocate from active pool then pool is full; so create another one...
-  struct PoolListNode* new_node = (struct PoolListNode*)malloc(sizeof(struct PoolListNode));
-  new_node->_p_next = NULL;
-  int err = init_pool_alloc(&(new_node->_pool), p_dynpool->_alloc_size_bytes, p_dynpool->_sub_pool_size_allocs);
-  if(err != SUCCESS){
-    free(new_node);
-    return ERROR_2;
+  // if failed to allocate from active pool then pool is full; so move to the next, creating it if required...
+  if(active->_p_next == NULL){
+    struct PoolListNode* new_node = (struct PoolListNode*)malloc(sizeof(struct PoolListNode));
+    if(new_node == NULL){
+      return ERROR_1;
+    }
+    new_node->_p_next = NULL;
+    int err = init_pool_alloc(&(new_node->_pool), p_dynpool->_alloc_size_bytes, p_dynpool->_sub_pool_size_allocs);
+    if(err != SUCCESS){
+      free(new_node);
+      return ERROR_2;
+    }
+    active->_p_next = new_node;
   }
-  active->_p_next = new_node;
-  active = active->_p_next; 
+  active = p_dynpool->_p_active = active->_p_next; 
 
   // attempt to allocate from the new pool...
   (*mem) = pool_malloc(&active->_pool);
@@ -175,3 +173,15 @@ int dynamic_pool_malloc(struct DynamicPoolAlloc* p_dynpool, void** mem){
 
   return SUCCESS;
 }
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * SEE HEADER
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+void dynamic_pool_reset(struct DynamicPoolAlloc* p_dynpool){
+  for(struct PoolListNode* node = p_dynpool->_p_head; node != NULL; node = node->_p_next){
+    pool_reset(&node->_pool);
+  }
+  p_dynpool->_p_active = p_dynpool->_p_head;
+}
@@ -61,4 +61,10 @@ void free_dynamic_pool_alloc(struct DynamicPoolAlloc** p_dynpool);
  */
 int dynamic_pool_malloc(struct DynamicPoolAlloc* p_dynpool, void** mem);
 
+/*
+ * brief: returns all allocations to the dynamic pool, keeping the memory of all its sub-pools for reuse.
+ * note: WILL invalidate all pointers to pool memory!
+ */
+void dynamic_pool_reset(struct DynamicPoolAlloc* p_dynpool);
+
 #endif
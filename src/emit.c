@@ -0,0 +1,456 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: emit.c
+ *
+ *===================================================================================================================*/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include "symbollib.h"
+#include "parser.h"
+#include "decoder.h"
+#include "outbuf.h"
+#include "asmerr.h"
+#include "emit.h"
+#include "srcmap.h"
+
+#define HACKINS_CHARS 17 // 16 binary digits + newline.
+#define C_LINE_CHARS 160 // most characters of a statement of the C translation.
+
+/*
+ * The C translation; a program that runs the Hack program and prints the state it stops in, as --run does. Each
+ * instruction is a labelled statement in ROM order and computed jumps go through the switch on the target at
+ * 'dispatch'. Blocks, runs of statements ending in a jump, are entered through ENTER, which takes the whole block
+ * from the cycle budget; so a run that reaches the limit stops at the start of the block that would exceed it.
+ */
+static const char* g_c_prelude =
+  "#include <stdint.h>\n"
+  "#include <stdio.h>\n"
+  "#include <stdlib.h>\n\n"
+  "static uint16_t ram[32768];\n\n"
+  "#define M ram[a & 0x7fff]\n"
+  "#define ENTER(I, LEN) if(left < (LEN)){ pc = (I); goto limit; } left -= (LEN);\n"
+  "#define JUMP(T) do{ pc = (T) & 0x7fff; goto dispatch; }while(0)\n"
+  "#define HALT_IF(T, I) if(((T) & 0x7fff) == (I)){ pc = (I); how = \"halted\"; goto done; }\n\n"
+  "/* the ALU, for computations that are not mnemonics. */\n"
+  "static uint16_t alu(uint16_t x, uint16_t y, unsigned bits){\n"
+  "  x = (bits & 0x20) ? 0 : x;\n"
+  "  x = (bits & 0x10) ? ~x : x;\n"
+  "  y = (bits & 0x08) ? 0 : y;\n"
+  "  y = (bits & 0x04) ? ~y : y;\n"
+  "  uint16_t v = (bits & 0x02) ? x + y : x & y;\n"
+  "  return (bits & 0x01) ? ~v : v;\n"
+  "}\n\n"
+  "/* usage: program [max-cycles [address=value...]]; max-cycles is 0 for no limit. */\n"
+  "int main(int argc, char* argv[]){\n"
+  "  uint64_t max_cycles = (argc > 1) ? strtoull(argv[1], NULL, 10) : 1073741824ULL;\n"
+  "  for(int i = 2; i < argc; ++i){\n"
+  "    unsigned address, value;\n"
+  "    if(sscanf(argv[i], \"%u=%u\", &address, &value) == 2 && address < 32768){\n"
+  "      ram[address] = (uint16_t)value;\n"
+  "    }\n"
+  "  }\n"
+  "  uint64_t budget = (max_cycles == 0) ? UINT64_MAX : max_cycles, left = budget;\n"
+  "  uint16_t a = 0, d = 0, v, t;\n"
+  "  uint32_t pc = 0;\n"
+  "  const char* how;\n"
+  "  goto E0;\n\n";
+
+static const char* g_c_epilogue =
+  "limit:\n"
+  "  how = \"reached the cycle limit\";\n"
+  "  goto done;\n"
+  "end:\n"
+  "  how = (left == 0) ? \"reached the cycle limit\" : \"ended\";\n"
+  "done:\n"
+  "  printf(\"%s: %s at pc %u after %llu cycles\\n\", argv[0], how, (unsigned)pc, "
+  "(unsigned long long)(budget - left));\n"
+  "  printf(\"A=%u D=%u PC=%u\\n\", (unsigned)a, (unsigned)d, (unsigned)pc);\n"
+  "  for(int r = 0; r < 16; ++r){\n"
+  "    printf(\"R%d=%d%s\", r, (int16_t)ram[r], ((r + 1) % 8 == 0) ? \"\\n\" : \" \");\n"
+  "  }\n"
+  "  return (how[0] == 'r') ? 1 : 0;\n"
+  "}\n";
+
+/*
+ * the C comparison of a jump mnemonic, by its suffix; "JMP" has none.
+ */
+static const char* g_c_conditions[][2] = {
+  {"GT", ">"}, {"EQ", "=="}, {"GE", ">="}, {"LT", "<"}, {"NE", "!="}, {"LE", "<="}
+};
+
+/*
+ * Data used in solution to print binary representation of 16-bit instructions. Adapted from:
+ *  source: https://stackoverflow.com/questions/111928/is-there-a-printf-converter-to-print-in-binary-format?page=1&tab=votes#tab-top
+ */
+static const char* g_bitstr[16] = {
+    [ 0] = "0000", [ 1] = "0001", [ 2] = "0010", [ 3] = "0011",
+    [ 4] = "0100", [ 5] = "0101", [ 6] = "0110", [ 7] = "0111",
+    [ 8] = "1000", [ 9] = "1001", [10] = "1010", [11] = "1011",
+    [12] = "1100", [13] = "1101", [14] = "1110", [15] = "1111",
+};
+
+/*
+ * brief: an entry of the symbol map; collected from the symbol library then sorted.
+ */
+typedef struct MapEntry {
+  size_t _sym_offset;
+  uint16_t _address;
+  uint8_t _tag;
+} MapEntry_t;
+
+typedef struct MapEntries {
+  MapEntry_t* _p_entries;
+  size_t _num;
+  size_t _cap;
+  struct OutBuf _syms;
+} MapEntries_t;
+
+/*=====================================================================================================================
+ * PRIVATE HELPERS
+ *===================================================================================================================*/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void collect_map_entry(const char* sym, uint16_t address, uint8_t tag, void* p_ctx){
+  MapEntries_t* p_map = (MapEntries_t*)p_ctx;
+  if(tag != SYMTAG_LABEL && tag != SYMTAG_VARIABLE){
+    return;
+  }
+  if(p_map->_num == p_map->_cap){
+    size_t cap = (p_map->_cap == 0) ? 64 : p_map->_cap * 2;
+    MapEntry_t* p_entries = (MapEntry_t*)realloc(p_map->_p_entries, cap * sizeof(MapEntry_t));
+    if(p_entries == NULL){
+      return;
+    }
+    p_map->_p_entries = p_entries;
+    p_map->_cap = cap;
+  }
+  MapEntry_t* e = &p_map->_p_entries[p_map->_num];
+  e->_sym_offset = p_map->_syms._size;
+  e->_address = address;
+  e->_tag = tag;
+  if(outbuf_write(&p_map->_syms, sym, strlen(sym) + 1) == SUCCESS){
+    ++p_map->_num;
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: orders map entries labels first, then variables, each by address.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int compare_map_entries(const void* a, const void* b){
+  const MapEntry_t* ea = (const MapEntry_t*)a;
+  const MapEntry_t* eb = (const MapEntry_t*)b;
+  if(ea->_tag != eb->_tag){
+    return (ea->_tag == SYMTAG_LABEL) ? -1 : 1;
+  }
+  return (int)ea->_address - (int)eb->_address;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: writes the C expression of a computation; the mnemonic of the decoder with D, A and M as the C registers
+ *  and '!' as '~', e.g. "D+M" is "(uint16_t)(d+M)"; else a call of the ALU with the c bits.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void write_c_comp(char* expr, size_t n, uint16_t code){
+  int c = decoder_comp_index(code);
+  if(c < 0){
+    snprintf(expr, n, "alu(d, %s, 0x%02x)", (code & 0x1000) ? "M" : "a", (code >> 6) & 0x3f);
+    return;
+  }
+  const char* mn = decoder_comp_mnemonic(c);
+  size_t e = snprintf(expr, n, "(uint16_t)(");
+  for(; *mn != '\0'; ++mn){
+    expr[e++] = (*mn == 'D') ? 'd' : (*mn == 'A') ? 'a' : (*mn == '!') ? '~' : *mn;
+  }
+  snprintf(expr + e, n - e, ")");
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static const char* c_condition(const char* jump){
+  for(size_t k = 0; k < sizeof(g_c_conditions) / sizeof(g_c_conditions[0]); ++k){
+    if(strcmp(jump + 1, g_c_conditions[k][0]) == 0){
+      return g_c_conditions[k][1];
+    }
+  }
+  return NULL;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static bool is_c_jump(uint16_t code){
+  return (code & 0x8000) != 0 && (code & 0x7) != 0;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: writes the statement of instruction i; as the hardware, M is written and the jump taken at the A of before.
+ *
+ * note: a jump with no destination, taken to itself or to an '@' of its own address just before it, is a halt, as
+ *  detected by the simulator (see sim.h).
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int write_c_statement(const Assembler_t* p, uint32_t i, struct OutBuf* p_out){
+  char line[C_LINE_CHARS], expr[64];
+  uint16_t code = p->_p_hackins[i];
+  if((code & 0x8000) == 0){
+    snprintf(line, sizeof(line), "L%" PRIu32 ": a = %" PRIu16 ";\n", i, code);
+    return outbuf_puts(p_out, line);
+  }
+  const char* dest = decoder_dest_mnemonic((code >> 3) & 0x7);
+  const char* jump = decoder_jump_mnemonic(code & 0x7);
+  write_c_comp(expr, sizeof(expr), code);
+  size_t l = snprintf(line, sizeof(line), "L%" PRIu32 ": v = %s;%s%s%s%s", i, expr, (*jump != '\0') ? " t = a;" : "",
+                      strchr(dest, 'M') ? " M = v;" : "", strchr(dest, 'D') ? " d = v;" : "",
+                      strchr(dest, 'A') ? " a = v;" : "");
+  if(*jump == '\0'){
+    snprintf(line + l, sizeof(line) - l, "\n");
+    return outbuf_puts(p_out, line);
+  }
+  const char* cond = c_condition(jump);
+  if(cond != NULL){
+    l += snprintf(line + l, sizeof(line) - l, " if((int16_t)v %s 0){", cond);
+  }
+  if(*dest == '\0'){
+    l += snprintf(line + l, sizeof(line) - l, " HALT_IF(t, %" PRIu32 ")", i);
+    if(i > 0 && (p->_p_hackins[i - 1] & 0x8000) == 0 && p->_p_hackins[i - 1] == i - 1){
+      l += snprintf(line + l, sizeof(line) - l, " HALT_IF(t, %" PRIu32 ")", i - 1);
+    }
+  }
+  snprintf(line + l, sizeof(line) - l, " JUMP(t);%s\n", (cond != NULL) ? " }" : "");
+  return outbuf_puts(p_out, line);
+}
+
+/*=====================================================================================================================
+ * PUBLIC INTERFACE
+ *===================================================================================================================*/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int emit_hack(const Assembler_t* p, struct OutBuf* p_out){
+  if(outbuf_reserve(p_out, (size_t)p->_ins_count * HACKINS_CHARS) != SUCCESS){
+    return FAIL;
+  }
+  char* o = p_out->_p_data + p_out->_size;
+  for(uint32_t in = 0; in < p->_ins_count; ++in){
+    uint16_t i = p->_p_hackins[in];
+    memcpy(o, g_bitstr[i >> 12], 4);
+    memcpy(o + 4, g_bitstr[(i >> 8) & 0x000F], 4);
+    memcpy(o + 8, g_bitstr[(i >> 4) & 0x000F], 4);
+    memcpy(o + 12, g_bitstr[i & 0x000F], 4);
+    o[16] = '\n';
+    o += HACKINS_CHARS;
+  }
+  p_out->_size += (size_t)p->_ins_count * HACKINS_CHARS;
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int emit_bin(const Assembler_t* p, struct OutBuf* p_out){
+  if(outbuf_reserve(p_out, (size_t)p->_ins_count * 2) != SUCCESS){
+    return FAIL;
+  }
+  unsigned char* o = (unsigned char*)p_out->_p_data + p_out->_size;
+  for(uint32_t in = 0; in < p->_ins_count; ++in){
+    o[0] = (unsigned char)(p->_p_hackins[in] >> 8);
+    o[1] = (unsigned char)(p->_p_hackins[in] & 0x00FF);
+    o += 2;
+  }
+  p_out->_size += (size_t)p->_ins_count * 2;
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int emit_strip(const Assembler_t* p, struct OutBuf* p_out){
+  for(uint32_t cn = 0; cn < p->_line_count; ++cn){
+    Command_t* c = &p->_p_cmds[cn];
+    if(c->_type == CFORMAT_L0 || c->_type == CFORMAT_L1){
+      continue;
+    }
+    if(parser_write_cmdasm(p_out, c) != SUCCESS){
+      return FAIL;
+    }
+  }
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int emit_map(const Assembler_t* p, struct OutBuf* p_out){
+  MapEntries_t map;
+  memset(&map, 0, sizeof(MapEntries_t));
+  if(init_outbuf(&map._syms, 1 << 12) != SUCCESS){
+    return FAIL;
+  }
+  symlib_foreach(p->_p_sym_lib, collect_map_entry, &map);
+  qsort(map._p_entries, map._num, sizeof(MapEntry_t), compare_map_entries);
+
+  char line[32];
+  int result = SUCCESS;
+  for(size_t en = 0; en < map._num && result == SUCCESS; ++en){
+    MapEntry_t* e = &map._p_entries[en];
+    snprintf(line, sizeof(line), "%-8s %5" PRIu16 " ", (e->_tag == SYMTAG_LABEL) ? "label" : "variable", e->_address);
+    result = outbuf_puts(p_out, line);
+    result = (result == SUCCESS) ? outbuf_puts(p_out, map._syms._p_data + e->_sym_offset) : result;
+    result = (result == SUCCESS) ? outbuf_putc(p_out, '\n') : result;
+  }
+  free(map._p_entries);
+  free_outbuf(&map._syms);
+  return result;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * note: a block starts after each jump, and the length of the rest of its block is taken from the budget on entry;
+ *  entries through the switch into the middle of a block take their own rest of it, then join the statements.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int emit_c(const Assembler_t* p, struct OutBuf* p_out){
+  uint32_t n = p->_ins_count;
+  uint32_t* p_len = (uint32_t*)malloc((n + 1) * sizeof(uint32_t));
+  if(p_len == NULL){
+    return FAIL;
+  }
+  for(uint32_t i = n; i-- > 0;){
+    p_len[i] = (i + 1 == n || is_c_jump(p->_p_hackins[i])) ? 1 : p_len[i + 1] + 1;
+  }
+
+  char line[C_LINE_CHARS];
+  snprintf(line, sizeof(line), "/* Hack program of %" PRIu32 " instructions, translated to C by hackass. */\n", n);
+  int result = outbuf_puts(p_out, line);
+  result = (result == SUCCESS) ? outbuf_puts(p_out, g_c_prelude) : result;
+  for(uint32_t i = 0; i < n && result == SUCCESS; ++i){
+    if(i == 0 || is_c_jump(p->_p_hackins[i - 1])){
+      snprintf(line, sizeof(line), "E%" PRIu32 ": ENTER(%" PRIu32 ", %" PRIu32 ")\n", i, i, p_len[i]);
+      result = outbuf_puts(p_out, line);
+    }
+    result = (result == SUCCESS) ? write_c_statement(p, i, p_out) : result;
+  }
+  if(n == 0 && result == SUCCESS){
+    result = outbuf_puts(p_out, "E0:\n");
+  }
+  snprintf(line, sizeof(line), "  pc = %" PRIu32 ";\n  goto end;\n\ndispatch:\n  switch(pc){\n", n);
+  result = (result == SUCCESS) ? outbuf_puts(p_out, line) : result;
+  for(uint32_t i = 0; i < n && result == SUCCESS; ++i){
+    if(i == 0 || is_c_jump(p->_p_hackins[i - 1])){
+      snprintf(line, sizeof(line), "    case %" PRIu32 ": goto E%" PRIu32 ";\n", i, i);
+    }
+    else{
+      snprintf(line, sizeof(line), "    case %" PRIu32 ": ENTER(%" PRIu32 ", %" PRIu32 ") goto L%" PRIu32 ";\n", i, i, 
+               p_len[i], i);
+    }
+    result = outbuf_puts(p_out, line);
+  }
+  result = (result == SUCCESS) ? outbuf_puts(p_out, "    default: goto end;\n  }\n\n") : result;
+  result = (result == SUCCESS) ? outbuf_puts(p_out, g_c_epilogue) : result;
+  free(p_len);
+  return result;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int emit_srcmap(const Assembler_t* p, struct OutBuf* p_out){
+  return srcmap_write(p->_p_srcmap, p_out);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+Emitter_t emitter_of(int kind){
+  switch(kind){
+    case EMIT_HACK:
+      return emit_hack;
+    case EMIT_BIN:
+      return emit_bin;
+    case EMIT_STRIP:
+      return emit_strip;
+    case EMIT_MAP:
+      return emit_map;
+    case EMIT_C:
+      return emit_c;
+    case EMIT_SRCMAP:
+      return emit_srcmap;
+    default:
+      return NULL;
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+const char* emit_name(int kind){
+  switch(kind){
+    case EMIT_HACK:
+      return "hack";
+    case EMIT_BIN:
+      return "bin";
+    case EMIT_STRIP:
+      return "strip";
+    case EMIT_MAP:
+      return "map";
+    case EMIT_C:
+      return "c";
+    case EMIT_SRCMAP:
+      return "srcmap";
+    default:
+      return "";
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+const char* emit_extension(int kind){
+  switch(kind){
+    case EMIT_HACK:
+      return ".hack";
+    case EMIT_BIN:
+      return ".bin";
+    case EMIT_STRIP:
+      return ".strip.asm";
+    case EMIT_MAP:
+      return ".map";
+    case EMIT_C:
+      return ".c";
+    case EMIT_SRCMAP:
+      return ".smap";
+    default:
+      return "";
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int emit_parse_name(const char* name, size_t n){
+  for(int k = 0; k < NUM_EMIT_KINDS; ++k){
+    const char* kn = emit_name(1 << k);
+    if(strlen(kn) == n && strncmp(kn, name, n) == 0){
+      return 1 << k;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,87 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: emit.h
+ *
+ *===================================================================================================================*/
+
+
+#ifndef _EMIT_H_
+#define _EMIT_H_
+
+#include "assembler.h"
+
+/*
+ * ids of the artifacts the back end can emit; used as bit flags to select several artifacts at once.
+ */
+#define EMIT_HACK  0x01 // .hack file; one 16 character binary string per instruction.
+#define EMIT_BIN   0x02 // .bin file; raw ROM image of big-endian 16-bit instructions.
+#define EMIT_STRIP 0x04 // .asm file stripped of whitespace, comments and symbols.
+#define EMIT_MAP   0x08 // .map file; listing of label and variable addresses.
+#define EMIT_C     0x10 // .c file; the program translated to C, which runs it as --run does.
+#define EMIT_SRCMAP 0x20 // .smap file; binary source map of the instructions' lines and labels (see srcmap.h).
+#define NUM_EMIT_KINDS 6
+
+struct OutBuf;
+
+/*
+ * brief: a back end writer; appends an artifact composed from an assembled translation unit to a buffer.
+ * return: SUCCESS, or FAIL if the buffer could not grow.
+ * note: writers only read the assembler, so any number of writers may run concurrently on the same assembler.
+ */
+typedef int (*Emitter_t)(const Assembler_t* p, struct OutBuf* p_out);
+
+int emit_hack(const Assembler_t* p, struct OutBuf* p_out);
+int emit_bin(const Assembler_t* p, struct OutBuf* p_out);
+int emit_strip(const Assembler_t* p, struct OutBuf* p_out);
+int emit_map(const Assembler_t* p, struct OutBuf* p_out);
+int emit_c(const Assembler_t* p, struct OutBuf* p_out);
+int emit_srcmap(const Assembler_t* p, struct OutBuf* p_out);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: look up the writer, name and file extension of an artifact from its EMIT_* id.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+Emitter_t emitter_of(int kind);
+const char* emit_name(int kind);
+const char* emit_extension(int kind);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: parses an artifact name, as used on the command line, e.g. "hack".
+ * return: the EMIT_* id, or 0 if the name is not recognised.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int emit_parse_name(const char* name, size_t n);
+
+#endif
@@ -0,0 +1,143 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: hash.c
+ *
+ *===================================================================================================================*/
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "hash.h"
+
+static const uint64_t PRIME_1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t PRIME_3 = 0x165667B19E3779F9ULL;
+static const uint64_t PRIME_4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t PRIME_5 = 0x27D4EB2F165667C5ULL;
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+static inline uint64_t rotl(uint64_t x, int r){
+  return (x << r) | (x >> (64 - r));
+}
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/*
+ * note: memcpy loads are unaligned-safe and compile to single moves; the algorithm is defined little endian.
+ */
+/*--------------------------------------------------------------------------------------------------------------------*/
+static inline uint64_t read64(const uint8_t* p){
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  v = __builtin_bswap64(v);
+#endif
+  return v;
+}
+
+static inline uint32_t read32(const uint8_t* p){
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  v = __builtin_bswap32(v);
+#endif
+  return v;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+static inline uint64_t round64(uint64_t acc, uint64_t input){
+  acc += input * PRIME_2;
+  acc = rotl(acc, 31);
+  return acc * PRIME_1;
+}
+
+static inline uint64_t merge64(uint64_t acc, uint64_t val){
+  acc ^= round64(0, val);
+  return acc * PRIME_1 + PRIME_4;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+uint64_t hash_xxh64(const void* data, size_t n, uint64_t seed){
+  const uint8_t* p = (const uint8_t*)data;
+  const uint8_t* end = p + n;
+  uint64_t h;
+
+  // four independent lanes over 32 byte stripes...
+  if(n >= 32){
+    uint64_t v1 = seed + PRIME_1 + PRIME_2;
+    uint64_t v2 = seed + PRIME_2;
+    uint64_t v3 = seed;
+    uint64_t v4 = seed - PRIME_1;
+    const uint8_t* limit = end - 32;
+    do{
+      v1 = round64(v1, read64(p));
+      v2 = round64(v2, read64(p + 8));
+      v3 = round64(v3, read64(p + 16));
+      v4 = round64(v4, read64(p + 24));
+      p += 32;
+    } while(p <= limit);
+    h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+    h = merge64(h, v1);
+    h = merge64(h, v2);
+    h = merge64(h, v3);
+    h = merge64(h, v4);
+  }
+  else{
+    h = seed + PRIME_5;
+  }
+  h += (uint64_t)n;
+
+  // ...then the tail, 8, 4 and 1 bytes at a time...
+  for(; p + 8 <= end; p += 8){
+    h ^= round64(0, read64(p));
+    h = rotl(h, 27) * PRIME_1 + PRIME_4;
+  }
+  if(p + 4 <= end){
+    h ^= (uint64_t)read32(p) * PRIME_1;
+    h = rotl(h, 23) * PRIME_2 + PRIME_3;
+    p += 4;
+  }
+  for(; p < end; ++p){
+    h ^= (*p) * PRIME_5;
+    h = rotl(h, 11) * PRIME_1;
+  }
+
+  // ...and finally avalanche.
+  h ^= h >> 33;
+  h *= PRIME_2;
+  h ^= h >> 29;
+  h *= PRIME_3;
+  h ^= h >> 32;
+  return h;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
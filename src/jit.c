@@ -0,0 +1,594 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: jit.c
+ *
+ *===================================================================================================================*/
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "jit.h"
+#include "sim.h"
+#include "assembler.h"
+#include "outbuf.h"
+#include "asmerr.h"
+
+#if defined(__x86_64__) && defined(__linux__)
+#define JIT_SUPPORTED
+#endif
+
+#define ADDRESS_MASK 0x7fff
+#define JIT_FALLBACK 0xdf   // status of a run that stopped to finish on the interpreter; see 'jit_run'.
+#define MAX_INS_CODE 192    // most bytes of native code of one Hack instruction, its stub included.
+
+/*
+ * x86-64 registers, by their number in the encoding. The Hack registers live in host registers for the whole run:
+ *
+ *   esi  A          rbx  RAM          r8  cycles left (the budget)
+ *   edi  D          rbp  the table    r9  the JitState_t
+ *   eax  the ALU output, ecx the jump target and a temporary, edx the M address or value.
+ */
+#define EAX 0
+#define ECX 1
+#define EDX 2
+#define ESI 6
+#define EDI 7
+
+/*
+ * targets of the rel32 of a jump, resolved once all code is laid out; the kind is in the high byte of a target.
+ */
+#define TO_BODY  0x01000000 // the code of instruction i.
+#define TO_TRAMP 0x02000000 // leaves the run at instruction i, to be finished by the interpreter.
+#define TO_LABEL 0x03000000 // one of the LABEL_* exits.
+#define TO_INDEX 0x00ffffff
+
+#define LABEL_END      0 // ran past the end of the program.
+#define LABEL_HALT     1 // a halt was detected.
+#define LABEL_FALLBACK 2 // the budget is less than the block.
+#define LABEL_EXIT     3 // saves the registers and returns.
+#define NUM_LABELS     4
+
+/*
+ * brief: the state handed between C and the native code of a run; the offsets are in the native code.
+ */
+typedef struct JitState {
+  uint16_t* _p_ram;   // 0
+  void** _p_table;    // 8
+  uint64_t _budget;   // 16
+  uint32_t _a;        // 24
+  uint32_t _d;        // 28
+  uint32_t _pc;       // 32
+  uint32_t _status;   // 36
+} JitState_t;
+
+_Static_assert(offsetof(JitState_t, _budget) == 16 && offsetof(JitState_t, _status) == 36, "JitState_t layout");
+
+typedef void (*JitEntry_t)(JitState_t* p_state);
+
+/*
+ * brief: a compiled program.
+ *
+ * @member _p_code: the native code, mapped executable; the entry point of a run is at its start.
+ * @member _code_size: size of the mapping.
+ * @member _p_table: address of the stub of each ROM address, MAX_ADDRESS + 1 of them; the targets of computed jumps.
+ */
+struct Jit {
+  uint8_t* _p_code;
+  size_t _code_size;
+  void** _p_table;
+};
+
+/*
+ * brief: the code being emitted.
+ *
+ * @member _code: the native code; reserved MAX_INS_CODE bytes ahead, so single instructions are put without checks.
+ * @member _p_fixups: offset of each rel32 to resolve, with its TO_* target.
+ */
+typedef struct Emitter {
+  struct OutBuf _code;
+  uint32_t* _p_fixups;
+  uint32_t* _p_fixup_targets;
+  uint32_t _num_fixups;
+  uint32_t* _p_body;
+  uint32_t* _p_stub;
+  uint32_t* _p_tramp;
+  uint32_t _labels[NUM_LABELS];
+} Emitter_t;
+
+/*
+ * brief: the value of an operand of the ALU; a constant, or a host register that is maybe inverted.
+ */
+typedef struct Operand {
+  bool _is_const;
+  uint16_t _value;
+  uint8_t _reg;
+  bool _is_not;
+} Operand_t;
+
+/*=====================================================================================================================
+ * PRIVATE INTERFACE
+ *===================================================================================================================*/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void put(Emitter_t* p_em, const char* bytes, size_t n){
+  memcpy(p_em->_code._p_data + p_em->_code._size, bytes, n);
+  p_em->_code._size += n;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void put_u8(Emitter_t* p_em, uint8_t byte){
+  p_em->_code._p_data[p_em->_code._size++] = (char)byte;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void put_u32(Emitter_t* p_em, uint32_t value){
+  for(int b = 0; b < 4; ++b){
+    put_u8(p_em, (uint8_t)(value >> (8 * b)));
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: puts a rel32 to a TO_* target, to resolve once the target is laid out.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void put_rel32(Emitter_t* p_em, uint32_t target){
+  p_em->_p_fixups[p_em->_num_fixups] = (uint32_t)p_em->_code._size;
+  p_em->_p_fixup_targets[p_em->_num_fixups++] = target;
+  put_u32(p_em, 0);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: puts a jump, 'jmp' if cc is 0, else the jcc with that second opcode byte; e.g. 0x84 for 'je'.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void put_jump(Emitter_t* p_em, uint8_t cc, uint32_t target){
+  if(cc == 0){
+    put_u8(p_em, 0xe9);
+  }
+  else{
+    put_u8(p_em, 0x0f);
+    put_u8(p_em, cc);
+  }
+  put_rel32(p_em, target);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void put_mov_imm(Emitter_t* p_em, uint8_t reg, uint32_t imm){
+  put_u8(p_em, 0xb8 + reg);                                                 // mov reg, imm32
+  put_u32(p_em, imm);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void put_mov_reg(Emitter_t* p_em, uint8_t dst, uint8_t src){
+  put_u8(p_em, 0x89);                                                       // mov dst, src
+  put_u8(p_em, 0xc0 | (src << 3) | dst);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void put_not(Emitter_t* p_em, uint8_t reg){
+  put_u8(p_em, 0xf7);                                                       // not reg
+  put_u8(p_em, 0xd0 | reg);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: puts the address of M, i.e. A & ADDRESS_MASK, in edx.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void put_m_address(Emitter_t* p_em){
+  put_mov_reg(p_em, EDX, ESI);                                              // mov edx, esi
+  put(p_em, "\x81\xe2", 2);                                                 // and edx, ADDRESS_MASK
+  put_u32(p_em, ADDRESS_MASK);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void put_operand(Emitter_t* p_em, uint8_t reg, Operand_t op){
+  if(op._is_const){
+    put_mov_imm(p_em, reg, op._value);
+    return;
+  }
+  put_mov_reg(p_em, reg, op._reg);
+  if(op._is_not){
+    put_not(p_em, reg);
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void invert(Operand_t* p_op){
+  p_op->_value ^= 0xffff;
+  p_op->_is_not = !p_op->_is_not;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: puts the computation of the ALU, by its zx, nx, zy, ny, f and no bits, with the result in eax.
+ * @param y_reg: the host register of the y input, A or M.
+ *
+ * note: the bits are folded where an input is constant, so a computation mnemonic takes one to four instructions;
+ *  e.g. D+1 is x = !D, y = -1, out = !(x + y), i.e. mov, not, add -1, not.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void put_comp(Emitter_t* p_em, uint8_t bits, uint8_t y_reg){
+  Operand_t x = {._is_const = (bits & 0x20) != 0, ._value = 0, ._reg = EDI, ._is_not = false};
+  Operand_t y = {._is_const = (bits & 0x08) != 0, ._value = 0, ._reg = y_reg, ._is_not = false};
+  if(bits & 0x10){
+    invert(&x);
+  }
+  if(bits & 0x04){
+    invert(&y);
+  }
+  bool is_add = (bits & 0x02) != 0;
+  bool is_binary = false, is_dec = false;
+  Operand_t out = x;
+  if(x._is_const && y._is_const){
+    out._value = is_add ? x._value + y._value : x._value & y._value;
+  }
+  else if(!is_add && ((x._is_const && x._value == 0) || (y._is_const && y._value == 0))){
+    out = (Operand_t){._is_const = true, ._value = 0};
+  }
+  else if(!is_add || x._is_const || y._is_const){
+    // and of all ones, add of zero, or add of all ones: the other input, decremented for the last.
+    bool is_x_const = x._is_const;
+    out = is_x_const ? y : x;
+    is_dec = is_add && (is_x_const ? x._value : y._value) == 0xffff;
+    is_binary = !is_add && !x._is_const && !y._is_const;
+  }
+  else{
+    is_binary = true;
+  }
+
+  bool is_out_not = (bits & 0x01) != 0;
+  if(is_out_not && !is_binary && !is_dec){
+    invert(&out);
+    is_out_not = false;
+  }
+  if(is_binary){
+    put_operand(p_em, EAX, x);
+    put_operand(p_em, ECX, y);
+    put(p_em, is_add ? "\x01\xc8" : "\x21\xc8", 2);                         // add|and eax, ecx
+  }
+  else{
+    out._value &= 0xffff;
+    put_operand(p_em, EAX, out);
+  }
+  if(is_dec){
+    put(p_em, "\x83\xc0\xff", 3);                                           // add eax, -1
+  }
+  if(is_out_not){
+    put_not(p_em, EAX);
+  }
+  if(is_binary || is_dec || is_out_not || (!out._is_const && out._is_not)){
+    put(p_em, "\x0f\xb7\xc0", 3);                                           // movzx eax, ax
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: puts the entry to instruction i; leaves the run for the interpreter if the budget is less than the 'len'
+ *  instructions left in its block, else takes them from the budget.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void put_stub(Emitter_t* p_em, uint32_t i, uint32_t len){
+  p_em->_p_stub[i] = (uint32_t)p_em->_code._size;
+  put(p_em, "\x49\x81\xf8", 3);                                             // cmp r8, len
+  put_u32(p_em, len);
+  put_jump(p_em, 0x82, TO_TRAMP | i);                                       // jb tramp_i
+  put(p_em, "\x49\x81\xe8", 3);                                             // sub r8, len
+  put_u32(p_em, len);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: puts the code of instruction i; as the interpreter, M is written and the jump taken at the A of before.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void put_body(Emitter_t* p_em, const SimOp_t* op, uint32_t i){
+  static const uint8_t not_taken[8] = {0, 0x8e, 0x85, 0x8c, 0x8d, 0x84, 0x8f, 0}; // jle, jne, jl, jge, je, jg.
+
+  p_em->_p_body[i] = (uint32_t)p_em->_code._size;
+  if(op->_op == SIMOP_LOAD){
+    put_mov_imm(p_em, ESI, op->_value);                                     // mov esi, value
+    return;
+  }
+  if(op->_value & 0x40){
+    put_m_address(p_em);
+    put(p_em, "\x0f\xb7\x14\x53", 4);                                       // movzx edx, word [rbx + rdx * 2]
+  }
+  put_comp(p_em, op->_value & 0x3f, (op->_value & 0x40) ? EDX : ESI);
+  if(op->_dest & 0x1){
+    put_m_address(p_em);
+    put(p_em, "\x66\x89\x04\x53", 4);                                       // mov word [rbx + rdx * 2], ax
+  }
+  if(op->_jump != 0){
+    put_mov_reg(p_em, ECX, ESI);                                            // mov ecx, esi
+  }
+  if(op->_dest & 0x2){
+    put_mov_reg(p_em, EDI, EAX);                                            // mov edi, eax
+  }
+  if(op->_dest & 0x4){
+    put_mov_reg(p_em, ESI, EAX);                                            // mov esi, eax
+  }
+  if(op->_jump == 0){
+    return;
+  }
+
+  size_t skip = 0;
+  if(op->_jump != 0x7){
+    put(p_em, "\x66\x85\xc0", 3);                                           // test ax, ax
+    put(p_em, "\x0f", 1);                                                   // j<not taken> skip
+    put_u8(p_em, not_taken[op->_jump]);
+    skip = p_em->_code._size;
+    put_u32(p_em, 0);
+  }
+  put(p_em, "\x81\xe1", 2);                                                 // and ecx, ADDRESS_MASK
+  put_u32(p_em, ADDRESS_MASK);
+  if(op->_flags & SIMFLAG_NO_EFFECT){
+    put(p_em, "\x81\xf9", 2);                                               // cmp ecx, i
+    put_u32(p_em, i);
+    put_jump(p_em, 0x84, TO_LABEL | LABEL_HALT);                            // je halt
+  }
+  if(op->_flags & SIMFLAG_AFTER_LOAD){
+    put(p_em, "\x81\xf9", 2);                                               // cmp ecx, i - 1
+    put_u32(p_em, i - 1);
+    put_jump(p_em, 0x84, TO_LABEL | LABEL_HALT);                            // je halt
+  }
+  put(p_em, "\xff\x64\xcd\x00", 4);                                         // jmp [rbp + rcx * 8]
+  if(skip != 0){
+    uint32_t rel = (uint32_t)(p_em->_code._size - (skip + 4));
+    memcpy(p_em->_code._p_data + skip, &rel, 4);
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: puts the entry of a run, and its exits.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void put_prologue(Emitter_t* p_em){
+  put(p_em, "\x53\x55", 2);                                                 // push rbx; push rbp
+  put(p_em, "\x49\x89\xf9", 3);                                             // mov r9, rdi
+  put(p_em, "\x49\x8b\x19", 3);                                             // mov rbx, [r9]
+  put(p_em, "\x49\x8b\x69\x08", 4);                                         // mov rbp, [r9 + 8]
+  put(p_em, "\x4d\x8b\x41\x10", 4);                                         // mov r8, [r9 + 16]
+  put(p_em, "\x41\x8b\x71\x18", 4);                                         // mov esi, [r9 + 24]
+  put(p_em, "\x41\x8b\x79\x1c", 4);                                         // mov edi, [r9 + 28]
+  put(p_em, "\x41\x8b\x49\x20", 4);                                         // mov ecx, [r9 + 32]
+  put(p_em, "\xff\x64\xcd\x00", 4);                                         // jmp [rbp + rcx * 8]
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void put_exits(Emitter_t* p_em){
+  // the pc of each exit is in ecx...
+  p_em->_labels[LABEL_END] = (uint32_t)p_em->_code._size;
+  put(p_em, "\x4d\x85\xc0", 3);                                             // test r8, r8
+  put_jump(p_em, 0x84, TO_LABEL | LABEL_FALLBACK);                          // jz fallback
+  put_mov_imm(p_em, EAX, SIM_ENDED);
+  put_jump(p_em, 0, TO_LABEL | LABEL_EXIT);
+  p_em->_labels[LABEL_HALT] = (uint32_t)p_em->_code._size;
+  put_mov_imm(p_em, EAX, SIM_HALTED);
+  put_jump(p_em, 0, TO_LABEL | LABEL_EXIT);
+  p_em->_labels[LABEL_FALLBACK] = (uint32_t)p_em->_code._size;
+  put_mov_imm(p_em, EAX, JIT_FALLBACK);
+  p_em->_labels[LABEL_EXIT] = (uint32_t)p_em->_code._size;
+  put(p_em, "\x41\x89\x71\x18", 4);                                         // mov [r9 + 24], esi
+  put(p_em, "\x41\x89\x79\x1c", 4);                                         // mov [r9 + 28], edi
+  put(p_em, "\x4d\x89\x41\x10", 4);                                         // mov [r9 + 16], r8
+  put(p_em, "\x41\x89\x49\x20", 4);                                         // mov [r9 + 32], ecx
+  put(p_em, "\x41\x89\x41\x24", 4);                                         // mov [r9 + 36], eax
+  put(p_em, "\x5d\x5b\xc3", 3);                                             // pop rbp; pop rbx; ret
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int reserve(Emitter_t* p_em){
+  return outbuf_reserve(&p_em->_code, MAX_INS_CODE);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: emits the native code of a program.
+ *
+ * note: a block runs from an instruction that follows a jump to the next jump. The bodies of the instructions are laid
+ *  out in ROM order, and each block is entered at its stub, placed inline before its first body. A computed jump
+ *  can land inside a block, so every other instruction has a stub of its own, out of line, that jumps to its body.
+ *  Checking the budget once per block keeps the cycle count exact: a block either runs whole or is left to the
+ *  interpreter before it starts.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int emit_program(Emitter_t* p_em, const SimOp_t* p_ops, uint32_t n, uint32_t* p_len){
+  // the length of the rest of the block of each instruction...
+  for(uint32_t i = n; i-- > 0;){
+    bool is_block_end = (i + 1 == n) || (p_ops[i]._op != SIMOP_LOAD && p_ops[i]._jump != 0);
+    p_len[i] = is_block_end ? 1 : p_len[i + 1] + 1;
+  }
+
+  if(reserve(p_em) != SUCCESS){
+    return FAIL;
+  }
+  put_prologue(p_em);
+  for(uint32_t i = 0; i < n; ++i){
+    if(reserve(p_em) != SUCCESS){
+      return FAIL;
+    }
+    bool is_leader = (i == 0) || (p_ops[i - 1]._op != SIMOP_LOAD && p_ops[i - 1]._jump != 0);
+    if(is_leader){
+      put_stub(p_em, i, p_len[i]);
+    }
+    put_body(p_em, &p_ops[i], i);
+  }
+  if(reserve(p_em) != SUCCESS){
+    return FAIL;
+  }
+  put_mov_imm(p_em, ECX, n);                                                // ran off the end.
+  put_jump(p_em, 0, TO_LABEL | LABEL_END);
+
+  for(uint32_t i = 1; i < n; ++i){
+    if(p_ops[i - 1]._op != SIMOP_LOAD && p_ops[i - 1]._jump != 0){
+      continue;
+    }
+    if(reserve(p_em) != SUCCESS){
+      return FAIL;
+    }
+    put_stub(p_em, i, p_len[i]);
+    put_jump(p_em, 0, TO_BODY | i);
+  }
+  for(uint32_t i = 0; i < n; ++i){
+    if(reserve(p_em) != SUCCESS){
+      return FAIL;
+    }
+    p_em->_p_tramp[i] = (uint32_t)p_em->_code._size;
+    put_mov_imm(p_em, ECX, i);
+    put_jump(p_em, 0, TO_LABEL | LABEL_FALLBACK);
+  }
+  if(reserve(p_em) != SUCCESS){
+    return FAIL;
+  }
+  put_exits(p_em);
+
+  for(uint32_t f = 0; f < p_em->_num_fixups; ++f){
+    uint32_t target = p_em->_p_fixup_targets[f], index = target & TO_INDEX, to;
+    switch(target & ~TO_INDEX){
+      case TO_BODY:
+        to = p_em->_p_body[index];
+        break;
+      case TO_TRAMP:
+        to = p_em->_p_tramp[index];
+        break;
+      default:
+        to = p_em->_labels[index];
+    }
+    uint32_t rel = to - (p_em->_p_fixups[f] + 4);
+    memcpy(p_em->_code._p_data + p_em->_p_fixups[f], &rel, 4);
+  }
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void free_emitter(Emitter_t* p_em){
+  free_outbuf(&p_em->_code);
+  free(p_em->_p_fixups);
+  free(p_em->_p_fixup_targets);
+  free(p_em->_p_body);
+  free(p_em->_p_stub);
+  free(p_em->_p_tramp);
+}
+
+/*=====================================================================================================================
+ * PUBLIC INTERFACE
+ *===================================================================================================================*/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+bool jit_is_supported(){
+#ifdef JIT_SUPPORTED
+  return true;
+#else
+  return false;
+#endif
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+Jit_t* new_jit(const Sim_t* p_sim){
+  if(!jit_is_supported()){
+    return NULL;
+  }
+  uint32_t n = p_sim->_num_ins;
+  uint32_t max_fixups = 5 * n + 8; // a stub, its jump to the body, two halt checks and a trampoline.
+  Emitter_t em = {0};
+  em._p_fixups = (uint32_t*)malloc(max_fixups * sizeof(uint32_t));
+  em._p_fixup_targets = (uint32_t*)malloc(max_fixups * sizeof(uint32_t));
+  em._p_body = (uint32_t*)calloc(n + 1, sizeof(uint32_t));
+  em._p_stub = (uint32_t*)calloc(n + 1, sizeof(uint32_t));
+  em._p_tramp = (uint32_t*)calloc(n + 1, sizeof(uint32_t));
+  uint32_t* p_len = (uint32_t*)calloc(n + 1, sizeof(uint32_t));
+  Jit_t* p_jit = (Jit_t*)calloc(1, sizeof(Jit_t));
+  bool is_ok = init_outbuf(&em._code, (n + 16) * 64) == SUCCESS && em._p_fixups != NULL && 
+               em._p_fixup_targets != NULL && em._p_body != NULL && em._p_stub != NULL && em._p_tramp != NULL && 
+               p_len != NULL && p_jit != NULL;
+  is_ok = is_ok && emit_program(&em, p_sim->_p_ops, n, p_len) == SUCCESS;
+  free(p_len);
+  if(is_ok){
+    p_jit->_p_table = (void**)malloc((MAX_ADDRESS + 1) * sizeof(void*));
+    p_jit->_code_size = em._code._size;
+    p_jit->_p_code = (uint8_t*)mmap(NULL, p_jit->_code_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(p_jit->_p_code == MAP_FAILED){
+      p_jit->_p_code = NULL;
+    }
+    is_ok = p_jit->_p_table != NULL && p_jit->_p_code != NULL;
+  }
+  if(is_ok){
+    memcpy(p_jit->_p_code, em._code._p_data, p_jit->_code_size);
+    is_ok = mprotect(p_jit->_p_code, p_jit->_code_size, PROT_READ | PROT_EXEC) == 0;
+  }
+  if(is_ok){
+    for(uint32_t i = 0; i <= MAX_ADDRESS; ++i){
+      uint32_t to = (i < n) ? em._p_stub[i] : em._labels[LABEL_END];
+      p_jit->_p_table[i] = p_jit->_p_code + to;
+    }
+  }
+  free_emitter(&em);
+  if(!is_ok && p_jit != NULL){
+    free_jit(&p_jit);
+  }
+  return p_jit;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void free_jit(Jit_t** pp_jit){
+  if((*pp_jit)->_p_code != NULL){
+    munmap((*pp_jit)->_p_code, (*pp_jit)->_code_size);
+  }
+  free((*pp_jit)->_p_table);
+  free(*pp_jit);
+  (*pp_jit) = NULL;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int jit_run(Jit_t* p_jit, Sim_t* p_sim, uint64_t max_cycles){
+  uint64_t budget = (max_cycles == 0) ? UINT64_MAX : max_cycles;
+  JitState_t state = {p_sim->_p_ram, p_jit->_p_table, budget, p_sim->_a, p_sim->_d, p_sim->_pc, 0};
+  ((JitEntry_t)p_jit->_p_code)(&state);
+  p_sim->_a = (uint16_t)state._a;
+  p_sim->_d = (uint16_t)state._d;
+  p_sim->_pc = (uint16_t)state._pc;
+  p_sim->_cycles += budget - state._budget;
+  if(state._status != JIT_FALLBACK){
+    return (int)state._status;
+  }
+  // fewer cycles are left than the next block; the interpreter stops within it at the exact cycle...
+  return (state._budget == 0) ? SIM_LIMIT : sim_run(p_sim, state._budget);
+}
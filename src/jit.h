@@ -0,0 +1,80 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: jit.h
+ *
+ *===================================================================================================================*/
+
+
+#ifndef _JIT_H_
+#define _JIT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sim.h"
+
+/*
+ * brief: closed type of a program compiled to native code; instantiate with 'new_jit'.
+ */
+typedef struct Jit Jit_t;
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: true if the host can run compiled programs; x86-64 Linux.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+bool jit_is_supported();
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: compiles the program loaded in a simulator to native code.
+ * return: pointer to the compiled program, or NULL if unsupported or on error; the simulator may still interpret it.
+ *
+ * note: compile again after each 'sim_load'; the compiled program does not follow the ROM of the simulator.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+Jit_t* new_jit(const Sim_t* p_sim);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void free_jit(Jit_t** pp_jit);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: as 'sim_run', but runs the compiled program; the state the run stops in, the status returned and the cycles
+ *  counted are those of 'sim_run'.
+ *
+ * note: the run ends on the interpreter when fewer cycles are left than the block of instructions next to run.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int jit_run(Jit_t* p_jit, Sim_t* p_sim, uint64_t max_cycles);
+
+#endif
@@ -0,0 +1,181 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: jobserver.c
+ *
+ *===================================================================================================================*/
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include "jobserver.h"
+
+#define MAX_TOKENS 64 /* most tokens held at once; more jobs than this run in the implicit slot. */
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * SEE HEADER
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+struct Jobserver {
+  int _read_fd;                 /* non-blocking read end, opened by the client; tokens are taken from it. */
+  int _write_fd;                /* write end; tokens are returned to it. */
+  bool _is_own_write_fd;        /* flag indicates _write_fd was opened by the client, thus must be closed. */
+  char _tokens[MAX_TOKENS];     /* the tokens held; the bytes read must be the bytes written back. */
+  int _num_tokens;
+  pthread_mutex_t _lock;        /* guards _tokens. */
+};
+
+/*=====================================================================================================================
+ * PRIVATE HELPERS
+ *===================================================================================================================*/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: finds the value of the last jobserver option in MAKEFLAGS; make passes the latest last.
+ * return: the value, a copy to be freed, or NULL if there is none.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static char* find_auth(const char* flags){
+  static const char* names[] = {"--jobserver-auth=", "--jobserver-fds="};
+  const char* last = NULL;
+  const char* value = NULL;
+  for(int i = 0; i < 2; ++i){
+    for(const char* p = flags; (p = strstr(p, names[i])) != NULL; ++p){
+      if(last == NULL || p > last){
+        last = p;
+        value = p + strlen(names[i]);
+      }
+    }
+  }
+  return (value != NULL) ? strndup(value, strcspn(value, " ")) : NULL;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: opens the read and write ends of the jobserver named by the value of a jobserver option.
+ *
+ * note: the read end is opened anew, non-blocking, rather than made non-blocking with fcntl; the pipe inherited from
+ *  make is shared with every other job, and its flags with it.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static bool open_auth(Jobserver_t* p_js, const char* auth){
+  if(strncmp(auth, "fifo:", 5) == 0){
+    p_js->_read_fd = open(auth + 5, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    p_js->_write_fd = (p_js->_read_fd >= 0) ? open(auth + 5, O_WRONLY | O_CLOEXEC) : -1;
+    p_js->_is_own_write_fd = true;
+    return p_js->_read_fd >= 0 && p_js->_write_fd >= 0;
+  }
+  int r, w;
+  if(sscanf(auth, "%d,%d", &r, &w) != 2 || r < 0 || w < 0 || fcntl(r, F_GETFD) == -1 || fcntl(w, F_GETFD) == -1){
+    return false; // make did not pass the pipe to this recipe.
+  }
+  char path[32];
+  snprintf(path, sizeof(path), "/proc/self/fd/%d", r);
+  p_js->_read_fd = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+  p_js->_write_fd = w;
+  return p_js->_read_fd >= 0;
+}
+
+/*=====================================================================================================================
+ * PUBLIC INTERFACE
+ *===================================================================================================================*/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+Jobserver_t* new_jobserver(){
+  const char* flags = getenv("MAKEFLAGS");
+  char* auth = (flags != NULL) ? find_auth(flags) : NULL;
+  if(auth == NULL){
+    return NULL;
+  }
+  Jobserver_t* p_js = (Jobserver_t*)calloc(1, sizeof(Jobserver_t));
+  if(p_js == NULL){
+    free(auth);
+    return NULL;
+  }
+  p_js->_read_fd = p_js->_write_fd = -1;
+  bool is_open = open_auth(p_js, auth);
+  free(auth);
+  if(!is_open){
+    free_jobserver(&p_js);
+    return NULL;
+  }
+  pthread_mutex_init(&p_js->_lock, NULL);
+  return p_js;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void free_jobserver(Jobserver_t** pp_js){
+  Jobserver_t* p_js = *pp_js;
+  while(p_js->_num_tokens > 0){
+    jobserver_release(p_js);
+  }
+  if(p_js->_read_fd >= 0){
+    close(p_js->_read_fd);
+  }
+  if(p_js->_is_own_write_fd && p_js->_write_fd >= 0){
+    close(p_js->_write_fd);
+  }
+  free(p_js);
+  (*pp_js) = NULL;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+bool jobserver_try_acquire(Jobserver_t* p_js){
+  pthread_mutex_lock(&p_js->_lock);
+  bool is_acquired = false;
+  char token;
+  if(p_js->_num_tokens < MAX_TOKENS && read(p_js->_read_fd, &token, 1) == 1){
+    p_js->_tokens[p_js->_num_tokens++] = token;
+    is_acquired = true;
+  }
+  pthread_mutex_unlock(&p_js->_lock);
+  return is_acquired;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void jobserver_release(Jobserver_t* p_js){
+  pthread_mutex_lock(&p_js->_lock);
+  if(p_js->_num_tokens > 0){
+    char token = p_js->_tokens[--p_js->_num_tokens];
+    while(write(p_js->_write_fd, &token, 1) == -1 && errno == EINTR){
+    }
+  }
+  pthread_mutex_unlock(&p_js->_lock);
+}
@@ -0,0 +1,86 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: jobserver.h
+ *
+ *===================================================================================================================*/
+
+
+#ifndef _JOBSERVER_H_
+#define _JOBSERVER_H_
+
+#include <stdbool.h>
+
+/*
+ * brief: closed type of a client of the GNU make jobserver; instantiate with 'new_jobserver'.
+ *
+ * note: make hands each recipe one implicit job slot; a recipe that runs more than one job at a time takes a token
+ *  from the jobserver for each extra job and returns the token when the job ends, so a 'make -jN' build runs at
+ *  most N jobs overall. make only shares its jobserver with recipes it knows run sub-makes, so prefix the recipe 
+ *  line of hackass with '+'.
+ */
+typedef struct Jobserver Jobserver_t;
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: connects to the jobserver named in the MAKEFLAGS environment variable; either the pipe of 
+ *  '--jobserver-auth=R,W' (or '--jobserver-fds=R,W') or the fifo of '--jobserver-auth=fifo:PATH'.
+ * return: the jobserver, or NULL if not run by make with a jobserver, or if it cannot be used.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+Jobserver_t* new_jobserver();
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: returns any tokens still held and disconnects from the jobserver.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+void free_jobserver(Jobserver_t** pp_js);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: takes a token for an extra job, without blocking.
+ * return: true if a token was taken, false if the jobserver has none free.
+ * note: thread-safe.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+bool jobserver_try_acquire(Jobserver_t* p_js);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: returns a token taken with 'jobserver_try_acquire'.
+ * note: thread-safe.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+void jobserver_release(Jobserver_t* p_js);
+
+#endif
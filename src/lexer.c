@@ -0,0 +1,491 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: lexer.c
+ *
+ *===================================================================================================================*/
+
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+#include "asmerr.h"
+#include "parser.h"
+#include "lexer.h"
+
+/*=====================================================================================================================
+ * MNEMONIC TABLES
+ *===================================================================================================================*/
+
+/*
+ * note: the order of each table MUST match the order of the bit tables in the decoder; the lexer outputs indices into
+ *  these tables which the decoder uses directly. Index 0 of the dest and jump tables is the null mnemonic.
+ */
+static const char* g_dest_str[NUM_DEST_MNEMONICS] = {
+  "", "M", "D", "MD", "A", "AM", "AD", "AMD"
+};
+static const char* g_comp_str[NUM_COMP_MNEMONICS] = {
+  "0", "1", "-1", "D", "A", "!D", "!A", "-D", "-A", "D+1", "A+1", "D-1", "A-1", "D+A", "D-A", "A-D", "D&A", "D|A",
+  "M", "!M", "-M", "M+1", "M-1", "D+M", "D-M", "M-D", "D&M", "D|M"
+};
+static const char* g_jump_str[NUM_JUMP_MNEMONICS] = {
+  "", "JGT", "JEQ", "JGE", "JLT", "JNE", "JLE", "JMP"
+};
+
+/*
+ * restrictions on C commands with a jump field (CFORMAT_C0 and CFORMAT_C2); no mnemonic may reference the A or M
+ * registers, thus:
+ *
+ *  valid destinations: {D}
+ *  valid computations: {D, !D, -D, D+1, D-1, 0, 1, -1}
+ */
+#define JUMP_FORMAT_DEST 2
+#define JUMP_FORMAT_COMP_MASK ((1u << 0) | (1u << 1) | (1u << 2) | (1u << 3) | (1u << 5) | (1u << 7) | (1u << 9) | (1u << 11))
+
+#define MAX_LITERAL 32767 // max value of a 15-bit address.
+
+/*=====================================================================================================================
+ * STATE MACHINE TABLES
+ *===================================================================================================================*/
+
+/*
+ * byte classes; every byte of input maps to exactly one class and the transition table is indexed by class rather
+ * than by byte. Each character which appears in a mnemonic gets its own class so the mnemonic tries can be encoded
+ * in the transition table.
+ */
+enum ByteClass {
+  CC_WS, CC_SLASH, CC_AT, CC_LPAR, CC_RPAR, CC_EQ, CC_SEMI,
+  CC_ZERO, CC_ONE, CC_DIGIT,
+  CC_PLUS, CC_MINUS, CC_NOT, CC_AND, CC_OR,
+  CC_A, CC_D, CC_M, CC_J, CC_G, CC_T, CC_E, CC_Q, CC_L, CC_N, CC_P,
+  CC_SYM,  /* any other symbol character: letters, '_', '.', '$', ':' */
+  CC_BAD,  /* any byte which cannot appear in a command */
+  NUM_BYTE_CLASSES
+};
+
+/*
+ * fixed states; the states of the mnemonic tries are generated in 'init_lexer' and numbered after these.
+ *
+ * note: LS_START doubles as the root of the first field trie, which holds both the dest and comp mnemonics since it
+ *  is not known which field the first field is until a '=' or ';' is reached.
+ */
+#define LS_START       0
+#define LS_AT          1
+#define LS_A_LIT       2
+#define LS_A_SYM       3
+#define LS_LPAR        4
+#define LS_L_LIT       5
+#define LS_L_SYM       6
+#define LS_L_END_LIT   7
+#define LS_L_END_SYM   8
+#define LS_COMP_ROOT   9
+#define LS_JUMP_ROOT   10
+#define LS_NUM_FIXED   11
+
+/*
+ * error states; these share their values with the LEXERR_* results so the state the lexer stops in is its result.
+ * LS_E_FIELD1 is the exception; an invalid character in the first field could be either a dest or comp error, which
+ * is resolved on the error path.
+ */
+#define LS_FIRST_ERROR LEXERR_FORMAT
+#define LS_E_FIELD1    0xdf
+
+#define MAX_STATES LEX_BLANK   // states must not collide with the results stored in 'g_final'.
+#define NO_INDEX   0xff
+
+/*
+ * actions performed on entering a state from a non-whitespace byte.
+ */
+#define ACT_NONE 0
+#define ACT_LIT  1  // accumulate a digit of a literal.
+#define ACT_SYM  2  // append a character to a symbol.
+#define ACT_DEST 3  // passed a '=', capture the dest index of the previous state.
+#define ACT_COMP 4  // passed a ';', capture the comp index of the previous state.
+
+static uint8_t g_byte_class[256];
+static uint8_t g_transition[MAX_STATES][NUM_BYTE_CLASSES];
+static uint8_t g_final[MAX_STATES];   // result when the line ends in a state; a CFORMAT_*, LEX_BLANK or error state.
+static uint8_t g_action[MAX_STATES];
+static uint8_t g_dest_of[MAX_STATES]; // mnemonic accepted by a trie state, or NO_INDEX.
+static uint8_t g_comp_of[MAX_STATES];
+static uint8_t g_jump_of[MAX_STATES];
+static int g_num_states;
+
+/*=====================================================================================================================
+ * PRIVATE HELPERS
+ *===================================================================================================================*/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void init_byte_classes(){
+  for(int b = 0; b < 256; ++b){
+    g_byte_class[b] = CC_BAD;
+  }
+  for(int b = 'a'; b <= 'z'; ++b){
+    g_byte_class[b] = CC_SYM;
+  }
+  for(int b = 'A'; b <= 'Z'; ++b){
+    g_byte_class[b] = CC_SYM;
+  }
+  for(int b = '2'; b <= '9'; ++b){
+    g_byte_class[b] = CC_DIGIT;
+  }
+  g_byte_class['_'] = g_byte_class['.'] = g_byte_class['$'] = g_byte_class[':'] = CC_SYM;
+  g_byte_class[' '] = g_byte_class['\t'] = g_byte_class['\r'] = g_byte_class['\v'] = g_byte_class['\f'] = CC_WS;
+  g_byte_class['/'] = CC_SLASH;
+  g_byte_class['@'] = CC_AT;
+  g_byte_class['('] = CC_LPAR;
+  g_byte_class[')'] = CC_RPAR;
+  g_byte_class['='] = CC_EQ;
+  g_byte_class[';'] = CC_SEMI;
+  g_byte_class['0'] = CC_ZERO;
+  g_byte_class['1'] = CC_ONE;
+  g_byte_class['+'] = CC_PLUS;
+  g_byte_class['-'] = CC_MINUS;
+  g_byte_class['!'] = CC_NOT;
+  g_byte_class['&'] = CC_AND;
+  g_byte_class['|'] = CC_OR;
+  g_byte_class['A'] = CC_A;
+  g_byte_class['D'] = CC_D;
+  g_byte_class['M'] = CC_M;
+  g_byte_class['J'] = CC_J;
+  g_byte_class['G'] = CC_G;
+  g_byte_class['T'] = CC_T;
+  g_byte_class['E'] = CC_E;
+  g_byte_class['Q'] = CC_Q;
+  g_byte_class['L'] = CC_L;
+  g_byte_class['N'] = CC_N;
+  g_byte_class['P'] = CC_P;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: initialises the row of state 's'; all classes transition to 'dflt' except whitespace, which loops.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void init_state(int s, uint8_t dflt, uint8_t final, uint8_t action){
+  assert(s < MAX_STATES);
+  for(int c = 0; c < NUM_BYTE_CLASSES; ++c){
+    g_transition[s][c] = dflt;
+  }
+  g_transition[s][CC_WS] = (uint8_t)s;
+  g_transition[s][CC_SLASH] = LEXERR_FORMAT; // a lone '/' is not a comment.
+  g_final[s] = final;
+  g_action[s] = action;
+  g_dest_of[s] = g_comp_of[s] = g_jump_of[s] = NO_INDEX;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void set_delimiters(int s, uint8_t eq, uint8_t semi, uint8_t other){
+  g_transition[s][CC_EQ] = eq;
+  g_transition[s][CC_SEMI] = semi;
+  g_transition[s][CC_AT] = g_transition[s][CC_LPAR] = g_transition[s][CC_RPAR] = other;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void set_symbol_chars(int s, uint8_t to){
+  static const uint8_t classes[] = {
+    CC_ZERO, CC_ONE, CC_DIGIT, CC_A, CC_D, CC_M, CC_J, CC_G, CC_T, CC_E, CC_Q, CC_L, CC_N, CC_P, CC_SYM
+  };
+  for(size_t i = 0; i < sizeof(classes); ++i){
+    g_transition[s][classes[i]] = to;
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: a '=' ends the first field as a dest and a ';' ends it as a comp; if the mnemonic read so far is not a valid
+ *  mnemonic of that field the transition is to the field's error state.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void link_first_field(int s){
+  set_delimiters(s, (g_dest_of[s] != NO_INDEX) ? LS_COMP_ROOT : LEXERR_DEST,
+                    (g_comp_of[s] != NO_INDEX) ? LS_JUMP_ROOT : LEXERR_COMP, LEXERR_FORMAT);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: adds the path for mnemonic 'str' to the trie rooted at 'root', generating states as required.
+ * return: the state reached at the end of the mnemonic.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int insert_mnemonic(int root, const char* str, uint8_t dflt, uint8_t final){
+  int s = root;
+  for(; *str != '\0'; ++str){
+    uint8_t c = g_byte_class[(uint8_t)*str];
+    if(g_transition[s][c] >= LS_FIRST_ERROR){
+      init_state(g_num_states, dflt, final, ACT_NONE);
+      g_transition[s][c] = (uint8_t)g_num_states;
+      ++g_num_states;
+    }
+    s = g_transition[s][c];
+  }
+  return s;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void init_states(){
+  g_num_states = LS_NUM_FIXED;
+
+  // A and L commands...
+  init_state(LS_AT, LEXERR_SYMBOL, LEXERR_SYMBOL, ACT_NONE);
+  set_delimiters(LS_AT, LEXERR_FORMAT, LEXERR_FORMAT, LEXERR_FORMAT);
+  set_symbol_chars(LS_AT, LS_A_SYM);
+  g_transition[LS_AT][CC_ZERO] = g_transition[LS_AT][CC_ONE] = g_transition[LS_AT][CC_DIGIT] = LS_A_LIT;
+
+  init_state(LS_A_LIT, LEXERR_SYMBOL, CFORMAT_A1, ACT_LIT);
+  set_delimiters(LS_A_LIT, LEXERR_FORMAT, LEXERR_FORMAT, LEXERR_FORMAT);
+  g_transition[LS_A_LIT][CC_ZERO] = g_transition[LS_A_LIT][CC_ONE] = g_transition[LS_A_LIT][CC_DIGIT] = LS_A_LIT;
+
+  init_state(LS_A_SYM, LEXERR_SYMBOL, CFORMAT_A0, ACT_SYM);
+  set_delimiters(LS_A_SYM, LEXERR_FORMAT, LEXERR_FORMAT, LEXERR_FORMAT);
+  set_symbol_chars(LS_A_SYM, LS_A_SYM);
+
+  init_state(LS_LPAR, LEXERR_SYMBOL, LEXERR_FORMAT, ACT_NONE);
+  set_delimiters(LS_LPAR, LEXERR_FORMAT, LEXERR_FORMAT, LEXERR_FORMAT);
+  set_symbol_chars(LS_LPAR, LS_L_SYM);
+  g_transition[LS_LPAR][CC_ZERO] = g_transition[LS_LPAR][CC_ONE] = g_transition[LS_LPAR][CC_DIGIT] = LS_L_LIT;
+
+  init_state(LS_L_LIT, LEXERR_SYMBOL, LEXERR_FORMAT, ACT_LIT);
+  set_delimiters(LS_L_LIT, LEXERR_FORMAT, LEXERR_FORMAT, LEXERR_FORMAT);
+  g_transition[LS_L_LIT][CC_ZERO] = g_transition[LS_L_LIT][CC_ONE] = g_transition[LS_L_LIT][CC_DIGIT] = LS_L_LIT;
+  g_transition[LS_L_LIT][CC_RPAR] = LS_L_END_LIT;
+
+  init_state(LS_L_SYM, LEXERR_SYMBOL, LEXERR_FORMAT, ACT_SYM);
+  set_delimiters(LS_L_SYM, LEXERR_FORMAT, LEXERR_FORMAT, LEXERR_FORMAT);
+  set_symbol_chars(LS_L_SYM, LS_L_SYM);
+  g_transition[LS_L_SYM][CC_RPAR] = LS_L_END_SYM;
+
+  init_state(LS_L_END_LIT, LEXERR_TRAILING, CFORMAT_L1, ACT_NONE);
+  init_state(LS_L_END_SYM, LEXERR_TRAILING, CFORMAT_L0, ACT_NONE);
+
+  // C commands; generate the tries of the three fields...
+  init_state(LS_START, LS_E_FIELD1, LEX_BLANK, ACT_NONE);
+  int f1_first = g_num_states;
+  for(uint8_t d = 1; d < NUM_DEST_MNEMONICS; ++d){
+    g_dest_of[insert_mnemonic(LS_START, g_dest_str[d], LS_E_FIELD1, LEXERR_FORMAT)] = d;
+  }
+  for(uint8_t c = 0; c < NUM_COMP_MNEMONICS; ++c){
+    g_comp_of[insert_mnemonic(LS_START, g_comp_str[c], LS_E_FIELD1, LEXERR_FORMAT)] = c;
+  }
+  int f1_end = g_num_states;
+
+  init_state(LS_COMP_ROOT, LEXERR_COMP, LEXERR_COMP, ACT_DEST);
+  int comp_first = g_num_states;
+  for(uint8_t c = 0; c < NUM_COMP_MNEMONICS; ++c){
+    int s = insert_mnemonic(LS_COMP_ROOT, g_comp_str[c], LEXERR_COMP, LEXERR_COMP);
+    g_comp_of[s] = c;
+    g_final[s] = CFORMAT_C1;
+  }
+  int comp_end = g_num_states;
+
+  init_state(LS_JUMP_ROOT, LEXERR_JUMP, LEXERR_JUMP, ACT_COMP);
+  int jump_first = g_num_states;
+  for(uint8_t j = 1; j < NUM_JUMP_MNEMONICS; ++j){
+    int s = insert_mnemonic(LS_JUMP_ROOT, g_jump_str[j], LEXERR_JUMP, LEXERR_JUMP);
+    g_jump_of[s] = j;
+    g_final[s] = CFORMAT_C2; // upgraded to CFORMAT_C0 by the lexer if a dest was captured.
+  }
+  int jump_end = g_num_states;
+
+  // ...then link the tries through their delimiters.
+  link_first_field(LS_START);
+  for(int s = f1_first; s < f1_end; ++s){
+    link_first_field(s);
+  }
+  g_transition[LS_START][CC_AT] = LS_AT;
+  g_transition[LS_START][CC_LPAR] = LS_LPAR;
+  set_delimiters(LS_COMP_ROOT, LEXERR_FORMAT, LEXERR_COMP, LEXERR_FORMAT);
+  for(int s = comp_first; s < comp_end; ++s){
+    set_delimiters(s, LEXERR_FORMAT, (g_comp_of[s] != NO_INDEX) ? LS_JUMP_ROOT : LEXERR_COMP, LEXERR_FORMAT);
+  }
+  set_delimiters(LS_JUMP_ROOT, LEXERR_FORMAT, LEXERR_FORMAT, LEXERR_FORMAT);
+  for(int s = jump_first; s < jump_end; ++s){
+    set_delimiters(s, LEXERR_FORMAT, LEXERR_FORMAT, LEXERR_FORMAT);
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: returns the 1-based column of the first non-whitespace character after the first 'delim' in the line, or
+ *  of the first non-whitespace character of the line if delim is '\0'.
+ * note: only used on the error path.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static uint32_t field_column(const char* src, size_t n, char delim){
+  size_t i = 0;
+  if(delim != '\0'){
+    const char* d = (const char*)memchr(src, delim, n);
+    i = (d != NULL) ? (size_t)(d - src) + 1 : 0;
+  }
+  while(i < n && g_byte_class[(uint8_t)src[i]] == CC_WS){
+    ++i;
+  }
+  return (uint32_t)i + 1;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: resolves an invalid character in the first field of a C command to a dest or comp error, or a format error
+ *  if the line has no C command delimiters at all.
+ * note: only used on the error path.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int resolve_field1_error(const char* src, size_t n){
+  if(memchr(src, '=', n) != NULL){
+    return LEXERR_DEST;
+  }
+  if(memchr(src, ';', n) != NULL){
+    return LEXERR_COMP;
+  }
+  return LEXERR_FORMAT;
+}
+
+/*=====================================================================================================================
+ * PUBLIC INTERFACE
+ *===================================================================================================================*/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void init_lexer(){
+  static bool is_initialised = false;
+  if(is_initialised){
+    return;
+  }
+  init_byte_classes();
+  init_states();
+  is_initialised = true;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int lex_line(const char* src, size_t n, Command_t* p_out, uint32_t* p_column){
+  uint8_t state = LS_START;
+  uint32_t value = 0;
+  size_t symlen = 0;
+  bool has_dest = false;
+
+  p_out->_dest = p_out->_comp = p_out->_jump = 0;
+  p_out->_value = 0;
+
+  size_t i = 0;
+  for(; i < n; ++i){
+    uint8_t c = g_byte_class[(uint8_t)src[i]];
+    if(c == CC_SLASH && (i + 1) < n && src[i + 1] == '/'){
+      break; // comment runs to the end of the line.
+    }
+    uint8_t next = g_transition[state][c];
+    if(next >= LS_FIRST_ERROR){
+      *p_column = (uint32_t)i + 1;
+      return (next == LS_E_FIELD1) ? resolve_field1_error(src, n) : next;
+    }
+    if(g_action[next] != ACT_NONE && c != CC_WS){
+      switch(g_action[next]){
+        case ACT_LIT:
+          value = (value * 10) + (uint32_t)(src[i] - '0');
+          if(value > MAX_LITERAL){
+            *p_column = (uint32_t)i + 1;
+            return LEXERR_LITERAL;
+          }
+          break;
+        case ACT_SYM:
+          if(symlen == MAX_SYM_LENGTH - 1){
+            *p_column = (uint32_t)i + 1;
+            return LEXERR_SYMLEN;
+          }
+          p_out->_sym[symlen] = src[i];
+          ++symlen;
+          break;
+        case ACT_DEST:
+          p_out->_dest = g_dest_of[state];
+          has_dest = true;
+          break;
+        case ACT_COMP:
+          p_out->_comp = g_comp_of[state];
+          break;
+      }
+    }
+    state = next;
+  }
+
+  uint8_t result = g_final[state];
+  if(result >= LS_FIRST_ERROR){
+    *p_column = (uint32_t)i + 1;
+    return result;
+  }
+  switch(result){
+    case CFORMAT_C1:
+      p_out->_comp = g_comp_of[state];
+      break;
+    case CFORMAT_C2:
+      p_out->_jump = g_jump_of[state];
+      if(has_dest){
+        result = CFORMAT_C0;
+        if(p_out->_dest != JUMP_FORMAT_DEST){
+          *p_column = field_column(src, n, '\0');
+          return LEXERR_DEST;
+        }
+      }
+      if(((1u << p_out->_comp) & JUMP_FORMAT_COMP_MASK) == 0){
+        *p_column = field_column(src, n, has_dest ? '=' : '\0');
+        return LEXERR_COMP;
+      }
+      break;
+    case CFORMAT_A0:
+    case CFORMAT_L0:
+      p_out->_sym[symlen] = '\0';
+      break;
+    case CFORMAT_A1:
+    case CFORMAT_L1:
+      p_out->_value = (uint16_t)value;
+      break;
+  }
+  p_out->_type = result;
+  return (result == LEX_BLANK) ? LEX_BLANK : SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+const char* lexer_dest_str(uint8_t dest){
+  assert(dest < NUM_DEST_MNEMONICS);
+  return g_dest_str[dest];
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+const char* lexer_comp_str(uint8_t comp){
+  assert(comp < NUM_COMP_MNEMONICS);
+  return g_comp_str[comp];
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+const char* lexer_jump_str(uint8_t jump){
+  assert(jump < NUM_JUMP_MNEMONICS);
+  return g_jump_str[jump];
+}
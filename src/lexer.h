@@ -0,0 +1,96 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: lexer.h
+ *
+ *===================================================================================================================*/
+
+
+#ifndef _LEXER_H_
+#define _LEXER_H_
+
+#include <stddef.h>
+#include <inttypes.h>
+#include "parser.h"
+
+/*
+ * results of lexing a line, returned from 'lex_line'; anything other than SUCCESS or LEX_BLANK is an error state.
+ */
+#define LEX_BLANK       0xd0 // line contains only whitespace and/or a comment.
+#define LEXERR_FORMAT   0xd1 // unrecognised instruction format.
+#define LEXERR_DEST     0xd2 // invalid destination mnemonic.
+#define LEXERR_COMP     0xd3 // invalid computation mnemonic.
+#define LEXERR_JUMP     0xd4 // invalid jump mnemonic.
+#define LEXERR_SYMBOL   0xd5 // expected a symbol or literal after '@' or '('.
+#define LEXERR_SYMLEN   0xd6 // symbol longer than MAX_SYM_LENGTH - 1 characters.
+#define LEXERR_LITERAL  0xd7 // literal too large for a 15-bit address.
+#define LEXERR_TRAILING 0xd8 // unexpected characters after the ')' of an L command.
+
+/*
+ * mnemonic table sizes; mnemonic indices stored in Command_t index tables of these sizes. Index 0 of the dest and
+ * jump tables is the null mnemonic.
+ */
+#define NUM_DEST_MNEMONICS 8
+#define NUM_COMP_MNEMONICS 28
+#define NUM_JUMP_MNEMONICS 8
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: generates the byte-class and transition tables of the lexer's state machine; must be called before 'lex_line'.
+ * note: safe to call more than once; the tables are only generated on the first call.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+void init_lexer();
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: lexes a single raw line of a translation unit into a command, inspecting each byte exactly once. Whitespace
+ *  and comments are skipped, the command format is detected and all fields are extracted in the same pass.
+ * @param src: start of the line; need not be null terminated.
+ * @param n: length of the line in bytes, excluding the newline.
+ * @param <out> p_out: the lexed command; C command fields are stored as mnemonic table indices.
+ * @param <out> p_column: on error, the 1-based column of the byte which put the lexer into the error state.
+ * return: SUCCESS if a command was lexed, LEX_BLANK if the line has no command, else one of the LEXERR_* errors.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int lex_line(const char* src, size_t n, Command_t* p_out, uint32_t* p_column);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: map mnemonic table indices back to their assembly mnemonics; the null mnemonic maps to "".
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+const char* lexer_dest_str(uint8_t dest);
+const char* lexer_comp_str(uint8_t comp);
+const char* lexer_jump_str(uint8_t jump);
+
+#endif
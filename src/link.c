@@ -0,0 +1,277 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: link.c
+ *
+ *===================================================================================================================*/
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "link.h"
+#include "object.h"
+#include "archive.h"
+#include "assembler.h"
+#include "symbollib.h"
+#include "srcmap.h"
+#include "diag.h"
+#include "asmerr.h"
+
+#define VERBOSE(X)if(p->_is_verbose){fprintf(stdout, X);}
+#define VERBOSE2(X, Y)if(p->_is_verbose){fprintf(stdout, X, Y);}
+
+/*=====================================================================================================================
+ * PRIVATE HELPERS
+ *===================================================================================================================*/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: adds the exported labels of an object placed at ROM address 'base' to the symbol library.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void add_exports(Assembler_t* p, const Object_t* p_obj, uint32_t base){
+  ObjSym_t sym;
+  for(uint32_t i = 0; i < p_obj->_num_syms; ++i){
+    object_symbol(p_obj, i, &sym);
+    if(sym._kind != OBJSYM_EXPORT){
+      continue;
+    }
+    int result = symlib_add_symbol(p->_p_sym_lib, sym._name, (uint16_t)(base + sym._value), SYMTAG_LABEL);
+    if(result == ERROR_1){
+      fprintf(diag_stream(), "%s: multiple declerations of label %s - labels must be unique\n", p_obj->_name, sym._name);
+      p->_fail = FAIL;
+    }
+    else if(result != SUCCESS){
+      fprintf(diag_stream(), "fatal error: out of memory\n");
+      p->_fail = FAIL;
+    }
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: resolves the address of an imported symbol, allocating a variable if no object exports it.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static uint16_t resolve_import(Assembler_t* p, const char* name){
+  uint16_t address;
+  if(symlib_search_symbol(p->_p_sym_lib, name, &address) == SUCCESS){
+    return address;
+  }
+  address = (uint16_t)p->_ram_address;
+  if(symlib_add_symbol(p->_p_sym_lib, name, address, SYMTAG_VARIABLE) != SUCCESS){
+    fprintf(diag_stream(), "fatal error: out of memory\n");
+    p->_fail = FAIL;
+  }
+  VERBOSE2("allocated variable '%s'...\n", name);
+  ++p->_ram_address;
+  if(p->_ram_address == MAX_ADDRESS + 1){ // report once, when the first variable overflows.
+    fprintf(diag_stream(), "exceeded RAM size, variable with address '%" PRIx32 "' cannot fit in 32K memory\n", p->_ram_address);
+    p->_fail = FAIL;
+  }
+  return address;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: copies the words of an object placed at ROM address 'base' into the instruction array and patches its
+ *  relocations.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void relocate(Assembler_t* p, const Object_t* p_obj, uint32_t base){
+  uint16_t* p_words = p->_p_hackins + base;
+  for(uint32_t i = 0; i < p_obj->_num_words; ++i){
+    p_words[i] = object_word(p_obj, i);
+  }
+  ObjSym_t sym;
+  for(uint32_t r = 0; r < p_obj->_num_relocs; ++r){
+    uint32_t word, index;
+    object_reloc(p_obj, r, &word, &index);
+    object_symbol(p_obj, index, &sym);
+    uint16_t address = (sym._kind == OBJSYM_EXPORT) ? (uint16_t)(base + sym._value) : resolve_import(p, sym._name);
+    p_words[word] = address & 0x7fff; // an A instruction has a 0 msb.
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: grows an array, if required, to hold one more element.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int reserve_one(void** pp_array, uint32_t num, uint32_t* p_capacity, size_t elem_size){
+  if(num < *p_capacity){
+    return SUCCESS;
+  }
+  uint32_t capacity = (*p_capacity == 0) ? 16 : *p_capacity * 2;
+  void* p_array = realloc(*pp_array, capacity * elem_size);
+  if(p_array == NULL){
+    fprintf(diag_stream(), "fatal error: out of memory\n");
+    return FAIL;
+  }
+  *pp_array = p_array;
+  *p_capacity = capacity;
+  return SUCCESS;
+}
+
+/*=====================================================================================================================
+ * PUBLIC INTERFACE
+ *===================================================================================================================*/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+LinkSet_t* new_linkset(bool is_verbose){
+  LinkSet_t* p_set = (LinkSet_t*)calloc(1, sizeof(LinkSet_t));
+  if(p_set == NULL){
+    return NULL;
+  }
+  if(new_symlib(&p_set->_p_exports) != SUCCESS){
+    free(p_set);
+    return NULL;
+  }
+  if(new_symlib(&p_set->_p_pending) != SUCCESS){
+    free_symlib(&p_set->_p_exports);
+    free(p_set);
+    return NULL;
+  }
+  p_set->_is_verbose = is_verbose;
+  return p_set;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void free_linkset(LinkSet_t** pp_set){
+  LinkSet_t* p_set = *pp_set;
+  for(uint32_t o = 0; o < p_set->_num_objs; ++o){ // members borrow the mapping of their archive; free them first.
+    free_object(&p_set->_pp_objs[o]);
+  }
+  for(uint32_t a = 0; a < p_set->_num_archives; ++a){
+    free_archive(&p_set->_pp_archives[a]);
+  }
+  free(p_set->_pp_objs);
+  free(p_set->_pp_archives);
+  free(p_set->_p_imports);
+  free_symlib(&p_set->_p_exports);
+  free_symlib(&p_set->_p_pending);
+  free(p_set);
+  (*pp_set) = NULL;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int linkset_add_object(LinkSet_t* p_set, Object_t* p_obj){
+  if(reserve_one((void**)&p_set->_pp_objs, p_set->_num_objs, &p_set->_obj_capacity, sizeof(Object_t*)) != SUCCESS){
+    free_object(&p_obj);
+    return FAIL;
+  }
+  p_set->_pp_objs[p_set->_num_objs++] = p_obj;
+  ObjSym_t sym;
+  for(uint32_t i = 0; i < p_obj->_num_syms; ++i){
+    object_symbol(p_obj, i, &sym);
+    if(sym._kind == OBJSYM_EXPORT){
+      symlib_add_symbol(p_set->_p_exports, sym._name, 0, SYMTAG_LABEL); // duplicates are reported by the link.
+      continue;
+    }
+    if(symlib_add_symbol(p_set->_p_pending, sym._name, 0, SYMTAG_NONE) != SUCCESS){
+      continue; // already listed.
+    }
+    if(reserve_one((void**)&p_set->_p_imports, p_set->_num_imports, &p_set->_import_capacity, sizeof(char*)) != SUCCESS){
+      return FAIL;
+    }
+    p_set->_p_imports[p_set->_num_imports++] = sym._name;
+  }
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int linkset_add_archive(LinkSet_t* p_set, Archive_t* p_ar){
+  LinkSet_t* p = p_set; // for VERBOSE.
+  if(reserve_one((void**)&p_set->_pp_archives, p_set->_num_archives, &p_set->_archive_capacity,
+                 sizeof(Archive_t*)) != SUCCESS){
+    free_archive(&p_ar);
+    return FAIL;
+  }
+  p_set->_pp_archives[p_set->_num_archives++] = p_ar;
+
+  // the import list grows as members are added, so a single pass reaches the imports of the members too...
+  uint16_t unused;
+  for(uint32_t i = 0; i < p_set->_num_imports; ++i){
+    const char* name = p_set->_p_imports[i];
+    uint32_t member;
+    if(symlib_search_symbol(p_set->_p_exports, name, &unused) == SUCCESS || archive_find(p_ar, name, &member) != SUCCESS){
+      continue;
+    }
+    Object_t* p_obj = archive_member(p_ar, member);
+    if(p_obj == NULL){
+      return FAIL;
+    }
+    VERBOSE2("pulling member '%s'", p_obj->_name);
+    VERBOSE2(" to resolve '%s'...\n", name);
+    if(linkset_add_object(p_set, p_obj) != SUCCESS){
+      return FAIL;
+    }
+  }
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int link_objects(Assembler_t* p, Object_t* const* pp_objs, int num_objs){
+  uint32_t base = 0;
+  for(int o = 0; o < num_objs; ++o){
+    VERBOSE2("placing object '%s'", pp_objs[o]->_name);
+    VERBOSE2(" at ROM address %" PRIu32 "...\n", base);
+    add_exports(p, pp_objs[o], base);
+    base += pp_objs[o]->_num_words;
+  }
+  if(base > MAX_ADDRESS){
+    fprintf(diag_stream(), "program has %" PRIu32 " instructions, ROM holds at most %d\n", base, MAX_ADDRESS);
+    p->_fail = FAIL;
+  }
+  if(p->_fail != SUCCESS){
+    return FAIL;
+  }
+  if(assembler_reserve(p, base) != SUCCESS){
+    fprintf(diag_stream(), "fatal error: out of memory\n");
+    return p->_fail = FAIL;
+  }
+  base = 0;
+  for(int o = 0; o < num_objs; ++o){
+    relocate(p, pp_objs[o], base);
+    base += pp_objs[o]->_num_words;
+  }
+  p->_line_count = 0;
+  p->_ins_count = base;
+  if(p->_fail == SUCCESS && srcmap_build(p->_p_srcmap, p) != SUCCESS){
+    fprintf(diag_stream(), "fatal error: out of memory\n");
+    p->_fail = FAIL;
+  }
+  return p->_fail;
+}
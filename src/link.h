@@ -0,0 +1,129 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: link.h
+ *
+ *===================================================================================================================*/
+
+
+#ifndef _LINK_H_
+#define _LINK_H_
+
+#include <stdbool.h>
+#include "assembler.h"
+#include "object.h"
+#include "archive.h"
+
+/*
+ * brief: the inputs of a link; the objects given and the archive members pulled in to resolve their imports.
+ *
+ * @member _pp_objs: the objects to link, in ROM order; owned by the set.
+ * @member _pp_archives: the archives the members were pulled from; owned by the set.
+ * @member _p_exports: library of the labels exported by the objects.
+ * @member _p_pending: library of the imports of the objects seen so far, to list each once.
+ * @member _p_imports: the imports of the objects, in order of first use; borrowed from the objects.
+ * @member _is_verbose: flag to control verbose output.
+ */
+typedef struct LinkSet {
+  Object_t** _pp_objs;
+  uint32_t _num_objs;
+  uint32_t _obj_capacity;
+  Archive_t** _pp_archives;
+  uint32_t _num_archives;
+  uint32_t _archive_capacity;
+  struct SymLib* _p_exports;
+  struct SymLib* _p_pending;
+  const char** _p_imports;
+  uint32_t _num_imports;
+  uint32_t _import_capacity;
+  bool _is_verbose;
+} LinkSet_t;
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: instantiates an empty set of link inputs.
+ * return: pointer to the new set or NULL on error.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+LinkSet_t* new_linkset(bool is_verbose);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: frees a set, with its objects and archives.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+void free_linkset(LinkSet_t** pp_set);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: adds an object to the set; the set takes ownership of the object.
+ * return: SUCCESS, or FAIL on malloc error.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int linkset_add_object(LinkSet_t* p_set, Object_t* p_obj);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: adds the members of an archive that resolve imports of the set; the set takes ownership of the archive.
+ *  Each import that no object of the set exports is looked up in the index of the archive, and the member that 
+ *  exports it is added, along with its own imports, until no import of the set can be resolved by the archive.
+ * return: SUCCESS, or FAIL if a pulled member is invalid or on malloc error.
+ *
+ * note: as with the archives of a unix linker, an archive only resolves the imports of the objects before it; 
+ *  imports it cannot resolve may be resolved by later archives, else become variables.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int linkset_add_archive(LinkSet_t* p_set, Archive_t* p_ar);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: links objects into a program held by an assembler, as if the translation units of the objects had been
+ *  assembled as one; the back ends then emit the program as they would an assembled unit.
+ *
+ *  1. ROM is laid out by placing the words of the objects one after another, in the order given.
+ *  2. the exported labels of all objects are added to the symbol library at their ROM address; a label exported by
+ *     two objects is an error.
+ *  3. the relocations are patched in order; an imported symbol that no object exports is a variable, allocated RAM
+ *     from RAM_START_ADDRESS on its first use.
+ *
+ * @param p: a new (or reset) assembler; receives the instructions and the symbol library of the program.
+ * return: SUCCESS, or FAIL if the objects do not link; errors are reported to the diagnostic stream (see diag.h).
+ *
+ * note: variables are allocated in the order of first use across the objects, as 'assembler_assemble' allocates
+ *  them in the order of first appearance; linking the objects of the parts of a program gives the instructions of
+ *  the whole.
+ * note: the assembler holds no commands after linking, thus cannot emit EMIT_STRIP.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int link_objects(Assembler_t* p, Object_t* const* pp_objs, int num_objs);
+
+#endif
@@ -38,29 +38,48 @@
 #include <stdio.h>
 #include <assert.h>
 #include <string.h>
-#include "symbollib.h"
-#include "parser.h"
+#include <inttypes.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <time.h>
 #include "asmerr.h"
-#include "decoder.h"
+#include "outbuf.h"
+#include "outfile.h"
+#include "cache.h"
+#include "server.h"
+#include "watch.h"
+#include "jobserver.h"
+#include "assembler.h"
+#include "emit.h"
+#include "object.h"
+#include "archive.h"
+#include "link.h"
+#include "sim.h"
+#include "jit.h"
+#include "batch.h"
+#include "tester.h"
+#include "profile.h"
+#include "coverage.h"
+#include "snapshot.h"
+#include "screen.h"
+#include "srcmap.h"
+#include "optimize.h"
 
 #define VERBOSE(X)if(g_is_verbose){fprintf(stdout, X);}
 #define VERBOSE2(X, Y)if(g_is_verbose){fprintf(stdout, X, Y);}
 
-#define MAX_ADDRESS 32768        // RAM and ROM on the Hack platform are both 15-bit addressed 32K memory.
-#define RAM_START_ADDRESS 1024
 #define MAX_FILENAME_CHAR 256    // filename have 256 character max on linux.
 #define MAX_FILEPATH_CHAR 4096   // file paths have max 4K bytes on linux.
 
-/*
- * Data used in solution to print binary representation of 16-bit instructions. Adapted from:
- *  source: https://stackoverflow.com/questions/111928/is-there-a-printf-converter-to-print-in-binary-format?page=1&tab=votes#tab-top
- */
-static const char* g_bitstr[16] = {
-    [ 0] = "0000", [ 1] = "0001", [ 2] = "0010", [ 3] = "0011",
-    [ 4] = "0100", [ 5] = "0101", [ 6] = "0110", [ 7] = "0111",
-    [ 8] = "1000", [ 9] = "1001", [10] = "1010", [11] = "1011",
-    [12] = "1100", [13] = "1101", [14] = "1110", [15] = "1111",
-};
+#define DEFAULT_CACHE_SIZE (64ULL << 20)
+#define CACHE_FORMAT_STRIP_MODE 0x100  // cache format of -s output; distinct from all EMIT_* formats.
+#define CACHE_FORMAT_OBJECT 0x101      // cache format of -c output.
+#define DEFAULT_MAX_CYCLES (1ULL << 30)
+#define DEFAULT_FRAME_CYCLES 100000
+#define NUM_RUN_REGISTERS 16           // R0..R15, printed after --run.
+#define SESSION_SLICE_CYCLES (1 << 20) // cycles a --run --watch session runs between polls of its infile.
 
 /*
  * operation modes of the assembler.
@@ -68,22 +87,70 @@ static const char* g_bitstr[16] = {
 typedef enum Mode {
   MODE_HELP,        // outputs a help message.
   MODE_STRIP,       // strips whitespace, comments and symbols from a .asm file; outputs another .asm file.
-  MODE_ASSEMBLE     // converts a .asm file to a .hack file containing 'Hack' machine instructions in string form.
+  MODE_ASSEMBLE,    // converts a .asm file to a .hack file containing 'Hack' machine instructions in string form.
+  MODE_COMPILE,     // converts a .asm file to a relocatable object, for separate assembly.
+  MODE_LINK,        // links objects into a program; outputs the artifacts of MODE_ASSEMBLE.
+  MODE_ARCHIVE,     // bundles objects into an indexed archive, for linking.
+  MODE_SERVE,       // serves assembly requests of clients over a unix domain socket.
+  MODE_TEST         // runs the tests of a directory on the simulator; outputs a JUnit report.
 } Mode_t;
 
+/*
+ * brief: a back end job; composes one artifact into its own buffer and writes it to its own file.
+ */
+typedef struct EmitJob {
+  int _kind;                         // EMIT_* id of the artifact, SERVE_KIND_STRIP for the -s output.
+  char _path[MAX_FILEPATH_CHAR];     // file to write the artifact to.
+  uint64_t _key;                     // cache key of the artifact; only set if caching.
+  int _result;                       // SUCCESS or FAIL.
+  pthread_t _thread;
+} EmitJob_t;
+
 static Mode_t g_mode;
-static struct SymLib* gp_sym_lib;                  // for user defined symbols.
-static Parser_t* gp_parser;
+static Assembler_t* gp_asm;                        // the assembler front end.
 static char* g_ifpath;                             // file path string to input .asm file (dynamically allocated).
 static char g_ofname[MAX_FILENAME_CHAR];           // name of output file.
-static FILE* g_ofstream;                           // output file stream to print results.
-static uint16_t g_line_count;                      // number of non-whitespace/comment lines in the translation unit.
-static uint16_t g_ins_count;                       // number of instructions to generate (= num_line - num_L_commands).
-static uint16_t g_ram_address = RAM_START_ADDRESS; // the next ram address to store a new variable.
-static Command_t* gp_cmds;                         // array of command structs generated from parsing lines.
-static uint16_t* gp_hackins;                       // array of hack machine instructions.
-static int g_asm_fail;                             // flag indicates if assembly failed.
+static bool g_has_ofname;                          // flag indicates if the output file was named with -o.
+static int g_emit;                                 // EMIT_* flags of artifacts selected with --emit.
 static bool g_is_verbose;                          // flag to control verbose output. 
+static bool g_is_if_changed;                       // flag to skip writing outputs whose content is unchanged.
+static bool g_is_stats;                            // flag to print statistics on completion.
+static uint8_t g_opt_level;                        // optimisation level of -O0 or -O1.
+static char* g_profile_use_path;                   // folded stacks of a profile to guide -O1 with, else NULL.
+static uint64_t* g_line_cycles;                    // the cycles of each line of the profile of --profile-use.
+static char* g_cache_dir;                          // directory of the output cache, NULL if not caching.
+static uint64_t g_cache_size = DEFAULT_CACHE_SIZE; // size limit of the output cache.
+static Cache_t* gp_cache;                          // the output cache, NULL if not caching.
+static char* g_serve_path;                         // socket to serve requests on with --serve.
+static char* g_client_path;                        // socket of the server to send requests to with --client.
+static bool g_is_watch;                            // flag to reassemble the input whenever it changes.
+static bool g_is_link;                             // flag to link objects with --link.
+static bool g_is_archive;                          // flag to archive objects with --archive.
+static char** g_objpaths;                          // file paths of the objects to link or archive (borrowed from argv).
+static int g_num_objpaths;
+static bool g_is_depfile;                          // flag to write a make dependency file with -MD or -MF.
+static char* g_depfile;                            // dependency file named with -MF, else NULL.
+static bool g_is_run;                              // flag to run the program on the simulator with --run.
+static uint64_t g_max_cycles = DEFAULT_MAX_CYCLES; // cycle limit of --run; 0 for none.
+static bool g_is_jit;                              // flag to run compiled to native code with --jit.
+static char* g_batch_path;                         // test vectors to run a batch of instances of with --batch.
+static char* g_dump_path;                          // file to dump the RAM of each run to with --dump.
+static bool g_is_profile;                          // flag to profile the run with --profile.
+static char* g_folded_path;                        // file to write the folded stacks of the profile to, else NULL.
+static bool g_is_coverage;                         // flag to report the coverage of the run or tests with --coverage.
+static char* g_coverage_path;                      // file to merge the coverage of the run into, else NULL.
+static char* g_save_path;                          // file to save the state the run stops in to with --save.
+static char* g_restore_path;                       // snapshot to start the run from with --restore.
+static uint64_t g_rewind;                          // cycles to step the run back with --rewind; 0 for none.
+static char* g_frames_path;                        // file to write frames of the screen of the run to with --frames.
+static uint64_t g_frame_cycles = DEFAULT_FRAME_CYCLES; // cycles between frames of --frames.
+static bool g_is_test;                             // flag to run the tests of the input directory with --test.
+static Jobserver_t* gp_jobserver;                  // jobserver of the make running hackass, NULL if none.
+static EmitJob_t g_jobs[NUM_EMIT_KINDS];           // the outputs of the mode, for the dependency file.
+static int g_num_jobs;
+static uint32_t g_stat_commands;                   // counts of the assembly, for --stats.
+static uint32_t g_stat_instructions;
+static uint32_t g_stat_variables;
 
 /*-------------------------------------------------------------------------------------------------------------------*/
 /*
@@ -91,240 +158,763 @@ static bool g_is_verbose;                          // flag to control verbose ou
  */
 /*-------------------------------------------------------------------------------------------------------------------*/
 void clean_exit(){
-  if(gp_sym_lib){
-    free_symlib(&gp_sym_lib); 
+  if(gp_asm){
+    free_assembler(&gp_asm);
   }
-  if(gp_parser){
-    free_parser(&gp_parser);
+  if(g_ifpath){
+    free(g_ifpath);
   }
-  if(gp_cmds){
-    free(gp_cmds);
+  if(gp_cache){
+    free_cache(&gp_cache);
   }
-  if(gp_hackins){
-    free(gp_hackins);
+  if(g_cache_dir){
+    free(g_cache_dir);
   }
-  if(g_ifpath){
-    free(g_ifpath);
+  free(g_serve_path);
+  free(g_client_path);
+  free(g_objpaths);
+  free(g_depfile);
+  free(g_batch_path);
+  free(g_dump_path);
+  free(g_folded_path);
+  free(g_profile_use_path);
+  free(g_line_cycles);
+  free(g_coverage_path);
+  free(g_save_path);
+  free(g_restore_path);
+  free(g_frames_path);
+  if(gp_jobserver){
+    free_jobserver(&gp_jobserver); // return any tokens, even on exit(FAIL).
   }
 }
 
 /*-------------------------------------------------------------------------------------------------------------------*/
-static void next_ram(){
-  ++g_ram_address;
-  if(g_ram_address > MAX_ADDRESS){
-    fprintf(stderr, "exceeded RAM size, variable with address '%x' cannot fit in 32K memory/n", g_ram_address);
-    g_asm_fail = FAIL;
+/*
+ * brief: atomically replaces the file at 'path' with the contents of a buffer; with --if-changed, leaves the file
+ *  (and its mtime) untouched if it already holds the contents, so make does not rebuild what depends on it.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int write_file(const char* path, struct OutBuf* p_buf){
+  int status;
+  if(outfile_commit(p_buf, path, g_is_if_changed, &status) != SUCCESS){
+    return FAIL;
   }
+  if(status == OUTFILE_UNCHANGED){
+    VERBOSE2("file '%s' is unchanged, not written.\n", path);
+  }
+  return SUCCESS;
 }
 
 /*-------------------------------------------------------------------------------------------------------------------*/
-static inline void next_line(){
-  ++g_line_count;
+/*
+ * brief: reads the whole of a file into a buffer.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int read_file(const char* path, struct OutBuf* p_buf){
+  int fd = open(path, O_RDONLY);
+  struct stat st;
+  if(fd < 0 || fstat(fd, &st) != 0 || outbuf_reserve(p_buf, (size_t)st.st_size) != SUCCESS){
+    perror(path);
+    if(fd >= 0){
+      close(fd);
+    }
+    return FAIL;
+  }
+  ssize_t r;
+  while((r = read(fd, p_buf->_p_data + p_buf->_size, p_buf->_capacity - p_buf->_size)) > 0){
+    p_buf->_size += (size_t)r;
+    if(p_buf->_size == p_buf->_capacity && outbuf_reserve(p_buf, 1 << 12) != SUCCESS){
+      r = -1;
+      break;
+    }
+  }
+  if(r < 0){
+    perror(path);
+  }
+  close(fd);
+  return (r < 0) ? FAIL : SUCCESS;
 }
 
 /*-------------------------------------------------------------------------------------------------------------------*/
-static void next_instruction(){
-  ++g_ins_count;
-  if(g_line_count > MAX_ADDRESS){
-    fprintf(stderr, "exceeded ROM size, instruction '%d' cannot fit in 32K memory\n", g_line_count);
-    g_asm_fail = FAIL;
+/*
+ * brief: initialises a buffer, printing a diagnostic if it cannot be allocated.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int init_buffer(struct OutBuf* p_buf, size_t capacity){
+  if(init_outbuf(p_buf, capacity) != SUCCESS){
+    fprintf(stderr, "fatal error: out of memory\n");
+    return FAIL;
   }
+  return SUCCESS;
 }
 
 /*-------------------------------------------------------------------------------------------------------------------*/
 /*
- * brief: attemps to add the symbol to the appropriate library.
- * returns: SUCCESS if symbol added, FAIL if symbol already exists in the library.
+ * brief: stores the composed artifact of a job in the cache, if caching, and writes it to its file.
  */
 /*-------------------------------------------------------------------------------------------------------------------*/
-static int add_symbol(Symbol_t* p_sym){
-  assert(p_sym->_type == SYMBOL_A || p_sym->_type == SYMBOL_L);
-  int result;
-  switch(p_sym->_type){
-    case SYMBOL_A:
-      result = symlib_add_symbol(gp_sym_lib, p_sym->_sym, g_ram_address);
-      assert(result == SUCCESS || result == ERROR_1);
-      return (result == SUCCESS) ? next_ram(), SUCCESS : FAIL;
-    case SYMBOL_L:
-      result = symlib_add_symbol(gp_sym_lib, p_sym->_sym, g_ins_count);
-      assert(result == SUCCESS || result == ERROR_1);
-      return (result == SUCCESS) ? SUCCESS : FAIL;
+static void finish_job(EmitJob_t* p_job, struct OutBuf* p_out){
+  if(gp_cache){
+    cache_store(gp_cache, p_job->_key, p_out);
   }
+  p_job->_result = write_file(p_job->_path, p_out);
 }
 
 /*-------------------------------------------------------------------------------------------------------------------*/
 /*
- * brief: searches the translation unit for symbols and adds all unique symbols to the library.
- *
- * note: this operation must be done in 2 phases because an '@' assembly instruction is ambiguous; it is not 
- *  possible to know if the symbol after the '@' refers to a variable or a label without first knowing what labels
- *  exist.
+ * brief: thread entry of a back end job.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void* run_emit_job(void* p_arg){
+  EmitJob_t* p_job = (EmitJob_t*)p_arg;
+  struct OutBuf out;
+  p_job->_result = init_outbuf(&out, 1 << 16);
+  if(p_job->_result == SUCCESS){
+    p_job->_result = emitter_of(p_job->_kind)(gp_asm, &out);
+  }
+  if(p_job->_result == SUCCESS){
+    finish_job(p_job, &out);
+  }
+  else{
+    fprintf(stderr, "fatal error: out of memory composing %s\n", p_job->_path);
+  }
+  free_outbuf(&out);
+  return NULL;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: the stem of the names of output files; the output file name, else the input file name without .asm
+ *  (or without .hobj when linking).
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void output_stem(char* stem){
+  if(g_has_ofname){
+    strncpy(stem, g_ofname, MAX_FILEPATH_CHAR - 1);
+    stem[MAX_FILEPATH_CHAR - 1] = '\0';
+    return;
+  }
+  const char* ext = (g_mode == MODE_LINK) ? OBJECT_EXTENSION : ".asm";
+  size_t l = strlen(g_ifpath), e = strlen(ext);
+  l = (l > e && strcmp(g_ifpath + l - e, ext) == 0) ? l - e : l;
+  snprintf(stem, MAX_FILEPATH_CHAR, "%.*s", (int)l, g_ifpath);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: creates a back end job for each selected artifact.
+ * return: the number of jobs.
  *
- * note: this function also counts the number of lines in the file, and for this reason MUST be the first operation
- *  performed by the assembler; this is convenient for initialising labels.
+ * note: if one artifact is selected, it is written to the output file; otherwise each artifact is written to the
+ *  output file name (or the input file name without .asm) plus the artifact's extension.
  */
 /*-------------------------------------------------------------------------------------------------------------------*/
-static int parse_symbols(){
-  Symbol_t sym;
-  int result;
+static int plan_jobs(int emit, EmitJob_t* p_jobs){
+  int num_jobs = 0;
 
-  // first add all predefined symbols...
-  strcpy(sym._sym, "SP");
-  assert(symlib_add_symbol(gp_sym_lib, sym._sym, 0) == SUCCESS);
-  strcpy(sym._sym, "LCL");
-  assert(symlib_add_symbol(gp_sym_lib, sym._sym, 1) == SUCCESS);
-  strcpy(sym._sym, "ARG");
-  assert(symlib_add_symbol(gp_sym_lib, sym._sym, 2) == SUCCESS);
-  strcpy(sym._sym, "THIS");
-  assert(symlib_add_symbol(gp_sym_lib, sym._sym, 3) == SUCCESS);
-  strcpy(sym._sym, "THAT");
-  assert(symlib_add_symbol(gp_sym_lib, sym._sym, 4) == SUCCESS);
-  char rx[4];
-  for(int r = 0; r <= 15; ++r){
-    snprintf(rx, 4, "R%d", r);
-    strcpy(sym._sym, rx);
-    assert(symlib_add_symbol(gp_sym_lib, sym._sym, r) == SUCCESS);
-  }
-  strcpy(sym._sym, "SCREEN");
-  assert(symlib_add_symbol(gp_sym_lib, sym._sym, 16384) == SUCCESS);
-  strcpy(sym._sym, "KBD");
-  assert(symlib_add_symbol(gp_sym_lib, sym._sym, 24576) == SUCCESS);
-
-  // parse all labels...
-  while((result = parser_next_symbol(gp_parser, &sym)) != CMD_EOF){
-    if(result != FAIL && sym._type == SYMBOL_L){
-      VERBOSE2("found label symbol '%s', adding to symbol library...\n", sym._sym);
-      if(add_symbol(&sym) != SUCCESS){
-        fprintf(stderr, "multiple declerations of label %s - labels must be unique\n", sym._sym);
-        g_asm_fail = FAIL; 
-      }
+  bool is_single = (emit & (emit - 1)) == 0;
+  char stem[MAX_FILEPATH_CHAR];
+  output_stem(stem);
+
+  for(int k = 0; k < NUM_EMIT_KINDS; ++k){
+    if((emit & (1 << k)) == 0){
+      continue;
+    }
+    EmitJob_t* p_job = &p_jobs[num_jobs];
+    p_job->_kind = 1 << k;
+    if(is_single){
+      snprintf(p_job->_path, MAX_FILEPATH_CHAR, "%s", g_ofname);
     }
     else{
-      next_instruction(); // dont count L commands; they dont generate instructions.
+      snprintf(p_job->_path, MAX_FILEPATH_CHAR, "%s%s", stem, emit_extension(p_job->_kind));
     }
-    next_line();
+    ++num_jobs;
   }
-  parser_rewind(gp_parser); 
+  return num_jobs;
+}
 
-  // then parse all variables...
-  while((result = parser_next_symbol(gp_parser, &sym)) != CMD_EOF){
-    if(result == FAIL){
-      continue;
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: true if the program is to be written; --run alone writes no outputs, unless they are named.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static bool is_writing(){
+  return !g_is_run || g_has_ofname || g_emit != 0 || g_is_depfile;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: looks up the output of a cache format of the input file, writing it to 'path' on a hit.
+ * @param <out> p_key: the cache key of the output, for storing the output on a miss.
+ * return: SUCCESS on a hit, ERROR_1 on a miss, FAIL if an output could not be written.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int fetch_cached(uint32_t format, const char* path, uint64_t* p_key){
+  if(cache_key_file(g_ifpath, format, p_key) != SUCCESS){
+    exit(FAIL);
+  }
+  struct OutBuf out;
+  if(init_buffer(&out, 1 << 16) != SUCCESS){
+    return FAIL;
+  }
+  int result = cache_fetch(gp_cache, *p_key, &out);
+  if(result == SUCCESS){
+    VERBOSE2("found output in cache, writing to file '%s'...\n", path);
+    result = write_file(path, &out);
+  }
+  free_outbuf(&out);
+  return result;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: writes the artifacts of all jobs from the cache if all are cached; sets the cache keys of the jobs.
+ * return: SUCCESS if all artifacts were cached and written, ERROR_1 if any missed, FAIL on write error.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int fetch_cached_jobs(EmitJob_t* p_jobs, int num_jobs){
+  int result = SUCCESS;
+  for(int j = 0; j < num_jobs && result == SUCCESS; ++j){
+    result = fetch_cached((uint32_t)p_jobs[j]._kind, p_jobs[j]._path, &p_jobs[j]._key);
+  }
+  for(int j = 0; j < num_jobs && result == ERROR_1; ++j){ // all jobs need keys to store on a miss.
+    if(cache_key_file(g_ifpath, (uint32_t)p_jobs[j]._kind, &p_jobs[j]._key) != SUCCESS){
+      exit(FAIL);
     }
-    if(sym._type != SYMBOL_A){
+  }
+  return result;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: runs the back end jobs; writers run concurrently on their own threads since they only read the final 
+ *  command and instruction arrays.
+ *
+ * note: the first job runs on this thread, in the job slot the process was started in. Under a make jobserver each
+ *  other thread holds a token, and jobs that get no token run on this thread after the first.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int run_jobs(EmitJob_t* p_jobs, int num_jobs){
+  for(int j = 0; j < num_jobs; ++j){
+    VERBOSE2("writing %s artifact", emit_name(p_jobs[j]._kind));
+    VERBOSE2(" to file '%s'...\n", p_jobs[j]._path);
+  }
+  bool is_threaded[NUM_EMIT_KINDS] = {false};
+  for(int j = 1; j < num_jobs; ++j){
+    if(gp_jobserver != NULL && !jobserver_try_acquire(gp_jobserver)){
       continue;
     }
-    if(add_symbol(&sym) == SUCCESS){
-      VERBOSE2("found variable symbol '%s', adding to symbol library...\n", sym._sym);
+    is_threaded[j] = pthread_create(&p_jobs[j]._thread, NULL, run_emit_job, &p_jobs[j]) == 0;
+    if(!is_threaded[j] && gp_jobserver != NULL){
+      jobserver_release(gp_jobserver);
+    }
+  }
+  int result = SUCCESS;
+  for(int j = 0; j < num_jobs; ++j){
+    if(!is_threaded[j]){
+      run_emit_job(&p_jobs[j]);
+      result = (p_jobs[j]._result != SUCCESS) ? FAIL : result;
+    }
+  }
+  for(int j = 0; j < num_jobs; ++j){
+    if(is_threaded[j]){
+      pthread_join(p_jobs[j]._thread, NULL);
+      if(gp_jobserver != NULL){
+        jobserver_release(gp_jobserver);
+      }
+      result = (p_jobs[j]._result != SUCCESS) ? FAIL : result;
     }
   }
-  parser_rewind(gp_parser); 
+  return result;
 }
 
 /*-------------------------------------------------------------------------------------------------------------------*/
 /*
- * brief: parse assembly instructions into command structs.
+ * brief: appends a path to a buffer, escaped for a make rule.
  */
 /*-------------------------------------------------------------------------------------------------------------------*/
-static int parse_commands(){
-  gp_cmds = (Command_t*)calloc(g_line_count, sizeof(Command_t));
-  int cmdno = 0;
-  int result; 
-  while((result = parser_next_command(gp_parser, &gp_cmds[cmdno])) != CMD_EOF && cmdno < g_line_count){
-    if(result == FAIL){
-      g_asm_fail = FAIL;
+static void put_make_path(struct OutBuf* p_buf, const char* path){
+  for(const char* c = path; *c != '\0'; ++c){
+    if(*c == ' ' || *c == '#' || *c == '\\'){
+      outbuf_putc(p_buf, '\\');
     }
-    if(g_is_verbose && result == SUCCESS){
-      parser_print_cmdrep(stderr, &gp_cmds[cmdno]);
+    else if(*c == '$'){
+      outbuf_putc(p_buf, '$');
     }
-    ++cmdno;
+    outbuf_putc(p_buf, *c);
   }
 }
 
 /*-------------------------------------------------------------------------------------------------------------------*/
 /*
- * brief: operates on the global gp_cmds command array; if command has a symbol, substitutes it for mapped  literal.
- * @param mode: if mode=0, subs A and L command symbols, if mode!=0 subs only A command symbols.
- * note: expects the symbol library to contain ALL symbols encountered; should be guaranteed by the symbol populating
- *  phase.
+ * brief: the cache format of the output of a job in the current mode.
  */
 /*-------------------------------------------------------------------------------------------------------------------*/
-static int substitute_symbols(int mode){
-  char addstr[6]; // max 5-digits in a 15-bit literal.
-  for(int cn = 0; cn < g_line_count; ++cn){
-    if(gp_cmds[cn]._type == CFORMAT_A0 || (gp_cmds[cn]._type == CFORMAT_L0 && mode == 0)){
-      uint16_t add;
-      assert(symlib_search_symbol(gp_sym_lib, gp_cmds[cn]._sym, &add) == SUCCESS);
-      snprintf(addstr, 6, "%d", add); 
-      ++gp_cmds[cn]._type; // change to CFORMAT_A/L1
-      memset((void*)gp_cmds[cn]._sym, '\0', MAX_SYM_LENGTH);
-      strncpy(gp_cmds[cn]._sym, addstr, 6);
-    }
-  }
+static uint32_t job_format(const EmitJob_t* p_job){
+  return (g_mode == MODE_STRIP) ? CACHE_FORMAT_STRIP_MODE : (g_mode == MODE_COMPILE) ? CACHE_FORMAT_OBJECT : 
+         (uint32_t)p_job->_kind;
 }
 
 /*-------------------------------------------------------------------------------------------------------------------*/
 /*
- * brief: operates on the global gp_cmds command array; translates commands into hack machine instructions.
- * note: command array MUST first have all symbols substituted for their literal values.
+ * brief: writes the make dependency file of -MD/-MF; a rule making the outputs of the jobs depend on the input files,
+ *  i.e. the infile and any profile of --profile-use, or the objects and archives linked or archived. The cache key
+ *  of each output of a single infile follows as a comment.
+ * return: SUCCESS, or FAIL if the file could not be written.
+ *
+ * note: without -MF the file is named after the first output, with its extension replaced by .d.
  */
 /*-------------------------------------------------------------------------------------------------------------------*/
-static int generate_hackins(){
-  VERBOSE("generating Hack instructions...\n");
-  gp_hackins = (uint16_t*)calloc(g_line_count, sizeof(uint16_t));
-  int in = 0;
-  for(int cn = 0; cn < g_line_count; ++cn){
-    int type = gp_cmds[cn]._type;
-    if(type == CFORMAT_A1 || type == CFORMAT_C0 || type == CFORMAT_C1 || type == CFORMAT_C2){
-      decode(&gp_cmds[cn], &gp_hackins[in]);
-      ++in;
+static int write_depfile(EmitJob_t* p_jobs, int num_jobs){
+  if(!g_is_depfile){
+    return SUCCESS;
+  }
+  char path[MAX_FILEPATH_CHAR];
+  if(g_depfile != NULL){
+    snprintf(path, MAX_FILEPATH_CHAR, "%s", g_depfile);
+  }
+  else{
+    const char* out = p_jobs[0]._path;
+    const char* dot = strrchr(out, '.');
+    size_t l = (dot != NULL && strchr(dot, '/') == NULL && dot != out) ? (size_t)(dot - out) : strlen(out);
+    snprintf(path, MAX_FILEPATH_CHAR, "%.*s.d", (int)l, out);
+  }
+
+  struct OutBuf out;
+  if(init_buffer(&out, 1 << 12) != SUCCESS){
+    return FAIL;
+  }
+  for(int j = 0; j < num_jobs; ++j){
+    put_make_path(&out, p_jobs[j]._path);
+    outbuf_puts(&out, (j + 1 < num_jobs) ? " " : ":");
+  }
+  bool is_multi_input = g_mode == MODE_LINK || g_mode == MODE_ARCHIVE;
+  for(int i = 0; i < (is_multi_input ? g_num_objpaths : 1); ++i){
+    outbuf_puts(&out, " \\\n  ");
+    put_make_path(&out, is_multi_input ? g_objpaths[i] : g_ifpath);
+  }
+  if(g_profile_use_path != NULL){
+    outbuf_puts(&out, " \\\n  ");
+    put_make_path(&out, g_profile_use_path);
+  }
+  outbuf_putc(&out, '\n');
+  for(int j = 0; j < num_jobs && !is_multi_input; ++j){
+    uint64_t key = p_jobs[j]._key;
+    if(gp_cache == NULL && cache_key_file(g_ifpath, job_format(&p_jobs[j]), &key) != SUCCESS){
+      free_outbuf(&out);
+      return FAIL;
     }
+    char line[64];
+    snprintf(line, sizeof(line), "# cache key %016" PRIx64 " of ", key);
+    outbuf_puts(&out, line);
+    put_make_path(&out, p_jobs[j]._path);
+    outbuf_putc(&out, '\n');
   }
-  assert(in == g_ins_count);
+  VERBOSE2("writing dependencies to file '%s'...\n", path);
+  int result = write_file(path, &out);
+  free_outbuf(&out);
+  return result;
 }
 
 /*-------------------------------------------------------------------------------------------------------------------*/
-static int print_hackins(FILE* stream){
-  VERBOSE2("printing Hack instructions to file '%s'...\n", g_ofname);
-  for(int in = 0; in < g_ins_count; ++in){
-    uint16_t i = gp_hackins[in];
-    fprintf(stream, "%s%s%s%s\n", g_bitstr[i >> 12], g_bitstr[(i >> 8) & 0x000F], g_bitstr[(i >> 4) & 0x000F], g_bitstr[i & 0x000F]); 
+/*
+ * brief: has the server of --client assemble (or strip) the input file; the artifacts of the reply are then cached
+ *  and written by the jobs as if assembled locally.
+ * return: SUCCESS, or FAIL if the server could not be reached or the input has errors.
+ *
+ * note: the source is sent inline, so the server need not share the client's working directory or file system.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int run_remote(uint32_t op, EmitJob_t* p_jobs, int num_jobs){
+  struct OutBuf src;
+  if(init_buffer(&src, 1 << 16) != SUCCESS){
+    return FAIL;
+  }
+  if(read_file(g_ifpath, &src) != SUCCESS || src._size > SERVE_MAX_FRAME){
+    free_outbuf(&src);
+    return FAIL;
+  }
+  Request_t req = {op, 0, g_ifpath, src._p_data, (uint32_t)src._size};
+  for(int j = 0; j < num_jobs; ++j){
+    req._emit |= (uint32_t)p_jobs[j]._kind;
   }
+  VERBOSE2("sending '%s'", g_ifpath);
+  VERBOSE2(" to server '%s'...\n", g_client_path);
+  Reply_t reply;
+  int result = client_request(g_client_path, &req, &reply);
+  free_outbuf(&src);
+  if(result != SUCCESS){
+    return FAIL;
+  }
+  fwrite(reply._p_diag, 1, reply._diag_len, stderr);
+  if(reply._status != 0){
+    free_reply(&reply);
+    return FAIL;
+  }
+  g_stat_commands = reply._line_count;
+  g_stat_instructions = reply._ins_count;
+  g_stat_variables = reply._var_count;
+
+  for(int j = 0; j < num_jobs && result == SUCCESS; ++j){
+    result = FAIL;
+    for(uint32_t a = 0; a < reply._num_artifacts; ++a){
+      Artifact_t* p_art = &reply._artifacts[a];
+      if(p_art->_kind == (uint32_t)p_jobs[j]._kind){
+        struct OutBuf view = {(char*)p_art->_p_data, p_art->_size, p_art->_size}; // borrows the reply; not freed.
+        finish_job(&p_jobs[j], &view);
+        result = p_jobs[j]._result;
+        break;
+      }
+    }
+  }
+  if(result != SUCCESS && reply._status == 0){
+    fprintf(stderr, "fatal error: server reply is missing an output\n");
+  }
+  free_reply(&reply);
+  return result;
 }
 
 /*-------------------------------------------------------------------------------------------------------------------*/
-static int print_stripped_assembly(FILE* stream){
-  VERBOSE2("printing assembly commands to file '%s'...\n", g_ofname);
-  for(int cn = 0; cn < g_line_count; ++cn){
-    if(gp_cmds[cn]._type != CFORMAT_L0 && gp_cmds[cn]._type != CFORMAT_L1){
-      parser_print_cmdasm(stream, &gp_cmds[cn]);
+/*
+ * brief: prints the statistics of the run to stdout.
+ * @param is_assembled: flag indicates if the input was assembled or stripped, i.e. not all outputs were cached.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void print_stats(bool is_assembled){
+  if(is_assembled && g_mode == MODE_ASSEMBLE){
+    printf("stats: %" PRIu32 " commands, %" PRIu32 " instructions, %" PRIu32 " variables\n", g_stat_commands,
+           g_stat_instructions, g_stat_variables);
+    if(gp_asm->_p_opt != NULL){
+      const OptReport_t* p_opt = gp_asm->_p_opt;
+      printf("stats: -O%d saved %" PRIu32 " of %" PRIu32 " instructions\n", g_opt_level, 
+             p_opt->_num_ins - gp_asm->_ins_count, p_opt->_num_ins);
+      for(int r = 0; optimize_rule_name(r) != NULL; ++r){
+        if(p_opt->_saved[r] != 0){
+          printf("stats:   %s: %" PRIu32 "\n", optimize_rule_name(r), p_opt->_saved[r]);
+        }
+      }
+      for(uint32_t i = 0; i < p_opt->_num_regions && i < OPT_MAX_REGIONS; ++i){
+        const OptRegion_t* p_region = &p_opt->_regions[i];
+        printf("stats:     %s%sline %" PRIu32 ": %" PRIu32 " words of ROM reclaimed\n", p_region->_label, 
+               (p_region->_label[0] != '\0') ? " at " : "", p_region->_lineno, p_region->_num_ins);
+      }
+      if(p_opt->_num_regions > OPT_MAX_REGIONS){
+        printf("stats:     and %" PRIu32 " more regions\n", p_opt->_num_regions - OPT_MAX_REGIONS);
+      }
+      if(p_opt->_num_labels != 0){
+        printf("stats:   labels removed: %" PRIu32 "\n", p_opt->_num_labels);
+      }
+      if(p_opt->_num_threaded != 0){
+        printf("stats:   jumps threaded: %" PRIu32 "\n", p_opt->_num_threaded);
+      }
+      if(gp_asm->_p_line_cycles != NULL){
+        printf("stats:   jumps removed save %" PRIu64 " cycles of the profiled run\n", p_opt->_saved_cycles);
+      }
     }
   }
+  else if(!is_assembled){
+    printf("stats: all outputs cached, assembly skipped\n");
+  }
+  if(gp_cache){
+    CacheStats_t cs = cache_stats(gp_cache);
+    printf("stats: cache %" PRIu32 " hits, %" PRIu32 " misses, %" PRIu32 " stores, %" PRIu32 " evictions\n", 
+           cs._hits, cs._misses, cs._stores, cs._evictions);
+  }
 }
 
 /*-------------------------------------------------------------------------------------------------------------------*/
 static void print_help(){
-  printf("USAGE\n  hackass infile [-o outfile] [-a|-s|-h] [-v]\n\n"
+  printf("USAGE\n  hackass infile [-o outfile] [-a|-s|-c|-h] [-v] [-O0|-O1] [--emit=kind[,kind...]] [--if-changed]\n"
+          "          [--cache-dir=dir [--cache-size=N[K|M|G]]] [--stats] [--client=sock] [--watch]\n"
+          "          [--profile-use=file] [-MD] [-MF depfile] [--run [--jit|--batch=file|--profile[=file]]\n"
+          "          [--coverage[=file]] [--dump=file] [--save=file] [--restore=file] [--rewind=N]\n"
+          "          [--frames=file [--frame-cycles=N]] [--max-cycles=N]]\n"
+          "  hackass --link objfile|libfile... [-o outfile] [-v] [--emit=kind[,kind...]] [--if-changed]\n"
+          "          [-MD] [-MF depfile] [--run [--jit|--batch=file|--profile[=file]] [--coverage[=file]]\n"
+          "          [--dump=file] [--save=file] [--restore=file] [--rewind=N] [--frames=file [--frame-cycles=N]]\n"
+          "          [--max-cycles=N]]\n"
+          "  hackass --archive objfile... [-o libfile] [-v] [--if-changed] [-MD] [-MF depfile]\n"
+          "  hackass --serve=sock\n"
+          "  hackass --test dir [-o reportfile] [-v] [--coverage] [--max-cycles=N]\n\n"
           "OPTIONS\n"
           "  -a    Assemble .asm infile to .hack outfile (default mode).\n"
           "  -s    Strip .asm infile of whitespace, comments and symbols.\n"
+          "  -c    Compile .asm infile to a relocatable object, outfile defaults to infile without .asm plus .hobj.\n"
           "  -h    Print this help message.\n"
           "  -v    Print verbose assembler output to stdout.\n"
-          "  -o    Specify name of outfile, default is a.out\n\n"
+          "  -O1   Optimise the program; rewrite redundant patterns of commands, e.g. the pop and push back of\n"
+          "        '@SP AM=M-1 D=M @SP AM=M+1', thread jumps to jumps, invert conditional jumps over jumps, lay\n"
+          "        out blocks so jumps fall through, remove code no path from address 0 runs and labels no\n"
+          "        command loads, drop A loads of the value A holds on every path to them, and move labels to\n"
+          "        match. --stats prints the instructions each rewrite saved and the ROM each unreachable region\n"
+          "        reclaimed. A jump to a literal address is labelled to move with its instruction; a jump to an\n"
+          "        address read from RAM must go to a label. -O0, the default, assembles commands as written.\n"
+          "  -o    Specify name of outfile, default is a.out.\n"
+          "  -MD   Write a make rule of the outfiles and the files they depend on to outfile with its\n"
+          "        extension replaced by .d. Outfiles made under make -jN share its job slots if the recipe\n"
+          "        has a '+'.\n"
+          "  -MF   Specify name of the dependency file; implies -MD.\n"
+          "  --emit=hack,bin,strip,map,srcmap,c\n"
+          "        Emit several artifacts from a single assembly; may be repeated. Each artifact is written\n"
+          "        to outfile (or infile without .asm) plus .hack, .bin, .strip.asm, .map, .smap or .c. The\n"
+          "        .smap file is a binary source map of the line and label of each instruction. The .c file\n"
+          "        is a C program that runs the program as --run does, taking the cycle limit and address=value\n"
+          "        settings of RAM as arguments; it stops at the start of the block that would pass the limit.\n"
+          "  --if-changed\n"
+          "        Do not rewrite outfiles that already hold the output, preserving their mtime.\n"
+          "  --cache-dir=dir\n"
+          "        Cache outputs in dir, keyed by the infile content; cached outputs are not reassembled.\n"
+          "  --cache-size=N[K|M|G]\n"
+          "        Size limit of the cache, least recently used outputs are evicted; default 64M.\n"
+          "  --stats\n"
+          "        Print assembly and cache statistics on completion.\n"
+          "  --serve=sock\n"
+          "        Run as a server; assemble requests of clients on the unix socket sock until interrupted.\n"
+          "  --client=sock\n"
+          "        Have the server on sock assemble infile; options and outputs are as without --client.\n"
+          "  --watch\n"
+          "        Reassemble infile each time it changes, lexing only the lines that changed, until interrupted.\n"
+          "        With --run, a session: the program runs on, its changed instructions are patched into ROM\n"
+          "        while its RAM and registers are kept, and the pc is moved to the same line, else to the start\n"
+          "        of its label, else to 0.\n"
+          "  --link\n"
+          "        Link objects compiled with -c into one program, laid out in ROM in the order given; outputs\n"
+          "        are as of -a. Labels are shared by all objects, other symbols are variables. Of a .harc\n"
+          "        archive, only the members exporting labels that earlier objects use are linked.\n"
+          "  --archive\n"
+          "        Bundle objects into a .harc archive, indexed by the labels they export.\n"
+          "  --run\n"
+          "        Run the assembled or linked program on a simulated Hack CPU until it halts in a loop such as\n"
+          "        '(END) @END 0;JMP', then print its registers and R0..R15. Outfiles are written only if named\n"
+          "        with -o, --emit or -MD.\n"
+          "  --jit\n"
+          "        Compile the program to native code to --run it; the results are those of the simulator.\n"
+          "        Falls back to the simulator on hosts other than x86-64 Linux.\n"
+          "  --batch=file\n"
+          "        Run an instance of the program for each line of file, 16 at a time in SIMD lanes, and\n"
+          "        print the state of each. A line sets the RAM of its instance with address=value settings;\n"
+          "        an address is a number or a symbol of the program, e.g. 'R0=3 R1=-4'.\n"
+          "  --dump=file\n"
+          "        Write the RAM of each run to file, 32K little-endian words per instance.\n"
+          "  --profile[=file]\n"
+          "        Count the cycles spent at each instruction of the run, then print the hottest labels, lines\n"
+          "        and loops. With file, also write the counts as folded stacks of label;line for flame graphs.\n"
+          "  --profile-use=file\n"
+          "        Lay out the blocks of -O1 so the jumps the folded stacks of --profile=file ran most fall\n"
+          "        through first. The profile must be of a run of the same infile; --stats prints the cycles\n"
+          "        the jumps removed would have saved it.\n"
+          "  --coverage[=file]\n"
+          "        Print the lines and labels the run, or the tests of each program, executed and did not, and the\n"
+          "        conditional jumps never taken. With file, the coverage is merged with that file holds of the same\n"
+          "        program, then written back to it; a bitmap of 1 bit per instruction.\n"
+          "  --save=file\n"
+          "        Write the state the run stopped in to file, a snapshot of its registers, cycle count and RAM.\n"
+          "        Reaching the cycle limit is not an error with --save, so a warm-up can be saved by its length.\n"
+          "  --restore=file\n"
+          "        Run from the state of a snapshot of the program written by --save, instead of from reset.\n"
+          "  --rewind=N\n"
+          "        Keep states of the run as it goes, then step it back N cycles and print the state it was in;\n"
+          "        --dump and --save write that state. At least the last 260 million cycles can be stepped back.\n"
+          "  --frames=file\n"
+          "        Write a frame of the screen to file every --frame-cycles cycles of the run in which it changed;\n"
+          "        to a .pbm file as PBM images one after another, else as the rows that changed each frame.\n"
+          "  --frame-cycles=N\n"
+          "        Cycles between the frames of --frames; default 100000.\n"
+          "  --max-cycles=N\n"
+          "        Cycle limit of --run, 0 for none; default 1073741824. Reaching it is an error.\n"
+          "  --test\n"
+          "        Run each .test file of dir on the simulator, on a thread per core, and write a JUnit report\n"
+          "        to reportfile, default TEST-<dir>.xml. A test has lines 'program file.asm', 'set address=value\n"
+          "        ...', 'expect address=value ...' and optionally 'cycles N', its budget; default --max-cycles;\n"
+          "        'start file.snap', a snapshot of the program written by --save to run from instead of reset,\n"
+          "        and 'screen file.pbm', the 512x256 image of the screen the program must leave. Each program is\n"
+          "        assembled, and each snapshot read, once however many tests use it.\n\n"
           "For more detailed help, please see,\n"
           "<https://github.com/imurf/hackass-hack-assembler-c>\n");                           
 }
 
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: parses an option of the form --name[=value].
+ * return: SUCCESS, or FAIL if the option is not recognised or has an invalid value.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int parse_long_option(const char* arg){
+  if(strncmp(arg, "--emit=", 7) == 0){
+    const char* list = arg + 7;
+    while(*list != '\0'){
+      size_t n = strcspn(list, ",");
+      int kind = emit_parse_name(list, n);
+      if(kind == 0){
+        fprintf(stderr, "fatal error: unrecognised artifact '%.*s' in option '%s'\n", (int)n, list, arg);
+        return FAIL;
+      }
+      g_emit |= kind;
+      list += (list[n] == ',') ? n + 1 : n;
+    }
+    if(g_emit == 0){
+      fprintf(stderr, "fatal error: option '%s' names no artifacts\n", arg);
+      return FAIL;
+    }
+    return SUCCESS;
+  }
+  if(strcmp(arg, "--if-changed") == 0){
+    g_is_if_changed = true;
+    return SUCCESS;
+  }
+  if(strcmp(arg, "--watch") == 0){
+    g_is_watch = true;
+    return SUCCESS;
+  }
+  if(strcmp(arg, "--link") == 0){
+    g_is_link = true;
+    return SUCCESS;
+  }
+  if(strcmp(arg, "--archive") == 0){
+    g_is_archive = true;
+    return SUCCESS;
+  }
+  if(strcmp(arg, "--run") == 0){
+    g_is_run = true;
+    return SUCCESS;
+  }
+  if(strcmp(arg, "--profile") == 0 || (strncmp(arg, "--profile=", 10) == 0 && arg[10] != '\0')){
+    g_is_profile = true;
+    free(g_folded_path);
+    g_folded_path = (arg[9] == '=') ? strdup(arg + 10) : NULL;
+    return SUCCESS;
+  }
+  if(strncmp(arg, "--profile-use=", 14) == 0 && arg[14] != '\0'){
+    free(g_profile_use_path);
+    g_profile_use_path = strdup(arg + 14);
+    return SUCCESS;
+  }
+  if(strcmp(arg, "--coverage") == 0 || (strncmp(arg, "--coverage=", 11) == 0 && arg[11] != '\0')){
+    g_is_coverage = true;
+    free(g_coverage_path);
+    g_coverage_path = (arg[10] == '=') ? strdup(arg + 11) : NULL;
+    return SUCCESS;
+  }
+  if(strcmp(arg, "--test") == 0){
+    g_is_test = true;
+    return SUCCESS;
+  }
+  if(strcmp(arg, "--jit") == 0){
+    g_is_jit = true;
+    return SUCCESS;
+  }
+  if(strncmp(arg, "--batch=", 8) == 0 && arg[8] != '\0'){
+    free(g_batch_path);
+    g_batch_path = strdup(arg + 8);
+    return SUCCESS;
+  }
+  if(strncmp(arg, "--dump=", 7) == 0 && arg[7] != '\0'){
+    free(g_dump_path);
+    g_dump_path = strdup(arg + 7);
+    return SUCCESS;
+  }
+  if(strncmp(arg, "--save=", 7) == 0 && arg[7] != '\0'){
+    free(g_save_path);
+    g_save_path = strdup(arg + 7);
+    return SUCCESS;
+  }
+  if(strncmp(arg, "--restore=", 10) == 0 && arg[10] != '\0'){
+    free(g_restore_path);
+    g_restore_path = strdup(arg + 10);
+    return SUCCESS;
+  }
+  if(strncmp(arg, "--rewind=", 9) == 0){
+    char* end;
+    g_rewind = strtoull(arg + 9, &end, 10);
+    if(end == arg + 9 || *end != '\0'){
+      fprintf(stderr, "fatal error: invalid cycle count in option '%s'\n", arg);
+      return FAIL;
+    }
+    return SUCCESS;
+  }
+  if(strncmp(arg, "--frames=", 9) == 0 && arg[9] != '\0'){
+    free(g_frames_path);
+    g_frames_path = strdup(arg + 9);
+    return SUCCESS;
+  }
+  if(strncmp(arg, "--frame-cycles=", 15) == 0){
+    char* end;
+    g_frame_cycles = strtoull(arg + 15, &end, 10);
+    if(end == arg + 15 || *end != '\0' || g_frame_cycles == 0){
+      fprintf(stderr, "fatal error: invalid cycle count in option '%s'\n", arg);
+      return FAIL;
+    }
+    return SUCCESS;
+  }
+  if(strncmp(arg, "--max-cycles=", 13) == 0){
+    char* end;
+    g_max_cycles = strtoull(arg + 13, &end, 10);
+    if(end == arg + 13 || *end != '\0'){
+      fprintf(stderr, "fatal error: invalid cycle count in option '%s'\n", arg);
+      return FAIL;
+    }
+    return SUCCESS;
+  }
+  if(strcmp(arg, "--stats") == 0){
+    g_is_stats = true;
+    return SUCCESS;
+  }
+  if(strncmp(arg, "--cache-dir=", 12) == 0 && arg[12] != '\0'){
+    free(g_cache_dir);
+    g_cache_dir = strdup(arg + 12);
+    return SUCCESS;
+  }
+  if(strncmp(arg, "--serve=", 8) == 0 && arg[8] != '\0'){
+    free(g_serve_path);
+    g_serve_path = strdup(arg + 8);
+    return SUCCESS;
+  }
+  if(strncmp(arg, "--client=", 9) == 0 && arg[9] != '\0'){
+    free(g_client_path);
+    g_client_path = strdup(arg + 9);
+    return SUCCESS;
+  }
+  if(strncmp(arg, "--cache-size=", 13) == 0){
+    char* end;
+    unsigned long long size = strtoull(arg + 13, &end, 10);
+    int shift = (*end == 'K') ? 10 : (*end == 'M') ? 20 : (*end == 'G') ? 30 : 0;
+    end += (shift != 0);
+    if(end == arg + 13 || *end != '\0'){
+      fprintf(stderr, "fatal error: invalid size in option '%s'\n", arg);
+      return FAIL;
+    }
+    g_cache_size = (uint64_t)size << shift;
+    return SUCCESS;
+  }
+  fprintf(stderr, "fatal error: unrecognised command line option '%s'\n", arg);
+  return FAIL;
+}
+
 /*-------------------------------------------------------------------------------------------------------------------*/
 static void parse_args(int argc, char* argv[]){
   bool is_error = false;
 
   // parse switches...
-  int oi = -1;
-  bool s = false, h = false, a = false, o = false, v = false;
+  int oi = -1, mfi = -1;
+  bool s = false, h = false, a = false, c = false, o = false, v = false;
   for(int i = 1; i < argc; ++i){
+    if(argv[i][0] == '-' && argv[i][1] == '-'){
+      if(parse_long_option(argv[i]) != SUCCESS){
+        is_error = true;
+      }
+      continue;
+    }
+    if(strcmp(argv[i], "-MD") == 0 || strcmp(argv[i], "-MF") == 0){
+      g_is_depfile = true;
+      mfi = (argv[i][2] == 'F') ? i : mfi;
+      continue;
+    }
+    if(strcmp(argv[i], "-O0") == 0 || strcmp(argv[i], "-O1") == 0){
+      g_opt_level = (uint8_t)(argv[i][2] - '0');
+      continue;
+    }
     if(argv[i][0] == '-'){
-      for(int j = 1; j < strlen(argv[i]); ++j){
+      for(size_t j = 1; j < strlen(argv[i]); ++j){
         switch(argv[i][j]){
           case 's':
             s = true;
@@ -335,6 +925,9 @@ static void parse_args(int argc, char* argv[]){
           case 'a':
             a = true;
             break;
+          case 'c':
+            c = true;
+            break;
           case 'o':
             oi = i;
             o = true;
@@ -358,7 +951,52 @@ static void parse_args(int argc, char* argv[]){
     g_mode = MODE_HELP;
     return;
   }
-  else if(s && !h && !a){
+  else if(g_serve_path != NULL){
+    if(s || a || g_client_path != NULL || g_is_depfile || g_opt_level != 0 || is_error){
+      fprintf(stderr, "fatal error: --serve takes no other options\n");
+      exit(FAIL);
+    }
+    g_mode = MODE_SERVE;
+    return;
+  }
+  else if(g_is_test){
+    if(s || a || c || g_is_link || g_is_archive || g_emit != 0 || g_is_run || g_is_depfile){
+      fprintf(stderr, "fatal error: conflicting operation modes; --test excludes -a,-s,-c,--link,--archive,--emit,"
+              "--run and -MD\n");
+      is_error = true;
+    }
+    VERBOSE("started MODE_TEST, running tests...\n");
+    g_mode = MODE_TEST;
+  }
+  else if(g_is_archive){
+    if(s || a || c || g_is_link || g_emit != 0){
+      fprintf(stderr, "fatal error: conflicting operation modes; --archive excludes -a,-s,-c,--link and --emit\n");
+      is_error = true;
+    }
+    VERBOSE("started MODE_ARCHIVE, archiving objects...\n");
+    g_mode = MODE_ARCHIVE;
+  }
+  else if(g_is_link){
+    if(s || a || c){
+      fprintf(stderr, "fatal error: conflicting operation modes; --link excludes -a,-s,-c\n");
+      is_error = true;
+    }
+    if(g_emit & EMIT_STRIP){
+      fprintf(stderr, "fatal error: objects hold no assembly to strip; --link excludes --emit=strip\n");
+      is_error = true;
+    }
+    VERBOSE("started MODE_LINK, linking objects...\n");
+    g_mode = MODE_LINK;
+  }
+  else if(c && !s && !a && g_emit == 0){
+    VERBOSE("started MODE_COMPILE, compiling .asm input to an object...\n");
+    g_mode = MODE_COMPILE;
+  }
+  else if(c){
+    fprintf(stderr, "fatal error: conflicting operation modes; -c excludes -a,-s and --emit\n");
+    is_error = true;
+  }
+  else if(s && !h && !a && g_emit == 0){
     VERBOSE("started MODE_STRIP, stripping comments, whitespace and symbols from .asm input...\n");
     g_mode = MODE_STRIP;
   }
@@ -366,22 +1004,114 @@ static void parse_args(int argc, char* argv[]){
     VERBOSE("started MODE_ASSEMBLE, beginning assembly of .asm input to .hack file...\n");
     g_mode = MODE_ASSEMBLE;
   }
+  else if(s && g_emit != 0){
+    fprintf(stderr, "fatal error: conflicting operation modes; use --emit=strip to strip while assembling\n");
+    is_error = true;
+  }
   else{
     fprintf(stderr, "fatal error: conflicting operation modes; -h,-a,-s are mutually exclusive\n");
     is_error = true;
   }
 
-  // search for .asm file input...
+  if(g_mode == MODE_TEST && (g_is_watch || g_client_path != NULL || g_cache_dir != NULL)){
+    fprintf(stderr, "fatal error: tests run locally; --test excludes --watch, --client and --cache-dir\n");
+    is_error = true;
+  }
+  if(g_is_watch && (g_mode != MODE_ASSEMBLE || g_client_path != NULL || g_cache_dir != NULL)){
+    fprintf(stderr, "fatal error: --watch only assembles locally; it excludes -s, --client and --cache-dir\n");
+    is_error = true;
+  }
+  if(g_opt_level != 0 && (g_mode != MODE_ASSEMBLE || g_is_watch || g_client_path != NULL || g_cache_dir != NULL)){
+    fprintf(stderr, "fatal error: -O1 optimises the program it assembles from infile; it excludes -s, -c, --link, "
+            "--archive, --test, --watch, --client and --cache-dir\n");
+    is_error = true;
+  }
+  if(g_profile_use_path != NULL && g_opt_level == 0){
+    fprintf(stderr, "fatal error: --profile-use guides the layout of -O1; it requires -O1\n");
+    is_error = true;
+  }
+  if(g_is_run && ((g_mode != MODE_ASSEMBLE && g_mode != MODE_LINK) || g_client_path != NULL || g_cache_dir != NULL)){
+    fprintf(stderr, "fatal error: --run runs the program it assembles or links; it excludes -s, -c, --archive, "
+            "--client and --cache-dir\n");
+    is_error = true;
+  }
+  if(g_is_run && g_is_watch && (g_is_jit || g_batch_path != NULL || g_dump_path != NULL || g_is_profile || 
+     g_is_coverage || g_save_path != NULL || g_rewind != 0 || g_frames_path != NULL)){
+    fprintf(stderr, "fatal error: a --run --watch session runs one program on the simulator, patched as it changes; "
+            "it excludes --jit, --batch, --dump, --profile, --coverage, --save, --rewind and --frames\n");
+    is_error = true;
+  }
+  if((g_is_jit || g_batch_path != NULL || g_dump_path != NULL || g_is_profile || g_save_path != NULL || 
+      g_restore_path != NULL || g_rewind != 0 || g_frames_path != NULL) && !g_is_run){
+    fprintf(stderr, "fatal error: --jit, --batch, --dump, --profile, --save, --restore, --rewind and --frames are ways "
+            "to --run; they require --run\n");
+    is_error = true;
+  }
+  if(g_frames_path != NULL && (g_is_jit || g_batch_path != NULL)){
+    fprintf(stderr, "fatal error: --frames are of the rows of the screen the simulator stores to; it excludes --jit "
+            "and --batch\n");
+    is_error = true;
+  }
+  if((g_save_path != NULL || g_restore_path != NULL || g_rewind != 0) && g_batch_path != NULL){
+    fprintf(stderr, "fatal error: the instances of a batch run from reset; --batch excludes --save, --restore and "
+            "--rewind\n");
+    is_error = true;
+  }
+  if(g_rewind != 0 && g_is_jit){
+    fprintf(stderr, "fatal error: --rewind steps back the states the simulator saves; it excludes --jit\n");
+    is_error = true;
+  }
+  if(g_is_profile && (g_is_jit || g_batch_path != NULL)){
+    fprintf(stderr, "fatal error: --profile counts the instructions the simulator runs; it excludes --jit and "
+            "--batch\n");
+    is_error = true;
+  }
+  if(g_is_coverage && (g_is_run ? (g_is_jit || g_batch_path != NULL) : (g_mode != MODE_TEST))){
+    fprintf(stderr, "fatal error: --coverage is of the instructions the simulator runs; it requires --run or --test, "
+            "and excludes --jit and --batch\n");
+    is_error = true;
+  }
+  if(g_coverage_path != NULL && g_mode == MODE_TEST){
+    fprintf(stderr, "fatal error: a coverage file is of one program; --test takes --coverage without a file\n");
+    is_error = true;
+  }
+  if(g_is_jit && g_batch_path != NULL){
+    fprintf(stderr, "fatal error: a batch runs on the simulator; --batch excludes --jit\n");
+    is_error = true;
+  }
+  bool is_multi_input = g_mode == MODE_LINK || g_mode == MODE_ARCHIVE;
+  if(g_client_path != NULL && (g_mode == MODE_COMPILE || is_multi_input)){
+    fprintf(stderr, "fatal error: the server only assembles and strips; --client excludes -c, --link and --archive\n");
+    is_error = true;
+  }
+  if(g_cache_dir != NULL && is_multi_input){
+    fprintf(stderr, "fatal error: outputs are cached by a single infile; --link and --archive exclude --cache-dir\n");
+    is_error = true;
+  }
+
+  // search for .asm file input, every object input when linking or archiving, or the directory of the tests...
+  if(is_multi_input && (g_objpaths = (char**)calloc(argc, sizeof(char*))) == NULL){
+    fprintf(stderr, "fatal error: out of memory\n");
+    exit(FAIL);
+  }
   for(int i = 1; i < argc; ++i){
     if(argv[i][0] == '-'){
       continue;
     }
-    if(oi == (i - 1)){ // if string follows -o switch then this is not the input file you are looking for.
+    if(oi == (i - 1) || mfi == (i - 1)){ // if string follows -o or -MF then this is not the input file.
       continue;
     }
     int l = strlen(argv[i]);
-    if(l < MAX_FILEPATH_CHAR && strstr(argv[i], ".asm") != NULL){
-      g_ifpath = (char*)calloc(l, sizeof(char)); 
+    if(is_multi_input){
+      g_objpaths[g_num_objpaths++] = argv[i];
+      if(g_ifpath == NULL && l < MAX_FILEPATH_CHAR){ // the first object names the outputs, as infile does.
+        g_ifpath = strdup(argv[i]);
+      }
+      continue;
+    }
+    if(l < MAX_FILEPATH_CHAR && (g_mode == MODE_TEST || strstr(argv[i], ".asm") != NULL)){
+      free(g_ifpath);
+      g_ifpath = (char*)calloc(l + 1, sizeof(char)); 
       strcpy(g_ifpath, argv[i]);
     }
   }
@@ -390,8 +1120,6 @@ static void parse_args(int argc, char* argv[]){
     is_error = true;
   }
 
-
-
   strncpy(g_ofname, "a.out", MAX_FILENAME_CHAR);
   if(o){
     if(oi + 1 >= argc || argv[oi + 1][0] =='-'){
@@ -399,71 +1127,877 @@ static void parse_args(int argc, char* argv[]){
       is_error = true;
     }
     else{
-      strncpy(g_ofname, argv[oi + 1], MAX_FILENAME_CHAR);
+      strncpy(g_ofname, argv[oi + 1], MAX_FILENAME_CHAR - 1);
+      g_has_ofname = true;
     }
   }
 
+  if(mfi >= 0){
+    if(mfi + 1 >= argc || argv[mfi + 1][0] == '-'){
+      fprintf(stderr, "fatal error: specified '-MF' option but provided no file name\n"); 
+      is_error = true;
+    }
+    else{
+      g_depfile = strdup(argv[mfi + 1]);
+    }
+  }
   if(is_error){
     exit(FAIL);
   }
+}
 
-  if(!h){
-    g_ofstream = fopen(g_ofname, "w");
-    if(g_ofstream == NULL){
-      perror(g_ofname);
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void init_assembler(){
+  assert(atexit(clean_exit) == SUCCESS);
+  if(g_client_path == NULL && (gp_asm = new_assembler(g_is_verbose)) == NULL){ // the server assembles for clients.
+    fprintf(stderr, "fatal error: out of memory\n");
+    exit(FAIL);
+  }
+  if(gp_asm != NULL){
+    gp_asm->_opt_level = g_opt_level;
+  }
+  if(g_profile_use_path != NULL){
+    struct OutBuf folded;
+    if(init_buffer(&folded, 1 << 12) != SUCCESS){
+      exit(FAIL);
+    }
+    if(read_file(g_profile_use_path, &folded) != SUCCESS){
+      free_outbuf(&folded);
       exit(FAIL);
     }
+    int result = profile_read_folded(folded._p_data, folded._size, &g_line_cycles, &gp_asm->_num_line_cycles);
+    free_outbuf(&folded);
+    if(result != SUCCESS){
+      fprintf(stderr, (result == ERROR_1) ? "fatal error: profile '%s' has no lines; write it with --run "
+              "--profile=file\n" : "fatal error: out of memory reading profile '%s'\n", g_profile_use_path);
+      exit(FAIL);
+    }
+    gp_asm->_p_line_cycles = g_line_cycles;
+  }
+  if(g_cache_dir != NULL && (gp_cache = new_cache(g_cache_dir, g_cache_size)) == NULL){
+    exit(FAIL);
+  }
+  if((gp_jobserver = new_jobserver()) != NULL){
+    VERBOSE("running under a make jobserver, writers share its job slots...\n");
   }
 }
 
 /*-------------------------------------------------------------------------------------------------------------------*/
-static void parse_file(){
-  VERBOSE2("parsing symbols from input file '%s'...\n", g_ifpath);
-  parse_symbols();
-  if(g_asm_fail){
-    VERBOSE("terminating assembly: symbol errors occured\n");
-    exit(FAIL);
+static int strip(){
+  EmitJob_t* p_job = &g_jobs[g_num_jobs++];
+  p_job->_kind = SERVE_KIND_STRIP;
+  snprintf(p_job->_path, MAX_FILEPATH_CHAR, "%s", g_ofname);
+  if(gp_cache){
+    int result = fetch_cached(CACHE_FORMAT_STRIP_MODE, p_job->_path, &p_job->_key);
+    if(result != ERROR_1){
+      return result;
+    }
   }
-  VERBOSE2("parsing assembly commands from input file '%s'...\n", g_ifpath);
-  parse_commands();
-  if(g_asm_fail){
-    VERBOSE("terminating assembly: assembly command errors occured\n");
-    exit(FAIL);
+  if(g_client_path){
+    return (run_remote(SERVE_OP_STRIP, p_job, 1) == SUCCESS) ? ERROR_1 : FAIL;
   }
+  struct OutBuf out;
+  if(init_buffer(&out, 1 << 16) != SUCCESS){
+    return FAIL;
+  }
+  int result = assembler_strip(gp_asm, g_ifpath, &out);
+  if(result == SUCCESS){
+    VERBOSE2("printing assembly commands to file '%s'...\n", g_ofname);
+    finish_job(p_job, &out);
+    result = p_job->_result;
+  }
+  free_outbuf(&out);
+  return (result == SUCCESS) ? ERROR_1 : FAIL;
 }
 
 /*-------------------------------------------------------------------------------------------------------------------*/
-static void init_assembler(){
-  assert(atexit(clean_exit) == SUCCESS);
-  assert(new_symlib(&gp_sym_lib) == SUCCESS);
-  if((gp_parser = new_parser(g_ifpath)) == NULL){
-    exit(FAIL);
+static int assemble(){
+  g_num_jobs = is_writing() ? plan_jobs((g_emit != 0) ? g_emit : EMIT_HACK, g_jobs) : 0;
+  if(gp_cache){
+    int result = fetch_cached_jobs(g_jobs, g_num_jobs);
+    if(result != ERROR_1){
+      return result;
+    }
+  }
+  if(g_client_path){
+    return (run_remote(SERVE_OP_ASSEMBLE, g_jobs, g_num_jobs) == SUCCESS) ? ERROR_1 : FAIL;
+  }
+  if(assembler_assemble(gp_asm, g_ifpath) != SUCCESS){
+    return FAIL;
+  }
+  g_stat_commands = gp_asm->_line_count;
+  g_stat_instructions = gp_asm->_ins_count;
+  g_stat_variables = gp_asm->_ram_address - RAM_START_ADDRESS;
+  return (run_jobs(g_jobs, g_num_jobs) == SUCCESS) ? ERROR_1 : FAIL;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int compile(){
+  EmitJob_t* p_job = &g_jobs[g_num_jobs++];
+  char stem[MAX_FILEPATH_CHAR];
+  output_stem(stem);
+  const char* ext = g_has_ofname ? "" : OBJECT_EXTENSION;
+  if(snprintf(p_job->_path, MAX_FILEPATH_CHAR, "%s%s", stem, ext) >= MAX_FILEPATH_CHAR){
+    fprintf(stderr, "fatal error: object file name '%s%s' is too long\n", stem, ext);
+    return FAIL;
+  }
+  if(gp_cache){
+    int result = fetch_cached(CACHE_FORMAT_OBJECT, p_job->_path, &p_job->_key);
+    if(result != ERROR_1){
+      return result;
+    }
+  }
+  if(assembler_compile(gp_asm, g_ifpath) != SUCCESS){
+    return FAIL;
+  }
+  struct OutBuf out;
+  if(init_buffer(&out, 1 << 16) != SUCCESS){
+    return FAIL;
+  }
+  int result = object_write(gp_asm, &out);
+  if(result == SUCCESS){
+    VERBOSE2("writing object to file '%s'...\n", p_job->_path);
+    finish_job(p_job, &out);
+    result = p_job->_result;
+  }
+  free_outbuf(&out);
+  return (result == SUCCESS) ? ERROR_1 : FAIL;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: true if the path names an archive, by its extension.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static bool is_archive_path(const char* path){
+  size_t l = strlen(path), e = strlen(ARCHIVE_EXTENSION);
+  return l > e && strcmp(path + l - e, ARCHIVE_EXTENSION) == 0;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: links the objects, and the members of the archives that resolve their imports, in the order given.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int link_program(){
+  g_num_jobs = is_writing() ? plan_jobs((g_emit != 0) ? g_emit : EMIT_HACK, g_jobs) : 0;
+  LinkSet_t* p_set = new_linkset(g_is_verbose);
+  if(p_set == NULL){
+    fprintf(stderr, "fatal error: out of memory\n");
+    return FAIL;
+  }
+  int result = SUCCESS;
+  for(int i = 0; i < g_num_objpaths && result == SUCCESS; ++i){
+    if(is_archive_path(g_objpaths[i])){
+      Archive_t* p_ar = new_archive(g_objpaths[i]);
+      result = (p_ar != NULL) ? linkset_add_archive(p_set, p_ar) : FAIL;
+    }
+    else{
+      Object_t* p_obj = new_object(g_objpaths[i]);
+      result = (p_obj != NULL) ? linkset_add_object(p_set, p_obj) : FAIL;
+    }
+  }
+  if(result == SUCCESS){
+    result = link_objects(gp_asm, p_set->_pp_objs, (int)p_set->_num_objs);
+  }
+  free_linkset(&p_set);
+  if(result != SUCCESS){
+    return FAIL;
+  }
+  return (run_jobs(g_jobs, g_num_jobs) == SUCCESS) ? ERROR_1 : FAIL;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int archive(){
+  snprintf(g_jobs[g_num_jobs++]._path, MAX_FILEPATH_CHAR, "%s", g_ofname);
+  Object_t** pp_objs = (Object_t**)calloc(g_num_objpaths, sizeof(Object_t*));
+  int result = (pp_objs != NULL) ? SUCCESS : FAIL;
+  for(int o = 0; o < g_num_objpaths && result == SUCCESS; ++o){
+    pp_objs[o] = new_object(g_objpaths[o]);
+    result = (pp_objs[o] != NULL) ? SUCCESS : FAIL;
+  }
+  struct OutBuf out;
+  if(init_buffer(&out, 1 << 16) != SUCCESS){
+    result = FAIL;
+  }
+  if(result == SUCCESS){
+    result = archive_write(pp_objs, g_num_objpaths, &out);
+  }
+  if(result == SUCCESS){
+    VERBOSE2("writing archive to file '%s'...\n", g_ofname);
+    result = write_file(g_ofname, &out);
+  }
+  free_outbuf(&out);
+  for(int o = 0; o < g_num_objpaths && pp_objs != NULL; ++o){
+    if(pp_objs[o] != NULL){
+      free_object(&pp_objs[o]);
+    }
+  }
+  free(pp_objs);
+  return (result == SUCCESS) ? ERROR_1 : FAIL;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: prints the registers and R0..R15 of a state.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void print_registers(uint16_t a, uint16_t d, uint16_t pc, const uint16_t* p_regs){
+  printf("A=%" PRIu16 " D=%" PRIu16 " PC=%" PRIu16 "\n", a, d, pc);
+  for(int r = 0; r < NUM_RUN_REGISTERS; ++r){
+    printf("R%d=%" PRId16 "%s", r, (int16_t)p_regs[r], ((r + 1) % 8 == 0) ? "\n" : " ");
   }
 }
 
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: prints the state a run stopped in; its status, registers and R0..R15.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void print_run(const char* who, int status, uint16_t a, uint16_t d, uint16_t pc, uint64_t cycles, 
+                      const uint16_t* p_regs){
+  const char* how = (status == SIM_HALTED) ? "halted" : (status == SIM_ENDED) ? "ended" : "reached the cycle limit";
+  printf("%s: %s at pc %" PRIu16 " after %" PRIu64 " cycles\n", who, how, pc, cycles);
+  print_registers(a, d, pc, p_regs);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void print_run_stats(uint64_t cycles, const struct timespec* p_start, const struct timespec* p_end){
+  double seconds = (p_end->tv_sec - p_start->tv_sec) + (p_end->tv_nsec - p_start->tv_nsec) / 1e9;
+  printf("stats: ran %" PRIu64 " instructions in %.3f seconds, %.1f million instructions per second\n", cycles, 
+         seconds, (seconds > 0) ? cycles / seconds / 1e6 : 0.0);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: appends the RAM of a run to a dump; MAX_ADDRESS little-endian words.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int put_ram_dump(struct OutBuf* p_dump, const uint16_t* p_ram){
+  if(outbuf_reserve(p_dump, MAX_ADDRESS * 2) != SUCCESS){
+    return FAIL;
+  }
+  unsigned char* o = (unsigned char*)p_dump->_p_data + p_dump->_size;
+  for(uint32_t w = 0; w < MAX_ADDRESS; ++w){
+    o[2 * w] = (unsigned char)(p_ram[w] & 0xff);
+    o[2 * w + 1] = (unsigned char)(p_ram[w] >> 8);
+  }
+  p_dump->_size += MAX_ADDRESS * 2;
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: reads the test vectors of a batch; one instance per line, of whitespace separated 'address=value' settings
+ *  of its RAM, where an address is a number or a symbol of the program. Blank lines and lines starting '#' are
+ *  skipped.
+ * @param p_batch: the batch to set the RAM of, or NULL to only count the instances.
+ * @param <out> p_num_lanes: the number of instances.
+ * return: SUCCESS, or FAIL if a setting is invalid.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int read_vectors(const struct OutBuf* p_text, Batch_t* p_batch, uint32_t* p_num_lanes){
+  const char* p = p_text->_p_data, *end = p + p_text->_size;
+  uint32_t lineno = 0, lane = 0;
+  while(p < end){
+    const char* eol = memchr(p, '\n', end - p);
+    eol = (eol != NULL) ? eol : end;
+    ++lineno;
+    p += strspn(p, " \t\r");
+    bool is_instance = p < eol && *p != '#';
+    while(is_instance && p < eol){
+      size_t n = strcspn(p, " \t\r\n");
+      n = (p + n > eol) ? (size_t)(eol - p) : n;
+      uint16_t address, value;
+      if(parse_setting(gp_asm->_p_sym_lib, p, n, &address, &value) != SUCCESS){
+        fprintf(stderr, "%s:%" PRIu32 ":error:invalid setting '%.*s', expected address=value\n", g_batch_path, lineno,
+                (int)n, p);
+        return FAIL;
+      }
+      if(p_batch != NULL){
+        batch_poke(p_batch, lane, address, value);
+      }
+      p += n;
+      p += strspn(p, " \t\r");
+    }
+    lane += is_instance;
+    p = eol + 1;
+  }
+  *p_num_lanes = lane;
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: runs an instance of the program for each test vector, in lockstep, then prints the state each stopped in.
+ * return: SUCCESS if every instance halted or ended, FAIL if one reached the cycle limit or on error.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int run_batch(const Sim_t* p_sim, struct OutBuf* p_dump){
+  struct OutBuf text;
+  uint32_t num_lanes;
+  Batch_t* p_batch = NULL;
+  int result = init_buffer(&text, 1 << 12);
+  result = (result == SUCCESS) ? read_file(g_batch_path, &text) : result;
+  result = (result == SUCCESS) ? read_vectors(&text, NULL, &num_lanes) : result;
+  if(result == SUCCESS && (p_batch = new_batch(p_sim, num_lanes)) == NULL){
+    fprintf(stderr, "fatal error: out of memory\n");
+    result = FAIL;
+  }
+  result = (result == SUCCESS) ? read_vectors(&text, p_batch, &num_lanes) : result;
+  free_outbuf(&text);
+  if(result != SUCCESS){
+    if(p_batch != NULL){
+      free_batch(&p_batch);
+    }
+    return FAIL;
+  }
+  VERBOSE2("running %" PRIu32 " instances on the simulator, in lockstep...\n", num_lanes);
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  batch_run(p_batch, g_max_cycles);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  uint64_t cycles = 0;
+  bool is_limit = false;
+  uint16_t* p_ram = (uint16_t*)malloc(MAX_ADDRESS * sizeof(uint16_t));
+  result = (p_ram != NULL) ? SUCCESS : FAIL;
+  for(uint32_t lane = 0; lane < num_lanes && result == SUCCESS; ++lane){
+    BatchLane_t state = batch_lane(p_batch, lane);
+    char who[32];
+    snprintf(who, sizeof(who), "instance %" PRIu32, lane + 1);
+    uint16_t regs[NUM_RUN_REGISTERS];
+    for(int r = 0; r < NUM_RUN_REGISTERS; ++r){
+      regs[r] = batch_peek(p_batch, lane, (uint16_t)r);
+    }
+    print_run(who, state._status, state._a, state._d, state._pc, state._cycles, regs);
+    if(p_dump != NULL){
+      batch_dump(p_batch, lane, p_ram);
+      result = put_ram_dump(p_dump, p_ram);
+    }
+    is_limit = is_limit || state._status == SIM_LIMIT;
+    cycles += state._cycles;
+  }
+  if(g_is_stats){
+    print_run_stats(cycles, &start, &end);
+  }
+  free(p_ram);
+  free_batch(&p_batch);
+  return is_limit ? FAIL : result;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: prints the profile of a run to stdout; with --profile=file, also writes its folded stacks to the file, rooted
+ *  at the name of the infile.
+ * return: SUCCESS, or FAIL if the folded stacks could not be written.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int print_profile(const uint64_t* p_counts){
+  struct OutBuf out;
+  if(init_buffer(&out, 1 << 12) != SUCCESS){
+    return FAIL;
+  }
+  int result = profile_report(gp_asm, p_counts, &out);
+  result = (result == SUCCESS) ? outbuf_flush(&out, stdout) : result;
+  if(result == SUCCESS && g_folded_path != NULL){
+    const char* slash = strrchr(g_ifpath, '/');
+    outbuf_clear(&out);
+    result = profile_folded(gp_asm, (slash != NULL) ? slash + 1 : g_ifpath, p_counts, &out);
+    VERBOSE2("writing folded stacks to file '%s'...\n", g_folded_path);
+    result = (result == SUCCESS) ? write_file(g_folded_path, &out) : result;
+  }
+  if(result != SUCCESS){
+    fprintf(stderr, "fatal error: failed to write the profile\n");
+  }
+  free_outbuf(&out);
+  return result;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: prints the coverage of a run to stdout; with --coverage=file, merged with the coverage the file holds of the
+ *  same program, then written back to the file.
+ * return: SUCCESS, or FAIL if the file is not a coverage or could not be written.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int print_coverage(const Sim_t* p_sim){
+  SimCoverage_t cov;
+  memset(&cov, 0, sizeof(SimCoverage_t));
+  sim_coverage(p_sim, &cov);
+  struct OutBuf out;
+  int result = init_buffer(&out, 1 << 12);
+  if(result == SUCCESS && g_coverage_path != NULL && access(g_coverage_path, F_OK) == 0 && 
+     (result = read_file(g_coverage_path, &out)) == SUCCESS){
+    result = coverage_read(&cov, gp_asm->_p_hackins, gp_asm->_ins_count, out._p_data, out._size);
+    if(result == ERROR_1){
+      VERBOSE2("coverage file '%s' is of another program, replacing it...\n", g_coverage_path);
+      result = SUCCESS;
+    }
+    else if(result != SUCCESS){
+      fprintf(stderr, "fatal error: '%s' is not a coverage file\n", g_coverage_path);
+    }
+    outbuf_clear(&out);
+  }
+  result = (result == SUCCESS) ? coverage_report(gp_asm->_p_srcmap, gp_asm->_p_hackins, &cov, &out) : result;
+  result = (result == SUCCESS) ? outbuf_flush(&out, stdout) : result;
+  if(result == SUCCESS && g_coverage_path != NULL){
+    outbuf_clear(&out);
+    VERBOSE2("writing coverage to file '%s'...\n", g_coverage_path);
+    result = coverage_write(&cov, gp_asm->_p_hackins, gp_asm->_ins_count, &out);
+    result = (result == SUCCESS) ? write_file(g_coverage_path, &out) : result;
+  }
+  free_outbuf(&out);
+  return result;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: puts the simulator in the state of the snapshot of --restore.
+ * return: SUCCESS, or FAIL if the file cannot be read or is not a snapshot of the program.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int restore_snapshot(Sim_t* p_sim){
+  SimState_t* p_state = (SimState_t*)malloc(sizeof(SimState_t));
+  if(p_state == NULL){
+    fprintf(stderr, "fatal error: out of memory\n");
+    return FAIL;
+  }
+  struct OutBuf data;
+  VERBOSE2("restoring snapshot '%s'...\n", g_restore_path);
+  int result = init_buffer(&data, 1 << 12);
+  result = (result == SUCCESS) ? read_file(g_restore_path, &data) : result;
+  if(result == SUCCESS && 
+     (result = snapshot_read(p_state, gp_asm->_p_hackins, gp_asm->_ins_count, data._p_data, data._size)) != SUCCESS){
+    fprintf(stderr, (result == ERROR_1) ? "fatal error: snapshot '%s' is of another program\n" : 
+            "fatal error: '%s' is not a snapshot file\n", g_restore_path);
+    result = FAIL;
+  }
+  if(result == SUCCESS){
+    sim_restore(p_sim, p_state);
+  }
+  free_outbuf(&data);
+  free(p_state);
+  return result;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: writes the state of the simulator to the snapshot file of --save.
+ * return: SUCCESS, or FAIL if the file could not be written.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int save_snapshot(const Sim_t* p_sim){
+  SimState_t* p_state = (SimState_t*)malloc(sizeof(SimState_t));
+  if(p_state == NULL){
+    fprintf(stderr, "fatal error: out of memory\n");
+    return FAIL;
+  }
+  sim_save(p_sim, p_state);
+  struct OutBuf out;
+  VERBOSE2("writing snapshot to file '%s'...\n", g_save_path);
+  int result = init_buffer(&out, 1 << 12);
+  result = (result == SUCCESS) ? snapshot_write(p_state, gp_asm->_p_hackins, gp_asm->_ins_count, &out) : result;
+  result = (result == SUCCESS) ? write_file(g_save_path, &out) : result;
+  free_outbuf(&out);
+  free(p_state);
+  return result;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: steps the run back by the cycles of --rewind, then prints the state it was in.
+ * return: SUCCESS, or FAIL if the history of the run does not reach back so far.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int rewind_run(History_t* p_hist, Sim_t* p_sim){
+  uint64_t reach = history_reach(p_hist, p_sim);
+  if(history_rewind(p_hist, p_sim, g_rewind) != SUCCESS){
+    fprintf(stderr, "fatal error: cannot rewind %" PRIu64 " cycles; the run kept the states of its last %" PRIu64 
+            " cycles\n", g_rewind, reach);
+    return FAIL;
+  }
+  printf("rewound: %" PRIu64 " cycles back, at pc %" PRIu16 " after %" PRIu64 " cycles\n", g_rewind, p_sim->_pc, 
+         p_sim->_cycles);
+  print_registers(p_sim->_a, p_sim->_d, p_sim->_pc, p_sim->_p_ram);
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: runs the simulator as 'sim_run' does, or 'history_run' with --rewind, taking a frame of the screen into a
+ *  buffer every --frame-cycles cycles.
+ * @param <out> p_result: set to FAIL if the buffer could not grow.
+ * return: SIM_HALTED, SIM_ENDED or SIM_LIMIT.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int run_frames(Sim_t* p_sim, History_t* p_hist, Frames_t* p_frames, struct OutBuf* p_out, int* p_result){
+  uint64_t left = g_max_cycles;
+  int status;
+  do{
+    uint64_t slice = (g_max_cycles != 0 && left < g_frame_cycles) ? left : g_frame_cycles;
+    status = (p_hist != NULL) ? history_run(p_hist, p_sim, slice) : sim_run(p_sim, slice);
+    left -= (g_max_cycles != 0) ? slice : 0;
+    if(frames_take(p_frames, p_sim, p_out) != SUCCESS){
+      *p_result = FAIL;
+    }
+  }while(status == SIM_LIMIT && (g_max_cycles == 0 || left > 0));
+  return status;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: runs the assembled or linked program on the simulator, from reset or the snapshot of --restore, then prints
+ *  the state it stopped in; or with --batch, an instance of it for each test vector.
+ * return: SUCCESS if the program halted or ended, or with --save reached the cycle limit; else FAIL.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int run_program(){
+  Sim_t* p_sim = new_sim();
+  if(p_sim == NULL){
+    fprintf(stderr, "fatal error: out of memory\n");
+    return FAIL;
+  }
+  sim_load(p_sim, gp_asm->_p_hackins, gp_asm->_ins_count);
+  struct OutBuf dump;
+  if(init_buffer(&dump, 1 << 16) != SUCCESS){
+    free_sim(&p_sim);
+    return FAIL;
+  }
+  if(g_batch_path != NULL){
+    int result = run_batch(p_sim, (g_dump_path != NULL) ? &dump : NULL);
+    if(g_dump_path != NULL && result == SUCCESS){
+      result = write_file(g_dump_path, &dump);
+    }
+    free_outbuf(&dump);
+    free_sim(&p_sim);
+    return result;
+  }
+  Jit_t* p_jit = NULL;
+  if(g_is_jit && (p_jit = new_jit(p_sim)) == NULL){
+    VERBOSE("cannot compile to native code on this host, interpreting...\n");
+  }
+  History_t* p_hist = NULL;
+  Frames_t* p_frames = NULL;
+  int result = (g_restore_path != NULL) ? restore_snapshot(p_sim) : SUCCESS;
+  if(result == SUCCESS && ((g_is_profile && sim_profile(p_sim) != SUCCESS) || 
+                           (g_rewind != 0 && (p_hist = new_history()) == NULL))){
+    fprintf(stderr, "fatal error: out of memory\n");
+    result = FAIL;
+  }
+  if(result == SUCCESS && g_frames_path != NULL){
+    size_t l = strlen(g_frames_path);
+    bool is_pbm = l >= 4 && strcmp(g_frames_path + l - 4, ".pbm") == 0;
+    if((p_frames = new_frames(is_pbm ? FRAMES_PBM : FRAMES_DELTA)) == NULL){
+      fprintf(stderr, "fatal error: out of memory\n");
+      result = FAIL;
+    }
+  }
+  struct OutBuf frames;
+  if(result == SUCCESS && init_buffer(&frames, 1 << 16) != SUCCESS){
+    result = FAIL;
+  }
+  if(result != SUCCESS){
+    if(p_frames != NULL){
+      free_frames(&p_frames);
+    }
+    if(p_hist != NULL){
+      free_history(&p_hist);
+    }
+    if(p_jit != NULL){
+      free_jit(&p_jit);
+    }
+    free_outbuf(&dump);
+    free_sim(&p_sim);
+    return FAIL;
+  }
+  VERBOSE2("running %" PRIu32 " instructions on the simulator...\n", gp_asm->_ins_count);
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  int status = (p_jit != NULL) ? jit_run(p_jit, p_sim, g_max_cycles) : 
+               (p_frames != NULL) ? run_frames(p_sim, p_hist, p_frames, &frames, &result) :
+               (p_hist != NULL) ? history_run(p_hist, p_sim, g_max_cycles) : sim_run(p_sim, g_max_cycles);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  if(p_frames != NULL){
+    if(result != SUCCESS){
+      fprintf(stderr, "fatal error: out of memory\n");
+    }
+    else{
+      VERBOSE2("writing frames to file '%s'...\n", g_frames_path);
+      result = write_file(g_frames_path, &frames);
+    }
+    free_frames(&p_frames);
+  }
+  free_outbuf(&frames);
+
+  print_run(g_ifpath, status, p_sim->_a, p_sim->_d, p_sim->_pc, p_sim->_cycles, p_sim->_p_ram);
+  if(g_is_stats){
+    print_run_stats(p_sim->_cycles, &start, &end);
+  }
+  result = (status == SIM_LIMIT && g_save_path == NULL) ? FAIL : result;
+  if(g_is_profile){
+    result = (print_profile(p_sim->_p_counts) == SUCCESS) ? result : FAIL;
+  }
+  if(g_is_coverage){
+    result = (print_coverage(p_sim) == SUCCESS) ? result : FAIL;
+  }
+  if(p_hist != NULL){
+    result = (rewind_run(p_hist, p_sim) == SUCCESS) ? result : FAIL;
+    free_history(&p_hist);
+  }
+  if(g_save_path != NULL && result == SUCCESS){
+    result = save_snapshot(p_sim);
+  }
+  if(g_dump_path != NULL && result == SUCCESS){
+    result = (put_ram_dump(&dump, p_sim->_p_ram) == SUCCESS) ? write_file(g_dump_path, &dump) : FAIL;
+  }
+  free_outbuf(&dump);
+  if(p_jit != NULL){
+    free_jit(&p_jit);
+  }
+  free_sim(&p_sim);
+  return result;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: assembles the input, then reassembles it incrementally each time it changes, until interrupted.
+ * return: FAIL if the input cannot be watched.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int watch(){
+  g_num_jobs = plan_jobs((g_emit != 0) ? g_emit : EMIT_HACK, g_jobs);
+  Watcher_t* p_watcher = new_watcher(g_ifpath);
+  if(p_watcher == NULL){
+    return FAIL;
+  }
+  while(true){
+    uint32_t num_lexed, num_encoded;
+    if(assembler_update(gp_asm, g_ifpath, &num_lexed, &num_encoded) == SUCCESS && run_jobs(g_jobs, g_num_jobs) == SUCCESS &&
+       write_depfile(g_jobs, g_num_jobs) == SUCCESS){
+      printf("%s: assembled; lexed %" PRIu32 " lines, encoded %" PRIu32 " instructions\n", g_ifpath, num_lexed,
+             num_encoded);
+      if(g_is_stats){
+        g_stat_commands = gp_asm->_line_count;
+        g_stat_instructions = gp_asm->_ins_count;
+        g_stat_variables = gp_asm->_ram_address - RAM_START_ADDRESS;
+        print_stats(true);
+      }
+    }
+    else{
+      printf("%s: assembly failed\n", g_ifpath);
+    }
+    fflush(stdout);
+    if(watcher_wait(p_watcher) != SUCCESS){
+      free_watcher(&p_watcher);
+      return FAIL;
+    }
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: reassembles the input of a session after it changed and patches the program of the simulator, keeping its
+ *  RAM and registers; the pc is moved to the instruction of the same line, else to the label it followed, else to 0.
+ * @param <in/out> p_line: the line of the pc, tracked across updates that fail; 0 if not known.
+ * @param <in/out> label: the label the pc followed, empty if none.
+ * return: SUCCESS if the input reassembled and the simulator was patched.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int reload(Sim_t* p_sim, uint32_t* p_line, char* label){
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  uint32_t num_lexed, num_encoded;
+  int result = assembler_update(gp_asm, g_ifpath, &num_lexed, &num_encoded);
+  *p_line = assembler_map_line(gp_asm, *p_line);
+  if(result != SUCCESS){
+    printf("%s: assembly failed; paused\n", g_ifpath);
+    return FAIL;
+  }
+  const SrcMap_t* p_map = gp_asm->_p_srcmap;
+  uint16_t pc = p_sim->_pc;
+  uint32_t address = 0;
+  const char* how = "reset";
+  if(srcmap_find_line(p_map, *p_line, &address) == SUCCESS){
+    how = "line";
+  }
+  else if(label[0] != '\0' && srcmap_find_label(p_map, label, &address) == SUCCESS){
+    how = "label";
+  }
+  uint32_t num_patched = sim_patch(p_sim, gp_asm->_p_hackins, gp_asm->_ins_count);
+  p_sim->_pc = (uint16_t)address;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double ms = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+  printf("%s: reloaded in %.3f ms; lexed %" PRIu32 " lines, encoded %" PRIu32 ", patched %" PRIu32 " instructions; "
+         "pc %" PRIu16 " -> %" PRIu32 " by %s\n", g_ifpath, ms, num_lexed, num_encoded, num_patched, pc, address, how);
+  if(run_jobs(g_jobs, g_num_jobs) != SUCCESS || write_depfile(g_jobs, g_num_jobs) != SUCCESS){
+    printf("%s: failed to write the outfiles\n", g_ifpath);
+  }
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: runs the input on the simulator, from reset or the snapshot of --restore, and each time it changes patches
+ *  the reassembled program into the run, until interrupted. A run that stops, or reaches the cycle limit, waits for
+ *  the next change; a program that fails to assemble is paused until it is fixed.
+ * return: FAIL if the input cannot be watched, assembled at first, or restored.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int run_session(){
+  g_num_jobs = is_writing() ? plan_jobs((g_emit != 0) ? g_emit : EMIT_HACK, g_jobs) : 0;
+  uint32_t num_lexed, num_encoded;
+  if(assembler_update(gp_asm, g_ifpath, &num_lexed, &num_encoded) != SUCCESS || 
+     run_jobs(g_jobs, g_num_jobs) != SUCCESS || write_depfile(g_jobs, g_num_jobs) != SUCCESS){
+    return FAIL;
+  }
+  Sim_t* p_sim = new_sim();
+  if(p_sim == NULL){
+    fprintf(stderr, "fatal error: out of memory\n");
+    return FAIL;
+  }
+  sim_load(p_sim, gp_asm->_p_hackins, gp_asm->_ins_count);
+  Watcher_t* p_watcher = NULL;
+  if((g_restore_path != NULL && restore_snapshot(p_sim) != SUCCESS) || (p_watcher = new_watcher(g_ifpath)) == NULL){
+    free_sim(&p_sim);
+    return FAIL;
+  }
+  VERBOSE2("running %" PRIu32 " instructions on the simulator, patched as the infile changes...\n", 
+           gp_asm->_ins_count);
+
+  uint64_t left = g_max_cycles;
+  bool is_running = true;
+  uint32_t line = 0;
+  char label[MAX_SYM_LENGTH + 1] = "";
+  while(true){
+    bool is_changed = false;
+    int result;
+    if(is_running){
+      uint64_t slice = (g_max_cycles != 0 && left < SESSION_SLICE_CYCLES) ? left : SESSION_SLICE_CYCLES;
+      int status = sim_run(p_sim, slice);
+      left -= (g_max_cycles != 0) ? slice : 0;
+      if(status != SIM_LIMIT || (g_max_cycles != 0 && left == 0)){
+        print_run(g_ifpath, status, p_sim->_a, p_sim->_d, p_sim->_pc, p_sim->_cycles, p_sim->_p_ram);
+        fflush(stdout);
+        is_running = false;
+      }
+      result = is_running ? watcher_poll(p_watcher, &is_changed) : SUCCESS;
+    }
+    else{
+      result = watcher_wait(p_watcher);
+      is_changed = true;
+    }
+    if(result != SUCCESS){
+      break;
+    }
+    if(!is_changed){
+      continue;
+    }
+
+    // only the pc of the program last assembled has a source; keep it while the input fails to assemble...
+    if(gp_asm->_fail == SUCCESS){
+      const char* name = (p_sim->_pc < gp_asm->_ins_count) ? srcmap_label(gp_asm->_p_srcmap, p_sim->_pc) : NULL;
+      line = (p_sim->_pc < gp_asm->_ins_count) ? gp_asm->_p_srcmap->_p_lines[p_sim->_pc] : 0;
+      snprintf(label, sizeof(label), "%s", (name != NULL) ? name : "");
+    }
+    is_running = reload(p_sim, &line, label) == SUCCESS;
+    left = g_max_cycles;
+    fflush(stdout);
+  }
+  free_watcher(&p_watcher);
+  free_sim(&p_sim);
+  return FAIL;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: runs the tests of the input directory on a thread of each core, then writes their JUnit report to the
+ *  output file, or to TEST-<directory name>.xml.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int test(){
+  char path[MAX_FILEPATH_CHAR];
+  if(g_has_ofname){
+    snprintf(path, MAX_FILEPATH_CHAR, "%s", g_ofname);
+  }
+  else{
+    size_t l = strlen(g_ifpath);
+    while(l > 1 && g_ifpath[l - 1] == '/'){
+      --l;
+    }
+    size_t b = l;
+    while(b > 0 && g_ifpath[b - 1] != '/'){
+      --b;
+    }
+    snprintf(path, MAX_FILEPATH_CHAR, "TEST-%.*s.xml", (int)(l - b), g_ifpath + b);
+  }
+  long num_workers = sysconf(_SC_NPROCESSORS_ONLN);
+  struct OutBuf report;
+  if(init_buffer(&report, 1 << 16) != SUCCESS){
+    return FAIL;
+  }
+  int result = run_tests(g_ifpath, g_max_cycles, (num_workers > 0) ? (int)num_workers : 1, gp_jobserver, 
+                         g_is_coverage, g_is_verbose, &report);
+  if(result != FAIL){
+    VERBOSE2("writing test report to file '%s'...\n", path);
+    result = (write_file(path, &report) == SUCCESS) ? result : FAIL;
+  }
+  free_outbuf(&report);
+  return (result == SUCCESS) ? ERROR_1 : FAIL;
+}
+
 /*-------------------------------------------------------------------------------------------------------------------*/
 int main(int argc, char* argv[]){
   parse_args(argc, argv);
+  if(g_mode == MODE_HELP){
+    print_help();
+    return SUCCESS;
+  }
+  if(g_mode == MODE_SERVE){
+    assert(atexit(clean_exit) == SUCCESS);
+    long num_workers = sysconf(_SC_NPROCESSORS_ONLN);
+    VERBOSE2("serving requests on '%s'...\n", g_serve_path);
+    return (serve(g_serve_path, (num_workers > 0) ? (int)num_workers : 1) == SUCCESS) ? SUCCESS : FAIL;
+  }
+
+  // the modes return SUCCESS if all outputs were cached, ERROR_1 if the input was processed...
+  init_assembler();
+  if(g_is_watch){
+    return (((g_is_run) ? run_session() : watch()) == SUCCESS) ? SUCCESS : FAIL;
+  }
+  int result;
   switch(g_mode){
-    case MODE_HELP:
-      print_help();
-      break;
     case MODE_STRIP:
-      init_assembler();
-      parse_file();
-      substitute_symbols(0);
-      print_stripped_assembly(g_ofstream);
-      fclose(g_ofstream);
+      result = strip();
+      break;
+    case MODE_COMPILE:
+      result = compile();
+      break;
+    case MODE_LINK:
+      result = link_program();
+      break;
+    case MODE_ARCHIVE:
+      result = archive();
+      break;
+    case MODE_TEST:
+      result = test();
       break;
-    case MODE_ASSEMBLE:
-      init_assembler();
-      parse_file();
-      substitute_symbols(1);
-      init_decoder();
-      generate_hackins();
-      print_hackins(g_ofstream);
-      fclose(g_ofstream);
+    default:
+      result = assemble();
+  }
+  if(result == FAIL || write_depfile(g_jobs, g_num_jobs) != SUCCESS){
+    exit(FAIL);
+  }
+  if(g_is_run && run_program() != SUCCESS){
+    exit(FAIL);
+  }
+  if(gp_cache){
+    cache_evict(gp_cache);
+  }
+  if(g_is_stats){
+    print_stats(result == ERROR_1);
   }
   return SUCCESS;
 }
-
@@ -0,0 +1,361 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: object.c
+ *
+ *===================================================================================================================*/
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "object.h"
+#include "assembler.h"
+#include "parser.h"
+#include "decoder.h"
+#include "symbollib.h"
+#include "outbuf.h"
+#include "diag.h"
+#include "asmerr.h"
+
+#define HEADER_SIZE 24 /* bytes of the object header. */
+#define SYM_SIZE 8     /* bytes of a symbol entry. */
+#define RELOC_SIZE 8   /* bytes of a relocation entry. */
+#define MAX_SYMS 0xffff /* symbol indices are kept in a SymLib, whose values are 16-bit. */
+
+/*
+ * brief: state of composing the sections of an object; the sections are composed apart and joined after.
+ */
+typedef struct Writer {
+  struct OutBuf _words;
+  struct OutBuf _syms;
+  struct OutBuf _relocs;
+  struct OutBuf _strtab;
+  struct SymLib* _p_index;  /* maps the name of each symbol of the object to its index. */
+  uint32_t _num_syms;
+  int _fail;
+} Writer_t;
+
+/*=====================================================================================================================
+ * PRIVATE HELPERS
+ *===================================================================================================================*/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int put_u16le(struct OutBuf* p_buf, uint16_t v){
+  char b[2] = {(char)v, (char)(v >> 8)};
+  return outbuf_write(p_buf, b, 2);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int put_u32le(struct OutBuf* p_buf, uint32_t v){
+  char b[4] = {(char)v, (char)(v >> 8), (char)(v >> 16), (char)(v >> 24)};
+  return outbuf_write(p_buf, b, 4);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static uint16_t get_u16le(const uint8_t* b){
+  return (uint16_t)(b[0] | (b[1] << 8));
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static uint32_t get_u32le(const uint8_t* b){
+  return (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: appends a symbol to the symbol table of the object being written.
+ * @param <out> p_index: index of the new symbol.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void add_entry(Writer_t* w, const char* name, uint16_t value, uint8_t kind, uint32_t* p_index){
+  *p_index = w->_num_syms;
+  if(w->_num_syms == MAX_SYMS){
+    if(w->_fail == SUCCESS){
+      fprintf(diag_stream(), "object has more than %d symbols\n", MAX_SYMS);
+    }
+    w->_fail = FAIL;
+    return;
+  }
+  char pad[2] = {(char)kind, 0};
+  if(put_u32le(&w->_syms, (uint32_t)w->_strtab._size) != SUCCESS || put_u16le(&w->_syms, value) != SUCCESS ||
+     outbuf_write(&w->_syms, pad, 2) != SUCCESS || outbuf_write(&w->_strtab, name, strlen(name) + 1) != SUCCESS ||
+     symlib_add_symbol(w->_p_index, name, (uint16_t)w->_num_syms, SYMTAG_NONE) != SUCCESS){
+    w->_fail = FAIL;
+    return;
+  }
+  ++w->_num_syms;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: SymVisitor_t exporting each label of the unit.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void export_label(const char* sym, uint16_t address, uint8_t tag, void* p_ctx){
+  uint32_t index;
+  if(tag == SYMTAG_LABEL){
+    add_entry((Writer_t*)p_ctx, sym, address, OBJSYM_EXPORT, &index);
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: encodes a command of the unit into the words of the object; '@<symbol>' commands of labels and undeclared
+ *  symbols become relocations, the first use of an undeclared symbol importing it.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void write_command(const Assembler_t* p, Writer_t* w, const Command_t* c){
+  Command_t cmd = *c;
+  uint16_t word = 0, address;
+  uint8_t tag;
+  switch(c->_type){
+    case CFORMAT_A0:
+      if(symlib_lookup(p->_p_sym_lib, c->_sym, &address, &tag) == SUCCESS && tag == SYMTAG_PREDEFINED){
+        cmd._type = CFORMAT_A1;
+        cmd._value = address;
+        decode(&cmd, &word);
+        break;
+      }
+      uint32_t index = 0;
+      if(symlib_search_symbol(w->_p_index, c->_sym, &address) == SUCCESS){
+        index = address;
+      }
+      else{
+        add_entry(w, c->_sym, 0, OBJSYM_IMPORT, &index);
+      }
+      if(put_u32le(&w->_relocs, (uint32_t)(w->_words._size / 2)) != SUCCESS || put_u32le(&w->_relocs, index) != SUCCESS){
+        w->_fail = FAIL;
+      }
+      break;
+    case CFORMAT_A1:
+    case CFORMAT_C0:
+    case CFORMAT_C1:
+    case CFORMAT_C2:
+      decode(&cmd, &word);
+      break;
+    default:
+      return; // L commands generate no instructions.
+  }
+  if(put_u16le(&w->_words, word) != SUCCESS){
+    w->_fail = FAIL;
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: reports an invalid object.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static Object_t* reject_object(Object_t* p_obj, const char* why){
+  fprintf(diag_stream(), "%s: invalid object, %s\n", p_obj->_name, why);
+  free_object(&p_obj);
+  return NULL;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: locates the sections of a mapped object and checks every offset and index within them.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static Object_t* validate_object(Object_t* p_obj){
+  const uint8_t* d = p_obj->_p_data;
+  if(p_obj->_size < HEADER_SIZE || get_u32le(d) != OBJECT_MAGIC){
+    return reject_object(p_obj, "bad magic");
+  }
+  if(get_u16le(d + 4) != OBJECT_VERSION){
+    return reject_object(p_obj, "unsupported version");
+  }
+  p_obj->_num_words = get_u32le(d + 8);
+  p_obj->_num_syms = get_u32le(d + 12);
+  p_obj->_num_relocs = get_u32le(d + 16);
+  p_obj->_strtab_size = get_u32le(d + 20);
+  uint64_t size = HEADER_SIZE + 2ULL * p_obj->_num_words + (uint64_t)SYM_SIZE * p_obj->_num_syms + 
+                  (uint64_t)RELOC_SIZE * p_obj->_num_relocs + p_obj->_strtab_size;
+  if(size != p_obj->_size){
+    return reject_object(p_obj, "section sizes do not match the file size");
+  }
+  if(p_obj->_num_words > MAX_ADDRESS){
+    return reject_object(p_obj, "more instructions than ROM holds");
+  }
+  p_obj->_p_words = d + HEADER_SIZE;
+  p_obj->_p_syms = p_obj->_p_words + 2 * (size_t)p_obj->_num_words;
+  p_obj->_p_relocs = p_obj->_p_syms + SYM_SIZE * (size_t)p_obj->_num_syms;
+  p_obj->_p_strtab = (const char*)(p_obj->_p_relocs + RELOC_SIZE * (size_t)p_obj->_num_relocs);
+  if(p_obj->_strtab_size > 0 && p_obj->_p_strtab[p_obj->_strtab_size - 1] != '\0'){
+    return reject_object(p_obj, "unterminated string table");
+  }
+  for(uint32_t i = 0; i < p_obj->_num_syms; ++i){
+    const uint8_t* e = p_obj->_p_syms + SYM_SIZE * (size_t)i;
+    uint32_t name = get_u32le(e);
+    if(name >= p_obj->_strtab_size || strlen(p_obj->_p_strtab + name) >= MAX_SYM_LENGTH){
+      return reject_object(p_obj, "bad symbol name");
+    }
+    if((e[6] != OBJSYM_EXPORT && e[6] != OBJSYM_IMPORT) || get_u16le(e + 4) > MAX_ADDRESS){
+      return reject_object(p_obj, "bad symbol");
+    }
+  }
+  for(uint32_t i = 0; i < p_obj->_num_relocs; ++i){
+    const uint8_t* e = p_obj->_p_relocs + RELOC_SIZE * (size_t)i;
+    if(get_u32le(e) >= p_obj->_num_words || get_u32le(e + 4) >= p_obj->_num_syms){
+      return reject_object(p_obj, "bad relocation");
+    }
+  }
+  return p_obj;
+}
+
+/*=====================================================================================================================
+ * PUBLIC INTERFACE
+ *===================================================================================================================*/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int object_write(const Assembler_t* p, struct OutBuf* p_out){
+  Writer_t w = {._fail = SUCCESS};
+  if(init_outbuf(&w._words, 1 << 12) != SUCCESS || init_outbuf(&w._syms, 1 << 12) != SUCCESS ||
+     init_outbuf(&w._relocs, 1 << 12) != SUCCESS || init_outbuf(&w._strtab, 1 << 12) != SUCCESS ||
+     new_symlib(&w._p_index) != SUCCESS){
+    w._fail = FAIL;
+  }
+  if(w._fail == SUCCESS){
+    symlib_foreach(p->_p_sym_lib, export_label, &w);
+    for(uint32_t cn = 0; cn < p->_line_count && w._fail == SUCCESS; ++cn){
+      write_command(p, &w, &p->_p_cmds[cn]);
+    }
+  }
+  if(w._fail == SUCCESS){
+    char reserved[2] = {0, 0};
+    if(put_u32le(p_out, OBJECT_MAGIC) != SUCCESS || put_u16le(p_out, OBJECT_VERSION) != SUCCESS ||
+       outbuf_write(p_out, reserved, 2) != SUCCESS || put_u32le(p_out, (uint32_t)(w._words._size / 2)) != SUCCESS ||
+       put_u32le(p_out, w._num_syms) != SUCCESS || put_u32le(p_out, (uint32_t)(w._relocs._size / RELOC_SIZE)) != SUCCESS ||
+       put_u32le(p_out, (uint32_t)w._strtab._size) != SUCCESS ||
+       outbuf_write(p_out, w._words._p_data, w._words._size) != SUCCESS ||
+       outbuf_write(p_out, w._syms._p_data, w._syms._size) != SUCCESS ||
+       outbuf_write(p_out, w._relocs._p_data, w._relocs._size) != SUCCESS ||
+       outbuf_write(p_out, w._strtab._p_data, w._strtab._size) != SUCCESS){
+      w._fail = FAIL;
+    }
+  }
+  if(w._p_index){
+    free_symlib(&w._p_index);
+  }
+  free_outbuf(&w._words);
+  free_outbuf(&w._syms);
+  free_outbuf(&w._relocs);
+  free_outbuf(&w._strtab);
+  return w._fail;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+Object_t* new_object(const char* path){
+  Object_t* p_obj = (Object_t*)calloc(1, sizeof(Object_t));
+  if(p_obj == NULL || (p_obj->_name = strdup(path)) == NULL){
+    fprintf(diag_stream(), "fatal error: out of memory\n");
+    free(p_obj);
+    return NULL;
+  }
+  int fd = open(path, O_RDONLY);
+  struct stat st;
+  if(fd < 0 || fstat(fd, &st) != 0){
+    diag_perror(path);
+    if(fd >= 0){
+      close(fd);
+    }
+    free_object(&p_obj);
+    return NULL;
+  }
+  p_obj->_size = (size_t)st.st_size;
+  if(p_obj->_size > 0){
+    void* data = mmap(NULL, p_obj->_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(data == MAP_FAILED){
+      diag_perror(path);
+      close(fd);
+      p_obj->_size = 0;
+      free_object(&p_obj);
+      return NULL;
+    }
+    p_obj->_p_data = (const uint8_t*)data;
+    p_obj->_is_mapped = true;
+  }
+  close(fd);
+  return validate_object(p_obj);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+Object_t* new_object_buffer(const char* name, const void* data, size_t size){
+  Object_t* p_obj = (Object_t*)calloc(1, sizeof(Object_t));
+  if(p_obj == NULL || (p_obj->_name = strdup(name)) == NULL){
+    fprintf(diag_stream(), "fatal error: out of memory\n");
+    free(p_obj);
+    return NULL;
+  }
+  p_obj->_p_data = (const uint8_t*)data;
+  p_obj->_size = size;
+  return validate_object(p_obj);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void free_object(Object_t** pp_obj){
+  Object_t* p_obj = *pp_obj;
+  if(p_obj->_is_mapped){
+    munmap((void*)p_obj->_p_data, p_obj->_size);
+  }
+  free(p_obj->_name);
+  free(p_obj);
+  (*pp_obj) = NULL;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+uint16_t object_word(const Object_t* p_obj, uint32_t i){
+  return get_u16le(p_obj->_p_words + 2 * (size_t)i);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void object_symbol(const Object_t* p_obj, uint32_t i, ObjSym_t* p_out){
+  const uint8_t* e = p_obj->_p_syms + SYM_SIZE * (size_t)i;
+  p_out->_name = p_obj->_p_strtab + get_u32le(e);
+  p_out->_value = get_u16le(e + 4);
+  p_out->_kind = e[6];
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void object_reloc(const Object_t* p_obj, uint32_t i, uint32_t* p_word, uint32_t* p_sym){
+  const uint8_t* e = p_obj->_p_relocs + RELOC_SIZE * (size_t)i;
+  *p_word = get_u32le(e);
+  *p_sym = get_u32le(e + 4);
+}
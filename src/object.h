@@ -0,0 +1,139 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: object.h
+ *
+ *===================================================================================================================*/
+
+
+#ifndef _OBJECT_H_
+#define _OBJECT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "assembler.h"
+
+/*
+ * The relocatable object format of separately assembled translation units. All integers are little-endian.
+ *
+ *   header:   u32 magic, u16 version, u16 reserved (0), u32 num_words, u32 num_symbols, u32 num_relocs,
+ *             u32 strtab_size
+ *   words:    num_words u16 encoded instructions; the word of a relocation holds 0.
+ *   symbols:  num_symbols entries of u32 name (offset into strtab), u16 value, u8 kind, u8 reserved (0).
+ *   relocs:   num_relocs entries of u32 word (index into words), u32 symbol (index into symbols); in word order.
+ *   strtab:   strtab_size bytes of null terminated symbol names.
+ *
+ * Each '@<symbol>' of a label or of an undeclared symbol is a relocation; '@<symbol>' of a predefined symbol is
+ * encoded in place. The linker patches the word of each relocation with the address of its symbol.
+ */
+#define OBJECT_MAGIC     0x4a424f48 // "HOBJ".
+#define OBJECT_VERSION   1
+#define OBJECT_EXTENSION ".hobj"
+
+#define OBJSYM_EXPORT 0x01 // label declared by the unit; value is its address relative to the start of the unit.
+#define OBJSYM_IMPORT 0x02 // symbol used but not declared by the unit; a label of another unit, else a variable.
+
+/*
+ * brief: a symbol of an object.
+ */
+typedef struct ObjSym {
+  const char* _name;
+  uint16_t _value;
+  uint8_t _kind;
+} ObjSym_t;
+
+/*
+ * brief: an object file mapped into memory; instantiate with 'new_object'.
+ *
+ * @member _name: path of the object file, used in error messages.
+ * @member _p_data: the mapped file, or the borrowed image of an archive member.
+ * @member _size: size of the object in bytes.
+ * @member _is_mapped: flag indicates _p_data was mapped by 'new_object', else it is borrowed.
+ * @member _num_*: number of entries of each section.
+ * @member _p_*: base of each section within the mapped file.
+ */
+typedef struct Object {
+  char* _name;
+  const uint8_t* _p_data;
+  size_t _size;
+  uint32_t _num_words;
+  uint32_t _num_syms;
+  uint32_t _num_relocs;
+  uint32_t _strtab_size;
+  const uint8_t* _p_words;
+  const uint8_t* _p_syms;
+  const uint8_t* _p_relocs;
+  const char* _p_strtab;
+  bool _is_mapped;
+} Object_t;
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: composes the object of a translation unit compiled with 'assembler_compile'.
+ * @param <out> p_out: buffer to append the object to.
+ * return: SUCCESS, or FAIL on malloc error or if the unit has too many symbols for the format.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int object_write(const Assembler_t* p, struct OutBuf* p_out);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: maps an object file and validates its header and sections; the accessors below need no further checks.
+ * return: the object, or NULL if the file cannot be read or is not a valid object; errors are reported to the 
+ *  diagnostic stream (see diag.h).
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+Object_t* new_object(const char* path);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: as 'new_object', but of an object image already in memory, e.g. a member of an archive.
+ * @param name: name of the object, used in error messages.
+ * @param data: the object image; borrowed, thus must outlive the object.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+Object_t* new_object_buffer(const char* name, const void* data, size_t size);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void free_object(Object_t** pp_obj);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: accessors of the entries of the sections of an object; indices must be in range.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+uint16_t object_word(const Object_t* p_obj, uint32_t i);
+void object_symbol(const Object_t* p_obj, uint32_t i, ObjSym_t* p_out);
+void object_reloc(const Object_t* p_obj, uint32_t i, uint32_t* p_word, uint32_t* p_sym);
+
+#endif
@@ -0,0 +1,1176 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: optimize.c
+ *
+ *===================================================================================================================*/
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include "optimize.h"
+#include "assembler.h"
+#include "parser.h"
+#include "lexer.h"
+#include "symbollib.h"
+#include "diag.h"
+#include "asmerr.h"
+
+#define PATTERN_MAX 9 // commands of the longest match of the pattern table.
+
+/*
+ * brief: a peephole pattern; a window of commands to match and the commands to rewrite them to, as assembly.
+ *
+ * @member _match, _replace: the commands, NULL terminated; the replacement is shorter than the match. An '@$1' to
+ *  '@$9' matches any A command, the same command each time it recurs, and is replaced by the command it matched.
+ */
+typedef struct Pattern {
+  const char* _name;
+  const char* _match[PATTERN_MAX + 1];
+  const char* _replace[PATTERN_MAX + 1];
+} Pattern_t;
+
+/*
+ * the pattern table; the patterns are tried in order, the first match is rewritten.
+ */
+static const Pattern_t g_patterns[] = {
+  {"pop and push back",   {"@SP", "AM=M-1", "D=M", "@SP", "AM=M+1", NULL},
+                          {"@SP", "A=M-1", "D=M", "A=A+1", NULL}},
+  {"pop and push back",   {"@SP", "AM=M-1", "D=M", "@SP", "A=M", "M=D", "@SP", "M=M+1", "@$1", NULL},
+                          {"@SP", "A=M-1", "D=M", "@$1", NULL}},
+  {"push and pop back",   {"@SP", "M=M+1", "@SP", "AM=M-1", NULL},
+                          {"@SP", "A=M", NULL}},
+  {"operate in place",    {"@SP", "AM=M-1", "M=D+M", "@SP", "M=M+1", "@$1", NULL},
+                          {"@SP", "A=M-1", "M=D+M", "@$1", NULL}},
+  {"operate in place",    {"@SP", "AM=M-1", "M=M-D", "@SP", "M=M+1", "@$1", NULL},
+                          {"@SP", "A=M-1", "M=M-D", "@$1", NULL}},
+  {"operate in place",    {"@SP", "AM=M-1", "M=D&M", "@SP", "M=M+1", "@$1", NULL},
+                          {"@SP", "A=M-1", "M=D&M", "@$1", NULL}},
+  {"operate in place",    {"@SP", "AM=M-1", "M=D|M", "@SP", "M=M+1", "@$1", NULL},
+                          {"@SP", "A=M-1", "M=D|M", "@$1", NULL}},
+  {"operate in place",    {"@SP", "AM=M-1", "M=-M", "@SP", "M=M+1", "@$1", NULL},
+                          {"@SP", "A=M-1", "M=-M", "@$1", NULL}},
+  {"operate in place",    {"@SP", "AM=M-1", "M=!M", "@SP", "M=M+1", "@$1", NULL},
+                          {"@SP", "A=M-1", "M=!M", "@$1", NULL}},
+  {"copy back to A",      {"D=A", "A=D", NULL},
+                          {"D=A", NULL}},
+  {"copy back to D",      {"A=D", "D=A", NULL},
+                          {"A=D", NULL}},
+  {"store back",          {"D=M", "M=D", NULL},
+                          {"D=M", NULL}},
+  {"load back",           {"M=D", "D=M", NULL},
+                          {"M=D", NULL}},
+  {"self copy",           {"D=D", NULL},
+                          {NULL}},
+  {"self copy",           {"A=A", NULL},
+                          {NULL}},
+  {"self copy",           {"M=M", NULL},
+                          {NULL}},
+  {"dead A load",         {"@$1", "@$2", NULL},
+                          {"@$2", NULL}},
+};
+
+#define NUM_PATTERNS (sizeof(g_patterns) / sizeof(g_patterns[0]))
+
+/*
+ * brief: a pattern compiled to commands.
+ *
+ * @member _from: the index in the match of the command whose line each replacement command takes.
+ * @member _rule: the index of the pattern's name in the rule names of the report.
+ */
+typedef struct Rule {
+  Command_t _match[PATTERN_MAX];
+  Command_t _replace[PATTERN_MAX];
+  uint8_t _from[PATTERN_MAX];
+  uint8_t _num_match;
+  uint8_t _num_replace;
+  uint8_t _rule;
+} Rule_t;
+
+/*
+ * brief: the control flow graph of the commands; blocks of commands that run from first to last, entered only at 
+ *  their first and left only after their last. A block starts at the first command, at a label, and after a jump.
+ *
+ * @member _p_starts: the first command of each block, then the end of the commands; _num_blocks + 1 of them.
+ * @member _p_block_of: the block starting at each instruction address, up to the address past the last instruction.
+ */
+typedef struct Cfg {
+  uint32_t* _p_starts;
+  uint32_t* _p_block_of;
+  uint32_t _num_blocks;
+} Cfg_t;
+
+#define NO_BLOCK 0xffffffff
+
+/*
+ * the contents of the A register in the dataflow of the A register; else the index of the command that loaded A,
+ *  which for a block entered by a jump may be the label of the block, since a jump goes to the address in A.
+ */
+#define A_UNDEF   0xffffffff // not yet known; the block has not been reached.
+#define A_UNKNOWN 0xfffffffe // varies by path, or computed.
+
+static Rule_t g_rules[NUM_PATTERNS];
+static const char* g_rule_names[OPT_MAX_RULES];
+static int g_num_rule_names = 0;
+static uint8_t g_rule_reload;  // the rule of the dataflow pass.
+static uint8_t g_rule_unreachable;  // the rule of the reachability pass.
+static uint8_t g_rule_inversion;  // the rules of the jump passes.
+static uint8_t g_rule_layout;
+
+/*=====================================================================================================================
+ * PRIVATE INTERFACE
+ *===================================================================================================================*/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static inline bool is_instruction(const Command_t* c){
+  return c->_type == CFORMAT_A0 || c->_type == CFORMAT_A1 || c->_type == CFORMAT_C0 || c->_type == CFORMAT_C1 || 
+         c->_type == CFORMAT_C2;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static inline bool is_a_command(const Command_t* c){
+  return c->_type == CFORMAT_A0 || c->_type == CFORMAT_A1;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static inline bool is_label(const Command_t* c){
+  return c->_type == CFORMAT_L0 || c->_type == CFORMAT_L1;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static inline bool is_jump(const Command_t* c){
+  return (c->_type == CFORMAT_C0 || c->_type == CFORMAT_C2) && c->_jump != 0;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: true if a command writes the A register; an A command, or a C command with A in its destination.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static inline bool is_a_write(const Command_t* c){
+  return is_a_command(c) || ((c->_type == CFORMAT_C0 || c->_type == CFORMAT_C1) && (c->_dest & 0x4) != 0);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: the variable of a pattern command, 1 to 9, if it is an '@$n' wildcard; else 0.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static inline int wildcard(const Command_t* q){
+  return (q->_type == CFORMAT_A0 && q->_sym[0] == '$' && q->_sym[1] >= '1' && q->_sym[1] <= '9' && q->_sym[2] == '\0') 
+         ? q->_sym[1] - '0' : 0;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: true if two commands are the same instruction; A commands of the same symbol or literal, C commands of the 
+ *  same fields.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static bool is_same(const Command_t* a, const Command_t* b){
+  if(a->_type != b->_type){
+    return false;
+  }
+  switch(a->_type){
+    case CFORMAT_A0:
+      return strcmp(a->_sym, b->_sym) == 0;
+    case CFORMAT_A1:
+      return a->_value == b->_value;
+    default:
+      return a->_dest == b->_dest && a->_comp == b->_comp && a->_jump == b->_jump;
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static inline bool is_goto(const Command_t* c){
+  return c->_type == CFORMAT_C2 && c->_jump == 0x7; // JMP, and no destination to write.
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: true if a C command reads the value of A, as a number or as the address of M; a jump reads it as the 
+ *  address to go to, but no command with a jump may read it otherwise.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static inline bool is_a_read(const Command_t* c){
+  return (c->_type == CFORMAT_C0 || c->_type == CFORMAT_C1 || c->_type == CFORMAT_C2) && 
+         ((c->_dest & 0x1) != 0 || strpbrk(lexer_comp_str(c->_comp), "AM") != NULL);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: true if no command reads the value A holds before command 'i' runs; A is written before it is read, by 
+ *  the commands from 'i' on, as falling through the labels between them.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static bool is_a_dead(const Command_t* p_cmds, uint32_t n, uint32_t i){
+  for(; i < n && p_cmds[i]._type == CFORMAT_L0; ++i);
+  for(; i < n; ++i){
+    const Command_t* c = &p_cmds[i];
+    if(is_a_command(c)){
+      return true;
+    }
+    if(c->_type == CFORMAT_L0 || c->_type == CFORMAT_L1 || c->_jump != 0 || is_a_read(c)){
+      return false;
+    }
+    if((c->_dest & 0x4) != 0){
+      return true;
+    }
+  }
+  return false;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: the cycles a profile spent at the line of a command; 0 without a profile.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static inline uint64_t line_cycles(const Assembler_t* p, const Command_t* c){
+  return (p->_p_line_cycles != NULL && c->_lineno < p->_num_line_cycles) ? p->_p_line_cycles[c->_lineno] : 0;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: true if two commands put the same value in A; A commands of the same symbol or literal, where a label 
+ *  is the value of its address.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static bool is_same_value(const Command_t* a, const Command_t* b){
+  bool is_sym_a = a->_type == CFORMAT_A0 || a->_type == CFORMAT_L0;
+  bool is_sym_b = b->_type == CFORMAT_A0 || b->_type == CFORMAT_L0;
+  if(is_sym_a || is_sym_b){
+    return is_sym_a && is_sym_b && strcmp(a->_sym, b->_sym) == 0;
+  }
+  return a->_type == CFORMAT_A1 && b->_type == CFORMAT_A1 && a->_value == b->_value;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: matches a rule against the window of commands ending at 'end'.
+ * @param <out> pp_vars: the commands the wildcards of the rule matched.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static bool match_rule(const Rule_t* r, const Command_t* p_cmds, uint32_t end, const Command_t** pp_vars){
+  if(end < r->_num_match){
+    return false;
+  }
+  const Command_t* w = p_cmds + end - r->_num_match;
+  memset(pp_vars, 0, 10 * sizeof(Command_t*));
+  for(int i = 0; i < r->_num_match; ++i){
+    int v = wildcard(&r->_match[i]);
+    if(v == 0 && !is_same(&w[i], &r->_match[i])){
+      return false;
+    }
+    if(v != 0){
+      if(!is_a_command(&w[i]) || (pp_vars[v] != NULL && !is_same(pp_vars[v], &w[i]))){
+        return false;
+      }
+      pp_vars[v] = &w[i];
+    }
+  }
+  return true;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: rewrites the window of commands ending at 'end' that matched a rule.
+ * return: the end of the window after the rewrite.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static uint32_t rewrite(const Rule_t* r, Command_t* p_cmds, uint32_t end, const Command_t** pp_vars){
+  Command_t window[PATTERN_MAX];
+  uint32_t start = end - r->_num_match;
+  memcpy(window, p_cmds + start, r->_num_match * sizeof(Command_t));
+  for(int i = 0; i < r->_num_replace; ++i){
+    int v = wildcard(&r->_replace[i]);
+    Command_t* c = &p_cmds[start + i];
+    *c = (v != 0) ? window[pp_vars[v] - (p_cmds + start)] : r->_replace[i];
+    c->_lineno = window[r->_from[i]]._lineno;
+  }
+  return start + r->_num_replace;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: the peephole pass; the commands are read in order and pushed onto the optimised commands, which are rewritten
+ *  while a rule matches at their end. The optimised commands are never longer than those read, so the pass is in 
+ *  place.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void peephole(Assembler_t* p, OptReport_t* p_report){
+  Command_t* p_cmds = p->_p_cmds;
+  const Command_t* vars[10];
+  uint32_t out = 0;
+  for(uint32_t i = 0; i < p->_line_count; ++i){
+    p_cmds[out++] = p_cmds[i];
+    bool is_rewritten = is_instruction(&p_cmds[out - 1]);
+    while(is_rewritten){
+      is_rewritten = false;
+      for(size_t r = 0; r < NUM_PATTERNS && !is_rewritten; ++r){
+        if(match_rule(&g_rules[r], p_cmds, out, vars)){
+          out = rewrite(&g_rules[r], p_cmds, out, vars);
+          p_report->_saved[g_rules[r]._rule] += g_rules[r]._num_match - g_rules[r]._num_replace;
+          is_rewritten = out > 0;
+        }
+      }
+    }
+  }
+  p->_line_count = out;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: builds the control flow graph of the commands.
+ * return: SUCCESS, or FAIL on malloc error.
+ *
+ * note: the labels must be at the addresses of the commands (see 'move_labels').
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int new_cfg(const Assembler_t* p, Cfg_t* p_cfg){
+  const Command_t* p_cmds = p->_p_cmds;
+  uint32_t n = p->_line_count;
+  p_cfg->_p_starts = (uint32_t*)malloc((n + 1) * sizeof(uint32_t));
+  p_cfg->_p_block_of = (uint32_t*)malloc((n + 1) * sizeof(uint32_t));
+  if(p_cfg->_p_starts == NULL || p_cfg->_p_block_of == NULL){
+    free(p_cfg->_p_starts);
+    free(p_cfg->_p_block_of);
+    return FAIL;
+  }
+  uint32_t b = 0, address = 0;
+  for(uint32_t i = 0; i < n; ++i){
+    if(i == 0 || is_jump(&p_cmds[i - 1]) || (is_label(&p_cmds[i]) && !is_label(&p_cmds[i - 1]))){
+      p_cfg->_p_starts[b] = i;
+      p_cfg->_p_block_of[address] = b++;
+    }
+    address += p_cmds[i]._type != CFORMAT_L0;
+  }
+  p_cfg->_p_starts[b] = n;
+  p_cfg->_num_blocks = b;
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void free_cfg(Cfg_t* p_cfg){
+  free(p_cfg->_p_starts);
+  free(p_cfg->_p_block_of);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: the block a jump goes to if the A register holds the value a command loaded.
+ * return: the block, or NO_BLOCK if the value is not a label.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static uint32_t jump_target(const Assembler_t* p, const Cfg_t* p_cfg, uint32_t value){
+  uint16_t address;
+  uint8_t tag;
+  if(value >= A_UNKNOWN || (p->_p_cmds[value]._type != CFORMAT_A0 && p->_p_cmds[value]._type != CFORMAT_L0) ||
+     symlib_lookup(p->_p_sym_lib, p->_p_cmds[value]._sym, &address, &tag) != SUCCESS || tag != SYMTAG_LABEL){
+    return NO_BLOCK;
+  }
+  return p_cfg->_p_block_of[address];
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: merges the contents of A on an edge into the contents on entry to a block of the dataflow.
+ * return: true if the contents on entry changed; the block must be run again.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static bool merge_a(const Command_t* p_cmds, uint32_t* p_in, uint32_t value){
+  if(*p_in == A_UNDEF){
+    *p_in = value;
+    return true;
+  }
+  if(*p_in != A_UNKNOWN && (value == A_UNKNOWN || !is_same_value(&p_cmds[*p_in], &p_cmds[value]))){
+    *p_in = A_UNKNOWN;
+    return true;
+  }
+  return false;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: the forward dataflow of the contents of the A register; finds what A holds on entry to each block on every 
+ *  path to it, from the first block, which is entered from reset.
+ *
+ *  An edge of a jump carries the label of the block it enters, since A holds the address jumped to. A jump whose A is
+ *  not a label, e.g. the return of a function through an address in RAM, is taken to go to any label, with A unknown.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void flow_a(const Assembler_t* p, const Cfg_t* p_cfg, uint32_t* p_in, uint32_t* p_work){
+  const Command_t* p_cmds = p->_p_cmds;
+  uint32_t num_work = 0;
+  bool is_any_label = false;
+  for(uint32_t b = 0; b < p_cfg->_num_blocks; ++b){
+    p_in[b] = A_UNDEF;
+  }
+  if(p_cfg->_num_blocks > 0){
+    p_in[0] = A_UNKNOWN;
+    p_work[num_work++] = 0;
+  }
+  while(num_work > 0){
+    uint32_t b = p_work[--num_work];
+    uint32_t a = p_in[b], end = p_cfg->_p_starts[b + 1];
+    bool is_fall = true;
+    for(uint32_t i = p_cfg->_p_starts[b]; i < end; ++i){
+      const Command_t* c = &p_cmds[i];
+      a = is_a_command(c) ? i : is_a_write(c) ? A_UNKNOWN : a;
+      if(!is_jump(c)){
+        continue;
+      }
+      uint32_t t = jump_target(p, p_cfg, a);
+      if(t != NO_BLOCK && merge_a(p_cmds, &p_in[t], a)){
+        p_work[num_work++] = t;
+      }
+      if(t == NO_BLOCK && !is_any_label){
+        is_any_label = true;
+        for(uint32_t l = 0; l < p_cfg->_num_blocks; ++l){
+          uint32_t first = p_cfg->_p_starts[l];
+          if(p_cmds[first]._type == CFORMAT_L0 && merge_a(p_cmds, &p_in[l], A_UNKNOWN)){
+            p_work[num_work++] = l;
+          }
+        }
+      }
+      is_fall = c->_jump != 0x7; // JMP
+    }
+    if(is_fall && b + 1 < p_cfg->_num_blocks && merge_a(p_cmds, &p_in[b + 1], a)){
+      p_work[num_work++] = b + 1;
+    }
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int compare_labels(const void* a, const void* b){
+  return strcmp((*(const Command_t* const*)a)->_sym, (*(const Command_t* const*)b)->_sym);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: finds the blocks some path from the first block runs; falling into a block or loading its label reaches it.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void reach_blocks(const Assembler_t* p, const Cfg_t* p_cfg, bool* p_is_reached, uint32_t* p_work){
+  const Command_t* p_cmds = p->_p_cmds;
+  uint32_t num_work = 0;
+  if(p_cfg->_num_blocks > 0){
+    p_is_reached[0] = true;
+    p_work[num_work++] = 0;
+  }
+  while(num_work > 0){
+    uint32_t b = p_work[--num_work];
+    uint32_t end = p_cfg->_p_starts[b + 1];
+    for(uint32_t i = p_cfg->_p_starts[b]; i < end; ++i){
+      uint32_t t = (p_cmds[i]._type == CFORMAT_A0) ? jump_target(p, p_cfg, i) : NO_BLOCK;
+      if(t != NO_BLOCK && !p_is_reached[t]){
+        p_is_reached[t] = true;
+        p_work[num_work++] = t;
+      }
+    }
+    const Command_t* p_last = &p_cmds[end - 1];
+    bool is_fall = !is_jump(p_last) || p_last->_jump != 0x7; // JMP
+    if(is_fall && b + 1 < p_cfg->_num_blocks && !p_is_reached[b + 1]){
+      p_is_reached[b + 1] = true;
+      p_work[num_work++] = b + 1;
+    }
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: marks the labels of the reached blocks that no command of a reached block references.
+ * return: SUCCESS, or FAIL on malloc error.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int mark_unused_labels(const Assembler_t* p, const Cfg_t* p_cfg, const bool* p_is_reached, bool* p_is_dead){
+  const Command_t* p_cmds = p->_p_cmds;
+  uint32_t num_labels = 0;
+  for(uint32_t i = 0; i < p->_line_count; ++i){
+    num_labels += p_cmds[i]._type == CFORMAT_L0;
+  }
+  const Command_t** pp_labels = (const Command_t**)malloc((num_labels + 1) * sizeof(Command_t*));
+  bool* p_is_used = (bool*)calloc(num_labels + 1, sizeof(bool));
+  if(pp_labels == NULL || p_is_used == NULL){
+    free(pp_labels);
+    free(p_is_used);
+    return FAIL;
+  }
+
+  // sort the labels by symbol to look up the references of the A commands...
+  num_labels = 0;
+  for(uint32_t b = 0; b < p_cfg->_num_blocks; ++b){
+    for(uint32_t i = p_cfg->_p_starts[b]; i < p_cfg->_p_starts[b + 1] && p_is_reached[b]; ++i){
+      if(p_cmds[i]._type == CFORMAT_L0){
+        pp_labels[num_labels++] = &p_cmds[i];
+      }
+    }
+  }
+  qsort(pp_labels, num_labels, sizeof(Command_t*), compare_labels);
+  for(uint32_t b = 0; b < p_cfg->_num_blocks; ++b){
+    for(uint32_t i = p_cfg->_p_starts[b]; i < p_cfg->_p_starts[b + 1] && p_is_reached[b]; ++i){
+      const Command_t* c = &p_cmds[i];
+      const Command_t** pp_found = (c->_type != CFORMAT_A0) ? NULL : 
+        (const Command_t**)bsearch(&c, pp_labels, num_labels, sizeof(Command_t*), compare_labels);
+      if(pp_found != NULL){
+        p_is_used[pp_found - pp_labels] = true;
+      }
+    }
+  }
+
+  // ...then mark the labels no reference found.
+  for(uint32_t l = 0; l < num_labels; ++l){
+    p_is_dead[pp_labels[l] - p_cmds] = !p_is_used[l];
+  }
+  free(pp_labels);
+  free(p_is_used);
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: removes the commands of the unreached blocks and the dead labels, recording each region of consecutive 
+ *  unreached blocks in the report; the labels removed are removed from the symbol library.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void drop_blocks(Assembler_t* p, const Cfg_t* p_cfg, const bool* p_is_reached, bool* p_is_dead, 
+                        OptReport_t* p_report){
+  Command_t* p_cmds = p->_p_cmds;
+  bool is_in_region = false;
+  for(uint32_t b = 0; b < p_cfg->_num_blocks; ++b){
+    if(p_is_reached[b]){
+      is_in_region = false;
+      continue;
+    }
+    if(!is_in_region && p_report->_num_regions < OPT_MAX_REGIONS){
+      memset(&p_report->_regions[p_report->_num_regions], 0, sizeof(OptRegion_t));
+      p_report->_regions[p_report->_num_regions]._lineno = p_cmds[p_cfg->_p_starts[b]]._lineno;
+    }
+    p_report->_num_regions += !is_in_region;
+    is_in_region = true;
+    OptRegion_t* p_region = (p_report->_num_regions <= OPT_MAX_REGIONS) ? 
+      &p_report->_regions[p_report->_num_regions - 1] : NULL;
+    for(uint32_t i = p_cfg->_p_starts[b]; i < p_cfg->_p_starts[b + 1]; ++i){
+      const Command_t* c = &p_cmds[i];
+      p_is_dead[i] = true;
+      p_report->_saved[g_rule_unreachable] += is_instruction(c);
+      if(p_region == NULL){
+        continue;
+      }
+      p_region->_num_ins += is_instruction(c);
+      if(c->_type == CFORMAT_L0 && p_region->_label[0] == '\0'){
+        strcpy(p_region->_label, c->_sym);
+      }
+    }
+  }
+
+  uint32_t out = 0;
+  for(uint32_t i = 0; i < p->_line_count; ++i){
+    if(!p_is_dead[i]){
+      p_cmds[out++] = p_cmds[i];
+    }
+    else if(p_cmds[i]._type == CFORMAT_L0){
+      symlib_remove_symbol(p->_p_sym_lib, p_cmds[i]._sym);
+      ++p_report->_num_labels;
+    }
+  }
+  p->_line_count = out;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: the reachability pass; removes the blocks no path from the first command runs, then the labels left that 
+ *  no command references.
+ * return: SUCCESS, or FAIL on malloc error.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int remove_unreachable(Assembler_t* p, OptReport_t* p_report){
+  Cfg_t cfg;
+  if(new_cfg(p, &cfg) != SUCCESS){
+    return FAIL;
+  }
+  bool* p_is_reached = (bool*)calloc(cfg._num_blocks + 1, sizeof(bool));
+  bool* p_is_dead = (bool*)calloc(p->_line_count + 1, sizeof(bool));
+  uint32_t* p_work = (uint32_t*)malloc((cfg._num_blocks + 1) * sizeof(uint32_t));
+  int result = (p_is_reached == NULL || p_is_dead == NULL || p_work == NULL) ? FAIL : SUCCESS;
+  if(result == SUCCESS){
+    reach_blocks(p, &cfg, p_is_reached, p_work);
+    result = mark_unused_labels(p, &cfg, p_is_reached, p_is_dead);
+  }
+  if(result == SUCCESS){
+    drop_blocks(p, &cfg, p_is_reached, p_is_dead, p_report);
+  }
+  free(p_is_reached);
+  free(p_is_dead);
+  free(p_work);
+  free_cfg(&cfg);
+  return result;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: the dataflow pass; removes the A commands that load the value A holds on every path to them.
+ * return: SUCCESS, or FAIL on malloc error.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int remove_reloads(Assembler_t* p, OptReport_t* p_report){
+  Cfg_t cfg;
+  if(new_cfg(p, &cfg) != SUCCESS){
+    return FAIL;
+  }
+
+  // a block is put on the worklist each time its entry changes, at most twice; from A_UNDEF, then to A_UNKNOWN...
+  uint32_t* p_in = (uint32_t*)malloc((cfg._num_blocks + 1) * sizeof(uint32_t));
+  uint32_t* p_work = (uint32_t*)malloc((2 * cfg._num_blocks + 1) * sizeof(uint32_t));
+  bool* p_is_dead = (bool*)calloc(p->_line_count + 1, sizeof(bool));
+  if(p_in == NULL || p_work == NULL || p_is_dead == NULL){
+    free(p_in);
+    free(p_work);
+    free(p_is_dead);
+    free_cfg(&cfg);
+    return FAIL;
+  }
+  flow_a(p, &cfg, p_in, p_work);
+
+  // ...then the blocks are run once more to find the reloads; a reload leaves A as it was.
+  Command_t* p_cmds = p->_p_cmds;
+  for(uint32_t b = 0; b < cfg._num_blocks; ++b){
+    uint32_t a = p_in[b];
+    for(uint32_t i = cfg._p_starts[b]; i < cfg._p_starts[b + 1] && a != A_UNDEF; ++i){
+      const Command_t* c = &p_cmds[i];
+      if(is_a_command(c) && a != A_UNKNOWN && is_same_value(&p_cmds[a], c)){
+        p_is_dead[i] = true;
+        ++p_report->_saved[g_rule_reload];
+        continue;
+      }
+      a = is_a_command(c) ? i : is_a_write(c) ? A_UNKNOWN : a;
+    }
+  }
+  uint32_t out = 0;
+  for(uint32_t i = 0; i < p->_line_count; ++i){
+    if(!p_is_dead[i]){
+      p_cmds[out++] = p_cmds[i];
+    }
+  }
+  p->_line_count = out;
+  free(p_in);
+  free(p_work);
+  free(p_is_dead);
+  free_cfg(&cfg);
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: the A command a jump through the label an A command loads ends at, following the jumps of blocks that
+ *  only jump on, e.g. '(L) @M 0;JMP'; the A command itself if its label starts no such block.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static uint32_t thread_target(const Assembler_t* p, const Cfg_t* p_cfg, uint32_t value){
+  const Command_t* p_cmds = p->_p_cmds;
+  for(uint32_t steps = 0; steps < p_cfg->_num_blocks; ++steps){ // a cycle of such blocks loops forever.
+    uint32_t t = jump_target(p, p_cfg, value);
+    if(t == NO_BLOCK){
+      break;
+    }
+    uint32_t i = p_cfg->_p_starts[t], end = p_cfg->_p_starts[t + 1];
+    for(; i < end && p_cmds[i]._type == CFORMAT_L0; ++i);
+    if(i + 2 != end || p_cmds[i]._type != CFORMAT_A0 || !is_goto(&p_cmds[i + 1]) || 
+       jump_target(p, p_cfg, i) == NO_BLOCK){
+      break;
+    }
+    value = i;
+  }
+  return value;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: the jump pass; threads each jump to a block that only jumps on to where that block goes, then inverts the
+ *  conditional jumps over a jump to the label after it, e.g. '@T D;JLT @U 0;JMP (T)' to '@U D;JGE (T)'.
+ * return: SUCCESS, or FAIL on malloc error.
+ *
+ * note: a jump is only changed if what A holds after it is written before it is read; A holds where it went.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int thread_jumps(Assembler_t* p, OptReport_t* p_report){
+  Cfg_t cfg;
+  if(new_cfg(p, &cfg) != SUCCESS){
+    return FAIL;
+  }
+  bool* p_is_dead = (bool*)calloc(p->_line_count + 1, sizeof(bool));
+  if(p_is_dead == NULL){
+    free_cfg(&cfg);
+    return FAIL;
+  }
+
+  // thread; the labels keep their addresses as no command is removed...
+  Command_t* p_cmds = p->_p_cmds;
+  uint32_t n = p->_line_count;
+  for(uint32_t i = 1; i < n; ++i){
+    const Command_t* c = &p_cmds[i];
+    if(!is_jump(c) || p_cmds[i - 1]._type != CFORMAT_A0 || (c->_jump != 0x7 && !is_a_dead(p_cmds, n, i + 1))){
+      continue;
+    }
+    uint32_t v = thread_target(p, &cfg, i - 1);
+    if(strcmp(p_cmds[v]._sym, p_cmds[i - 1]._sym) != 0){
+      strcpy(p_cmds[i - 1]._sym, p_cmds[v]._sym);
+      ++p_report->_num_threaded;
+    }
+  }
+
+  // ...then invert; the jump takes the other way, JGT (1) to JLE (6), JEQ (2) to JNE (5), JGE (3) to JLT (4).
+  for(uint32_t i = 1; i + 3 < n; ++i){
+    Command_t* c = &p_cmds[i];
+    if(!is_jump(c) || c->_jump == 0x7 || p_cmds[i - 1]._type != CFORMAT_A0 || !is_a_command(&p_cmds[i + 1]) ||
+       !is_goto(&p_cmds[i + 2]) || !is_a_dead(p_cmds, n, i + 3)){
+      continue;
+    }
+    uint32_t l = i + 3;
+    for(; l < n && p_cmds[l]._type == CFORMAT_L0 && strcmp(p_cmds[l]._sym, p_cmds[i - 1]._sym) != 0; ++l);
+    if(l == n || p_cmds[l]._type != CFORMAT_L0){
+      continue;
+    }
+    p_cmds[i - 1] = p_cmds[i + 1];
+    c->_jump = 0x7 - c->_jump;
+    p_is_dead[i + 1] = p_is_dead[i + 2] = true;
+    p_report->_saved[g_rule_inversion] += 2;
+    p_report->_saved_cycles += 2 * line_cycles(p, &p_cmds[i + 2]);
+    i += 3;
+  }
+  uint32_t out = 0;
+  for(uint32_t i = 0; i < n; ++i){
+    if(!p_is_dead[i]){
+      p_cmds[out++] = p_cmds[i];
+    }
+  }
+  p->_line_count = out;
+  free(p_is_dead);
+  free_cfg(&cfg);
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: removes the jumps to the instruction after them, e.g. '@L 0;JMP (L)', or '@L D;JEQ (L)'; either way the
+ *  next instruction runs.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void drop_jumps_to_next(Assembler_t* p, OptReport_t* p_report){
+  Command_t* p_cmds = p->_p_cmds;
+  uint32_t n = p->_line_count, out = 0;
+  for(uint32_t i = 0; i < n; ++i){
+    if(i + 2 < n && p_cmds[i]._type == CFORMAT_A0 && p_cmds[i + 1]._type == CFORMAT_C2 && p_cmds[i + 1]._jump != 0 &&
+       is_a_dead(p_cmds, n, i + 2)){
+      uint32_t l = i + 2;
+      for(; l < n && p_cmds[l]._type == CFORMAT_L0 && strcmp(p_cmds[l]._sym, p_cmds[i]._sym) != 0; ++l);
+      if(l < n && p_cmds[l]._type == CFORMAT_L0){
+        p_report->_saved[g_rule_layout] += 2;
+        p_report->_saved_cycles += line_cycles(p, &p_cmds[i]) + line_cycles(p, &p_cmds[i + 1]);
+        ++i;
+        continue;
+      }
+    }
+    p_cmds[out++] = p_cmds[i];
+  }
+  p->_line_count = out;
+}
+
+/*
+ * brief: a jump ending one chain of blocks that may be removed by laying out the chain it goes to after it.
+ */
+typedef struct Link {
+  uint32_t _from;    // chain whose last block ends with the jump.
+  uint32_t _to;      // chain starting at the block the jump goes to.
+  uint32_t _jump;    // the command of the jump; its A command is before it.
+  uint64_t _cycles;  // cycles of the profile at the jump.
+} Link_t;
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int compare_links(const void* a, const void* b){
+  const Link_t* la = (const Link_t*)a;
+  const Link_t* lb = (const Link_t*)b;
+  if(la->_cycles != lb->_cycles){
+    return (la->_cycles > lb->_cycles) ? -1 : 1; // hottest first...
+  }
+  return (la->_jump > lb->_jump) - (la->_jump < lb->_jump); // ...then in program order.
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: finds the links between the chains of blocks; a chain is the blocks from one after a 'JMP' to the next
+ *  ending in a 'JMP', which must stay together as each falls into the next.
+ * return: the number of links.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static uint32_t find_links(const Assembler_t* p, const Cfg_t* p_cfg, const uint32_t* p_chain_of, 
+                           uint32_t num_chains, bool is_last_fixed, Link_t* p_links){
+  const Command_t* p_cmds = p->_p_cmds;
+  uint32_t num_links = 0;
+  for(uint32_t b = 0; b < p_cfg->_num_blocks; ++b){
+    uint32_t e = p_cfg->_p_starts[b + 1] - 1;
+    if(!is_goto(&p_cmds[e]) || e == p_cfg->_p_starts[b] || p_cmds[e - 1]._type != CFORMAT_A0){
+      continue;
+    }
+    uint32_t t = jump_target(p, p_cfg, e - 1);
+    if(t == NO_BLOCK || t == 0 || p_chain_of[t - 1] == p_chain_of[t] || p_chain_of[t] == p_chain_of[b] || 
+       (is_last_fixed && p_chain_of[t] == num_chains - 1) || !is_a_dead(p_cmds, p->_line_count, p_cfg->_p_starts[t])){
+      continue;
+    }
+    Link_t link = {p_chain_of[b], p_chain_of[t], e, line_cycles(p, &p_cmds[e])};
+    p_links[num_links++] = link;
+  }
+  return num_links;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: the layout pass; lays out the chains of blocks so a jump ending a chain goes to the chain after it, and 
+ *  removes the jump. The hottest jumps of the profile, if any, are removed first, then those earliest.
+ * return: SUCCESS, or FAIL on malloc error.
+ *
+ * note: the first chain stays first, as does the last last if it runs off the end of the program; a jump to it, and
+ *  any other jump left going to the label after it, is then removed by 'drop_jumps_to_next'.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int layout_blocks(Assembler_t* p, OptReport_t* p_report){
+  Cfg_t cfg;
+  if(new_cfg(p, &cfg) != SUCCESS){
+    return FAIL;
+  }
+  uint32_t nb = cfg._num_blocks, n = p->_line_count;
+  uint32_t* p_ints = (uint32_t*)malloc(4 * (nb + 1) * sizeof(uint32_t));
+  Link_t* p_links = (Link_t*)malloc((nb + 1) * sizeof(Link_t));
+  bool* p_is_dead = (bool*)calloc(n + 1, sizeof(bool));
+  Command_t* p_out = (Command_t*)malloc((n + 1) * sizeof(Command_t));
+  if(p_ints == NULL || p_links == NULL || p_is_dead == NULL || p_out == NULL){
+    free(p_ints);
+    free(p_links);
+    free(p_is_dead);
+    free(p_out);
+    free_cfg(&cfg);
+    return FAIL;
+  }
+  uint32_t* p_chain_of = p_ints;           // chain of each block.
+  uint32_t* p_heads = p_ints + (nb + 1);   // first block of each chain, then nb.
+  uint32_t* p_next = p_ints + 2 * (nb + 1); // chain laid out after each chain, else NO_BLOCK.
+  uint32_t* p_prev = p_ints + 3 * (nb + 1);
+
+  // find the chains...
+  const Command_t* p_cmds = p->_p_cmds;
+  uint32_t num_chains = 0;
+  for(uint32_t b = 0; b < nb; ++b){
+    if(b == 0 || is_goto(&p_cmds[cfg._p_starts[b] - 1])){
+      p_heads[num_chains] = b;
+      p_next[num_chains] = p_prev[num_chains] = NO_BLOCK;
+      ++num_chains;
+    }
+    p_chain_of[b] = num_chains - 1;
+  }
+  p_heads[num_chains] = nb;
+  bool is_last_fixed = nb > 0 && !is_goto(&p_cmds[n - 1]);
+
+  // ...link them, hottest first, unless the link would close a cycle of chains...
+  uint32_t num_links = find_links(p, &cfg, p_chain_of, num_chains, is_last_fixed, p_links);
+  qsort(p_links, num_links, sizeof(Link_t), compare_links);
+  for(uint32_t l = 0; l < num_links; ++l){
+    const Link_t* k = &p_links[l];
+    uint32_t first = k->_from;
+    for(; p_prev[first] != NO_BLOCK; first = p_prev[first]);
+    if(p_next[k->_from] != NO_BLOCK || p_prev[k->_to] != NO_BLOCK || first == k->_to){
+      continue;
+    }
+    p_next[k->_from] = k->_to;
+    p_prev[k->_to] = k->_from;
+    p_is_dead[k->_jump - 1] = p_is_dead[k->_jump] = true;
+    p_report->_saved[g_rule_layout] += 2;
+    p_report->_saved_cycles += 2 * k->_cycles;
+  }
+
+  // ...then lay out the runs of linked chains by their first chains; the first chain is first, a fixed last chain, 
+  // which no chain links to, last.
+  uint32_t out = 0;
+  for(uint32_t r = 0; r <= num_chains && num_chains > 0; ++r){
+    uint32_t x = (r < num_chains) ? r : num_chains - 1;
+    bool is_last = is_last_fixed && x == num_chains - 1 && x != 0;
+    if(p_prev[x] != NO_BLOCK || is_last != (r == num_chains)){
+      continue;
+    }
+    for(; x != NO_BLOCK; x = p_next[x]){
+      for(uint32_t i = cfg._p_starts[p_heads[x]]; i < cfg._p_starts[p_heads[x + 1]]; ++i){
+        if(!p_is_dead[i]){
+          p_out[out++] = p_cmds[i];
+        }
+      }
+    }
+  }
+  memcpy(p->_p_cmds, p_out, out * sizeof(Command_t));
+  p->_line_count = out;
+  drop_jumps_to_next(p, p_report);
+  free(p_ints);
+  free(p_links);
+  free(p_is_dead);
+  free(p_out);
+  free_cfg(&cfg);
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: names the literal ROM addresses the jumps go to; each '@N' a jump goes to becomes '@ROM@N', a label put
+ *  before the instruction at N, so the jump keeps its instruction as the passes move it. The number N itself must
+ *  not be read, before the jump or after it, on either path.
+ * return: SUCCESS, or FAIL if an address is also read as a number, or past the end of the program, or on malloc 
+ *  error.
+ *
+ * note: the name of the labels cannot clash with a symbol of the program, which cannot hold '@'.
+ * note: an address a jump takes from RAM is not known; it must have been loaded from a label.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int label_literal_jumps(Assembler_t* p){
+  Command_t* p_cmds = p->_p_cmds;
+  uint32_t n = p->_line_count, num_ins = 0, num_new = 0;
+  for(uint32_t i = 0; i < n; ++i){
+    num_ins += p_cmds[i]._type != CFORMAT_L0; // as the addresses of 'parse_symbols'.
+  }
+  bool* p_is_target = (bool*)calloc(num_ins + 1, sizeof(bool));
+  if(p_is_target == NULL){
+    fprintf(diag_stream(), "fatal error: out of memory\n");
+    return p->_fail = FAIL;
+  }
+
+  // follow A down each block, and on past labels and conditional jumps where it falls through...
+  uint32_t a = NO_BLOCK;
+  uint16_t address = 0;
+  bool is_read = false, is_jumped = false;
+  for(uint32_t i = 0; i < n; ++i){
+    Command_t* c = &p_cmds[i];
+    if(is_a_command(c)){
+      a = (c->_type == CFORMAT_A1) ? i : NO_BLOCK;
+      address = c->_value;
+      is_read = is_jumped = false;
+      continue;
+    }
+    if(a == NO_BLOCK || is_label(c)){
+      a = is_a_write(c) ? NO_BLOCK : a;
+      continue;
+    }
+    is_read = is_read || is_a_read(c);
+    is_jumped = is_jumped || is_jump(c);
+    if(is_read && is_jumped){
+      fprintf(diag_stream(), "fatal error: line %" PRIu32 ": -O1 cannot move ROM address %" PRIu16 ", which is both "
+              "jumped to and read as a number\n", p_cmds[a]._lineno, address);
+      free(p_is_target);
+      return p->_fail = FAIL;
+    }
+    if(is_jump(c) && p_cmds[a]._type == CFORMAT_A1){
+      if(address > num_ins){
+        fprintf(diag_stream(), "fatal error: line %" PRIu32 ": -O1 cannot move the jump to ROM address %" PRIu16 
+                ", past the end of the program\n", p_cmds[a]._lineno, address);
+        free(p_is_target);
+        return p->_fail = FAIL;
+      }
+      p_cmds[a]._type = CFORMAT_A0;
+      snprintf(p_cmds[a]._sym, MAX_SYM_LENGTH, "ROM@%" PRIu16, address);
+      num_new += !p_is_target[address];
+      p_is_target[address] = true;
+    }
+    a = (is_a_write(c) || (is_jump(c) && c->_jump == 0x7)) ? NO_BLOCK : a;
+  }
+
+  // ...then put the labels before their instructions, from the end, each command moving up past the labels before it.
+  int result = (num_new == 0) ? SUCCESS : assembler_reserve(p, n + num_new);
+  p_cmds = p->_p_cmds;
+  uint32_t w = n + num_new, at = num_ins;
+  for(uint32_t i = n + 1; i-- > 0 && num_new > 0 && result == SUCCESS; ){
+    if(i < n){
+      p_cmds[--w] = p_cmds[i];
+      if(p_cmds[w]._type == CFORMAT_L0){
+        continue;
+      }
+      --at;
+    }
+    if(!p_is_target[at]){
+      continue;
+    }
+    Command_t* l = &p_cmds[--w];
+    memset(l, 0, sizeof(Command_t));
+    l->_type = CFORMAT_L0;
+    l->_lineno = (i < n) ? p_cmds[w + 1]._lineno : p_cmds[n - 1]._lineno;
+    snprintf(l->_sym, MAX_SYM_LENGTH, "ROM@%" PRIu32, at);
+    if(!is_a_dead(p_cmds, n + num_new, w + 1)){
+      fprintf(diag_stream(), "fatal error: line %" PRIu32 ": -O1 cannot move ROM address %" PRIu32 ", which is both "
+              "jumped to and read as a number\n", l->_lineno, at);
+      free(p_is_target);
+      return p->_fail = FAIL;
+    }
+    if(symlib_add_symbol(p->_p_sym_lib, l->_sym, (uint16_t)at, SYMTAG_LABEL) != SUCCESS){
+      result = FAIL;
+    }
+  }
+  p->_line_count = n + num_new;
+  free(p_is_target);
+  if(result != SUCCESS){
+    fprintf(diag_stream(), "fatal error: out of memory\n");
+    return p->_fail = FAIL;
+  }
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: moves the labels to the addresses of the optimised commands; counted as the symbol phase counts them.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int move_labels(Assembler_t* p){
+  uint32_t address = 0;
+  for(uint32_t i = 0; i < p->_line_count; ++i){
+    const Command_t* c = &p->_p_cmds[i];
+    if(c->_type != CFORMAT_L0){
+      ++address; // the symbol phase counts '(<literal>)' L commands as instructions.
+      continue;
+    }
+    if(symlib_set_address(p->_p_sym_lib, c->_sym, (uint16_t)address) != SUCCESS){
+      fprintf(diag_stream(), "fatal error: label %s was lost by the optimiser\n", c->_sym);
+      return p->_fail = FAIL;
+    }
+  }
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: compiles a command of the pattern table.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void compile_command(const char* text, Command_t* p_out){
+  uint32_t column;
+  int result = lex_line(text, strlen(text), p_out, &column);
+  assert(result == SUCCESS && is_instruction(p_out));
+  (void)result;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: the index of a rule name in the report, added if new.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static uint8_t add_rule_name(const char* name){
+  for(int n = 0; n < g_num_rule_names; ++n){
+    if(strcmp(g_rule_names[n], name) == 0){
+      return (uint8_t)n;
+    }
+  }
+  assert(g_num_rule_names < OPT_MAX_RULES);
+  g_rule_names[g_num_rule_names] = name;
+  return (uint8_t)g_num_rule_names++;
+}
+
+/*=====================================================================================================================
+ * PUBLIC INTERFACE
+ *===================================================================================================================*/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void init_optimizer(){
+  static bool is_init = false;
+  if(is_init){
+    return;
+  }
+  init_lexer();
+  for(size_t p = 0; p < NUM_PATTERNS; ++p){
+    const Pattern_t* p_pat = &g_patterns[p];
+    Rule_t* r = &g_rules[p];
+    r->_rule = add_rule_name(p_pat->_name);
+    for(r->_num_match = 0; p_pat->_match[r->_num_match] != NULL; ++r->_num_match){
+      compile_command(p_pat->_match[r->_num_match], &r->_match[r->_num_match]);
+    }
+    for(r->_num_replace = 0; p_pat->_replace[r->_num_replace] != NULL; ++r->_num_replace){
+      Command_t* c = &r->_replace[r->_num_replace];
+      compile_command(p_pat->_replace[r->_num_replace], c);
+
+      // a replacement command takes the line of the same command of the match, else of the match at its place...
+      uint8_t from = (r->_num_replace < r->_num_match) ? r->_num_replace : r->_num_match - 1;
+      for(int m = 0; m < r->_num_match; ++m){
+        if(is_same(c, &r->_match[m])){
+          from = (uint8_t)m;
+          break;
+        }
+      }
+      r->_from[r->_num_replace] = from;
+    }
+    assert(r->_num_replace < r->_num_match);
+  }
+  g_rule_inversion = add_rule_name("branch over jump");
+  g_rule_layout = add_rule_name("fall-through layout");
+  g_rule_unreachable = add_rule_name("unreachable code");
+  g_rule_reload = add_rule_name("redundant A load");
+  is_init = true;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int optimize(Assembler_t* p, OptReport_t* p_report){
+  memset(p_report, 0, sizeof(OptReport_t));
+  for(uint32_t i = 0; i < p->_line_count; ++i){
+    p_report->_num_ins += is_instruction(&p->_p_cmds[i]);
+  }
+  if(label_literal_jumps(p) != SUCCESS){
+    return FAIL;
+  }
+  peephole(p, p_report);
+  if(move_labels(p) != SUCCESS){
+    return FAIL;
+  }
+
+  // the passes over the blocks; each finds the blocks from the addresses of the labels, so they move after each.
+  static int (*const passes[])(Assembler_t*, OptReport_t*) = {
+    thread_jumps, layout_blocks, remove_unreachable, remove_reloads
+  };
+  for(size_t k = 0; k < sizeof(passes) / sizeof(passes[0]); ++k){
+    if(passes[k](p, p_report) != SUCCESS){
+      fprintf(diag_stream(), "fatal error: out of memory\n");
+      return p->_fail = FAIL;
+    }
+    if(move_labels(p) != SUCCESS){
+      return FAIL;
+    }
+  }
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+const char* optimize_rule_name(int rule){
+  return (rule >= 0 && rule < g_num_rule_names) ? g_rule_names[rule] : NULL;
+}
@@ -0,0 +1,128 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: optimize.h
+ *
+ *===================================================================================================================*/
+
+
+#ifndef _OPTIMIZE_H_
+#define _OPTIMIZE_H_
+
+#include <stdint.h>
+#include "assembler.h"
+
+#define OPT_MAX_RULES 32 // rules of all passes; each counts the instructions it saved.
+#define OPT_MAX_REGIONS 16 // unreachable regions a report lists; the rest are only counted.
+
+/*
+ * brief: a region of consecutive commands removed as unreachable.
+ *
+ * @member _label: the first label of the region, or empty if it has none, e.g. the commands after a jump.
+ * @member _lineno: the line of the first command of the region.
+ * @member _num_ins: the instructions of the region; the ROM it reclaimed.
+ */
+typedef struct OptRegion {
+  char _label[MAX_SYM_LENGTH];
+  uint32_t _lineno;
+  uint32_t _num_ins;
+} OptRegion_t;
+
+/*
+ * brief: what the optimiser saved in an assembly.
+ *
+ * @member _saved: the instructions each rule removed, indexed as the names of 'optimize_rule_name'.
+ * @member _num_ins: the instructions of the program before the passes.
+ * @member _regions: the first OPT_MAX_REGIONS unreachable regions removed, in program order.
+ * @member _num_regions: all unreachable regions removed; may exceed OPT_MAX_REGIONS.
+ * @member _num_labels: the labels removed, of unreachable regions or never referenced.
+ * @member _num_threaded: the jumps threaded past blocks that only jump on; each saves 2 cycles when taken.
+ * @member _saved_cycles: the cycles the profiled run would have saved by the jumps removed; 0 without a profile.
+ */
+typedef struct OptReport {
+  uint32_t _saved[OPT_MAX_RULES];
+  uint32_t _num_ins;
+  OptRegion_t _regions[OPT_MAX_REGIONS];
+  uint32_t _num_regions;
+  uint32_t _num_labels;
+  uint32_t _num_threaded;
+  uint64_t _saved_cycles;
+} OptReport_t;
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: compiles the pattern table of the peephole pass; must be called before 'optimize'.
+ * note: safe to call more than once; the table is only compiled on the first call.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+void init_optimizer();
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: optimises the parsed commands of an assembler in place, then moves its labels to their new addresses.
+ *
+ *  The peephole pass slides a window over the A and C commands and rewrites each match of its pattern table, e.g. 
+ *  the pop and push back of '@SP AM=M-1 D=M @SP AM=M+1' to '@SP A=M-1 D=M A=A+1'; a rewrite may complete a match
+ *  ending before it, so matches are tried again after each. A window never spans a label, thus a rewrite cannot 
+ *  change what a jump to the label runs.
+ *
+ *  The jump passes then thread each jump to a block that only jumps on, e.g. '(L) @M 0;JMP', to where it goes, 
+ *  invert each conditional jump over a jump to the label after it, and lay out the blocks so that a jump ending one 
+ *  goes to the next and can be removed; the hottest jumps of a profile first if the assembler has one.
+ *
+ *  The reachability pass then removes the blocks of commands no path from the first command runs, and the labels no
+ *  command references; a block is reached by falling into it, or by any load of its label, as a jump through a 
+ *  computed address can only go to an address some command loaded.
+ *
+ *  The dataflow pass then finds what the A register holds on entry to each block of commands on every path to it, 
+ *  and removes each A command loading the value A already holds, e.g. the '@SP' after 'M=D @SP'. A jump to a label 
+ *  enters it with A holding the label; a jump through a computed address, e.g. a function return, may enter any label.
+ *
+ * @param p: an assembler between parsing its commands and substituting their symbols.
+ * @param <out> p_report: the instructions saved by each rule.
+ * return: SUCCESS, or FAIL if a label could not be moved.
+ *
+ * note: the commands keep their lines, so the source map is of the optimised program.
+ * note: a jump to a literal ROM address first gets a label 'ROM@N' at the address, so it moves with its instruction;
+ *  FAIL if the address is also read as a number. A jump to an address read from RAM must go to a label.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int optimize(Assembler_t* p, OptReport_t* p_report);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: the name of a rule of the report; NULL past the last rule.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+const char* optimize_rule_name(int rule);
+
+#endif
@@ -0,0 +1,137 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: outbuf.c
+ *
+ *===================================================================================================================*/
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "outbuf.h"
+#include "asmerr.h"
+
+#define MIN_CAPACITY 64
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+int init_outbuf(struct OutBuf* p_buf, size_t capacity){
+  if(capacity < MIN_CAPACITY){
+    capacity = MIN_CAPACITY;
+  }
+  p_buf->_p_data = (char*)malloc(capacity);
+  if(p_buf->_p_data == NULL){
+    p_buf->_size = p_buf->_capacity = 0;
+    return FAIL;
+  }
+  p_buf->_size = 0;
+  p_buf->_capacity = capacity;
+  return SUCCESS;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+void free_outbuf(struct OutBuf* p_buf){
+  free(p_buf->_p_data);
+  p_buf->_p_data = NULL;
+  p_buf->_size = p_buf->_capacity = 0;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+int outbuf_reserve(struct OutBuf* p_buf, size_t n){
+  if(p_buf->_capacity - p_buf->_size >= n){
+    return SUCCESS;
+  }
+  size_t capacity = (p_buf->_capacity < MIN_CAPACITY) ? MIN_CAPACITY : p_buf->_capacity;
+  while(capacity - p_buf->_size < n){
+    capacity *= 2;
+  }
+  char* data = (char*)realloc(p_buf->_p_data, capacity);
+  if(data == NULL){
+    return FAIL;
+  }
+  p_buf->_p_data = data;
+  p_buf->_capacity = capacity;
+  return SUCCESS;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+int outbuf_write(struct OutBuf* p_buf, const void* src, size_t n){
+  if(outbuf_reserve(p_buf, n) != SUCCESS){
+    return FAIL;
+  }
+  memcpy(p_buf->_p_data + p_buf->_size, src, n);
+  p_buf->_size += n;
+  return SUCCESS;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+int outbuf_puts(struct OutBuf* p_buf, const char* str){
+  return outbuf_write(p_buf, str, strlen(str));
+}
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+int outbuf_putc(struct OutBuf* p_buf, char c){
+  if(outbuf_reserve(p_buf, 1) != SUCCESS){
+    return FAIL;
+  }
+  p_buf->_p_data[p_buf->_size] = c;
+  ++p_buf->_size;
+  return SUCCESS;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+int outbuf_put_u32(struct OutBuf* p_buf, uint32_t value){
+  char digits[10]; // max 10 digits in a 32-bit value.
+  int n = 0;
+  do{
+    digits[sizeof(digits) - 1 - n] = (char)('0' + (value % 10));
+    value /= 10;
+    ++n;
+  } while(value != 0);
+  return outbuf_write(p_buf, digits + sizeof(digits) - n, (size_t)n);
+}
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+void outbuf_clear(struct OutBuf* p_buf){
+  p_buf->_size = 0;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+int outbuf_flush(struct OutBuf* p_buf, FILE* stream){
+  if(p_buf->_size > 0 && fwrite(p_buf->_p_data, 1, p_buf->_size, stream) != p_buf->_size){
+    return FAIL;
+  }
+  return SUCCESS;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,107 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: outbuf.h
+ *
+ *===================================================================================================================*/
+
+
+#ifndef _OUTBUF_H_
+#define _OUTBUF_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* 
+ * brief: simple growable byte buffer used to compose output before writing it in one go.
+ *
+ * note: the buffer doubles in capacity when full, thus appends are amortised O(1) and output composition scales
+ *  like memcpy.
+ */
+struct OutBuf {
+  char* _p_data;      /* base address of the buffer, returned from malloc. */
+  size_t _size;       /* number of bytes written to the buffer. */
+  size_t _capacity;   /* number of bytes allocated. */
+};
+
+/*
+ * brief: initialises an instance of an output buffer.
+ * return: SUCCESS, or FAIL if failed to allocate the buffer.
+ * note: calls malloc.
+ */
+int init_outbuf(struct OutBuf* p_buf, size_t capacity);
+
+/*
+ * brief: frees the memory used by the buffer, does NOT free the OutBuf instance itself.
+ */
+void free_outbuf(struct OutBuf* p_buf);
+
+/*
+ * brief: grows the buffer, if required, so that 'n' more bytes can be written without reallocation.
+ * return: SUCCESS, or FAIL if failed to grow the buffer.
+ */
+int outbuf_reserve(struct OutBuf* p_buf, size_t n);
+
+/*
+ * brief: appends 'n' bytes from 'src' to the buffer.
+ * return: SUCCESS, or FAIL if failed to grow the buffer.
+ */
+int outbuf_write(struct OutBuf* p_buf, const void* src, size_t n);
+
+/*
+ * brief: appends a null terminated string (excluding the terminator) to the buffer.
+ */
+int outbuf_puts(struct OutBuf* p_buf, const char* str);
+
+/*
+ * brief: appends a single character to the buffer.
+ */
+int outbuf_putc(struct OutBuf* p_buf, char c);
+
+/*
+ * brief: appends the decimal representation of 'value' to the buffer.
+ */
+int outbuf_put_u32(struct OutBuf* p_buf, uint32_t value);
+
+/*
+ * brief: discards the contents of the buffer, keeping its memory.
+ */
+void outbuf_clear(struct OutBuf* p_buf);
+
+/*
+ * brief: writes the contents of the buffer to a stream.
+ * return: SUCCESS, or FAIL if the write failed.
+ */
+int outbuf_flush(struct OutBuf* p_buf, FILE* stream);
+
+#endif
@@ -0,0 +1,182 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: outfile.c
+ *
+ *===================================================================================================================*/
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "outbuf.h"
+#include "outfile.h"
+#include "hash.h"
+#include "asmerr.h"
+
+#define TMP_SUFFIX ".XXXXXX"
+
+static pthread_once_t g_umask_once = PTHREAD_ONCE_INIT;
+static mode_t g_umask;      /* file mode creation mask of the process; can only be read by setting it. */
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/*
+ * note: run once since reading the mask sets it, which would race between concurrent commits.
+ */
+/*--------------------------------------------------------------------------------------------------------------------*/
+static void read_umask(){
+  g_umask = umask(0);
+  umask(g_umask);
+}
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: determines if the file 'fd' with status 'p_st' holds exactly the contents of 'p_buf'.
+ */
+/*--------------------------------------------------------------------------------------------------------------------*/
+static bool is_same_content(int fd, const struct stat* p_st, const struct OutBuf* p_buf){
+  if(!S_ISREG(p_st->st_mode) || (size_t)p_st->st_size != p_buf->_size){
+    return false;
+  }
+  if(p_buf->_size == 0){
+    return true;
+  }
+  void* p_map = mmap(NULL, p_buf->_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if(p_map == MAP_FAILED){
+    return false;
+  }
+  bool is_same = hash_xxh64(p_map, p_buf->_size, 0) == hash_xxh64(p_buf->_p_data, p_buf->_size, 0);
+  munmap(p_map, p_buf->_size);
+  return is_same;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+static int write_all(int fd, const char* data, size_t n){
+  while(n > 0){
+    ssize_t w = write(fd, data, n);
+    if(w < 0){
+      return FAIL;
+    }
+    data += w;
+    n -= (size_t)w;
+  }
+  return SUCCESS;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+int outfile_commit(struct OutBuf* p_buf, const char* path, bool is_if_changed, int* p_status){
+  // stat the existing file, if any, for its permissions and possibly its content...
+  struct stat st;
+  bool is_existing = false;
+  int fd = open(path, O_RDONLY);
+  if(fd >= 0){
+    is_existing = fstat(fd, &st) == 0;
+    bool is_unchanged = is_if_changed && is_existing && is_same_content(fd, &st, p_buf);
+    close(fd);
+    if(is_unchanged){
+      if(p_status){
+        *p_status = OUTFILE_UNCHANGED;
+      }
+      return SUCCESS;
+    }
+  }
+
+  // devices and pipes, e.g. /dev/stdout, cannot be replaced; write them in place...
+  if(is_existing && !S_ISREG(st.st_mode)){
+    fd = open(path, O_WRONLY | O_TRUNC);
+    int result = (fd >= 0 && write_all(fd, p_buf->_p_data, p_buf->_size) == SUCCESS) ? SUCCESS : FAIL;
+    if(fd >= 0 && close(fd) != 0){
+      result = FAIL;
+    }
+    if(result != SUCCESS){
+      perror(path);
+    }
+    else if(p_status){
+      *p_status = OUTFILE_WRITTEN;
+    }
+    return result;
+  }
+
+  // write a temporary sibling of the file, so the rename stays on one file system...
+  size_t l = strlen(path);
+  char* tmp_path = (char*)malloc(l + sizeof(TMP_SUFFIX));
+  if(tmp_path == NULL){
+    fprintf(stderr, "fatal error: out of memory\n");
+    return FAIL;
+  }
+  memcpy(tmp_path, path, l);
+  memcpy(tmp_path + l, TMP_SUFFIX, sizeof(TMP_SUFFIX));
+  fd = mkstemp(tmp_path);
+  if(fd < 0){
+    perror(tmp_path);
+    free(tmp_path);
+    return FAIL;
+  }
+
+  // mkstemp creates files 0600; match the replaced file, else the permissions 'fopen' would have given...
+  mode_t mode;
+  if(is_existing){
+    mode = st.st_mode & 07777;
+  }
+  else{
+    pthread_once(&g_umask_once, read_umask);
+    mode = 0666 & ~g_umask;
+  }
+
+  int result = SUCCESS;
+  if(fchmod(fd, mode) != 0 || write_all(fd, p_buf->_p_data, p_buf->_size) != SUCCESS){
+    result = FAIL;
+  }
+  if(close(fd) != 0){
+    result = FAIL;
+  }
+  if(result == SUCCESS && rename(tmp_path, path) != 0){
+    result = FAIL;
+  }
+  if(result != SUCCESS){
+    perror(path);
+    unlink(tmp_path);
+  }
+  else if(p_status){
+    *p_status = OUTFILE_WRITTEN;
+  }
+  free(tmp_path);
+  return result;
+}
+/*--------------------------------------------------------------------------------------------------------------------*/
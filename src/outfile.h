@@ -0,0 +1,68 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: outfile.h
+ *
+ *===================================================================================================================*/
+
+
+#ifndef _OUTFILE_H_
+#define _OUTFILE_H_
+
+#include <stdbool.h>
+
+struct OutBuf;
+
+/*
+ * results of committing a buffer to a file; returned through 'p_status' of 'outfile_commit'.
+ */
+#define OUTFILE_WRITTEN   0xe0 // the file was (re)written.
+#define OUTFILE_UNCHANGED 0xe1 // the file already held the buffer contents; left untouched, mtime preserved.
+
+/*
+ * brief: writes the contents of a buffer to the file at 'path' by writing a temporary file in the same directory
+ *  and renaming it over 'path'; readers of 'path' see either the old or the new contents, never a partial write.
+ *
+ * @param p_buf: the complete contents of the file.
+ * @param path: the file to write.
+ * @param is_if_changed: if true, and the file already exists with the same size and content hash as the buffer,
+ *  the file is not written.
+ * @param <out> p_status: OUTFILE_WRITTEN or OUTFILE_UNCHANGED; may be NULL.
+ *
+ * return: SUCCESS, or FAIL if the file could not be written; errors are reported to stderr.
+ *
+ * note: a rewritten file keeps the permissions of the file it replaces.
+ * note: existing files that are not regular files (devices, pipes) are written in place.
+ */
+int outfile_commit(struct OutBuf* p_buf, const char* path, bool is_if_changed, int* p_status);
+
+#endif
@@ -42,6 +42,7 @@
 #include <stdbool.h>
 
 #define CMD_EOF 0xc001 
+#define CMD_BLANK 0xc002 // a line with only whitespace and/or a comment.
 
 /*
  * ids for command formats; 5 different valid formats of assembly instructions.
@@ -72,25 +73,33 @@
  */
 typedef struct Parser Parser_t;
 
+struct OutBuf;
+
 /*
  * brief: Parsed assembly instruction data.
  *
  * @member _type: the format type of the command (CFORMAT_C0, CFORMAT_C1 ...).
+ * @member _dest: index of the destination mnemonic of a C command; 0 (null) for format C2.
+ * @member _comp: index of the computation mnemonic of a C command.
+ * @member _jump: index of the jump mnemonic of a C command; 0 (null) for format C1.
+ * @member _value: value of the literal of an A or L command of format A1 or L1.
  * @member _sym: buffer to store symbol string.
- * @member _dest: destination mnemonic extracted from a C command of format C0 or C1.
- * @member _comp: computation mnemonic extracted from a C command.
- * @member _jump: jump mnemonic extracted from a C command of format C0 or C2.
+ * @member _lineno: the line of the translation unit the command was lexed from, counted from 1.
  *
  * note: check _type before reading other members; members are only set if the command type has the member. Garbage 
- *  values will reside in the members the command doesn't have. For example, only the _literal member if set if the
- *  _type if CFORMAT_A0 | CFORMAT_L0.
+ *  values will reside in the members the command doesn't have. For example, only the _sym member is set if the
+ *  _type is CFORMAT_A0 | CFORMAT_L0.
+ *
+ * note: mnemonic indices index the mnemonic tables of the lexer and the bit tables of the decoder (see lexer.h).
  */
 typedef struct Command {
   uint8_t _type;
+  uint8_t _dest; 
+  uint8_t _comp;
+  uint8_t _jump;
+  uint16_t _value;
   char _sym[MAX_SYM_LENGTH];
-  char _dest[MAX_MNEMONIC_CHAR_LENGTH]; 
-  char _comp[MAX_MNEMONIC_CHAR_LENGTH];
-  char _jump[MAX_MNEMONIC_CHAR_LENGTH];
+  uint32_t _lineno;
 } Command_t;
 
 /*
@@ -105,12 +114,16 @@ typedef struct Symbol {
 } Symbol_t;
 
 Parser_t* new_parser(const char* filename);
+Parser_t* new_parser_buffer(const char* filename, const char* src, size_t n);
 void free_parser(Parser_t** p_parser);
 int parser_next_command(Parser_t* p_parser, Command_t* p_out);
 int parser_next_symbol(Parser_t* p, Symbol_t* p_out);
 bool parser_has_next(Parser_t* p_parser);
 void parser_rewind(Parser_t* p_parser);
+int parser_next_line(Parser_t* p, const char** pp_line, size_t* p_n);
+int parser_lex_line(Parser_t* p, const char* line, size_t n, uint32_t lineno, Command_t* p_out, bool is_quiet);
 void parser_print_cmdrep(FILE* stream, Command_t* c);
 int parser_print_cmdasm(FILE* stream, Command_t* c);
+int parser_write_cmdasm(struct OutBuf* p_buf, Command_t* c);
 
 #endif
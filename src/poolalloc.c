@@ -69,6 +69,11 @@ void* pool_malloc(struct PoolAlloc* p_pool){
   return radd;
 }
 
+/*--------------------------------------------------------------------------------------------------------------------*/
+void pool_reset(struct PoolAlloc* p_pool){
+  p_pool->_p_next = p_pool->_p_base;
+}
+
 /*--------------------------------------------------------------------------------------------------------------------*/
 size_t calc_free_allocs(struct PoolAlloc* p_pool){
   return ((p_pool->_p_base + p_pool->_pool_size_bytes) - p_pool->_p_next) / p_pool->_alloc_size_bytes;
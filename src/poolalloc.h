@@ -74,6 +74,12 @@ void free_pool_alloc(struct PoolAlloc* p_pool);
  */
 void* pool_malloc(struct PoolAlloc* p_pool);
 
+/*
+ * brief: returns all allocations to the pool, keeping its memory.
+ * note: WILL invalidate all pointers to pool memory!
+ */
+void pool_reset(struct PoolAlloc* p_pool);
+
 /*
  * brief: calculates the remaining number of allocations the pool can make.
  */
@@ -0,0 +1,305 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: profile.c
+ *
+ *===================================================================================================================*/
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include "profile.h"
+#include "assembler.h"
+#include "srcmap.h"
+#include "outbuf.h"
+#include "asmerr.h"
+
+#define REPORT_LINE_CHARS 512
+
+/*
+ * ids of the listings of the report.
+ */
+#define LISTING_LABELS 0x01
+#define LISTING_SPOTS  0x02 // lines, or instructions where lines are not known.
+#define LISTING_LOOPS  0x03
+
+/*
+ * brief: a row of a listing; the cycles spent in a label, line or loop.
+ *
+ * @member _key: the label index, line, or address of the row; of a loop, the address of its head.
+ * @member _first, _last: the first address of a line; the addresses a loop spans.
+ * @member _runs: the number of times the head of a loop was run.
+ */
+typedef struct Row {
+  uint64_t _cycles;
+  uint64_t _runs;
+  uint32_t _key;
+  uint32_t _first;
+  uint32_t _last;
+} Row_t;
+
+/*=====================================================================================================================
+ * PRIVATE INTERFACE
+ *===================================================================================================================*/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: orders rows hottest first; rows of equal cycles by key.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int compare_rows(const void* p_a, const void* p_b){
+  const Row_t* a = (const Row_t*)p_a, *b = (const Row_t*)p_b;
+  if(a->_cycles != b->_cycles){
+    return (a->_cycles > b->_cycles) ? -1 : 1;
+  }
+  return (a->_key < b->_key) ? -1 : (a->_key > b->_key);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static bool has_lines(const SrcMap_t* p_map){
+  return p_map->_num_ins > 0 && p_map->_p_lines[0] != 0;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static const char* label_name(const SrcMap_t* p_map, uint32_t label){
+  return (label == SRCMAP_NO_LABEL) ? "-" : p_map->_names._p_data + p_map->_p_label_table[label]._name;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: true if the instruction is a jump back to the '@' before it, or to an earlier instruction; sets the target.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static bool is_back_jump(const Assembler_t* p, uint32_t i, uint32_t* p_target){
+  uint16_t w = p->_p_hackins[i];
+  if((w & 0x8000) == 0 || (w & 0x7) == 0 || i == 0 || (p->_p_hackins[i - 1] & 0x8000) != 0){
+    return false;
+  }
+  *p_target = p->_p_hackins[i - 1];
+  return *p_target < i;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: sorts the rows, then appends the hottest PROFILE_TOP of them, and those of any cycles, to the report.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int put_rows(const Assembler_t* p, Row_t* p_rows, uint32_t num_rows, uint64_t total, const char* title,
+                    int listing, struct OutBuf* p_out){
+  const SrcMap_t* p_map = p->_p_srcmap;
+  qsort(p_rows, num_rows, sizeof(Row_t), compare_rows);
+  char line[REPORT_LINE_CHARS];
+  int result = outbuf_puts(p_out, title);
+  for(uint32_t r = 0; r < num_rows && r < PROFILE_TOP && p_rows[r]._cycles > 0 && result == SUCCESS; ++r){
+    const Row_t* p_row = &p_rows[r];
+    int n = snprintf(line, sizeof(line), "%14" PRIu64 " %6.2f%%  ", p_row->_cycles, 100.0 * p_row->_cycles / total);
+    if(listing == LISTING_LABELS){
+      snprintf(line + n, sizeof(line) - n, "%s\n", label_name(p_map, p_row->_key));
+    }
+    else if(listing == LISTING_SPOTS){
+      snprintf(line + n, sizeof(line) - n, "%s %-6" PRIu32 " %s\n", has_lines(p_map) ? "line" : "address", 
+               p_row->_key, label_name(p_map, p_map->_p_labels[p_row->_first]));
+    }
+    else if(has_lines(p_map)){
+      snprintf(line + n, sizeof(line) - n, "lines %" PRIu32 "-%" PRIu32 ", %" PRIu64 " iterations  %s\n", 
+               p_map->_p_lines[p_row->_first], p_map->_p_lines[p_row->_last], p_row->_runs, 
+               label_name(p_map, p_map->_p_labels[p_row->_first]));
+    }
+    else{
+      snprintf(line + n, sizeof(line) - n, "addresses %" PRIu32 "-%" PRIu32 ", %" PRIu64 " iterations  %s\n",
+               p_row->_first, p_row->_last, p_row->_runs, label_name(p_map, p_map->_p_labels[p_row->_first]));
+    }
+    result = outbuf_puts(p_out, line);
+  }
+  return result;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: appends the frames of the label of an instruction to a stack; 'function;function$local' for a local label.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void put_frames(const SrcMap_t* p_map, uint32_t label, struct OutBuf* p_out){
+  if(label == SRCMAP_NO_LABEL){
+    return;
+  }
+  const char* name = label_name(p_map, label), *dollar = strchr(name, '$');
+  if(dollar != NULL && dollar != name){
+    outbuf_putc(p_out, ';');
+    outbuf_write(p_out, name, (size_t)(dollar - name));
+  }
+  outbuf_putc(p_out, ';');
+  outbuf_puts(p_out, name);
+}
+
+/*=====================================================================================================================
+ * PUBLIC INTERFACE
+ *===================================================================================================================*/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int profile_report(const Assembler_t* p, const uint64_t* p_counts, struct OutBuf* p_out){
+  const SrcMap_t* p_map = p->_p_srcmap;
+  uint32_t n = p_map->_num_ins, num_lines = 0;
+  for(uint32_t i = 0; i < n; ++i){
+    num_lines = (p_map->_p_lines[i] >= num_lines) ? p_map->_p_lines[i] + 1 : num_lines;
+  }
+  bool is_by_line = has_lines(p_map);
+  uint32_t num_spots = is_by_line ? num_lines : n;
+  Row_t* p_rows = (Row_t*)calloc((size_t)p_map->_num_labels + num_spots + n + 1, sizeof(Row_t));
+  uint64_t* p_prefix = (uint64_t*)malloc(((size_t)n + 1) * sizeof(uint64_t));
+  if(p_rows == NULL || p_prefix == NULL){
+    free(p_rows);
+    free(p_prefix);
+    return FAIL;
+  }
+  Row_t* p_labels = p_rows, *p_spots = p_rows + p_map->_num_labels + 1, *p_loops = p_spots + num_spots;
+  p_prefix[0] = 0;
+  for(uint32_t l = 0; l <= p_map->_num_labels; ++l){
+    p_labels[l]._key = (l == p_map->_num_labels) ? SRCMAP_NO_LABEL : l;
+  }
+  for(uint32_t s = 0; s < num_spots; ++s){
+    p_spots[s]._key = s;
+    p_spots[s]._first = UINT32_MAX;
+  }
+  for(uint32_t i = 0; i < n; ++i){
+    uint32_t label = p_map->_p_labels[i];
+    p_labels[(label == SRCMAP_NO_LABEL) ? p_map->_num_labels : label]._cycles += p_counts[i];
+    Row_t* p_spot = &p_spots[is_by_line ? p_map->_p_lines[i] : i];
+    p_spot->_cycles += p_counts[i];
+    p_spot->_first = (p_spot->_first == UINT32_MAX) ? i : p_spot->_first;
+    p_prefix[i + 1] = p_prefix[i] + p_counts[i];
+  }
+  uint32_t num_loops = 0;
+  for(uint32_t i = 0; i < n; ++i){
+    uint32_t target;
+    if(is_back_jump(p, i, &target) && p_counts[i] > 0){
+      Row_t* p_loop = &p_loops[num_loops++];
+      p_loop->_cycles = p_prefix[i + 1] - p_prefix[target];
+      p_loop->_first = target;
+      p_loop->_last = i;
+      p_loop->_key = target;
+      p_loop->_runs = p_counts[target];
+    }
+  }
+  uint64_t total = p_prefix[n];
+  char line[REPORT_LINE_CHARS];
+  snprintf(line, sizeof(line), "profile: %" PRIu64 " cycles in %" PRIu32 " instructions\n", total, n);
+  int result = outbuf_puts(p_out, line);
+  if(total > 0 && result == SUCCESS){
+    const char* title = is_by_line ? "hottest lines:\n" : "hottest instructions:\n";
+    result = put_rows(p, p_labels, p_map->_num_labels + 1, total, "hottest labels:\n", LISTING_LABELS, p_out);
+    result = (result == SUCCESS) ? put_rows(p, p_spots, num_spots, total, title, LISTING_SPOTS, p_out) : result;
+    result = (result == SUCCESS) ? put_rows(p, p_loops, num_loops, total, "hottest loops:\n", LISTING_LOOPS, p_out) :
+             result;
+  }
+  free(p_rows);
+  free(p_prefix);
+  return result;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int profile_read_folded(const char* p_data, size_t size, uint64_t** pp_cycles, uint32_t* p_num_lines){
+  static const char LEAF[] = ";line ";
+  *pp_cycles = NULL;
+  *p_num_lines = 0;
+  for(size_t start = 0, end; start < size; start = end + 1){
+    for(end = start; end < size && p_data[end] != '\n'; ++end);
+
+    // each stack ends ';line <line> <cycles>'; read back from its end...
+    size_t k = end;
+    uint64_t cycles = 0, line = 0, scale = 1;
+    for(; k > start && p_data[k - 1] >= '0' && p_data[k - 1] <= '9'; --k, scale *= 10){
+      cycles += (uint64_t)(p_data[k - 1] - '0') * scale;
+    }
+    if(k == end || k == start || p_data[--k] != ' '){
+      continue;
+    }
+    size_t digits = k;
+    for(scale = 1; k > start && p_data[k - 1] >= '0' && p_data[k - 1] <= '9'; --k, scale *= 10){
+      line += (uint64_t)(p_data[k - 1] - '0') * scale;
+    }
+    if(k == digits || k - start < sizeof(LEAF) - 1 || memcmp(p_data + k - (sizeof(LEAF) - 1), LEAF, 
+       sizeof(LEAF) - 1) != 0 || line >= UINT32_MAX){
+      continue;
+    }
+
+    // ...and add its cycles to its line.
+    if(line >= *p_num_lines){
+      uint32_t num_lines = ((uint32_t)line < 2 * *p_num_lines) ? 2 * *p_num_lines : (uint32_t)line + 1;
+      uint64_t* p_cycles = (uint64_t*)realloc(*pp_cycles, num_lines * sizeof(uint64_t));
+      if(p_cycles == NULL){
+        free(*pp_cycles);
+        *pp_cycles = NULL;
+        *p_num_lines = 0;
+        return FAIL;
+      }
+      memset(p_cycles + *p_num_lines, 0, (num_lines - *p_num_lines) * sizeof(uint64_t));
+      *pp_cycles = p_cycles;
+      *p_num_lines = num_lines;
+    }
+    (*pp_cycles)[line] += cycles;
+  }
+  return (*p_num_lines > 0) ? SUCCESS : ERROR_1;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int profile_folded(const Assembler_t* p, const char* root, const uint64_t* p_counts, struct OutBuf* p_out){
+  const SrcMap_t* p_map = p->_p_srcmap;
+  bool is_by_line = has_lines(p_map);
+  char leaf[32];
+  for(uint32_t i = 0; i < p_map->_num_ins; ){
+    // the instructions of a line follow each other, so a run of them is one stack...
+    uint32_t j = i + 1;
+    uint64_t cycles = p_counts[i];
+    while(is_by_line && j < p_map->_num_ins && p_map->_p_lines[j] == p_map->_p_lines[i] &&
+          p_map->_p_labels[j] == p_map->_p_labels[i]){
+      cycles += p_counts[j++];
+    }
+    if(cycles > 0){
+      outbuf_puts(p_out, root);
+      put_frames(p_map, p_map->_p_labels[i], p_out);
+      snprintf(leaf, sizeof(leaf), is_by_line ? ";line %" PRIu32 " " : ";@%" PRIu32 " ", 
+               is_by_line ? p_map->_p_lines[i] : i);
+      outbuf_puts(p_out, leaf);
+      snprintf(leaf, sizeof(leaf), "%" PRIu64 "\n", cycles);
+      if(outbuf_puts(p_out, leaf) != SUCCESS){
+        return FAIL;
+      }
+    }
+    i = j;
+  }
+  return SUCCESS;
+}
@@ -0,0 +1,88 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: profile.h
+ *
+ *===================================================================================================================*/
+
+
+#ifndef _PROFILE_H_
+#define _PROFILE_H_
+
+#include <stdint.h>
+#include "assembler.h"
+
+#define PROFILE_TOP 20 // rows of each listing of the report.
+
+struct OutBuf;
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: appends the flat profile of a run to a buffer; the labels, lines and loops the run spent the most cycles
+ *  in, hottest first, with their share of all cycles.
+ * @param p: the assembler of the program run; its instructions and source map.
+ * @param p_counts: the number of times each instruction was executed (see 'sim_profile').
+ * return: SUCCESS, or FAIL on malloc error.
+ *
+ * note: a loop is the span from the target of a jump back to the jump; the '@' of a jump gives its target.
+ * note: instructions are listed by address where their lines are not known, i.e. of linked programs.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int profile_report(const Assembler_t* p, const uint64_t* p_counts, struct OutBuf* p_out);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: appends the profile of a run in the folded stack format of flame graph tools; a line per source line run,
+ *  of its frames separated by ';' then its cycles, e.g. 'Main;Main.loop;Main.loop$END;line 12 3400'.
+ * @param root: the frame all stacks start from, e.g. the name of the program.
+ * return: SUCCESS, or FAIL on malloc error.
+ *
+ * note: the frames of a stack are the label of the instruction, preceded by the function of the label if the label
+ *  is local to one, i.e. named 'function$local' as by the VM translator.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int profile_folded(const Assembler_t* p, const char* root, const uint64_t* p_counts, struct OutBuf* p_out);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: reads the cycles of each source line from folded stacks (see 'profile_folded'), e.g. to guide -O1.
+ * @param p_data: the folded stacks; 'size' bytes.
+ * @param <out> pp_cycles: the cycles of each line, by line; the caller frees it.
+ * @param <out> p_num_lines: the number of lines of the array, including the unused line 0.
+ * return: SUCCESS, ERROR_1 if no stack ends in a line, e.g. of a linked program, or FAIL on malloc error.
+ *
+ * note: the stacks of a line are summed; the lines are those of the program profiled, so it must be the same source.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int profile_read_folded(const char* p_data, size_t size, uint64_t** pp_cycles, uint32_t* p_num_lines);
+
+#endif
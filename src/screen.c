@@ -0,0 +1,259 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: screen.c
+ *
+ *===================================================================================================================*/
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "screen.h"
+#include "outbuf.h"
+#include "asmerr.h"
+
+#define ROW_BYTES      (SCREEN_WIDTH / 8) // bytes of a row of a PBM image.
+#define FIRST_ROW      (SIM_SCREEN_ADDRESS >> SIM_ROW_SHIFT)
+#define PBM_HEADER     "P4\n512 256\n"
+#define DELTA_HEADER   12
+
+/*
+ * brief: a sequence of frames being taken.
+ *
+ * @member _words: the screen of the last frame.
+ * @member _p_packed: of PBM frames, the last frame packed as the pixels of a PBM image; else NULL.
+ * @member _rows: the rows changed in the frame being taken.
+ * @member _num_frames: the number of frames appended.
+ */
+struct Frames {
+  int _format;
+  uint16_t _words[SCREEN_WORDS];
+  uint8_t* _p_packed;
+  uint16_t _rows[SIM_SCREEN_ROWS];
+  uint64_t _num_frames;
+};
+
+/*=====================================================================================================================
+ * PRIVATE INTERFACE
+ *===================================================================================================================*/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: the byte of a PBM image of 8 pixels of the Hack screen; the leftmost pixel is bit 0 of a word of the
+ *  screen, but the most significant bit of a byte of the image.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static inline uint8_t reverse_bits(uint8_t b){
+  b = (uint8_t)(((b & 0xf0) >> 4) | ((b & 0x0f) << 4));
+  b = (uint8_t)(((b & 0xcc) >> 2) | ((b & 0x33) << 2));
+  return (uint8_t)(((b & 0xaa) >> 1) | ((b & 0x55) << 1));
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void put_u16le(struct OutBuf* p_buf, uint16_t v){
+  char b[2] = {(char)v, (char)(v >> 8)};
+  outbuf_write(p_buf, b, 2);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: skips the whitespace and comments of a PBM header.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static const char* skip_space(const char* s, const char* end){
+  while(s < end && (*s == ' ' || *s == '\t' || *s == '\r' || *s == '\n' || *s == '#')){
+    if(*s == '#'){
+      while(s < end && *s != '\n'){
+        ++s;
+      }
+    }
+    else{
+      ++s;
+    }
+  }
+  return s;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: reads a number of a PBM header.
+ * return: the number, or -1 if there is none.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static long read_number(const char** p_s, const char* end){
+  const char* s = skip_space(*p_s, end);
+  long n = -1;
+  for(; s < end && *s >= '0' && *s <= '9' && n < 1000000; ++s){
+    n = ((n < 0) ? 0 : n * 10) + (*s - '0');
+  }
+  *p_s = s;
+  return n;
+}
+
+/*=====================================================================================================================
+ * PUBLIC INTERFACE
+ *===================================================================================================================*/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+Frames_t* new_frames(int format){
+  Frames_t* p_frames = (Frames_t*)calloc(1, sizeof(Frames_t));
+  if(p_frames == NULL){
+    return NULL;
+  }
+  p_frames->_format = format;
+  if(format == FRAMES_PBM && (p_frames->_p_packed = (uint8_t*)calloc(SCREEN_HEIGHT, ROW_BYTES)) == NULL){
+    free(p_frames);
+    return NULL;
+  }
+  return p_frames;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void free_frames(Frames_t** pp_frames){
+  free((*pp_frames)->_p_packed);
+  free(*pp_frames);
+  (*pp_frames) = NULL;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int frames_take(Frames_t* p_frames, Sim_t* p_sim, struct OutBuf* p_out){
+  uint8_t* dirty = &p_sim->_p_dirty[FIRST_ROW];
+  const uint16_t* screen = &p_sim->_p_ram[SIM_SCREEN_ADDRESS];
+  uint32_t num_rows = 0;
+  for(uint32_t r = 0; r < SIM_SCREEN_ROWS; ++r){
+    uint16_t* words = &p_frames->_words[r * SIM_ROW_WORDS];
+    if(!dirty[r] || memcmp(words, &screen[r * SIM_ROW_WORDS], SIM_ROW_WORDS * sizeof(uint16_t)) == 0){
+      continue;
+    }
+    memcpy(words, &screen[r * SIM_ROW_WORDS], SIM_ROW_WORDS * sizeof(uint16_t));
+    p_frames->_rows[num_rows++] = (uint16_t)r;
+    if(p_frames->_p_packed != NULL){
+      uint8_t* packed = &p_frames->_p_packed[r * ROW_BYTES];
+      for(uint32_t w = 0; w < SIM_ROW_WORDS; ++w){
+        packed[2 * w] = reverse_bits((uint8_t)words[w]);
+        packed[2 * w + 1] = reverse_bits((uint8_t)(words[w] >> 8));
+      }
+    }
+  }
+  memset(dirty, 0, SIM_SCREEN_ROWS);
+  if(num_rows == 0){
+    return SUCCESS;
+  }
+  if(p_frames->_format == FRAMES_PBM){
+    if(outbuf_reserve(p_out, strlen(PBM_HEADER) + SCREEN_HEIGHT * ROW_BYTES) != SUCCESS){
+      return FAIL;
+    }
+    outbuf_write(p_out, PBM_HEADER, strlen(PBM_HEADER));
+    outbuf_write(p_out, (const char*)p_frames->_p_packed, SCREEN_HEIGHT * ROW_BYTES);
+    ++p_frames->_num_frames;
+    return SUCCESS;
+  }
+  size_t size = ((p_frames->_num_frames == 0) ? DELTA_HEADER : 0) + 10 + num_rows * (2 + SIM_ROW_WORDS * 2);
+  if(outbuf_reserve(p_out, size) != SUCCESS){
+    return FAIL;
+  }
+  if(p_frames->_num_frames == 0){
+    outbuf_write(p_out, FRAMES_MAGIC, 4);
+    put_u16le(p_out, FRAMES_VERSION);
+    put_u16le(p_out, SCREEN_WIDTH);
+    put_u16le(p_out, SCREEN_HEIGHT);
+    put_u16le(p_out, 0);
+  }
+  for(int i = 0; i < 4; ++i){
+    put_u16le(p_out, (uint16_t)(p_sim->_cycles >> (16 * i)));
+  }
+  put_u16le(p_out, (uint16_t)num_rows);
+  for(uint32_t i = 0; i < num_rows; ++i){
+    const uint16_t* words = &p_frames->_words[p_frames->_rows[i] * SIM_ROW_WORDS];
+    put_u16le(p_out, p_frames->_rows[i]);
+    for(uint32_t w = 0; w < SIM_ROW_WORDS; ++w){
+      put_u16le(p_out, words[w]);
+    }
+  }
+  ++p_frames->_num_frames;
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int screen_read_pbm(ScreenImage_t* p_image, const char* p_data, size_t size){
+  const char* s = p_data, *end = p_data + size;
+  if(size < 2 || s[0] != 'P' || (s[1] != '4' && s[1] != '1')){
+    return FAIL;
+  }
+  bool is_plain = s[1] == '1';
+  s += 2;
+  if(read_number(&s, end) != SCREEN_WIDTH || read_number(&s, end) != SCREEN_HEIGHT){
+    return FAIL;
+  }
+  memset(p_image->_words, 0, sizeof(p_image->_words));
+  if(is_plain){
+    for(uint32_t p = 0; p < SCREEN_WIDTH * SCREEN_HEIGHT; ++p){
+      s = skip_space(s, end);
+      if(s == end || (*s != '0' && *s != '1')){
+        return FAIL;
+      }
+      p_image->_words[p >> 4] |= (uint16_t)((*s++ - '0') << (p & 15));
+    }
+  }
+  else{
+    if(s == end || (end - ++s) < SCREEN_HEIGHT * ROW_BYTES){ // a single whitespace ends the header.
+      return FAIL;
+    }
+    for(uint32_t i = 0; i < SCREEN_WORDS; ++i){
+      p_image->_words[i] = (uint16_t)(reverse_bits((uint8_t)s[2 * i]) | (reverse_bits((uint8_t)s[2 * i + 1]) << 8));
+    }
+  }
+  for(uint32_t r = 0; r < SIM_SCREEN_ROWS; ++r){
+    p_image->_is_blank[r] = 1;
+    for(uint32_t w = 0; w < SIM_ROW_WORDS && p_image->_is_blank[r]; ++w){
+      p_image->_is_blank[r] = p_image->_words[r * SIM_ROW_WORDS + w] == 0;
+    }
+  }
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+uint32_t screen_diff(const Sim_t* p_sim, const ScreenImage_t* p_image, uint32_t* p_first_row){
+  const uint8_t* dirty = &p_sim->_p_dirty[FIRST_ROW];
+  const uint16_t* screen = &p_sim->_p_ram[SIM_SCREEN_ADDRESS];
+  uint32_t num_rows = 0;
+  for(uint32_t r = 0; r < SIM_SCREEN_ROWS; ++r){
+    bool is_same = dirty[r] ? memcmp(&screen[r * SIM_ROW_WORDS], &p_image->_words[r * SIM_ROW_WORDS], 
+                                     SIM_ROW_WORDS * sizeof(uint16_t)) == 0 : p_image->_is_blank[r];
+    if(!is_same && num_rows++ == 0){
+      *p_first_row = r;
+    }
+  }
+  return num_rows;
+}
@@ -0,0 +1,126 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: screen.h
+ *
+ *===================================================================================================================*/
+
+
+#ifndef _SCREEN_H_
+#define _SCREEN_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sim.h"
+
+#define SCREEN_WIDTH  512
+#define SCREEN_HEIGHT SIM_SCREEN_ROWS
+#define SCREEN_WORDS  (SIM_SCREEN_ROWS * SIM_ROW_WORDS)
+
+#define FRAMES_MAGIC "HSCR"
+#define FRAMES_VERSION 1
+
+/*
+ * ids of the formats of frames; see 'new_frames'.
+ */
+#define FRAMES_PBM   0xf0 // binary PBM (P4) images, one after another.
+#define FRAMES_DELTA 0xf1 // the rows changed each frame.
+
+struct OutBuf;
+
+/*
+ * brief: an image of the screen, e.g. the screen a test expects its program to leave.
+ *
+ * @member _words: the screen as its memory map holds it.
+ * @member _is_blank: whether each row is all white, so rows the program never stored to need not be read.
+ */
+typedef struct ScreenImage {
+  uint16_t _words[SCREEN_WORDS];
+  uint8_t _is_blank[SIM_SCREEN_ROWS];
+} ScreenImage_t;
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: closed type of a sequence of frames of the screen being taken; instantiate with 'new_frames'.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+typedef struct Frames Frames_t;
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: starts a sequence of frames of a screen, all white, of either format,
+ *
+ *    FRAMES_PBM    a binary PBM image of the whole screen a frame; 1 is black, as on the Hack screen.
+ *    FRAMES_DELTA  little-endian; magic "HSCR", u16 version, u16 width, u16 height, u16 0, then a frame each of
+ *                  u64 cycles, u16 number of rows, and of each row changed, u16 row then its 32 u16 words.
+ *
+ * return: pointer to the new sequence or NULL on error.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+Frames_t* new_frames(int format);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void free_frames(Frames_t** pp_frames);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: takes a frame of the screen of a simulator; appends it to a buffer if the screen changed since the last
+ *  frame, then clears the dirty rows of the screen.
+ * return: SUCCESS, or FAIL if the buffer could not grow.
+ *
+ * note: only the rows stored to since the last frame are read; of a PBM image, only they are packed again.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int frames_take(Frames_t* p_frames, Sim_t* p_sim, struct OutBuf* p_out);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: reads an image of the screen from a PBM image, binary (P4) or plain (P1), of SCREEN_WIDTH x SCREEN_HEIGHT;
+ *  of a sequence of images, the first.
+ * return: SUCCESS, or FAIL if the data is not a PBM image of the size of the screen.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int screen_read_pbm(ScreenImage_t* p_image, const char* p_data, size_t size);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: compares the screen of a simulator with an image.
+ * @param <out> p_first_row: the first row that differs, if any.
+ * return: the number of rows that differ.
+ *
+ * note: only the dirty rows are read; the others are as reset left them, all white, so they differ only where the
+ *  image is not blank. So the simulator must not have had its dirty rows taken by a frame since reset.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+uint32_t screen_diff(const Sim_t* p_sim, const ScreenImage_t* p_image, uint32_t* p_first_row);
+
+#endif
@@ -0,0 +1,559 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: server.c
+ *
+ *===================================================================================================================*/
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "server.h"
+#include "assembler.h"
+#include "emit.h"
+#include "outbuf.h"
+#include "lexer.h"
+#include "decoder.h"
+#include "diag.h"
+#include "asmerr.h"
+
+#define QUEUE_SIZE 64        /* max accepted connections waiting for a worker. */
+#define LISTEN_BACKLOG 64
+
+/*
+ * brief: bounded queue of accepted connections; the accepting thread pushes, workers pop.
+ */
+typedef struct ConnQueue {
+  int _fds[QUEUE_SIZE];
+  int _head;
+  int _count;
+  pthread_mutex_t _lock;
+  pthread_cond_t _not_empty;
+  pthread_cond_t _not_full;
+} ConnQueue_t;
+
+/*
+ * brief: a thread of the server's pool; its assembler and buffers are kept warm between requests.
+ */
+typedef struct Worker {
+  Assembler_t* _p_asm;
+  struct OutBuf _in;                          /* body of the current request frame. */
+  struct OutBuf _out;                         /* current reply frame. */
+  struct OutBuf _artifacts[NUM_EMIT_KINDS];   /* outputs of the current request, one per kind. */
+  pthread_t _thread;
+} Worker_t;
+
+/*
+ * brief: a cursor over a frame body, used to decode it with bounds checks.
+ */
+typedef struct Reader {
+  const char* _p;
+  const char* _end;
+  bool _is_bad;         /* set if a read ran past the end. */
+} Reader_t;
+
+static ConnQueue_t g_queue = {
+  ._lock = PTHREAD_MUTEX_INITIALIZER, ._not_empty = PTHREAD_COND_INITIALIZER, ._not_full = PTHREAD_COND_INITIALIZER
+};
+static volatile sig_atomic_t g_is_stopping;
+
+/*=====================================================================================================================
+ * WIRE FORMAT
+ *===================================================================================================================*/
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int put_u32le(struct OutBuf* p_buf, uint32_t v){
+  char b[4] = {(char)v, (char)(v >> 8), (char)(v >> 16), (char)(v >> 24)};
+  return outbuf_write(p_buf, b, 4);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static uint32_t get_u32le(const char* b){
+  const uint8_t* u = (const uint8_t*)b;
+  return (uint32_t)u[0] | ((uint32_t)u[1] << 8) | ((uint32_t)u[2] << 16) | ((uint32_t)u[3] << 24);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static uint32_t read_u32(Reader_t* r){
+  if(r->_end - r->_p < 4){
+    r->_is_bad = true;
+    return 0;
+  }
+  uint32_t v = get_u32le(r->_p);
+  r->_p += 4;
+  return v;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static const char* read_bytes(Reader_t* r, uint32_t n){
+  if((uint64_t)(r->_end - r->_p) < n){
+    r->_is_bad = true;
+    return NULL;
+  }
+  const char* p = r->_p;
+  r->_p += n;
+  return p;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int write_all(int fd, const char* data, size_t n){
+  while(n > 0){
+    ssize_t w = write(fd, data, n);
+    if(w < 0){
+      if(errno == EINTR){
+        continue;
+      }
+      return FAIL;
+    }
+    data += w;
+    n -= (size_t)w;
+  }
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * return: SUCCESS, or ERROR_1 if the peer closed the connection cleanly before the first byte.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int read_all(int fd, char* data, size_t n){
+  size_t got = 0;
+  while(got < n){
+    ssize_t r = read(fd, data + got, n - got);
+    if(r < 0 && errno == EINTR){
+      continue;
+    }
+    if(r <= 0){
+      return (r == 0 && got == 0) ? ERROR_1 : FAIL;
+    }
+    got += (size_t)r;
+  }
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: reads a frame from 'fd' into 'p_body', replacing its contents with the frame body.
+ * return: SUCCESS, ERROR_1 at end of stream, or FAIL on error or if the frame is too large.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int read_frame(int fd, struct OutBuf* p_body){
+  char len[4];
+  int result = read_all(fd, len, 4);
+  if(result != SUCCESS){
+    return result;
+  }
+  uint32_t n = get_u32le(len);
+  outbuf_clear(p_body);
+  if(n > SERVE_MAX_FRAME || outbuf_reserve(p_body, n) != SUCCESS){
+    return FAIL;
+  }
+  if(read_all(fd, p_body->_p_data, n) != SUCCESS){
+    return FAIL;
+  }
+  p_body->_size = n;
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: starts a frame in a buffer; the length is patched by 'end_frame'.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void begin_frame(struct OutBuf* p_frame){
+  outbuf_clear(p_frame);
+  put_u32le(p_frame, 0);
+}
+
+static int end_frame(struct OutBuf* p_frame){
+  if(p_frame->_size < 4){ // a put failed; out of memory.
+    return FAIL;
+  }
+  uint32_t n = (uint32_t)(p_frame->_size - 4);
+  char b[4] = {(char)n, (char)(n >> 8), (char)(n >> 16), (char)(n >> 24)};
+  memcpy(p_frame->_p_data, b, 4);
+  return SUCCESS;
+}
+
+/*=====================================================================================================================
+ * SERVER
+ *===================================================================================================================*/
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void on_stop_signal(int sig){
+  (void)sig;
+  g_is_stopping = 1;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void push_connection(int fd){
+  pthread_mutex_lock(&g_queue._lock);
+  while(g_queue._count == QUEUE_SIZE){
+    pthread_cond_wait(&g_queue._not_full, &g_queue._lock);
+  }
+  g_queue._fds[(g_queue._head + g_queue._count) % QUEUE_SIZE] = fd;
+  ++g_queue._count;
+  pthread_cond_signal(&g_queue._not_empty);
+  pthread_mutex_unlock(&g_queue._lock);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int pop_connection(){
+  pthread_mutex_lock(&g_queue._lock);
+  while(g_queue._count == 0){
+    pthread_cond_wait(&g_queue._not_empty, &g_queue._lock);
+  }
+  int fd = g_queue._fds[g_queue._head];
+  g_queue._head = (g_queue._head + 1) % QUEUE_SIZE;
+  --g_queue._count;
+  pthread_cond_signal(&g_queue._not_full);
+  pthread_mutex_unlock(&g_queue._lock);
+  return fd;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: assembles or strips the source of a request into the artifact buffers of the worker.
+ * return: SUCCESS, or FAIL if the source has errors; errors are reported to the diagnostic stream.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int run_request(Worker_t* w, uint32_t op, uint32_t emit, const char* name, const char* src, uint32_t n){
+  Assembler_t* p = w->_p_asm;
+  if(assembler_reset(p) != SUCCESS){
+    fprintf(diag_stream(), "fatal error: out of memory\n");
+    return FAIL;
+  }
+  bool is_inline = (op & SERVE_REQ_INLINE) != 0;
+  if((op & ~SERVE_REQ_INLINE) == SERVE_OP_STRIP){
+    struct OutBuf* p_out = &w->_artifacts[0];
+    outbuf_clear(p_out);
+    return is_inline ? assembler_strip_buffer(p, name, src, n, p_out) : assembler_strip(p, name, p_out);
+  }
+  int result = is_inline ? assembler_assemble_buffer(p, name, src, n) : assembler_assemble(p, name);
+  for(int k = 0; k < NUM_EMIT_KINDS && result == SUCCESS; ++k){
+    if(emit & (1 << k)){
+      outbuf_clear(&w->_artifacts[k]);
+      if(emitter_of(1 << k)(p, &w->_artifacts[k]) != SUCCESS){
+        fprintf(diag_stream(), "fatal error: out of memory\n");
+        result = FAIL;
+      }
+    }
+  }
+  return result;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: decodes the request in the worker's input buffer, runs it and composes the reply frame.
+ * return: SUCCESS, or FAIL if the reply could not be composed.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int handle_request(Worker_t* w){
+  Reader_t r = {w->_in._p_data, w->_in._p_data + w->_in._size, false};
+  uint32_t op = read_u32(&r);
+  uint32_t emit = read_u32(&r);
+  uint32_t name_len = read_u32(&r);
+  const char* p_name = read_bytes(&r, name_len);
+  uint32_t src_len = read_u32(&r);
+  const char* p_src = read_bytes(&r, src_len);
+  uint32_t base_op = op & ~SERVE_REQ_INLINE;
+
+  // diagnostics of the request are captured into the reply...
+  char* p_diag = NULL;
+  size_t diag_len = 0;
+  FILE* diag = open_memstream(&p_diag, &diag_len);
+  if(diag == NULL){
+    return FAIL;
+  }
+  diag_redirect(diag);
+
+  int result = FAIL;
+  if(r._is_bad || name_len == 0 || name_len > SERVE_MAX_NAME || (base_op != SERVE_OP_ASSEMBLE && 
+     base_op != SERVE_OP_STRIP) || (emit & ~((1u << NUM_EMIT_KINDS) - 1)) != 0){
+    fprintf(diag, "fatal error: malformed request\n");
+  }
+  else{
+    char name[SERVE_MAX_NAME + 1];
+    memcpy(name, p_name, name_len);
+    name[name_len] = '\0';
+    result = run_request(w, op, emit, name, p_src, src_len);
+  }
+
+  diag_redirect(NULL);
+  fclose(diag);
+
+  // ...then compose the reply.
+  Assembler_t* p = w->_p_asm;
+  bool is_assembled = result == SUCCESS && base_op == SERVE_OP_ASSEMBLE;
+  struct OutBuf* p_out = &w->_out;
+  begin_frame(p_out);
+  put_u32le(p_out, (result == SUCCESS) ? 0 : 1);
+  put_u32le(p_out, is_assembled ? p->_line_count : 0);
+  put_u32le(p_out, is_assembled ? p->_ins_count : 0);
+  put_u32le(p_out, is_assembled ? p->_ram_address - RAM_START_ADDRESS : 0);
+  put_u32le(p_out, (uint32_t)diag_len);
+  outbuf_write(p_out, p_diag, diag_len);
+  free(p_diag);
+  if(result != SUCCESS){
+    put_u32le(p_out, 0);
+  }
+  else if(base_op == SERVE_OP_STRIP){
+    put_u32le(p_out, 1);
+    put_u32le(p_out, SERVE_KIND_STRIP);
+    put_u32le(p_out, (uint32_t)w->_artifacts[0]._size);
+    outbuf_write(p_out, w->_artifacts[0]._p_data, w->_artifacts[0]._size);
+  }
+  else{
+    put_u32le(p_out, (uint32_t)__builtin_popcount(emit));
+    for(int k = 0; k < NUM_EMIT_KINDS; ++k){
+      if(emit & (1 << k)){
+        put_u32le(p_out, 1u << k);
+        put_u32le(p_out, (uint32_t)w->_artifacts[k]._size);
+        outbuf_write(p_out, w->_artifacts[k]._p_data, w->_artifacts[k]._size);
+      }
+    }
+  }
+  return end_frame(p_out);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: thread entry of a worker; serves connections from the queue, one request at a time, until the client
+ *  closes the connection.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void* run_worker(void* p_arg){
+  Worker_t* w = (Worker_t*)p_arg;
+  while(true){
+    int fd = pop_connection();
+    int result;
+    while((result = read_frame(fd, &w->_in)) == SUCCESS){
+      if(handle_request(w) != SUCCESS || write_all(fd, w->_out._p_data, w->_out._size) != SUCCESS){
+        break;
+      }
+    }
+    close(fd);
+  }
+  return NULL;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int init_worker(Worker_t* w){
+  memset(w, 0, sizeof(Worker_t));
+  if((w->_p_asm = new_assembler(false)) == NULL || init_outbuf(&w->_in, 1 << 16) != SUCCESS || 
+     init_outbuf(&w->_out, 1 << 16) != SUCCESS){
+    return FAIL;
+  }
+  for(int k = 0; k < NUM_EMIT_KINDS; ++k){
+    if(init_outbuf(&w->_artifacts[k], 1 << 16) != SUCCESS){
+      return FAIL;
+    }
+  }
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int make_address(const char* sock_path, struct sockaddr_un* p_addr){
+  memset(p_addr, 0, sizeof(struct sockaddr_un));
+  p_addr->sun_family = AF_UNIX;
+  if(strlen(sock_path) >= sizeof(p_addr->sun_path)){
+    fprintf(stderr, "fatal error: socket path '%s' is too long\n", sock_path);
+    return FAIL;
+  }
+  strcpy(p_addr->sun_path, sock_path);
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int serve(const char* sock_path, int num_workers){
+  struct sockaddr_un addr;
+  if(make_address(sock_path, &addr) != SUCCESS){
+    return FAIL;
+  }
+
+  // the tables are built before the workers start, since their lazy initialisation is not thread safe...
+  init_lexer();
+  init_decoder();
+
+  // replace a stale socket, but never a regular file...
+  struct stat st;
+  if(lstat(sock_path, &st) == 0){
+    if(!S_ISSOCK(st.st_mode)){
+      fprintf(stderr, "fatal error: '%s' exists and is not a socket\n", sock_path);
+      return FAIL;
+    }
+    unlink(sock_path);
+  }
+  int lfd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if(lfd < 0 || bind(lfd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(lfd, LISTEN_BACKLOG) != 0){
+    perror(sock_path);
+    if(lfd >= 0){
+      close(lfd);
+    }
+    return FAIL;
+  }
+
+  // stop on SIGINT/SIGTERM; no SA_RESTART, so the signal interrupts 'accept'. Clients that hang up must not kill us...
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = on_stop_signal;
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
+  signal(SIGPIPE, SIG_IGN);
+
+  Worker_t* p_workers = (Worker_t*)calloc((size_t)num_workers, sizeof(Worker_t));
+  if(p_workers == NULL){
+    fprintf(stderr, "fatal error: out of memory\n");
+    close(lfd);
+    unlink(sock_path);
+    return FAIL;
+  }
+  for(int i = 0; i < num_workers; ++i){
+    if(init_worker(&p_workers[i]) != SUCCESS || pthread_create(&p_workers[i]._thread, NULL, run_worker, &p_workers[i]) != 0){
+      fprintf(stderr, "fatal error: failed to start server worker %d\n", i);
+      close(lfd);
+      unlink(sock_path);
+      return FAIL; // the process exits; the started workers and their memory go with it.
+    }
+  }
+
+  // ...then accept connections until stopped.
+  while(!g_is_stopping){
+    int fd = accept(lfd, NULL, NULL);
+    if(fd < 0){
+      if(errno != EINTR){
+        perror("accept");
+      }
+      continue;
+    }
+    push_connection(fd);
+  }
+  close(lfd);
+  unlink(sock_path);
+  return SUCCESS; // the workers are torn down by process exit.
+}
+
+/*=====================================================================================================================
+ * CLIENT
+ *===================================================================================================================*/
+/*-------------------------------------------------------------------------------------------------------------------*/
+int client_request(const char* sock_path, const Request_t* p_req, Reply_t* p_reply){
+  struct sockaddr_un addr;
+  if(make_address(sock_path, &addr) != SUCCESS){
+    return FAIL;
+  }
+  memset(p_reply, 0, sizeof(Reply_t));
+  if(init_outbuf(&p_reply->_frame, 1 << 16) != SUCCESS){
+    fprintf(stderr, "fatal error: out of memory\n");
+    return FAIL;
+  }
+
+  // compose the request in the reply's buffer, which is then reused for the reply...
+  uint32_t name_len = (uint32_t)strlen(p_req->_name);
+  struct OutBuf* p_buf = &p_reply->_frame;
+  begin_frame(p_buf);
+  put_u32le(p_buf, p_req->_op | ((p_req->_p_src != NULL) ? SERVE_REQ_INLINE : 0));
+  put_u32le(p_buf, p_req->_emit);
+  put_u32le(p_buf, name_len);
+  outbuf_write(p_buf, p_req->_name, name_len);
+  put_u32le(p_buf, p_req->_src_len);
+  if(p_req->_src_len > 0){
+    outbuf_write(p_buf, p_req->_p_src, p_req->_src_len);
+  }
+  if(end_frame(p_buf) != SUCCESS || p_buf->_size - 4 > SERVE_MAX_FRAME){
+    fprintf(stderr, "fatal error: request for '%s' is too large\n", p_req->_name);
+    free_reply(p_reply);
+    return FAIL;
+  }
+
+  // ...exchange frames...
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if(fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0){
+    perror(sock_path);
+    if(fd >= 0){
+      close(fd);
+    }
+    free_reply(p_reply);
+    return FAIL;
+  }
+  signal(SIGPIPE, SIG_IGN);
+  int result = write_all(fd, p_buf->_p_data, p_buf->_size);
+  if(result == SUCCESS){
+    result = read_frame(fd, p_buf);
+  }
+  close(fd);
+  if(result != SUCCESS){
+    fprintf(stderr, "fatal error: no reply from server '%s'\n", sock_path);
+    free_reply(p_reply);
+    return FAIL;
+  }
+
+  // ...and decode the reply.
+  Reader_t r = {p_buf->_p_data, p_buf->_p_data + p_buf->_size, false};
+  p_reply->_status = read_u32(&r);
+  p_reply->_line_count = read_u32(&r);
+  p_reply->_ins_count = read_u32(&r);
+  p_reply->_var_count = read_u32(&r);
+  p_reply->_diag_len = read_u32(&r);
+  p_reply->_p_diag = read_bytes(&r, p_reply->_diag_len);
+  p_reply->_num_artifacts = read_u32(&r);
+  if(p_reply->_num_artifacts > NUM_EMIT_KINDS){
+    r._is_bad = true;
+  }
+  for(uint32_t a = 0; a < p_reply->_num_artifacts && !r._is_bad; ++a){
+    Artifact_t* p_art = &p_reply->_artifacts[a];
+    p_art->_kind = read_u32(&r);
+    p_art->_size = read_u32(&r);
+    p_art->_p_data = read_bytes(&r, p_art->_size);
+  }
+  if(r._is_bad){
+    fprintf(stderr, "fatal error: malformed reply from server '%s'\n", sock_path);
+    free_reply(p_reply);
+    return FAIL;
+  }
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void free_reply(Reply_t* p_reply){
+  free_outbuf(&p_reply->_frame);
+}
+/*-------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,122 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: server.h
+ *
+ *===================================================================================================================*/
+
+
+#ifndef _SERVER_H_
+#define _SERVER_H_
+
+#include <stdint.h>
+#include "outbuf.h"
+#include "emit.h"
+
+/*
+ * The assembler server answers requests sent over a unix domain socket by any number of clients; a client may send
+ * any number of requests on one connection. Each request and reply is a frame: a 32-bit length followed by that
+ * many bytes of body. All integers on the wire are 32-bit little endian.
+ *
+ *   request body:  op | emit | name_len | name[name_len] | src_len | src[src_len]
+ *   reply body:    status | commands | instructions | variables | diag_len | diag[diag_len] | num_artifacts |
+ *                  { kind | size | data[size] } * num_artifacts
+ *
+ * 'op' is a SERVE_OP_* id, or'd with SERVE_REQ_INLINE if the source is sent in the request; otherwise 'name' is a
+ * path the server reads and 'src_len' is 0. 'emit' selects the EMIT_* artifacts of SERVE_OP_ASSEMBLE. 'status' is
+ * 0 on success, 1 if the source has errors, which are then in 'diag' as the CLI would print them.
+ */
+#define SERVE_OP_ASSEMBLE     0x01
+#define SERVE_OP_STRIP        0x02   // reply holds one artifact of kind SERVE_KIND_STRIP, the output of the -s mode.
+#define SERVE_REQ_INLINE      0x100
+#define SERVE_KIND_STRIP      0x00
+#define SERVE_MAX_FRAME       (64u << 20)
+#define SERVE_MAX_NAME        4096
+
+/*
+ * brief: a request to the server.
+ */
+typedef struct Request {
+  uint32_t _op;
+  uint32_t _emit;
+  const char* _name;
+  const char* _p_src;     // source of an inline request, else NULL.
+  uint32_t _src_len;
+} Request_t;
+
+/*
+ * brief: an output in a reply; the data points into the reply frame.
+ */
+typedef struct Artifact {
+  uint32_t _kind;
+  uint32_t _size;
+  const char* _p_data;
+} Artifact_t;
+
+/*
+ * brief: a reply from the server; all pointers point into the frame, thus are valid until 'free_reply'.
+ */
+typedef struct Reply {
+  uint32_t _status;
+  uint32_t _line_count;
+  uint32_t _ins_count;
+  uint32_t _var_count;
+  const char* _p_diag;
+  uint32_t _diag_len;
+  uint32_t _num_artifacts;
+  Artifact_t _artifacts[NUM_EMIT_KINDS];
+  struct OutBuf _frame;
+} Reply_t;
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: runs the server on a socket at 'sock_path' until SIGINT or SIGTERM; requests are assembled by a pool of
+ *  'num_workers' threads, each with its own assembler that is reset, not reallocated, between requests.
+ * return: SUCCESS once stopped, or FAIL if the socket could not be created; errors are reported to stderr.
+ * note: an existing socket at 'sock_path' is replaced; any other existing file is not.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int serve(const char* sock_path, int num_workers);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: sends a request to the server at 'sock_path' and waits for its reply.
+ * return: SUCCESS if a reply was received, else FAIL; errors are reported to stderr.
+ * note: on SUCCESS, free the reply with 'free_reply'.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int client_request(const char* sock_path, const Request_t* p_req, Reply_t* p_reply);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void free_reply(Reply_t* p_reply);
+
+#endif
@@ -0,0 +1,365 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: sim.c
+ *
+ *===================================================================================================================*/
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+#include "assembler.h"
+#include "parser.h"
+#include "decoder.h"
+#include "asmerr.h"
+
+#define ADDRESS_MASK 0x7fff /* RAM and ROM addresses are 15-bit. */
+
+/*=====================================================================================================================
+ * PRIVATE INTERFACE
+ *===================================================================================================================*/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: predecodes instruction 'i' of a program; the flags of a jump depend on the instruction before it too.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void decode_op(SimOp_t* op, const uint16_t* p_rom, uint32_t i){
+  uint16_t w = p_rom[i];
+  if((w & 0x8000) == 0){
+    *op = (SimOp_t){._value = w, ._op = SIMOP_LOAD};
+    return;
+  }
+  int comp = decoder_comp_index(w);
+  op->_op = (comp >= 0) ? (uint8_t)comp : (w & 0x1000) ? SIMOP_ALU_M : SIMOP_ALU;
+  op->_value = (w >> 6) & 0x7f;
+  op->_dest = (w >> 3) & 0x7;
+  op->_jump = w & 0x7;
+  op->_flags = 0;
+  if(op->_dest == 0 && op->_jump != 0){
+    bool is_after_load = i > 0 && (p_rom[i - 1] & 0x8000) == 0 && p_rom[i - 1] == i - 1;
+    op->_flags = SIMFLAG_NO_EFFECT | (is_after_load ? SIMFLAG_AFTER_LOAD : 0);
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: clears what runs left at the addresses of the program; its profile counts and coverage marks.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void clear_marks(Sim_t* p_sim){
+  if(p_sim->_p_counts != NULL){
+    memset(p_sim->_p_counts, 0, (MAX_ADDRESS + 1) * sizeof(uint64_t));
+  }
+  memset(p_sim->_p_marks, 0, sizeof(SimMarks_t));
+}
+
+/*=====================================================================================================================
+ * PUBLIC INTERFACE
+ *===================================================================================================================*/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+Sim_t* new_sim(){
+  Sim_t* p_sim = (Sim_t*)calloc(1, sizeof(Sim_t));
+  if(p_sim == NULL){
+    return NULL;
+  }
+  p_sim->_p_ops = (SimOp_t*)malloc((MAX_ADDRESS + 1) * sizeof(SimOp_t));
+  p_sim->_p_rom = (uint16_t*)malloc(MAX_ADDRESS * sizeof(uint16_t));
+  p_sim->_p_ram = (uint16_t*)calloc(MAX_ADDRESS, sizeof(uint16_t));
+  p_sim->_p_marks = (SimMarks_t*)malloc(sizeof(SimMarks_t));
+  p_sim->_p_dirty = (uint8_t*)calloc(SIM_NUM_ROWS, 1);
+  if(p_sim->_p_ops == NULL || p_sim->_p_rom == NULL || p_sim->_p_ram == NULL || p_sim->_p_marks == NULL || 
+     p_sim->_p_dirty == NULL){
+    free_sim(&p_sim);
+    return NULL;
+  }
+  init_decoder();
+  sim_load(p_sim, NULL, 0);
+  return p_sim;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void free_sim(Sim_t** pp_sim){
+  free((*pp_sim)->_p_counts);
+  free((*pp_sim)->_p_marks);
+  free((*pp_sim)->_p_dirty);
+  free((*pp_sim)->_p_ops);
+  free((*pp_sim)->_p_rom);
+  free((*pp_sim)->_p_ram);
+  free(*pp_sim);
+  (*pp_sim) = NULL;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void sim_load(Sim_t* p_sim, const uint16_t* p_rom, uint32_t n){
+  for(uint32_t i = 0; i < n; ++i){
+    decode_op(&p_sim->_p_ops[i], p_rom, i);
+  }
+  for(uint32_t i = n; i <= MAX_ADDRESS; ++i){
+    p_sim->_p_ops[i] = (SimOp_t){._op = SIMOP_END};
+  }
+  memcpy(p_sim->_p_rom, p_rom, n * sizeof(uint16_t));
+  p_sim->_num_ins = n;
+  clear_marks(p_sim);
+  sim_reset(p_sim);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+uint32_t sim_patch(Sim_t* p_sim, const uint16_t* p_rom, uint32_t n){
+  const uint16_t* old = p_sim->_p_rom;
+  uint32_t num_old = p_sim->_num_ins, num_patched = 0;
+  for(uint32_t i = 0; i < n; ++i){
+    bool is_changed = i >= num_old || p_rom[i] != old[i];
+    if(is_changed || (i > 0 && (i - 1 >= num_old || p_rom[i - 1] != old[i - 1]))){
+      decode_op(&p_sim->_p_ops[i], p_rom, i);
+    }
+    num_patched += is_changed;
+  }
+  for(uint32_t i = n; i < num_old; ++i){
+    p_sim->_p_ops[i] = (SimOp_t){._op = SIMOP_END};
+  }
+  memcpy(p_sim->_p_rom, p_rom, n * sizeof(uint16_t));
+  p_sim->_num_ins = n;
+  clear_marks(p_sim);
+  return num_patched + ((num_old > n) ? num_old - n : 0);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void sim_reset(Sim_t* p_sim){
+  memset(p_sim->_p_ram, 0, MAX_ADDRESS * sizeof(uint16_t));
+  memset(p_sim->_p_dirty, 0, SIM_NUM_ROWS);
+  p_sim->_a = p_sim->_d = p_sim->_pc = 0;
+  p_sim->_cycles = 0;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void sim_save(const Sim_t* p_sim, SimState_t* p_state){
+  p_state->_a = p_sim->_a;
+  p_state->_d = p_sim->_d;
+  p_state->_pc = p_sim->_pc;
+  p_state->_cycles = p_sim->_cycles;
+  memcpy(p_state->_ram, p_sim->_p_ram, sizeof(p_state->_ram));
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void sim_restore(Sim_t* p_sim, const SimState_t* p_state){
+  p_sim->_a = p_state->_a;
+  p_sim->_d = p_state->_d;
+  p_sim->_pc = p_state->_pc;
+  p_sim->_cycles = p_state->_cycles;
+  memcpy(p_sim->_p_ram, p_state->_ram, sizeof(p_state->_ram));
+  memset(p_sim->_p_dirty, 1, SIM_NUM_ROWS);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * note: threaded dispatch; each handler ends by jumping straight to the handler of the next op through a table of
+ *  label addresses (a GCC extension), so there is no decode and no central switch per instruction. A C instruction
+ *  runs three handlers: its computation, its destination and its jump.
+ * note: as in the hardware, M is written and the jump taken at the A of before the instruction.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int sim_run(Sim_t* p_sim, uint64_t max_cycles){
+  static const void* comps[NUM_SIMOPS] = {
+    &&c_zero, &&c_one, &&c_neg1, &&c_d, &&c_a, &&c_notd, &&c_nota, &&c_negd, &&c_nega, &&c_dp1, &&c_ap1, &&c_dm1,
+    &&c_am1, &&c_dpa, &&c_dma, &&c_amd, &&c_danda, &&c_dora, &&c_m, &&c_notm, &&c_negm, &&c_mp1, &&c_mm1, &&c_dpm,
+    &&c_dmm, &&c_mmd, &&c_dandm, &&c_dorm, &&op_alu, &&op_alu_m, &&op_load, &&op_end
+  };
+  static const void* dests[8] = {&&d_null, &&d_m, &&d_d, &&d_md, &&d_a, &&d_am, &&d_ad, &&d_amd};
+  static const void* jumps[8] = {&&j_null, &&j_gt, &&j_eq, &&j_ge, &&j_lt, &&j_ne, &&j_le, &&j_mp};
+
+  uint64_t* counts = p_sim->_p_counts;
+  SimMarks_t* marks = p_sim->_p_marks;
+  uint8_t* dirty = p_sim->_p_dirty;
+  const SimOp_t* p_ops = p_sim->_p_ops;
+  const SimOp_t* op;
+  uint16_t* ram = p_sim->_p_ram;
+  uint16_t a = p_sim->_a, d = p_sim->_d, v = 0, t = 0, x, y;
+  uint32_t pc = p_sim->_pc;
+  uint64_t budget = (max_cycles == 0) ? UINT64_MAX : max_cycles, left = budget;
+  int status;
+
+#define NEXT() do{ if(left == 0){ status = SIM_LIMIT; goto stop; } --left; op = &p_ops[pc]; COUNT(); goto *comps[op->_op]; }while(0)
+#define COUNT() do{ if(__builtin_expect(counts != NULL, 0)){ ++counts[pc]; } }while(0)
+#define COMP(X) do{ v = (uint16_t)(X); goto *dests[op->_dest]; }while(0)
+#define M ram[a & ADDRESS_MASK]
+#define STORE() do{ M = v; dirty[(a & ADDRESS_MASK) >> SIM_ROW_SHIFT] = 1; }while(0)
+
+  uint32_t block = pc; // where the run entered the instructions it runs up to a jump.
+  marks->_entered[pc] = 1;
+  NEXT();
+
+  // computations...
+c_zero:   COMP(0);
+c_one:    COMP(1);
+c_neg1:   COMP(0xffff);
+c_d:      COMP(d);
+c_a:      COMP(a);
+c_notd:   COMP(~d);
+c_nota:   COMP(~a);
+c_negd:   COMP(-d);
+c_nega:   COMP(-a);
+c_dp1:    COMP(d + 1);
+c_ap1:    COMP(a + 1);
+c_dm1:    COMP(d - 1);
+c_am1:    COMP(a - 1);
+c_dpa:    COMP(d + a);
+c_dma:    COMP(d - a);
+c_amd:    COMP(a - d);
+c_danda:  COMP(d & a);
+c_dora:   COMP(d | a);
+c_m:      COMP(M);
+c_notm:   COMP(~M);
+c_negm:   COMP(-M);
+c_mp1:    COMP(M + 1);
+c_mm1:    COMP(M - 1);
+c_dpm:    COMP(d + M);
+c_dmm:    COMP(d - M);
+c_mmd:    COMP(M - d);
+c_dandm:  COMP(d & M);
+c_dorm:   COMP(d | M);
+op_alu:
+  y = a;
+  goto alu;
+op_alu_m:
+  y = M;
+alu:      // the zx, nx, zy, ny, f and no bits of the ALU, from the high bit down.
+  x = (op->_value & 0x20) ? 0 : d;
+  x = (op->_value & 0x10) ? ~x : x;
+  y = (op->_value & 0x08) ? 0 : y;
+  y = (op->_value & 0x04) ? ~y : y;
+  v = (op->_value & 0x02) ? x + y : x & y;
+  COMP((op->_value & 0x01) ? ~v : v);
+op_load:
+  a = op->_value;
+  ++pc;
+  NEXT();
+op_end:
+  ++left; // not an instruction.
+  status = SIM_ENDED;
+  goto stop;
+
+  // destinations; t keeps the A of before the instruction, the jump target...
+d_null:   t = a;                          goto *jumps[op->_jump];
+d_m:      t = a; STORE();                 goto *jumps[op->_jump];
+d_d:      t = a; d = v;                   goto *jumps[op->_jump];
+d_md:     t = a; STORE(); d = v;          goto *jumps[op->_jump];
+d_a:      t = a; a = v;                   goto *jumps[op->_jump];
+d_am:     t = a; STORE(); a = v;          goto *jumps[op->_jump];
+d_ad:     t = a; a = v; d = v;            goto *jumps[op->_jump];
+d_amd:    t = a; STORE(); a = v; d = v;   goto *jumps[op->_jump];
+
+  // jumps...
+j_null:   ++pc; NEXT();
+j_gt:     if((int16_t)v > 0){ goto take; }  goto fall;
+j_eq:     if(v == 0){ goto take; }          goto fall;
+j_ge:     if((int16_t)v >= 0){ goto take; } goto fall;
+j_lt:     if((int16_t)v < 0){ goto take; }  goto fall;
+j_ne:     if(v != 0){ goto take; }          goto fall;
+j_le:     if((int16_t)v <= 0){ goto take; } goto fall;
+j_mp:     goto take;
+fall:
+  marks->_fell[pc] = 1;
+  block = ++pc;
+  NEXT();
+take:
+  marks->_taken[pc] = 1;
+  t &= ADDRESS_MASK;
+  if(op->_flags != 0 && (t == pc || ((uint32_t)t + 1 == pc && (op->_flags & SIMFLAG_AFTER_LOAD)))){
+    pc = t;
+    status = SIM_HALTED;
+    goto stop;
+  }
+  pc = block = t;
+  marks->_entered[pc] = 1;
+  NEXT();
+
+#undef NEXT
+#undef COUNT
+#undef COMP
+#undef M
+#undef STORE
+
+stop:
+  if(status != SIM_HALTED){
+    memset(&marks->_ran[block], 1, pc - block);
+  }
+  p_sim->_a = a;
+  p_sim->_d = d;
+  p_sim->_pc = (uint16_t)pc;
+  p_sim->_cycles += budget - left;
+  return status;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int sim_profile(Sim_t* p_sim){
+  if(p_sim->_p_counts == NULL && (p_sim->_p_counts = (uint64_t*)calloc(MAX_ADDRESS + 1, sizeof(uint64_t))) == NULL){
+    return FAIL;
+  }
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void sim_coverage(const Sim_t* p_sim, SimCoverage_t* p_cov){
+  const SimMarks_t* marks = p_sim->_p_marks;
+  uint32_t n = p_sim->_num_ins;
+  for(uint32_t b = 0; b < n; ){
+    // a block runs from b to its jump, or to the last instruction...
+    uint32_t e = b;
+    while(p_sim->_p_ops[e]._jump == 0 && e + 1 < n){
+      ++e;
+    }
+    uint32_t first = e + 1;
+    if(marks->_taken[e] || marks->_fell[e]){
+      for(first = b; first < e && !marks->_entered[first] && !(first > 0 && marks->_fell[first - 1]); ++first){}
+    }
+    for(uint32_t i = b; i <= e; ++i){
+      if(i >= first || marks->_ran[i]){
+        p_cov->_executed[i >> 6] |= (uint64_t)1 << (i & 63);
+      }
+    }
+    if(marks->_taken[e]){
+      p_cov->_taken[e >> 6] |= (uint64_t)1 << (e & 63);
+    }
+    b = e + 1;
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void sim_set_key(Sim_t* p_sim, uint16_t key){
+  p_sim->_p_ram[SIM_KBD_ADDRESS] = key;
+  p_sim->_p_dirty[SIM_KBD_ADDRESS >> SIM_ROW_SHIFT] = 1;
+}
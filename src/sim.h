@@ -0,0 +1,266 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: sim.h
+ *
+ *===================================================================================================================*/
+
+
+#ifndef _SIM_H_
+#define _SIM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SIM_SCREEN_ADDRESS 16384 // the memory map of the Hack platform.
+#define SIM_KBD_ADDRESS    24576
+#define SIM_RAM_WORDS      32768 // RAM addresses are 15-bit.
+#define SIM_ROW_SHIFT      5     // a row of the screen is 32 words, 512 pixels; the leftmost is bit 0 of a word.
+#define SIM_ROW_WORDS      (1 << SIM_ROW_SHIFT)
+#define SIM_SCREEN_ROWS    256
+#define SIM_NUM_ROWS       (SIM_RAM_WORDS / SIM_ROW_WORDS) // rows of RAM, of the screen and of the rest.
+
+/*
+ * ids of the reasons a run stops.
+ */
+#define SIM_HALTED 0xd0 // the program reached a loop that cannot exit, e.g. '(END) @END 0;JMP'.
+#define SIM_ENDED  0xd1 // the program ran past its last instruction.
+#define SIM_LIMIT  0xd2 // the cycle limit was reached.
+
+/*
+ * ids of the handlers of predecoded instructions; SimOp_t::_op. The handlers of C instructions with a computation
+ * mnemonic come first, in the order of the mnemonic indices of the decoder, so the index is the handler id.
+ */
+#define SIMOP_ALU   28 // C instruction with a computation that is not a mnemonic.
+#define SIMOP_ALU_M 29 // as SIMOP_ALU, with the a bit set, i.e. the y input of the ALU is M.
+#define SIMOP_LOAD  30 // A instruction.
+#define SIMOP_END   31 // past the last instruction of the program.
+#define NUM_SIMOPS  32
+
+/*
+ * flags of jumps that cannot change the state of the CPU; SimOp_t::_flags.
+ */
+#define SIMFLAG_NO_EFFECT  0x01 // a jump with no destination; taken to itself it spins forever.
+#define SIMFLAG_AFTER_LOAD 0x02 // also follows '@' of its own address minus one; taken there it spins forever.
+
+#define SIM_COVER_WORDS 512 // words of a coverage bitmap; a bit for each of the 32K ROM addresses.
+#define SIM_MARK_BYTES  (SIM_COVER_WORDS * 64 + 1)
+
+/*
+ * brief: the coverage of runs of a program; bitmaps of the ROM addresses of the instructions executed and of the
+ *  jumps taken, the bit of an address is bit (address % 64) of word (address / 64).
+ *
+ * note: the coverages of runs of the same program merge by OR, see 'coverage_merge'.
+ */
+typedef struct SimCoverage {
+  uint64_t _executed[SIM_COVER_WORDS];
+  uint64_t _taken[SIM_COVER_WORDS];
+} SimCoverage_t;
+
+/*
+ * brief: the marks runs leave for their coverage, a byte per ROM address and one for the address past it; left only
+ *  where control does not pass to the next instruction, so a run pays a store per jump and nothing per instruction.
+ *
+ * @member _entered: addresses entered other than from the instruction before them; the targets of jumps taken, and
+ *  the addresses runs start at.
+ * @member _taken, _fell: the jumps taken, and the conditional jumps not taken.
+ * @member _ran: the instructions executed by runs in the blocks they stopped part way through, on reaching their
+ *  cycle limit or the end.
+ */
+typedef struct SimMarks {
+  uint8_t _entered[SIM_MARK_BYTES];
+  uint8_t _taken[SIM_MARK_BYTES];
+  uint8_t _fell[SIM_MARK_BYTES];
+  uint8_t _ran[SIM_MARK_BYTES];
+} SimMarks_t;
+
+/*
+ * brief: the state of a simulator, all a run depends on but its program; taken with 'sim_save' and put back with
+ *  'sim_restore'.
+ */
+typedef struct SimState {
+  uint16_t _a;
+  uint16_t _d;
+  uint16_t _pc;
+  uint64_t _cycles;
+  uint16_t _ram[SIM_RAM_WORDS];
+} SimState_t;
+
+/*
+ * brief: a predecoded instruction.
+ *
+ * @member _value: the value of an A instruction; the a and c bits of a C instruction, 0 to 0x7f.
+ * @member _op: the SIMOP_* id, or the computation mnemonic index, of the handler of the instruction.
+ * @member _dest, _jump: the d and j bits of a C instruction.
+ * @member _flags: SIMFLAG_* of a C instruction.
+ */
+typedef struct SimOp {
+  uint16_t _value;
+  uint8_t _op;
+  uint8_t _dest;
+  uint8_t _jump;
+  uint8_t _flags;
+} SimOp_t;
+
+/*
+ * brief: a Hack CPU with its ROM and RAM; instantiate with 'new_sim'.
+ *
+ * @member _p_ops: the ROM, predecoded; MAX_ADDRESS + 1 ops, those past the program stop the run.
+ * @member _p_rom: the Hack machine instructions of the program, as loaded or patched.
+ * @member _p_ram: the 32K words of RAM; the SCREEN and KBD memory maps included.
+ * @member _a, _d, _pc: the registers.
+ * @member _cycles: number of instructions executed since the last reset.
+ * @member _num_ins: number of instructions of the loaded program.
+ * @member _p_counts: with profiling on, the number of times each instruction was executed since the program was
+ *  loaded; else NULL.
+ * @member _p_marks: the marks of the runs since the program was loaded, always left; see 'sim_coverage'.
+ * @member _p_dirty: a byte for each row of RAM, set by each store to the row; rows of 32 words, so those of the
+ *  screen are rows SIM_SCREEN_ADDRESS / SIM_ROW_WORDS on. Cleared by reset, and by whoever takes the rows.
+ *
+ * note: the registers and RAM may be read and written between runs; a write to RAM sets the byte of its row in
+ *  _p_dirty, as a store would.
+ */
+typedef struct Sim {
+  SimOp_t* _p_ops;
+  uint16_t* _p_rom;
+  uint16_t* _p_ram;
+  uint16_t _a;
+  uint16_t _d;
+  uint16_t _pc;
+  uint64_t _cycles;
+  uint32_t _num_ins;
+  uint64_t* _p_counts;
+  SimMarks_t* _p_marks;
+  uint8_t* _p_dirty;
+} Sim_t;
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: instantiates a new simulator, with an empty program.
+ * return: pointer to the new simulator or NULL on error.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+Sim_t* new_sim();
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void free_sim(Sim_t** pp_sim);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: loads a program into ROM, predecoding each instruction once, and resets the simulator.
+ * @param p_rom: the Hack machine instructions of the program, e.g. Assembler_t::_p_hackins.
+ * @param n: number of instructions; at most MAX_ADDRESS.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+void sim_load(Sim_t* p_sim, const uint16_t* p_rom, uint32_t n);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: replaces the program in ROM with another, e.g. a new version of it, keeping the registers and RAM; only the
+ *  instructions that differ are predecoded again.
+ * @param p_rom: the Hack machine instructions of the program.
+ * @param n: number of instructions; at most MAX_ADDRESS.
+ * return: the number of instructions that differ.
+ *
+ * note: the profile counts and coverage marks of the old program are cleared; _pc is left for the caller to remap.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+uint32_t sim_patch(Sim_t* p_sim, const uint16_t* p_rom, uint32_t n);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: clears the registers, RAM, cycle count and dirty rows; the reset of the Hack computer.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+void sim_reset(Sim_t* p_sim);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: copies the registers, cycle count and RAM of a simulator into a state.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+void sim_save(const Sim_t* p_sim, SimState_t* p_state);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: puts a simulator in a state saved of a run of the same program; runs continue from it as from the run.
+ *
+ * note: the state is only read, so a state may be restored into any number of simulators at once, e.g. to run tests
+ *  from a common checkpoint on several threads.
+ * note: every row of RAM is then dirty.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+void sim_restore(Sim_t* p_sim, const SimState_t* p_state);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: runs the program from the current state until it halts, ends or has run 'max_cycles' instructions.
+ * @param max_cycles: most instructions to run; 0 for no limit.
+ * return: SIM_HALTED, SIM_ENDED or SIM_LIMIT.
+ *
+ * note: a halt is detected when a jump without a destination is taken to itself, or to an '@' of its own address
+ *  just before it; the state cannot change, so the program would spin forever. _pc is left at the loop.
+ * note: may be called again after SIM_LIMIT to continue the run.
+ * note: a store costs one more byte store, to _p_dirty, unconditionally; cheaper than telling the screen apart.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int sim_run(Sim_t* p_sim, uint64_t max_cycles);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: turns on profiling; from then on runs count the executions of each instruction in _p_counts.
+ * return: SUCCESS, or FAIL on malloc error.
+ *
+ * note: runs without profiling pay only a predicted branch per instruction for it.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int sim_profile(Sim_t* p_sim);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: merges the coverage of the runs since the program was loaded into a coverage, by OR.
+ *
+ * note: the instructions executed are found from the marks of the runs; those from the first address entered before
+ *  a jump to the jump are executed if the jump was. So of a block a run stopped part way through, the instructions
+ *  before the address another run entered it at count as executed if that run reached the jump.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+void sim_coverage(const Sim_t* p_sim, SimCoverage_t* p_cov);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: sets the key code read from the KBD memory map; 0 for no key.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+void sim_set_key(Sim_t* p_sim, uint16_t key);
+
+#endif
@@ -0,0 +1,281 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: snapshot.c
+ *
+ *===================================================================================================================*/
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "snapshot.h"
+#include "outbuf.h"
+#include "hash.h"
+#include "asmerr.h"
+
+#define HEADER_BYTES 36
+#define SPAN_BYTES   4 // the header of a span; its address and number of words.
+
+/*
+ * brief: a ring of the states of a run, oldest first.
+ *
+ * @member _first: index of the oldest state.
+ * @member _num_states: number of states kept; at most HISTORY_STATES.
+ */
+struct History {
+  SimState_t* _p_states;
+  uint32_t _first;
+  uint32_t _num_states;
+};
+
+/*=====================================================================================================================
+ * PRIVATE INTERFACE
+ *===================================================================================================================*/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void put_u16le(struct OutBuf* p_buf, uint16_t v){
+  char b[2] = {(char)v, (char)(v >> 8)};
+  outbuf_write(p_buf, b, 2);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void put_u32le(struct OutBuf* p_buf, uint32_t v){
+  char b[4] = {(char)v, (char)(v >> 8), (char)(v >> 16), (char)(v >> 24)};
+  outbuf_write(p_buf, b, 4);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void put_u64le(struct OutBuf* p_buf, uint64_t v){
+  put_u32le(p_buf, (uint32_t)v);
+  put_u32le(p_buf, (uint32_t)(v >> 32));
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static uint16_t get_u16le(const uint8_t* b){
+  return (uint16_t)(b[0] | (b[1] << 8));
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static uint32_t get_u32le(const uint8_t* b){
+  return (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static uint64_t get_u64le(const uint8_t* b){
+  return get_u32le(b) | ((uint64_t)get_u32le(b + 4) << 32);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: the end of the span of RAM words not 0 starting at 'first'; the span takes in runs of 0 too short to be
+ *  worth the header of another span.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static uint32_t span_end(const uint16_t* p_ram, uint32_t first){
+  uint32_t end = first;
+  for(uint32_t i = first; i < SIM_RAM_WORDS && i - end <= SPAN_BYTES / 2; ++i){
+    end = (p_ram[i] != 0) ? i + 1 : end;
+  }
+  return end;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static SimState_t* newest(History_t* p_hist){
+  return &p_hist->_p_states[(p_hist->_first + p_hist->_num_states - 1) % HISTORY_STATES];
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: saves the state of a simulator in a history, over its oldest state if it is full.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void save_state(History_t* p_hist, const Sim_t* p_sim){
+  if(p_hist->_num_states == HISTORY_STATES){
+    p_hist->_first = (p_hist->_first + 1) % HISTORY_STATES;
+    --p_hist->_num_states;
+  }
+  ++p_hist->_num_states;
+  sim_save(p_sim, newest(p_hist));
+}
+
+/*=====================================================================================================================
+ * PUBLIC INTERFACE
+ *===================================================================================================================*/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int snapshot_write(const SimState_t* p_state, const uint16_t* p_rom, uint32_t n, struct OutBuf* p_out){
+  const uint16_t* ram = p_state->_ram;
+  uint32_t num_spans = 0, num_words = 0;
+  for(uint32_t i = 0; i < SIM_RAM_WORDS; ++i){
+    if(ram[i] != 0){
+      uint32_t end = span_end(ram, i);
+      ++num_spans;
+      num_words += end - i;
+      i = end;
+    }
+  }
+  if(outbuf_reserve(p_out, HEADER_BYTES + SPAN_BYTES * (size_t)num_spans + 2 * (size_t)num_words) != SUCCESS){
+    return FAIL;
+  }
+  outbuf_write(p_out, SNAPSHOT_MAGIC, 4);
+  put_u16le(p_out, SNAPSHOT_VERSION);
+  put_u16le(p_out, p_state->_a);
+  put_u16le(p_out, p_state->_d);
+  put_u16le(p_out, p_state->_pc);
+  put_u32le(p_out, n);
+  put_u64le(p_out, hash_xxh64(p_rom, n * sizeof(uint16_t), 0));
+  put_u64le(p_out, p_state->_cycles);
+  put_u32le(p_out, num_spans);
+  for(uint32_t i = 0; i < SIM_RAM_WORDS; ++i){
+    if(ram[i] != 0){
+      uint32_t end = span_end(ram, i);
+      put_u16le(p_out, (uint16_t)i);
+      put_u16le(p_out, (uint16_t)(end - i));
+      for(; i < end; ++i){
+        put_u16le(p_out, ram[i]);
+      }
+    }
+  }
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int snapshot_read(SimState_t* p_state, const uint16_t* p_rom, uint32_t n, const char* p_data, size_t size){
+  const uint8_t* b = (const uint8_t*)p_data, *end = b + size;
+  if(size < HEADER_BYTES || memcmp(b, SNAPSHOT_MAGIC, 4) != 0 || get_u16le(b + 4) != SNAPSHOT_VERSION){
+    return FAIL;
+  }
+  p_state->_a = get_u16le(b + 6);
+  p_state->_d = get_u16le(b + 8);
+  p_state->_pc = get_u16le(b + 10);
+  p_state->_cycles = get_u64le(b + 24);
+  memset(p_state->_ram, 0, sizeof(p_state->_ram));
+  uint32_t num_spans = get_u32le(b + 32);
+  const uint8_t* s = b + HEADER_BYTES;
+  for(uint32_t i = 0; i < num_spans; ++i){
+    if(end - s < SPAN_BYTES){
+      return FAIL;
+    }
+    uint32_t address = get_u16le(s), num_words = get_u16le(s + 2);
+    s += SPAN_BYTES;
+    if(address + num_words > SIM_RAM_WORDS || (size_t)(end - s) < 2 * (size_t)num_words){
+      return FAIL;
+    }
+    for(uint32_t w = 0; w < num_words; ++w, s += 2){
+      p_state->_ram[address + w] = get_u16le(s);
+    }
+  }
+  if(s != end){
+    return FAIL;
+  }
+  if(get_u32le(b + 12) != n || get_u64le(b + 16) != hash_xxh64(p_rom, n * sizeof(uint16_t), 0)){
+    return ERROR_1;
+  }
+  if(p_state->_pc > n){
+    return FAIL; // the run can only be at an instruction of the program, or just past its end.
+  }
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+History_t* new_history(){
+  History_t* p_hist = (History_t*)calloc(1, sizeof(History_t));
+  if(p_hist == NULL){
+    return NULL;
+  }
+  if((p_hist->_p_states = (SimState_t*)malloc(HISTORY_STATES * sizeof(SimState_t))) == NULL){
+    free(p_hist);
+    return NULL;
+  }
+  return p_hist;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void free_history(History_t** pp_hist){
+  free((*pp_hist)->_p_states);
+  free(*pp_hist);
+  (*pp_hist) = NULL;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int history_run(History_t* p_hist, Sim_t* p_sim, uint64_t max_cycles){
+  if(p_hist->_num_states > 0 && newest(p_hist)->_cycles > p_sim->_cycles){ // the simulator was reset since.
+    p_hist->_num_states = 0;
+  }
+  uint64_t left = max_cycles;
+  while(true){
+    if(p_hist->_num_states == 0 || 
+       (p_sim->_cycles % HISTORY_INTERVAL == 0 && newest(p_hist)->_cycles != p_sim->_cycles)){
+      save_state(p_hist, p_sim);
+    }
+    // run to the next multiple of the interval, or to the limit...
+    uint64_t slice = HISTORY_INTERVAL - p_sim->_cycles % HISTORY_INTERVAL;
+    if(max_cycles != 0 && slice >= left){
+      return sim_run(p_sim, left);
+    }
+    int status = sim_run(p_sim, slice);
+    if(status != SIM_LIMIT){
+      return status;
+    }
+    left -= (max_cycles != 0) ? slice : 0;
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+uint64_t history_reach(const History_t* p_hist, const Sim_t* p_sim){
+  if(p_hist->_num_states == 0){
+    return 0;
+  }
+  return p_sim->_cycles - p_hist->_p_states[p_hist->_first]._cycles;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int history_rewind(History_t* p_hist, Sim_t* p_sim, uint64_t cycles){
+  if(cycles > history_reach(p_hist, p_sim)){
+    return FAIL;
+  }
+  uint64_t target = p_sim->_cycles - cycles;
+  while(newest(p_hist)->_cycles > target){
+    --p_hist->_num_states;
+  }
+  const SimState_t* p_state = newest(p_hist);
+  sim_restore(p_sim, p_state);
+  if(target > p_state->_cycles){
+    uint64_t* p_counts = p_sim->_p_counts;
+    p_sim->_p_counts = NULL;
+    sim_run(p_sim, target - p_state->_cycles);
+    p_sim->_p_counts = p_counts;
+  }
+  return SUCCESS;
+}
@@ -0,0 +1,128 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: snapshot.h
+ *
+ *===================================================================================================================*/
+
+
+#ifndef _SNAPSHOT_H_
+#define _SNAPSHOT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sim.h"
+
+#define SNAPSHOT_MAGIC "HSNP"
+#define SNAPSHOT_VERSION 1
+
+#define HISTORY_STATES   64        // states kept by a history; see 'new_history'.
+#define HISTORY_INTERVAL (1 << 22) // cycles between the states of a history.
+
+struct OutBuf;
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: closed type of the recent states of a run, kept to step it backwards; instantiate with 'new_history'.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+typedef struct History History_t;
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: appends the binary form of a state of a program to a buffer, a snapshot; little-endian,
+ *
+ *    magic "HSNP", u16 version, u16 A, u16 D, u16 PC, u32 number of instructions, u64 XXH64 of the instructions,
+ *    u64 cycles, u32 number of spans, then the spans of RAM words not 0; u16 address, u16 n, n u16 words each.
+ *
+ * @param p_rom: the 'n' Hack machine instructions of the program.
+ * return: SUCCESS, or FAIL if the buffer could not grow.
+ *
+ * note: spans of words not 0 are split only at runs of 0 longer than their header, so the RAM of a program that has
+ *  cleared the screen costs little more than the words it wrote.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int snapshot_write(const SimState_t* p_state, const uint16_t* p_rom, uint32_t n, struct OutBuf* p_out);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: reads a state from a snapshot of a program written by 'snapshot_write'.
+ * @param p_rom: the 'n' Hack machine instructions of the program.
+ * @param p_data: the 'size' bytes of the snapshot.
+ * return: SUCCESS, ERROR_1 if the snapshot is of another program, or FAIL if the data is not a snapshot, e.g. its pc 
+ *  is past the end of the program.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int snapshot_read(SimState_t* p_state, const uint16_t* p_rom, uint32_t n, const char* p_data, size_t size);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: creates an empty history, a ring of HISTORY_STATES states.
+ * return: pointer to the new history or NULL on error.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+History_t* new_history();
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void free_history(History_t** pp_hist);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: as 'sim_run', but saves the state of the simulator in the history every HISTORY_INTERVAL cycles, so the
+ *  run can be stepped backwards by 'history_rewind'; the oldest state is overwritten when the ring is full.
+ *
+ * note: a state is a copy of 64K of RAM, so saving them costs about a memcpy per HISTORY_INTERVAL cycles.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int history_run(History_t* p_hist, Sim_t* p_sim, uint64_t max_cycles);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: the most cycles a simulator can be stepped back by 'history_rewind'; those since the oldest state kept.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+uint64_t history_reach(const History_t* p_hist, const Sim_t* p_sim);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: puts a simulator back in the state it was in a number of cycles before; restores the latest state of the
+ *  history at or before that cycle, then runs forward to it.
+ * @param cycles: cycles to step back; at most 'history_reach'.
+ * return: SUCCESS, or FAIL if the state is older than the history reaches.
+ *
+ * note: the instructions run again are not counted by the profile; the coverage is unchanged, as they ran before.
+ * note: the states later than the one stepped back to are dropped; a run continued from there saves new ones.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int history_rewind(History_t* p_hist, Sim_t* p_sim, uint64_t cycles);
+
+#endif
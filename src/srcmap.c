@@ -0,0 +1,260 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: srcmap.c
+ *
+ *===================================================================================================================*/
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "srcmap.h"
+#include "assembler.h"
+#include "parser.h"
+#include "symbollib.h"
+#include "outbuf.h"
+#include "asmerr.h"
+
+#define MAX_LABEL_NAME 255 // the name length of a label is a byte in the binary form.
+
+static __thread const char* g_sort_names; // names of the labels being sorted, for 'compare_labels'.
+
+/*=====================================================================================================================
+ * PRIVATE INTERFACE
+ *===================================================================================================================*/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: grows the per instruction arrays, if required, to hold 'n' instructions.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int reserve_ins(SrcMap_t* p_map, uint32_t n){
+  if(n <= p_map->_capacity){
+    return SUCCESS;
+  }
+  uint32_t* p_lines = (uint32_t*)realloc(p_map->_p_lines, (size_t)n * sizeof(uint32_t));
+  if(p_lines == NULL){
+    return FAIL;
+  }
+  p_map->_p_lines = p_lines;
+  uint32_t* p_labels = (uint32_t*)realloc(p_map->_p_labels, (size_t)n * sizeof(uint32_t));
+  if(p_labels == NULL){
+    return FAIL;
+  }
+  p_map->_p_labels = p_labels;
+  p_map->_capacity = n;
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: symbol visitor; adds the labels of a symbol library to the label table. Sets _num_labels to UINT32_MAX on 
+ *  malloc error.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void collect_label(const char* sym, uint16_t address, uint8_t tag, void* p_ctx){
+  SrcMap_t* p_map = (SrcMap_t*)p_ctx;
+  if(tag != SYMTAG_LABEL || p_map->_num_labels == UINT32_MAX){
+    return;
+  }
+  if(p_map->_num_labels == p_map->_label_capacity){
+    uint32_t capacity = (p_map->_label_capacity == 0) ? 64 : p_map->_label_capacity * 2;
+    SrcLabel_t* p_table = (SrcLabel_t*)realloc(p_map->_p_label_table, capacity * sizeof(SrcLabel_t));
+    if(p_table == NULL){
+      p_map->_num_labels = UINT32_MAX;
+      return;
+    }
+    p_map->_p_label_table = p_table;
+    p_map->_label_capacity = capacity;
+  }
+  size_t l = strlen(sym);
+  SrcLabel_t* p_label = &p_map->_p_label_table[p_map->_num_labels];
+  p_label->_name = (uint32_t)p_map->_names._size;
+  p_label->_address = address;
+  if(outbuf_write(&p_map->_names, sym, (l > MAX_LABEL_NAME) ? MAX_LABEL_NAME : l) != SUCCESS ||
+     outbuf_putc(&p_map->_names, '\0') != SUCCESS){
+    p_map->_num_labels = UINT32_MAX;
+    return;
+  }
+  ++p_map->_num_labels;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int compare_labels(const void* p_a, const void* p_b){
+  const SrcLabel_t* a = (const SrcLabel_t*)p_a, *b = (const SrcLabel_t*)p_b;
+  if(a->_address != b->_address){
+    return (a->_address < b->_address) ? -1 : 1;
+  }
+  return strcmp(g_sort_names + a->_name, g_sort_names + b->_name);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int put_u16le(struct OutBuf* p_buf, uint16_t v){
+  char b[2] = {(char)v, (char)(v >> 8)};
+  return outbuf_write(p_buf, b, 2);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int put_u32le(struct OutBuf* p_buf, uint32_t v){
+  char b[4] = {(char)v, (char)(v >> 8), (char)(v >> 16), (char)(v >> 24)};
+  return outbuf_write(p_buf, b, 4);
+}
+
+/*=====================================================================================================================
+ * PUBLIC INTERFACE
+ *===================================================================================================================*/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+SrcMap_t* new_srcmap(){
+  SrcMap_t* p_map = (SrcMap_t*)calloc(1, sizeof(SrcMap_t));
+  if(p_map == NULL){
+    return NULL;
+  }
+  if(init_outbuf(&p_map->_names, 1 << 10) != SUCCESS){
+    free(p_map);
+    return NULL;
+  }
+  return p_map;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void free_srcmap(SrcMap_t** pp_map){
+  free((*pp_map)->_p_lines);
+  free((*pp_map)->_p_labels);
+  free((*pp_map)->_p_label_table);
+  free_outbuf(&(*pp_map)->_names);
+  free(*pp_map);
+  (*pp_map) = NULL;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int srcmap_build(SrcMap_t* p_map, const Assembler_t* p){
+  uint32_t n = p->_ins_count;
+  p_map->_num_ins = 0;
+  p_map->_num_labels = 0;
+  outbuf_clear(&p_map->_names);
+  if(reserve_ins(p_map, n + 1) != SUCCESS){
+    return FAIL;
+  }
+  symlib_foreach(p->_p_sym_lib, collect_label, p_map);
+  if(p_map->_num_labels == UINT32_MAX){
+    p_map->_num_labels = 0;
+    return FAIL;
+  }
+  g_sort_names = p_map->_names._p_data;
+  qsort(p_map->_p_label_table, p_map->_num_labels, sizeof(SrcLabel_t), compare_labels);
+
+  memset(p_map->_p_lines, 0, (size_t)n * sizeof(uint32_t));
+  uint32_t in = 0;
+  for(uint32_t cn = 0; cn < p->_line_count && in < n; ++cn){
+    int type = p->_p_cmds[cn]._type;
+    if(type == CFORMAT_A1 || type == CFORMAT_C0 || type == CFORMAT_C1 || type == CFORMAT_C2){
+      p_map->_p_lines[in++] = p->_p_cmds[cn]._lineno;
+    }
+  }
+  uint32_t label = 0, current = SRCMAP_NO_LABEL;
+  for(uint32_t i = 0; i < n; ++i){
+    while(label < p_map->_num_labels && p_map->_p_label_table[label]._address <= i){
+      current = label++; // of labels at the same address, an instruction follows the last.
+    }
+    p_map->_p_labels[i] = current;
+  }
+  p_map->_num_ins = n;
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+const char* srcmap_label(const SrcMap_t* p_map, uint32_t address){
+  if(address >= p_map->_num_ins || p_map->_p_labels[address] == SRCMAP_NO_LABEL){
+    return NULL;
+  }
+  return p_map->_names._p_data + p_map->_p_label_table[p_map->_p_labels[address]]._name;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int srcmap_find_line(const SrcMap_t* p_map, uint32_t line, uint32_t* p_address){
+  uint32_t lo = 0, hi = p_map->_num_ins;
+  while(lo < hi){
+    uint32_t mid = lo + (hi - lo) / 2;
+    if(p_map->_p_lines[mid] < line){
+      lo = mid + 1;
+    }
+    else{
+      hi = mid;
+    }
+  }
+  if(line == 0 || lo == p_map->_num_ins || p_map->_p_lines[lo] != line){
+    return FAIL;
+  }
+  *p_address = lo;
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int srcmap_find_label(const SrcMap_t* p_map, const char* name, uint32_t* p_address){
+  for(uint32_t l = 0; l < p_map->_num_labels; ++l){
+    if(strcmp(p_map->_names._p_data + p_map->_p_label_table[l]._name, name) == 0){
+      *p_address = p_map->_p_label_table[l]._address;
+      return SUCCESS;
+    }
+  }
+  return FAIL;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int srcmap_write(const SrcMap_t* p_map, struct OutBuf* p_out){
+  int result = outbuf_write(p_out, SRCMAP_MAGIC, 4);
+  result = (result == SUCCESS) ? put_u16le(p_out, SRCMAP_VERSION) : result;
+  result = (result == SUCCESS) ? put_u16le(p_out, 0) : result;
+  result = (result == SUCCESS) ? put_u32le(p_out, p_map->_num_ins) : result;
+  result = (result == SUCCESS) ? put_u32le(p_out, p_map->_num_labels) : result;
+  for(uint32_t l = 0; l < p_map->_num_labels && result == SUCCESS; ++l){
+    const char* name = p_map->_names._p_data + p_map->_p_label_table[l]._name;
+    size_t n = strlen(name);
+    result = put_u16le(p_out, p_map->_p_label_table[l]._address);
+    result = (result == SUCCESS) ? outbuf_putc(p_out, (char)n) : result;
+    result = (result == SUCCESS) ? outbuf_write(p_out, name, n) : result;
+  }
+  uint32_t line = 0;
+  for(uint32_t i = 0; i < p_map->_num_ins && result == SUCCESS; ++i){
+    int64_t delta = (int64_t)p_map->_p_lines[i] - line;
+    uint64_t z = (delta < 0) ? ((uint64_t)(-delta) << 1) - 1 : (uint64_t)delta << 1;
+    line = p_map->_p_lines[i];
+    do{
+      result = outbuf_putc(p_out, (char)((z & 0x7f) | ((z > 0x7f) ? 0x80 : 0)));
+      z >>= 7;
+    }while(z != 0 && result == SUCCESS);
+  }
+  return result;
+}
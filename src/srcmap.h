@@ -0,0 +1,142 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: srcmap.h
+ *
+ *===================================================================================================================*/
+
+
+#ifndef _SRCMAP_H_
+#define _SRCMAP_H_
+
+#include <stdint.h>
+#include "outbuf.h"
+
+#define SRCMAP_MAGIC "HSRC"
+#define SRCMAP_VERSION 1
+#define SRCMAP_NO_LABEL UINT32_MAX
+
+struct Assembler;
+
+/*
+ * brief: a label of the program; a ROM address with a name.
+ *
+ * @member _name: offset of the name in SrcMap_t::_names.
+ */
+typedef struct SrcLabel {
+  uint32_t _name;
+  uint16_t _address;
+} SrcLabel_t;
+
+/*
+ * brief: the source map of a program; maps each ROM address to the line of the translation unit it was assembled
+ *  from, and to the label it follows.
+ *
+ * @member _p_lines: the source line of each instruction, counted from 1; 0 if not known, e.g. of a linked program.
+ * @member _p_labels: the index in _p_label_table of the label each instruction follows, SRCMAP_NO_LABEL if none.
+ * @member _p_label_table: the labels, ordered by address; labels of the same address by name.
+ * @member _names: the names of the labels, null terminated.
+ */
+typedef struct SrcMap {
+  uint32_t* _p_lines;
+  uint32_t* _p_labels;
+  uint32_t _num_ins;
+  uint32_t _capacity;
+  SrcLabel_t* _p_label_table;
+  uint32_t _num_labels;
+  uint32_t _label_capacity;
+  struct OutBuf _names;
+} SrcMap_t;
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: instantiates a new, empty, source map.
+ * return: pointer to the new source map or NULL on error.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+SrcMap_t* new_srcmap();
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void free_srcmap(SrcMap_t** pp_map);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: builds the source map of an assembled or linked program; the lines from the command array, and the labels
+ *  from the label entries of the symbol library.
+ * return: SUCCESS, or FAIL on malloc error.
+ *
+ * note: the commands that generate instructions map to ROM addresses in order; a linked program has no commands,
+ *  so its lines are not known.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int srcmap_build(SrcMap_t* p_map, const struct Assembler* p);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: the name of the label an instruction follows, or NULL if none.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+const char* srcmap_label(const SrcMap_t* p_map, uint32_t address);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: finds the address of the first instruction of a line.
+ * return: SUCCESS, or FAIL if no instruction is of the line.
+ *
+ * note: a binary search; the lines of an assembled program rise with the addresses of its instructions.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int srcmap_find_line(const SrcMap_t* p_map, uint32_t line, uint32_t* p_address);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: finds the address of a label.
+ * return: SUCCESS, or FAIL if the program has no such label.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int srcmap_find_label(const SrcMap_t* p_map, const char* name, uint32_t* p_address);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: appends the binary form of the source map to a buffer; little-endian,
+ *
+ *    magic "HSRC", u16 version, u16 0, u32 number of instructions, u32 number of labels,
+ *    each label: u16 address, u8 length of name, name,
+ *    each instruction: its line minus the line of the instruction before, zigzag LEB128 encoded.
+ *
+ *  so an instruction on the line after the one before takes a single byte.
+ * return: SUCCESS, or FAIL if the buffer could not grow.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int srcmap_write(const SrcMap_t* p_map, struct OutBuf* p_out);
+
+#endif
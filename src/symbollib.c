@@ -39,10 +39,13 @@
 #include <stddef.h>
 #include <stdlib.h>
 #include "dynpoolalloc.h"
+#include "symbollib.h"
 #include "asmerr.h"
 
 static const size_t LIB_NODE_POOL_SIZE_NODES = 100; /* number of LibNodes per pool allocator. */
 
+#define MAX_VISIT_DEPTH 256 /* longest symbol 'symlib_foreach' can reconstruct, including the null terminator. */
+
 /*-------------------------------------------------------------------------------------------------------------------*/
 /*
  * brief: Node used in Trie data structure of symbol library.
@@ -53,6 +56,7 @@ struct LibNode {
   struct LibNode* _p_next_sibling;
   uint16_t _data;                 /* _data==character if _is_terminator==false, else _data==RAM/ROM address */
   bool _is_terminator;
+  uint8_t _tag;                   /* SYMTAG_* kind of symbol; only used by terminators. */
 };
 
 /*-------------------------------------------------------------------------------------------------------------------*/
@@ -101,6 +105,22 @@ static struct LibNode* find_terminator(struct LibNode* parent){
   return current;
 }
 
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: finds the terminating node of a symbol, which holds its address and tag.
+ * return: the node, or NULL if the symbol is not in the library.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static struct LibNode* find_symbol(struct SymLib* p_lib, const char* sym){
+  struct LibNode* node = p_lib->_p_root;
+  for(int i = 0; sym[i] != '\0'; ++i){
+    if((node = find_child(node, sym[i])) == NULL){
+      return NULL;
+    }
+  }
+  return find_terminator(node);
+}
+
 /*-------------------------------------------------------------------------------------------------------------------*/
 /*
  * brief: adds a child LibNode to a LibNode in a symbol library.
@@ -129,6 +149,7 @@ static int add_child(struct SymLib* p_lib, struct LibNode* p_parent, uint16_t da
   new_child->_p_next_sibling = NULL;
   new_child->_data = data;
   new_child->_is_terminator = is_terminator;
+  new_child->_tag = SYMTAG_NONE;
 
   // link the child to the last node in the sibling list...
   if(p_parent->_p_first_child == NULL){
@@ -149,6 +170,31 @@ static int add_child(struct SymLib* p_lib, struct LibNode* p_parent, uint16_t da
   return SUCCESS;
 }
 
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: depth first walk of the Trie below 'p_parent'; 'path' holds the characters of the nodes above, of which
+ *  there are 'depth'.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int visit_children(struct LibNode* p_parent, char* path, int depth, SymVisitor_t visit, void* p_ctx){
+  for(struct LibNode* child = p_parent->_p_first_child; child != NULL; child = child->_p_next_sibling){
+    if(child->_is_terminator){
+      path[depth] = '\0';
+      visit(path, child->_data, child->_tag, p_ctx);
+      continue;
+    }
+    if(depth + 1 >= MAX_VISIT_DEPTH){
+      return ERROR_1;
+    }
+    path[depth] = (char)child->_data;
+    int err = visit_children(child, path, depth + 1, visit, p_ctx);
+    if(err != SUCCESS){
+      return err;
+    }
+  }
+  return SUCCESS;
+}
+
 /*=====================================================================================================================
  * PUBLIC INTERFACE 
  *===================================================================================================================*/
@@ -184,6 +230,7 @@ int new_symlib(struct SymLib** pp_lib){
   (*pp_lib)->_p_root->_p_first_child = (*pp_lib)->_p_root->_p_next_sibling = NULL;
   (*pp_lib)->_p_root->_data = 0;  /* data in root is not used. */
   (*pp_lib)->_p_root->_is_terminator = false;
+  (*pp_lib)->_p_root->_tag = SYMTAG_NONE;
 
   return SUCCESS;
 }
@@ -197,7 +244,22 @@ int free_symlib(struct SymLib** pp_lib){
 }
 
 /*-------------------------------------------------------------------------------------------------------------------*/
-int symlib_add_symbol(struct SymLib* p_lib, const char* sym, uint16_t address){
+int symlib_clear(struct SymLib* p_lib){
+  dynamic_pool_reset(p_lib->_p_pool);
+  void* mem = NULL;
+  if(dynamic_pool_malloc(p_lib->_p_pool, &mem) != SUCCESS){ // cannot fail; the pools are kept by the reset.
+    return ERROR_1;
+  }
+  p_lib->_p_root = (struct LibNode*)mem;
+  p_lib->_p_root->_p_first_child = p_lib->_p_root->_p_next_sibling = NULL;
+  p_lib->_p_root->_data = 0;
+  p_lib->_p_root->_is_terminator = false;
+  p_lib->_p_root->_tag = SYMTAG_NONE;
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int symlib_add_symbol(struct SymLib* p_lib, const char* sym, uint16_t address, uint8_t tag){
   int err; 
 
   // find the last character in the symbol for which a node exists, and find its node...
@@ -233,37 +295,66 @@ int symlib_add_symbol(struct SymLib* p_lib, const char* sym, uint16_t address){
   }
 
   // finally add the terminator which stores the RAM/ROM address...
-  add_child(p_lib, node, address, true, &node);
+  err = add_child(p_lib, node, address, true, &node);
+  if(err != SUCCESS){
+    return ERROR_2;
+  }
+  node->_tag = tag;
 
   return SUCCESS;
 }
 
 /*-------------------------------------------------------------------------------------------------------------------*/
 int symlib_search_symbol(struct SymLib* p_lib, const char* sym, uint16_t* p_address){
-  // find the last character in the symbol for which a node exists, and find its node...
-  struct LibNode* node = p_lib->_p_root;
-  int i = 0;
-  for(; sym[i]!='\0'; ++i){
-    struct LibNode* child = find_child(node, sym[i]);
-    if(child != NULL){
-      node = child;
-    }
-    else{
-      break;
-    }
+  uint8_t tag;
+  return symlib_lookup(p_lib, sym, p_address, &tag);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int symlib_lookup(struct SymLib* p_lib, const char* sym, uint16_t* p_address, uint8_t* p_tag){
+  struct LibNode* terminator = find_symbol(p_lib, sym);
+  if(terminator == NULL){
+    return ERROR_1;
   }
+  *p_address = terminator->_data;
+  *p_tag = terminator->_tag;
 
-  // if found a node for all characters in the symbol, determine if the last characters node has a 
-  // terminating node. If it does, this symbol does exists in the library.
-  if(sym[i] == '\0'){
-    struct LibNode* terminator = find_terminator(node);
-    if(terminator != NULL){
-      *p_address = terminator->_data;
-    }
-    else{
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int symlib_set_address(struct SymLib* p_lib, const char* sym, uint16_t address){
+  struct LibNode* terminator = find_symbol(p_lib, sym);
+  if(terminator == NULL){
+    return ERROR_1;
+  }
+  terminator->_data = address;
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int symlib_remove_symbol(struct SymLib* p_lib, const char* sym){
+  struct LibNode* node = p_lib->_p_root;
+  for(int i = 0; sym[i] != '\0'; ++i){
+    if((node = find_child(node, sym[i])) == NULL){
       return ERROR_1;
     }
   }
 
+  // unlink the terminator from its siblings; the characters before it may be shared with other symbols...
+  struct LibNode** pp_link = &node->_p_first_child;
+  while(*pp_link != NULL && !(*pp_link)->_is_terminator){
+    pp_link = &(*pp_link)->_p_next_sibling;
+  }
+  if(*pp_link == NULL){
+    return ERROR_1;
+  }
+  *pp_link = (*pp_link)->_p_next_sibling;
   return SUCCESS;
 }
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int symlib_foreach(struct SymLib* p_lib, SymVisitor_t visit, void* p_ctx){
+  char path[MAX_VISIT_DEPTH];
+  return visit_children(p_lib->_p_root, path, 0, visit, p_ctx);
+}
@@ -48,6 +48,19 @@
 /*-------------------------------------------------------------------------------------------------------------------*/
 struct SymLib;
 
+/*
+ * tags recording what kind of symbol a library entry is; stored alongside the address of the symbol.
+ */
+#define SYMTAG_NONE       0x00
+#define SYMTAG_PREDEFINED 0x01 // symbols predefined by the Hack platform, e.g. SP, R0, SCREEN.
+#define SYMTAG_LABEL      0x02 // label declared by an L command; maps to a ROM address.
+#define SYMTAG_VARIABLE   0x03 // variable allocated for an A command symbol; maps to a RAM address.
+
+/*
+ * brief: callback invoked for each symbol in a library by 'symlib_foreach'.
+ */
+typedef void (*SymVisitor_t)(const char* sym, uint16_t address, uint8_t tag, void* p_ctx);
+
 /*-------------------------------------------------------------------------------------------------------------------*/
 /*
  * brief: creates and returns a new and initialised SymLib instance.
@@ -70,19 +83,28 @@ int new_symlib(struct SymLib** pp_lib);
 /*-------------------------------------------------------------------------------------------------------------------*/
 int free_symlib(struct SymLib** pp_lib);
 
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: removes all symbols from the library, keeping the memory of its pools for the symbols added next.
+ * return: SUCCESS, or ERROR_1 on malloc error.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int symlib_clear(struct SymLib* p_lib);
+
 /*-------------------------------------------------------------------------------------------------------------------*/
 /*
  * brief: adds a symbol to the symbol library, mapping said symbol to a RAM/ROM address.
  * @param p_lib: pointer to the symbol library to add the symbol to.
  * @param sym: the symbol to add.
  * @param address: the RAM/ROM address to map to the symbol.
+ * @param tag: one of the SYMTAG_* kinds of symbol.
  * return: 
  *        SUCCESS if symbol added.
  *        ERROR_1 if symbol already in the symbol library.
  *        ERROR_2 if failed to modify the underlying data structure, thus cannot add symbol.
  */
 /*-------------------------------------------------------------------------------------------------------------------*/
-int symlib_add_symbol(struct SymLib* p_lib, const char* sym, uint16_t address);
+int symlib_add_symbol(struct SymLib* p_lib, const char* sym, uint16_t address, uint8_t tag);
 
 /*-------------------------------------------------------------------------------------------------------------------*/
 /*
@@ -97,4 +119,48 @@ int symlib_add_symbol(struct SymLib* p_lib, const char* sym, uint16_t address);
 /*-------------------------------------------------------------------------------------------------------------------*/
 int symlib_search_symbol(struct SymLib* p_lib, const char* sym, uint16_t* p_address);
 
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: as 'symlib_search_symbol', but also returns the SYMTAG_* kind of the symbol in 'p_tag'.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int symlib_lookup(struct SymLib* p_lib, const char* sym, uint16_t* p_address, uint8_t* p_tag);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: moves a symbol of the library to another RAM/ROM address, keeping its tag.
+ * return: 
+ *    SUCCESS if the symbol was moved.
+ *    ERROR_1 if symbol not found.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int symlib_set_address(struct SymLib* p_lib, const char* sym, uint16_t address);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: removes a symbol from the library.
+ * return: 
+ *    SUCCESS if the symbol was removed.
+ *    ERROR_1 if symbol not found.
+ *
+ * note: the nodes of the symbol stay in the pools until the library is cleared or freed.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int symlib_remove_symbol(struct SymLib* p_lib, const char* sym);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: visits every symbol in the symbol library.
+ * @param p_lib: symbol library to walk.
+ * @param visit: callback invoked once per symbol with the symbol, its address and its tag.
+ * @param p_ctx: passed through to the callback.
+ * return:
+ *    SUCCESS if all symbols visited.
+ *    ERROR_1 if a symbol is too long to reconstruct (longer than 255 characters).
+ *
+ * note: symbols are visited in trie order, which is NOT sorted order.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int symlib_foreach(struct SymLib* p_lib, SymVisitor_t visit, void* p_ctx);
+
 #endif
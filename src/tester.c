@@ -0,0 +1,980 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: tester.c
+ *
+ *===================================================================================================================*/
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#include "tester.h"
+#include "assembler.h"
+#include "parser.h"
+#include "symbollib.h"
+#include "sim.h"
+#include "srcmap.h"
+#include "coverage.h"
+#include "snapshot.h"
+#include "screen.h"
+#include "outbuf.h"
+#include "jobserver.h"
+#include "lexer.h"
+#include "decoder.h"
+#include "asmerr.h"
+
+#define MAX_MESSAGE_CHAR 256
+#define NO_PROGRAM UINT32_MAX
+
+/*
+ * ids of the outcomes of a test; Test_t::_result.
+ */
+#define TEST_PASSED 0xe0
+#define TEST_FAILED 0xe1 // the program reached its cycle budget, or left RAM other than expected.
+#define TEST_ERROR  0xe2 // the test could not run; it is invalid, or its program does not assemble.
+
+/*
+ * brief: a setting of a RAM word.
+ */
+typedef struct Setting {
+  uint16_t _address;
+  uint16_t _value;
+} Setting_t;
+
+/*
+ * brief: a snapshot tests of a program start from; read once, by the thread that assembles the program, then shared
+ *  read-only by the threads that restore it.
+ *
+ * @member _path: the real path of the snapshot; snapshots are told apart by it.
+ */
+typedef struct Start {
+  char* _path;
+  SimState_t* _p_state;
+} Start_t;
+
+/*
+ * brief: a program run by tests; assembled once, by whichever thread takes it, then shared read-only.
+ *
+ * @member _path: the real path of the program; programs are told apart by it.
+ * @member _p_rom: the Hack machine instructions of the program, NULL if it failed to assemble.
+ * @member _first_test, _num_tests: the tests of the program; they are sorted together.
+ * @member _p_srcmap, _p_coverage: with coverage on, the source map of the program and the coverage of its tests,
+ *  merged from the workers that ran them; else NULL.
+ * @member _p_starts: the _num_starts snapshots the tests of the program start from.
+ */
+typedef struct Program {
+  char* _path;
+  uint16_t* _p_rom;
+  uint32_t _num_ins;
+  uint32_t _first_test;
+  uint32_t _num_tests;
+  SrcMap_t* _p_srcmap;
+  SimCoverage_t* _p_coverage;
+  Start_t* _p_starts;
+  uint32_t _num_starts;
+} Program_t;
+
+/*
+ * brief: a test, and its outcome.
+ *
+ * @member _name: the name of the test file without its extension.
+ * @member _text: the test file.
+ * @member _program: index of the program of the test, NO_PROGRAM if the test is invalid.
+ * @member _start_path, _p_start: the real path of the snapshot the test starts from, and its state once read; else
+ *  NULL, and the test starts from reset.
+ * @member _p_settings: the _num_sets RAM settings of the test, followed by its _num_expects expected RAM words.
+ * @member _p_screen: the screen the test expects, or NULL.
+ * @member _result: one of TEST_*.
+ * @member _message: why the test failed, or is in error.
+ */
+typedef struct Test {
+  char* _path;
+  char* _name;
+  struct OutBuf _text;
+  uint32_t _program;
+  char* _start_path;
+  const SimState_t* _p_start;
+  uint64_t _max_cycles;
+  Setting_t* _p_settings;
+  uint32_t _num_sets;
+  uint32_t _num_expects;
+  ScreenImage_t* _p_screen;
+  int _result;
+  uint64_t _cycles;
+  double _seconds;
+  char _message[MAX_MESSAGE_CHAR];
+} Test_t;
+
+/*
+ * brief: the tasks dealt to a thread of the pool, tasks [head, tail) packed in one word so both ends move with one
+ *  compare and swap; the owner takes tasks from the head, thieves from the tail.
+ *
+ * note: a span is never reused; tasks leave a deque once, so a stale span cannot compare equal (no ABA).
+ */
+typedef struct Deque {
+  _Alignas(64) _Atomic uint64_t _span; // one per cache line, so the threads do not share the lines they write.
+} Deque_t;
+
+struct Tester;
+
+/*
+ * brief: a thread of the pool; its assembler and simulator are kept between tasks.
+ *
+ * @member _loaded: index of the program loaded in the simulator, NO_PROGRAM if none.
+ */
+typedef struct Worker {
+  struct Tester* _p_tester;
+  uint32_t _index;
+  Assembler_t* _p_asm;
+  Sim_t* _p_sim;
+  uint32_t _loaded;
+  pthread_t _thread;
+} Worker_t;
+
+typedef void (*TaskFn_t)(Worker_t* p_worker, uint32_t task);
+
+/*
+ * @member _merge_lock: held to merge the coverage of a worker into that of a program.
+ */
+typedef struct Tester {
+  uint64_t _max_cycles;
+  bool _is_coverage;
+  pthread_mutex_t _merge_lock;
+  Test_t* _p_tests;
+  uint32_t _num_tests;
+  Program_t* _p_programs;
+  uint32_t _num_programs;
+  Worker_t* _p_workers;
+  Deque_t* _p_deques;
+  uint32_t _num_workers;
+  TaskFn_t _task;
+  Jobserver_t* _p_jobserver;
+} Tester_t;
+
+/*=====================================================================================================================
+ * WORK STEALING POOL
+ *===================================================================================================================*/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static inline uint64_t make_span(uint32_t head, uint32_t tail){
+  return ((uint64_t)tail << 32) | head;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: takes the task at the head of the deque of a worker.
+ * return: true if a task was taken, false if the deque is empty.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static bool pop_task(Deque_t* p_deque, uint32_t* p_task){
+  uint64_t span = atomic_load(&p_deque->_span);
+  while((uint32_t)span < (uint32_t)(span >> 32)){
+    if(atomic_compare_exchange_weak(&p_deque->_span, &span, span + 1)){
+      *p_task = (uint32_t)span;
+      return true;
+    }
+  }
+  return false;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: takes the back half of the tasks of another worker's deque, into the empty deque of a worker.
+ * return: true if any tasks were taken.
+ *
+ * note: only the owner of a deque refills it, and only once it is empty; no thief takes from an empty deque.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static bool steal_tasks(Deque_t* p_victim, Deque_t* p_own){
+  uint64_t span = atomic_load(&p_victim->_span);
+  while((uint32_t)span < (uint32_t)(span >> 32)){
+    uint32_t head = (uint32_t)span, tail = (uint32_t)(span >> 32), half = (tail - head + 1) / 2;
+    if(atomic_compare_exchange_weak(&p_victim->_span, &span, make_span(head, tail - half))){
+      atomic_store(&p_own->_span, make_span(tail - half, tail));
+      return true;
+    }
+  }
+  return false;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: runs the tasks of a worker, then steals from the others, until no deque has tasks left.
+ *
+ * note: tasks are only ever dealt before the pool starts, so once every deque is empty no task can appear; tasks in
+ *  the hands of a thief are run by the thief.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void* work(void* p_arg){
+  Worker_t* p_worker = (Worker_t*)p_arg;
+  Tester_t* p = p_worker->_p_tester;
+  Deque_t* p_own = &p->_p_deques[p_worker->_index];
+  while(true){
+    uint32_t task;
+    if(pop_task(p_own, &task)){
+      p->_task(p_worker, task);
+      continue;
+    }
+    bool is_stolen = false;
+    for(uint32_t v = 1; v < p->_num_workers && !is_stolen; ++v){
+      is_stolen = steal_tasks(&p->_p_deques[(p_worker->_index + v) % p->_num_workers], p_own);
+    }
+    if(!is_stolen){
+      return NULL;
+    }
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: runs tasks 0 to num_tasks - 1 on the pool; each worker is dealt an equal run of consecutive tasks.
+ *
+ * note: the first worker runs on this thread, in the job slot the process was started in. Under a make jobserver 
+ *  each other worker holds a token; a worker that gets none does not start, and its tasks are stolen by the others.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void run_pool(Tester_t* p, TaskFn_t task, uint32_t num_tasks){
+  p->_task = task;
+  for(uint32_t w = 0; w < p->_num_workers; ++w){
+    uint32_t head = (uint32_t)((uint64_t)num_tasks * w / p->_num_workers);
+    uint32_t tail = (uint32_t)((uint64_t)num_tasks * (w + 1) / p->_num_workers);
+    atomic_store(&p->_p_deques[w]._span, make_span(head, tail));
+  }
+  bool is_threaded[p->_num_workers];
+  is_threaded[0] = false;
+  for(uint32_t w = 1; w < p->_num_workers; ++w){
+    is_threaded[w] = false;
+    if(p->_p_jobserver != NULL && !jobserver_try_acquire(p->_p_jobserver)){
+      continue;
+    }
+    is_threaded[w] = pthread_create(&p->_p_workers[w]._thread, NULL, work, &p->_p_workers[w]) == 0;
+    if(!is_threaded[w] && p->_p_jobserver != NULL){
+      jobserver_release(p->_p_jobserver);
+    }
+  }
+  work(&p->_p_workers[0]);
+  for(uint32_t w = 1; w < p->_num_workers; ++w){
+    if(is_threaded[w]){
+      pthread_join(p->_p_workers[w]._thread, NULL);
+      if(p->_p_jobserver != NULL){
+        jobserver_release(p->_p_jobserver);
+      }
+    }
+  }
+}
+
+/*=====================================================================================================================
+ * TESTS
+ *===================================================================================================================*/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void set_error(Test_t* p_test, const char* format, const char* arg){
+  p_test->_result = TEST_ERROR;
+  snprintf(p_test->_message, MAX_MESSAGE_CHAR, format, arg);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: reads the whole of a file into a buffer.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int read_text(const char* path, struct OutBuf* p_buf){
+  FILE* file = fopen(path, "rb");
+  if(file == NULL){
+    return FAIL;
+  }
+  size_t n;
+  do{
+    if(outbuf_reserve(p_buf, 1 << 12) != SUCCESS){
+      fclose(file);
+      return FAIL;
+    }
+    n = fread(p_buf->_p_data + p_buf->_size, 1, p_buf->_capacity - p_buf->_size, file);
+    p_buf->_size += n;
+  }while(n > 0);
+  int result = ferror(file) ? FAIL : SUCCESS;
+  fclose(file);
+  return result;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: the index of the program at a real path, added if it is not yet known.
+ * return: the index, or NO_PROGRAM on malloc error.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static uint32_t find_program(Tester_t* p, const char* path){
+  for(uint32_t i = 0; i < p->_num_programs; ++i){
+    if(strcmp(p->_p_programs[i]._path, path) == 0){
+      return i;
+    }
+  }
+  Program_t* p_programs = (Program_t*)realloc(p->_p_programs, (p->_num_programs + 1) * sizeof(Program_t));
+  if(p_programs == NULL){
+    return NO_PROGRAM;
+  }
+  p->_p_programs = p_programs;
+  Program_t* p_program = &p_programs[p->_num_programs];
+  memset(p_program, 0, sizeof(Program_t));
+  if((p_program->_path = strdup(path)) == NULL){
+    return NO_PROGRAM;
+  }
+  return p->_num_programs++;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: the real path of a file a test names, relative to the directory of the test.
+ * return: SUCCESS, or FAIL if there is no such file.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int find_file(const Test_t* p_test, const char* name, size_t n, char* real){
+  char path[PATH_MAX];
+  const char* slash = strrchr(p_test->_path, '/');
+  int l = (name[0] == '/' || slash == NULL) ? 0 : (int)(slash - p_test->_path + 1);
+  snprintf(path, PATH_MAX, "%.*s%.*s", l, p_test->_path, (int)n, name);
+  return (realpath(path, real) != NULL) ? SUCCESS : FAIL;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: parses the program, snapshot and cycle budget of a test, and counts its settings; or with the symbols of its
+ *  assembled program, parses its settings.
+ * @param p_lib: the symbols of the program, or NULL for the first pass.
+ * return: SUCCESS, or FAIL if the test is invalid; the error is reported to stderr and kept in the test.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int parse_test(Tester_t* p, Test_t* p_test, struct SymLib* p_lib){
+  const char* s = p_test->_text._p_data, *end = s + p_test->_text._size;
+  uint32_t lineno = 0, num_sets = 0, num_expects = 0;
+  bool is_program = false, is_start = false, is_screen = false;
+  char error[MAX_MESSAGE_CHAR] = "";
+  while(s < end && error[0] == '\0'){
+    const char* eol = memchr(s, '\n', end - s);
+    eol = (eol != NULL) ? eol : end;
+    ++lineno;
+    s += strspn(s, " \t\r");
+    size_t n = (s < eol) ? strcspn(s, " \t\r\n") : 0;
+    n = (s + n > eol) ? (size_t)(eol - s) : n;
+    const char* arg = s + n;
+    arg += (arg < eol) ? strspn(arg, " \t\r") : 0;
+    size_t arg_n = (size_t)(eol - arg);
+    while(arg_n > 0 && (arg[arg_n - 1] == ' ' || arg[arg_n - 1] == '\t' || arg[arg_n - 1] == '\r')){
+      --arg_n;
+    }
+    if(n == 0 || *s == '#'){
+      s = eol + 1;
+      continue;
+    }
+    bool is_set = n == 3 && strncmp(s, "set", 3) == 0, is_expect = n == 6 && strncmp(s, "expect", 6) == 0;
+    if(n == 7 && strncmp(s, "program", 7) == 0){
+      char real[PATH_MAX];
+      if(is_program || arg_n == 0){
+        snprintf(error, MAX_MESSAGE_CHAR, "a test has a single program");
+      }
+      else if(p_lib == NULL && find_file(p_test, arg, arg_n, real) != SUCCESS){
+        snprintf(error, MAX_MESSAGE_CHAR, "cannot find program '%.*s'", (int)arg_n, arg);
+      }
+      else if(p_lib == NULL && (p_test->_program = find_program(p, real)) == NO_PROGRAM){
+        snprintf(error, MAX_MESSAGE_CHAR, "out of memory");
+      }
+      is_program = true;
+    }
+    else if(n == 5 && strncmp(s, "start", 5) == 0){
+      char real[PATH_MAX];
+      if(is_start || arg_n == 0){
+        snprintf(error, MAX_MESSAGE_CHAR, "a test has a single start");
+      }
+      else if(p_lib == NULL && find_file(p_test, arg, arg_n, real) != SUCCESS){
+        snprintf(error, MAX_MESSAGE_CHAR, "cannot find snapshot '%.*s'", (int)arg_n, arg);
+      }
+      else if(p_lib == NULL && (p_test->_start_path = strdup(real)) == NULL){
+        snprintf(error, MAX_MESSAGE_CHAR, "out of memory");
+      }
+      is_start = true;
+    }
+    else if(n == 6 && strncmp(s, "screen", 6) == 0){
+      char real[PATH_MAX];
+      struct OutBuf image = {0};
+      if(is_screen || arg_n == 0){
+        snprintf(error, MAX_MESSAGE_CHAR, "a test has a single screen");
+      }
+      else if(p_lib == NULL && (find_file(p_test, arg, arg_n, real) != SUCCESS || 
+                                init_outbuf(&image, 1 << 14) != SUCCESS || read_text(real, &image) != SUCCESS)){
+        snprintf(error, MAX_MESSAGE_CHAR, "cannot read screen '%.*s'", (int)arg_n, arg);
+      }
+      else if(p_lib == NULL && (p_test->_p_screen = (ScreenImage_t*)malloc(sizeof(ScreenImage_t))) == NULL){
+        snprintf(error, MAX_MESSAGE_CHAR, "out of memory");
+      }
+      else if(p_lib == NULL && screen_read_pbm(p_test->_p_screen, image._p_data, image._size) != SUCCESS){
+        snprintf(error, MAX_MESSAGE_CHAR, "screen '%.*s' is not a 512x256 PBM image", (int)arg_n, arg);
+      }
+      if(image._p_data != NULL){
+        free_outbuf(&image);
+      }
+      is_screen = true;
+    }
+    else if(n == 6 && strncmp(s, "cycles", 6) == 0){
+      char* tail;
+      p_test->_max_cycles = strtoull(arg, &tail, 10);
+      if(tail == arg || tail != arg + arg_n){
+        snprintf(error, MAX_MESSAGE_CHAR, "invalid cycle budget '%.*s'", (int)arg_n, arg);
+      }
+    }
+    else if(is_set || is_expect){
+      while(arg < eol && error[0] == '\0'){
+        size_t m = strcspn(arg, " \t\r\n");
+        m = (arg + m > eol) ? (size_t)(eol - arg) : m;
+        uint32_t i = is_set ? num_sets++ : p_test->_num_sets + num_expects++;
+        if(p_lib != NULL && parse_setting(p_lib, arg, m, &p_test->_p_settings[i]._address, 
+                                          &p_test->_p_settings[i]._value) != SUCCESS){
+          snprintf(error, MAX_MESSAGE_CHAR, "invalid setting '%.*s', expected address=value", (int)m, arg);
+        }
+        arg += m;
+        arg += (arg < eol) ? strspn(arg, " \t\r") : 0;
+      }
+    }
+    else{
+      snprintf(error, MAX_MESSAGE_CHAR, "unknown directive '%.*s', expected program, start, set, expect, "
+               "screen or cycles", (int)n, s);
+    }
+    s = eol + 1;
+  }
+  if(error[0] == '\0' && !is_program){
+    snprintf(error, MAX_MESSAGE_CHAR, "no program to test");
+  }
+  if(error[0] != '\0'){
+    fprintf(stderr, "%s:%" PRIu32 ":error:%s\n", p_test->_path, lineno, error);
+    p_test->_program = (p_lib == NULL) ? NO_PROGRAM : p_test->_program;
+    set_error(p_test, "%s", error);
+    return FAIL;
+  }
+  if(p_lib == NULL){
+    p_test->_num_sets = num_sets;
+    p_test->_num_expects = num_expects;
+    p_test->_p_settings = (Setting_t*)malloc((num_sets + num_expects + 1) * sizeof(Setting_t));
+    if(p_test->_p_settings == NULL){
+      p_test->_program = NO_PROGRAM;
+      set_error(p_test, "%s", "out of memory");
+      return FAIL;
+    }
+  }
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: orders tests by program, then by name; invalid tests last.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int compare_tests(const void* p_a, const void* p_b){
+  const Test_t* a = (const Test_t*)p_a, *b = (const Test_t*)p_b;
+  if(a->_program != b->_program){
+    return (a->_program < b->_program) ? -1 : 1;
+  }
+  return strcmp(a->_name, b->_name);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int is_test_file(const struct dirent* p_entry){
+  size_t l = strlen(p_entry->d_name), e = strlen(TEST_EXTENSION);
+  return p_entry->d_name[0] != '.' && l > e && strcmp(p_entry->d_name + l - e, TEST_EXTENSION) == 0 && 
+         (p_entry->d_type == DT_REG || p_entry->d_type == DT_LNK || p_entry->d_type == DT_UNKNOWN);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: reads the tests of a directory, and finds their programs.
+ * return: SUCCESS, or FAIL if the directory could not be read or on malloc error.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int load_tests(Tester_t* p, const char* dir){
+  struct dirent** pp_entries;
+  int num_entries = scandir(dir, &pp_entries, is_test_file, alphasort);
+  if(num_entries < 0){
+    perror(dir);
+    return FAIL;
+  }
+  int result = SUCCESS;
+  p->_p_tests = (Test_t*)calloc((size_t)num_entries + 1, sizeof(Test_t));
+  for(int e = 0; e < num_entries; ++e){
+    if(p->_p_tests != NULL && result == SUCCESS){
+      Test_t* p_test = &p->_p_tests[p->_num_tests++];
+      const char* name = pp_entries[e]->d_name;
+      size_t l = strlen(dir);
+      p_test->_path = (char*)malloc(l + strlen(name) + 2);
+      p_test->_name = strndup(name, strlen(name) - strlen(TEST_EXTENSION));
+      p_test->_max_cycles = p->_max_cycles;
+      result = (p_test->_path != NULL && p_test->_name != NULL) ? init_outbuf(&p_test->_text, 1 << 10) : FAIL;
+      if(result == SUCCESS){
+        sprintf(p_test->_path, "%s%s%s", dir, (l > 0 && dir[l - 1] == '/') ? "" : "/", name);
+        if(read_text(p_test->_path, &p_test->_text) != SUCCESS){
+          perror(p_test->_path);
+          p_test->_program = NO_PROGRAM;
+          set_error(p_test, "cannot read '%s'", p_test->_path);
+        }
+        else{
+          parse_test(p, p_test, NULL);
+        }
+      }
+    }
+    free(pp_entries[e]);
+  }
+  free(pp_entries);
+  if(p->_p_tests == NULL || result != SUCCESS){
+    fprintf(stderr, "fatal error: out of memory\n");
+    return FAIL;
+  }
+  qsort(p->_p_tests, p->_num_tests, sizeof(Test_t), compare_tests);
+  for(uint32_t t = p->_num_tests; t-- > 0;){
+    uint32_t i = p->_p_tests[t]._program;
+    if(i != NO_PROGRAM){
+      p->_p_programs[i]._first_test = t;
+      ++p->_p_programs[i]._num_tests;
+    }
+  }
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: sets the state a test starts from to its snapshot; read, and checked to be of the program of the test, if it
+ *  is not yet known.
+ * @param p_rom: the 'n' Hack machine instructions of the program.
+ * return: SUCCESS, or FAIL if the snapshot cannot be read or is not of the program; the error is kept in the test.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int find_start(Program_t* p_program, Test_t* p_test, const uint16_t* p_rom, uint32_t n){
+  for(uint32_t i = 0; i < p_program->_num_starts; ++i){
+    if(strcmp(p_program->_p_starts[i]._path, p_test->_start_path) == 0){
+      p_test->_p_start = p_program->_p_starts[i]._p_state;
+      return SUCCESS;
+    }
+  }
+  Start_t* p_starts = (Start_t*)realloc(p_program->_p_starts, (p_program->_num_starts + 1) * sizeof(Start_t));
+  SimState_t* p_state = (SimState_t*)malloc(sizeof(SimState_t));
+  struct OutBuf data;
+  if(p_starts == NULL || p_state == NULL || init_outbuf(&data, 1 << 12) != SUCCESS){
+    p_program->_p_starts = (p_starts != NULL) ? p_starts : p_program->_p_starts;
+    free(p_state);
+    set_error(p_test, "%s", "out of memory");
+    return FAIL;
+  }
+  p_program->_p_starts = p_starts;
+  int result = read_text(p_test->_start_path, &data);
+  if(result != SUCCESS){
+    set_error(p_test, "cannot read snapshot '%s'", p_test->_start_path);
+  }
+  else if((result = snapshot_read(p_state, p_rom, n, data._p_data, data._size)) != SUCCESS){
+    set_error(p_test, (result == ERROR_1) ? "snapshot '%s' is of another program" : "'%s' is not a snapshot", 
+              p_test->_start_path);
+  }
+  free_outbuf(&data);
+  if(result != SUCCESS){
+    free(p_state);
+    return FAIL;
+  }
+  p_starts[p_program->_num_starts++] = (Start_t){._path = p_test->_start_path, ._p_state = p_state};
+  p_test->_start_path = NULL; // owned by the program from here.
+  p_test->_p_start = p_state;
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: task of the pool; assembles a program, then parses the settings of its tests with its symbols and reads the
+ *  snapshots they start from.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void assemble_program(Worker_t* p_worker, uint32_t program){
+  Tester_t* p = p_worker->_p_tester;
+  Program_t* p_program = &p->_p_programs[program];
+  if(p_program->_num_tests == 0){ // the tests of the program are all invalid.
+    return;
+  }
+  Assembler_t* p_asm = p_worker->_p_asm;
+  int result = (p_asm != NULL) ? assembler_reset(p_asm) : FAIL;
+  if(p_asm == NULL && (p_asm = p_worker->_p_asm = new_assembler(false)) != NULL){
+    result = SUCCESS;
+  }
+  const char* error = (result == SUCCESS) ? "program '%s' failed to assemble" : "out of memory";
+  if(result == SUCCESS && (result = assembler_assemble(p_asm, p_program->_path)) == SUCCESS){
+    p_program->_num_ins = p_asm->_ins_count;
+    p_program->_p_rom = (uint16_t*)malloc((p_asm->_ins_count + 1) * sizeof(uint16_t));
+    result = (p_program->_p_rom != NULL) ? SUCCESS : FAIL;
+    if(result == SUCCESS && p->_is_coverage){
+      p_program->_p_srcmap = new_srcmap();
+      p_program->_p_coverage = (SimCoverage_t*)calloc(1, sizeof(SimCoverage_t));
+      result = (p_program->_p_srcmap != NULL && p_program->_p_coverage != NULL) ? 
+               srcmap_build(p_program->_p_srcmap, p_asm) : FAIL;
+      if(result != SUCCESS){ // no coverage is reported of a program its tests could not run.
+        free(p_program->_p_coverage);
+        p_program->_p_coverage = NULL;
+      }
+    }
+    error = (result == SUCCESS) ? error : "out of memory";
+  }
+  for(uint32_t t = p_program->_first_test; t < p_program->_first_test + p_program->_num_tests; ++t){
+    Test_t* p_test = &p->_p_tests[t];
+    if(result == SUCCESS){
+      if(parse_test(p, p_test, p_asm->_p_sym_lib) == SUCCESS && p_test->_start_path != NULL){
+        find_start(p_program, p_test, p_asm->_p_hackins, p_asm->_ins_count);
+      }
+    }
+    else{
+      set_error(p_test, error, p_program->_path);
+    }
+  }
+  if(result == SUCCESS){
+    memcpy(p_program->_p_rom, p_asm->_p_hackins, p_asm->_ins_count * sizeof(uint16_t));
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: merges the coverage of the tests a worker ran of the program loaded in its simulator into that of the
+ *  program; done when the worker loads another program, and when the tests are done.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void merge_coverage(Worker_t* p_worker){
+  Tester_t* p = p_worker->_p_tester;
+  if(!p->_is_coverage || p_worker->_loaded == NO_PROGRAM || p->_p_programs[p_worker->_loaded]._p_coverage == NULL){
+    return;
+  }
+  pthread_mutex_lock(&p->_merge_lock);
+  sim_coverage(p_worker->_p_sim, p->_p_programs[p_worker->_loaded]._p_coverage);
+  pthread_mutex_unlock(&p->_merge_lock);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: task of the pool; runs a test on the simulator of the worker, from reset or from its snapshot, and checks
+ *  the RAM it leaves.
+ *
+ * note: the tests of a program are dealt to a worker together, so the worker mostly reuses the ROM it predecoded.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void run_test(Worker_t* p_worker, uint32_t test){
+  Tester_t* p = p_worker->_p_tester;
+  Test_t* p_test = &p->_p_tests[test];
+  if(p_test->_result == TEST_ERROR){
+    return;
+  }
+  if(p_worker->_p_sim == NULL && (p_worker->_p_sim = new_sim()) == NULL){
+    set_error(p_test, "%s", "out of memory");
+    return;
+  }
+  Sim_t* p_sim = p_worker->_p_sim;
+  const Program_t* p_program = &p->_p_programs[p_test->_program];
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  if(p_worker->_loaded != p_test->_program){
+    merge_coverage(p_worker);
+    sim_load(p_sim, p_program->_p_rom, p_program->_num_ins);
+    p_worker->_loaded = p_test->_program;
+  }
+  else if(p_test->_p_start == NULL){
+    sim_reset(p_sim);
+  }
+  if(p_test->_p_start != NULL){
+    sim_restore(p_sim, p_test->_p_start);
+  }
+  for(uint32_t i = 0; i < p_test->_num_sets; ++i){
+    p_sim->_p_ram[p_test->_p_settings[i]._address] = p_test->_p_settings[i]._value;
+    p_sim->_p_dirty[p_test->_p_settings[i]._address >> SIM_ROW_SHIFT] = 1;
+  }
+  int status = sim_run(p_sim, p_test->_max_cycles);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  p_test->_seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  p_test->_cycles = p_sim->_cycles - ((p_test->_p_start != NULL) ? p_test->_p_start->_cycles : 0);
+  p_test->_result = TEST_PASSED;
+  if(status == SIM_LIMIT){
+    p_test->_result = TEST_FAILED;
+    snprintf(p_test->_message, MAX_MESSAGE_CHAR, "reached the cycle budget of %" PRIu64 " cycles at pc %" PRIu16,
+             p_test->_max_cycles, p_sim->_pc);
+    return;
+  }
+  uint32_t num_wrong = 0;
+  for(uint32_t i = p_test->_num_sets; i < p_test->_num_sets + p_test->_num_expects; ++i){
+    const Setting_t* p_expect = &p_test->_p_settings[i];
+    uint16_t value = p_sim->_p_ram[p_expect->_address];
+    if(value != p_expect->_value && num_wrong++ == 0){
+      snprintf(p_test->_message, MAX_MESSAGE_CHAR, "RAM[%" PRIu16 "] is %" PRId16 ", expected %" PRId16, 
+               p_expect->_address, (int16_t)value, (int16_t)p_expect->_value);
+    }
+  }
+  if(num_wrong > 1){
+    size_t l = strlen(p_test->_message);
+    snprintf(p_test->_message + l, MAX_MESSAGE_CHAR - l, ", and %" PRIu32 " more words differ", num_wrong - 1);
+  }
+  uint32_t first_row, num_rows = (p_test->_p_screen != NULL) ? screen_diff(p_sim, p_test->_p_screen, &first_row) : 0;
+  if(num_rows > 0){
+    size_t l = strlen(p_test->_message);
+    snprintf(p_test->_message + l, MAX_MESSAGE_CHAR - l, "%s%" PRIu32 " rows of the screen differ, first row %" PRIu32,
+             (num_wrong > 0) ? ", and " : "", num_rows, first_row);
+  }
+  if(num_wrong > 0 || num_rows > 0){
+    p_test->_result = TEST_FAILED;
+  }
+}
+
+/*=====================================================================================================================
+ * REPORT
+ *===================================================================================================================*/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void put_xml(struct OutBuf* p_buf, const char* s){
+  for(; *s != '\0'; ++s){
+    switch(*s){
+      case '&': outbuf_puts(p_buf, "&amp;"); break;
+      case '<': outbuf_puts(p_buf, "&lt;"); break;
+      case '>': outbuf_puts(p_buf, "&gt;"); break;
+      case '"': outbuf_puts(p_buf, "&quot;"); break;
+      default: outbuf_putc(p_buf, *s);
+    }
+  }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: the class of a test in the report; the name of its program without directory and extension.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static void class_of(const Tester_t* p, const Test_t* p_test, char* cls, size_t size){
+  if(p_test->_program == NO_PROGRAM){
+    snprintf(cls, size, "invalid");
+    return;
+  }
+  const char* path = p->_p_programs[p_test->_program]._path, *slash = strrchr(path, '/');
+  const char* name = (slash != NULL) ? slash + 1 : path, *dot = strrchr(name, '.');
+  snprintf(cls, size, "%.*s", (int)((dot != NULL && dot != name) ? dot - name : (long)strlen(name)), name);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: writes the JUnit report of the tests; a test suite of the directory, with a test case of each test whose
+ *  class is its program. The cycles a test ran are a property of its test case.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int write_report(const Tester_t* p, const char* dir, const uint32_t* p_counts, double seconds, 
+                        struct OutBuf* p_report){
+  char line[512];
+  snprintf(line, sizeof(line), "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+           "<testsuites tests=\"%" PRIu32 "\" failures=\"%" PRIu32 "\" errors=\"%" PRIu32 "\" time=\"%.6f\">\n"
+           "  <testsuite name=\"", p->_num_tests, p_counts[1], p_counts[2], seconds);
+  outbuf_puts(p_report, line);
+  put_xml(p_report, dir);
+  snprintf(line, sizeof(line), "\" tests=\"%" PRIu32 "\" failures=\"%" PRIu32 "\" errors=\"%" PRIu32 "\" "
+           "time=\"%.6f\">\n", p->_num_tests, p_counts[1], p_counts[2], seconds);
+  outbuf_puts(p_report, line);
+  for(uint32_t t = 0; t < p->_num_tests; ++t){
+    const Test_t* p_test = &p->_p_tests[t];
+    char cls[PATH_MAX];
+    class_of(p, p_test, cls, sizeof(cls));
+    outbuf_puts(p_report, "    <testcase name=\"");
+    put_xml(p_report, p_test->_name);
+    outbuf_puts(p_report, "\" classname=\"");
+    put_xml(p_report, cls);
+    snprintf(line, sizeof(line), "\" time=\"%.6f\">\n      <properties>\n        <property name=\"cycles\" "
+             "value=\"%" PRIu64 "\"/>\n      </properties>\n", p_test->_seconds, p_test->_cycles);
+    outbuf_puts(p_report, line);
+    if(p_test->_result != TEST_PASSED){
+      outbuf_puts(p_report, (p_test->_result == TEST_FAILED) ? "      <failure message=\"" : "      <error message=\"");
+      put_xml(p_report, p_test->_message);
+      outbuf_puts(p_report, "\"/>\n");
+    }
+    outbuf_puts(p_report, "    </testcase>\n");
+  }
+  return outbuf_puts(p_report, "  </testsuite>\n</testsuites>\n");
+}
+
+/*=====================================================================================================================
+ * PUBLIC INTERFACE
+ *===================================================================================================================*/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int parse_setting(struct SymLib* p_lib, const char* s, size_t n, uint16_t* p_address, uint16_t* p_value){
+  const char* eq = memchr(s, '=', n);
+  size_t l = (eq != NULL) ? (size_t)(eq - s) : 0;
+  char name[MAX_SYM_LENGTH + 1], value[8], *tail;
+  if(l == 0 || l > MAX_SYM_LENGTH || n - l - 1 == 0 || n - l - 1 >= sizeof(value)){
+    return FAIL;
+  }
+  memcpy(name, s, l);
+  name[l] = '\0';
+  unsigned long number = strtoul(name, &tail, 10);
+  if(*tail == '\0' && number >= MAX_ADDRESS){
+    return FAIL;
+  }
+  if(*tail != '\0' && symlib_search_symbol(p_lib, name, p_address) != SUCCESS){
+    return FAIL;
+  }
+  *p_address = (*tail == '\0') ? (uint16_t)number : *p_address;
+  memcpy(value, eq + 1, n - l - 1);
+  value[n - l - 1] = '\0';
+  long v = strtol(value, &tail, 10);
+  if(*tail != '\0' || v < -32768 || v > 65535){
+    return FAIL;
+  }
+  *p_value = (uint16_t)v;
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int run_tests(const char* dir, uint64_t max_cycles, int num_workers, struct Jobserver* p_jobserver, bool is_coverage,
+              bool is_verbose, struct OutBuf* p_report){
+  Tester_t tester = {._max_cycles = max_cycles, ._is_coverage = is_coverage, ._p_jobserver = p_jobserver};
+  Tester_t* p = &tester;
+  pthread_mutex_init(&p->_merge_lock, NULL);
+
+  // the tables are built before the workers start, since their lazy initialisation is not thread safe...
+  init_lexer();
+  init_decoder();
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  int result = load_tests(p, dir);
+  uint32_t most = (p->_num_tests > 0) ? p->_num_tests : 1;
+  p->_num_workers = (num_workers < 1) ? 1 : ((uint32_t)num_workers > most) ? most : (uint32_t)num_workers;
+  if(result == SUCCESS){
+    p->_p_workers = (Worker_t*)calloc(p->_num_workers, sizeof(Worker_t));
+    p->_p_deques = (Deque_t*)aligned_alloc(_Alignof(Deque_t), p->_num_workers * sizeof(Deque_t));
+    result = (p->_p_workers != NULL && p->_p_deques != NULL) ? SUCCESS : FAIL;
+    if(result != SUCCESS){
+      fprintf(stderr, "fatal error: out of memory\n");
+    }
+  }
+  if(result == SUCCESS){
+    for(uint32_t w = 0; w < p->_num_workers; ++w){
+      p->_p_workers[w] = (Worker_t){._p_tester = p, ._index = w, ._loaded = NO_PROGRAM};
+    }
+    if(is_verbose){
+      printf("assembling %" PRIu32 " programs of %" PRIu32 " tests...\n", p->_num_programs, p->_num_tests);
+    }
+    run_pool(p, assemble_program, p->_num_programs);
+    if(is_verbose){
+      printf("running %" PRIu32 " tests on %" PRIu32 " threads...\n", p->_num_tests, p->_num_workers);
+    }
+    run_pool(p, run_test, p->_num_tests);
+    for(uint32_t w = 0; w < p->_num_workers; ++w){
+      merge_coverage(&p->_p_workers[w]);
+    }
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+  uint32_t counts[3] = {0}; // passed, failed, in error.
+  for(uint32_t t = 0; t < p->_num_tests && result == SUCCESS; ++t){
+    const Test_t* p_test = &p->_p_tests[t];
+    ++counts[p_test->_result - TEST_PASSED];
+    if(p_test->_result == TEST_PASSED){
+      printf("%s: passed in %" PRIu64 " cycles\n", p_test->_name, p_test->_cycles);
+    }
+    else{
+      printf("%s: %s; %s\n", p_test->_name, (p_test->_result == TEST_FAILED) ? "failed" : "error", p_test->_message);
+    }
+  }
+  if(result == SUCCESS){
+    printf("tests: %" PRIu32 " passed, %" PRIu32 " failed, %" PRIu32 " errors, in %.3f seconds\n", counts[0], 
+           counts[1], counts[2], seconds);
+    result = (write_report(p, dir, counts, seconds, p_report) == SUCCESS) ? SUCCESS : FAIL;
+  }
+  for(uint32_t i = 0; i < p->_num_programs && is_coverage && result == SUCCESS; ++i){
+    const Program_t* p_program = &p->_p_programs[i];
+    if(p_program->_p_coverage == NULL){
+      continue;
+    }
+    struct OutBuf text;
+    result = init_outbuf(&text, 1 << 12);
+    result = (result == SUCCESS) ? outbuf_puts(&text, p_program->_path) : result;
+    result = (result == SUCCESS) ? outbuf_puts(&text, ":\n") : result;
+    result = (result == SUCCESS) ? coverage_report(p_program->_p_srcmap, p_program->_p_rom, p_program->_p_coverage, 
+                                                   &text) : result;
+    result = (result == SUCCESS) ? outbuf_flush(&text, stdout) : result;
+    if(text._p_data != NULL){
+      free_outbuf(&text);
+    }
+    if(result != SUCCESS){
+      fprintf(stderr, "fatal error: failed to print the coverage of program '%s'\n", p_program->_path);
+    }
+  }
+  if(result == SUCCESS && counts[0] != p->_num_tests){
+    result = ERROR_1;
+  }
+
+  for(uint32_t w = 0; w < p->_num_workers && p->_p_workers != NULL; ++w){
+    if(p->_p_workers[w]._p_asm != NULL){
+      free_assembler(&p->_p_workers[w]._p_asm);
+    }
+    if(p->_p_workers[w]._p_sim != NULL){
+      free_sim(&p->_p_workers[w]._p_sim);
+    }
+  }
+  for(uint32_t t = 0; t < p->_num_tests; ++t){
+    free(p->_p_tests[t]._path);
+    free(p->_p_tests[t]._name);
+    free(p->_p_tests[t]._start_path);
+    free(p->_p_tests[t]._p_screen);
+    free(p->_p_tests[t]._p_settings);
+    if(p->_p_tests[t]._text._p_data != NULL){
+      free_outbuf(&p->_p_tests[t]._text);
+    }
+  }
+  for(uint32_t i = 0; i < p->_num_programs; ++i){
+    free(p->_p_programs[i]._path);
+    free(p->_p_programs[i]._p_rom);
+    free(p->_p_programs[i]._p_coverage);
+    for(uint32_t s = 0; s < p->_p_programs[i]._num_starts; ++s){
+      free(p->_p_programs[i]._p_starts[s]._path);
+      free(p->_p_programs[i]._p_starts[s]._p_state);
+    }
+    free(p->_p_programs[i]._p_starts);
+    if(p->_p_programs[i]._p_srcmap != NULL){
+      free_srcmap(&p->_p_programs[i]._p_srcmap);
+    }
+  }
+  free(p->_p_tests);
+  free(p->_p_programs);
+  free(p->_p_workers);
+  free(p->_p_deques);
+  pthread_mutex_destroy(&p->_merge_lock);
+  return result;
+}
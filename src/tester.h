@@ -0,0 +1,96 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: tester.h
+ *
+ *===================================================================================================================*/
+
+
+#ifndef _TESTER_H_
+#define _TESTER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define TEST_EXTENSION ".test"
+
+struct SymLib;
+struct OutBuf;
+struct Jobserver;
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: parses a setting of a RAM word, 'address=value', where the address is a number or a symbol of a program
+ *  and the value is a signed or unsigned 16-bit number; the syntax of the test vectors of --batch and of tests.
+ * @param p_lib: the symbols of the program.
+ * @param s: the setting; 'n' characters, not null terminated.
+ * return: SUCCESS, or FAIL if the setting is invalid.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int parse_setting(struct SymLib* p_lib, const char* s, size_t n, uint16_t* p_address, uint16_t* p_value);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: runs the tests of a directory on a pool of threads, then prints the outcome of each and writes a JUnit
+ *  report of them; each '.test' file of the directory is a test, of lines of the form:
+ *
+ *    program <file.asm>        the program to test; relative to the directory of the test.
+ *    start <file.snap>         a snapshot of the program to run from instead of reset (see 'snapshot_write').
+ *    set <address=value>...    RAM settings before the run, from reset.
+ *    expect <address=value>... RAM the program must leave after it halts or ends.
+ *    screen <file.pbm>         the screen the program must leave; a 512x256 PBM image (see 'screen_read_pbm').
+ *    cycles <N>                most instructions the program may run; else 'max_cycles'.
+ *
+ *  blank lines and lines starting '#' are skipped.
+ * @param dir: the directory of the tests.
+ * @param max_cycles: the cycle budget of tests without one; 0 for no limit.
+ * @param num_workers: most threads to run tests on.
+ * @param p_jobserver: the jobserver each thread but the first takes a token from, or NULL.
+ * @param is_coverage: to print the coverage of each program by its tests after the outcomes (see 'coverage_report').
+ * @param <out> p_report: buffer to append the report to.
+ * return: SUCCESS if every test passed, ERROR_1 if any failed, or FAIL if the directory could not be read or on
+ *  malloc error.
+ *
+ * note: each program is assembled once, however many tests run it, and its ROM is shared read-only by the threads;
+ *  each thread runs its tests on its own simulator. Tests are dealt to the threads in runs of the same program,
+ *  and a thread that runs out steals half of the tests left to another.
+ * note: a snapshot is read once however many tests start from it, and is shared read-only by the threads; each
+ *  copies it into its own simulator to start a test, so tests that share a long warm-up run it once, to save it.
+ *  The cycles of a test are counted from its snapshot.
+ * note: the coverage of a program is merged, by OR, from the threads that ran its tests.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int run_tests(const char* dir, uint64_t max_cycles, int num_workers, struct Jobserver* p_jobserver, bool is_coverage,
+              bool is_verbose, struct OutBuf* p_report);
+
+#endif
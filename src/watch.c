@@ -0,0 +1,180 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: watch.c
+ *
+ *===================================================================================================================*/
+
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include "watch.h"
+#include "asmerr.h"
+
+#define EVENT_BUFFER_SIZE 4096
+#define SETTLE_MS 50          /* a change is reported once no further events arrive for this long. */
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * SEE HEADER
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+struct Watcher {
+  int _fd;              /* inotify instance. */
+  char* _name;          /* name of the file within its directory. */
+};
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: reads the pending events of the watcher.
+ * return: true if any event is of the watched file.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static bool read_events(Watcher_t* p_watcher, bool* p_is_error){
+  char buf[EVENT_BUFFER_SIZE] __attribute__((aligned(__alignof__(struct inotify_event))));
+  ssize_t n = read(p_watcher->_fd, buf, sizeof(buf));
+  if(n <= 0){
+    *p_is_error = (n < 0 && errno != EINTR);
+    return false;
+  }
+  bool is_match = false;
+  for(char* p = buf; p < buf + n; p += sizeof(struct inotify_event) + ((struct inotify_event*)p)->len){
+    const struct inotify_event* p_event = (const struct inotify_event*)p;
+    if(p_event->len > 0 && strcmp(p_event->name, p_watcher->_name) == 0){
+      is_match = true;
+    }
+  }
+  return is_match;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: reads events until none arrive for SETTLE_MS, letting a save settle.
+ * return: SUCCESS, or FAIL on error.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+static int settle(Watcher_t* p_watcher){
+  bool is_error = false;
+  struct pollfd pfd = {p_watcher->_fd, POLLIN, 0};
+  while(poll(&pfd, 1, SETTLE_MS) > 0){
+    read_events(p_watcher, &is_error);
+    if(is_error){
+      perror("inotify");
+      return FAIL;
+    }
+  }
+  return SUCCESS;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+Watcher_t* new_watcher(const char* path){
+  Watcher_t* p_watcher = (Watcher_t*)calloc(1, sizeof(Watcher_t));
+  char* dir = strdup(path);
+  if(p_watcher == NULL || dir == NULL){
+    fprintf(stderr, "fatal error: out of memory\n");
+    free(p_watcher);
+    free(dir);
+    return NULL;
+  }
+
+  // split the path into the directory to watch and the name to look for in its events...
+  char* slash = strrchr(dir, '/');
+  const char* name = (slash != NULL) ? slash + 1 : dir;
+  p_watcher->_name = strdup(name);
+  if(slash == dir){
+    dir[1] = '\0';
+  }
+  else if(slash != NULL){
+    *slash = '\0';
+  }
+  else{
+    strcpy(dir, ".");
+  }
+
+  p_watcher->_fd = inotify_init1(IN_CLOEXEC);
+  if(p_watcher->_name == NULL || p_watcher->_fd < 0 || 
+     inotify_add_watch(p_watcher->_fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO) < 0){
+    perror(dir);
+    if(p_watcher->_fd >= 0){
+      close(p_watcher->_fd);
+    }
+    free(p_watcher->_name);
+    free(p_watcher);
+    free(dir);
+    return NULL;
+  }
+  free(dir);
+  return p_watcher;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void free_watcher(Watcher_t** pp_watcher){
+  close((*pp_watcher)->_fd);
+  free((*pp_watcher)->_name);
+  free(*pp_watcher);
+  *pp_watcher = NULL;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int watcher_wait(Watcher_t* p_watcher){
+  bool is_error = false;
+  while(!read_events(p_watcher, &is_error)){
+    if(is_error){
+      perror("inotify");
+      return FAIL;
+    }
+  }
+  return settle(p_watcher);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+int watcher_poll(Watcher_t* p_watcher, bool* p_is_changed){
+  *p_is_changed = false;
+  struct pollfd pfd = {p_watcher->_fd, POLLIN, 0};
+  if(poll(&pfd, 1, 0) <= 0){
+    return SUCCESS;
+  }
+  bool is_error = false;
+  *p_is_changed = read_events(p_watcher, &is_error);
+  if(is_error){
+    perror("inotify");
+    return FAIL;
+  }
+  return *p_is_changed ? settle(p_watcher) : SUCCESS;
+}
+/*-------------------------------------------------------------------------------------------------------------------*/
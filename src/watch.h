@@ -0,0 +1,80 @@
+/*=====================================================================================================================
+ *
+ * MIT License
+ * 
+ * This project was completed by Ian Murfin as part of the Nand2Tetris Audit course 
+ * at coursera.
+ *
+ * It was completed as part of my personal portfolio. Nand2tetris requires submissions
+ * be your own work; plagiarism is your responsibility.
+ *
+ * Copyright (c) 2020 Ian Murfin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+ * of the Software, and to permit persons to whom the Software is furnished to do 
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * End license text. 
+ *
+ * author: Ian Murfin
+ * file: watch.h
+ *
+ *===================================================================================================================*/
+
+
+#ifndef _WATCH_H_
+#define _WATCH_H_
+
+#include <stdbool.h>
+
+/*
+ * brief: closed type of a watcher of a file; instantiate with 'new_watcher'.
+ *
+ * note: the watcher watches the directory of the file, thus it sees editors that save by writing a new file and 
+ *  renaming it over the old one, as well as those that write the file in place.
+ */
+typedef struct Watcher Watcher_t;
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: starts watching the file at 'path'.
+ * return: the watcher, or NULL on error; errors are reported to stderr.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+Watcher_t* new_watcher(const char* path);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+void free_watcher(Watcher_t** pp_watcher);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: blocks until the watched file has been written or replaced; a burst of changes, as made by a save, is
+ *  reported once.
+ * return: SUCCESS, or FAIL on error.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int watcher_wait(Watcher_t* p_watcher);
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/*
+ * brief: as 'watcher_wait' but does not block if the watched file has not changed.
+ * @param <out> p_is_changed: set true if the file has been written or replaced.
+ * return: SUCCESS, or FAIL on error.
+ */
+/*-------------------------------------------------------------------------------------------------------------------*/
+int watcher_poll(Watcher_t* p_watcher, bool* p_is_changed);
+
+#endif